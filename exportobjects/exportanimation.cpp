@@ -10,9 +10,12 @@
 
 #include "stdafx.h"
 #include "exportanimation.h"
+#include "ExportScene.h"
 
 using namespace DirectX;
 
+extern ATG::ExportScene* g_pScene;
+
 namespace ATG
 {
     float g_fPositionExportTolerance = 0.99f;
@@ -339,26 +342,241 @@ void ExportAnimationTransformTrack::OptimizeScaleKeys()
     ScaleKeys = NewKeyList;
 }
 
-bool PositionLessEqual(const ExportAnimationPositionKey& A, const ExportAnimationPositionKey& B)
+namespace
 {
-    return A.fTime <= B.fTime;
+    //---------------------------------------------------------------------------------
+    // Error-bounded key reduction
+    //
+    // Keys are dropped only if linear interpolation between the kept keys reproduces
+    // every source key within the channel's tolerance, so the reported error is the
+    // real worst case at the captured sample times.
+    //---------------------------------------------------------------------------------
+
+    inline float GetLerpFactor(float fStartTime, float fEndTime, float fTime)
+    {
+        if (fEndTime <= fStartTime)
+            return 0.0f;
+        return std::min(std::max((fTime - fStartTime) / (fEndTime - fStartTime), 0.0f), 1.0f);
+    }
+
+    float KeyError(const ExportAnimationPositionKey& A, const ExportAnimationPositionKey& B, const ExportAnimationPositionKey& Key)
+    {
+        const float fLerp = GetLerpFactor(A.fTime, B.fTime, Key.fTime);
+        const XMVECTOR v = XMVectorLerp(XMLoadFloat3(&A.Position), XMLoadFloat3(&B.Position), fLerp);
+        return XMVectorGetX(XMVector3Length(v - XMLoadFloat3(&Key.Position)));
+    }
+
+    float KeyError(const ExportAnimationOrientationKey& A, const ExportAnimationOrientationKey& B, const ExportAnimationOrientationKey& Key)
+    {
+        const float fLerp = GetLerpFactor(A.fTime, B.fTime, Key.fTime);
+        const XMVECTOR q = XMQuaternionNormalize(XMVectorLerp(XMLoadFloat4(&A.Orientation), XMLoadFloat4(&B.Orientation), fLerp));
+        XMVECTOR qKey = XMQuaternionNormalize(XMLoadFloat4(&Key.Orientation));
+        if (XMVectorGetX(XMQuaternionDot(q, qKey)) < 0.0f)
+            qKey = XMVectorNegate(qKey);
+
+        // Rotation angle from the chord between the unit quaternions; acos of the dot
+        // product loses most of its precision for the small angles that matter here.
+        const float fChord = XMVectorGetX(XMVector4Length(q - qKey));
+        return 4.0f * asinf(std::min(fChord * 0.5f, 1.0f));
+    }
+
+    float KeyError(const ExportAnimationScaleKey& A, const ExportAnimationScaleKey& B, const ExportAnimationScaleKey& Key)
+    {
+        const float fLerp = GetLerpFactor(A.fTime, B.fTime, Key.fTime);
+        const XMVECTOR v = XMVectorLerp(XMLoadFloat3(&A.Scale), XMLoadFloat3(&B.Scale), fLerp);
+        XMFLOAT3 Delta;
+        XMStoreFloat3(&Delta, XMVectorAbs(v - XMLoadFloat3(&Key.Scale)));
+        return std::max(std::max(Delta.x, Delta.y), Delta.z);
+    }
+
+    // Largest error over the keys strictly between keys i and j when only i and j are kept.
+    template <typename KeyType>
+    float SegmentError(const std::vector<KeyType>& Keys, size_t i, size_t j)
+    {
+        float fMaxError = 0.0f;
+        for (size_t k = i + 1; k < j; ++k)
+        {
+            fMaxError = std::max(fMaxError, KeyError(Keys[i], Keys[j], Keys[k]));
+        }
+        return fMaxError;
+    }
+
+    template <typename KeyType>
+    std::vector<KeyType> ReduceKeyList(const std::vector<KeyType>& Keys, float fTolerance, float& fMaxError)
+    {
+        fMaxError = 0.0f;
+        const size_t dwKeyCount = Keys.size();
+        if (dwKeyCount < 2)
+            return Keys;
+
+        // A channel that never leaves the tolerance of its first key needs only that key.
+        float fHoldError = 0.0f;
+        for (size_t k = 1; k < dwKeyCount && fHoldError <= fTolerance; ++k)
+        {
+            fHoldError = std::max(fHoldError, KeyError(Keys[0], Keys[0], Keys[k]));
+        }
+        if (fHoldError <= fTolerance)
+        {
+            fMaxError = fHoldError;
+            return std::vector<KeyType>(1, Keys[0]);
+        }
+
+        std::vector<KeyType> NewKeys;
+        NewKeys.push_back(Keys[0]);
+
+        const size_t dwLastKey = dwKeyCount - 1;
+        size_t dwStart = 0;
+        while (dwStart < dwLastKey)
+        {
+            // Grow the segment exponentially, then binary search between the last end key
+            // that passed and the first that failed.
+            size_t dwGood = dwStart + 1;
+            float fGoodError = 0.0f;
+            size_t dwBad = 0;
+            for (size_t dwStep = 2; ; dwStep *= 2)
+            {
+                const size_t dwEnd = std::min(dwStart + dwStep, dwLastKey);
+                const float fError = SegmentError(Keys, dwStart, dwEnd);
+                if (fError > fTolerance)
+                {
+                    dwBad = dwEnd;
+                    break;
+                }
+                dwGood = dwEnd;
+                fGoodError = fError;
+                if (dwEnd == dwLastKey)
+                    break;
+            }
+
+            if (dwBad)
+            {
+                while (dwBad - dwGood > 1)
+                {
+                    const size_t dwMid = dwGood + (dwBad - dwGood) / 2;
+                    const float fError = SegmentError(Keys, dwStart, dwMid);
+                    if (fError <= fTolerance)
+                    {
+                        dwGood = dwMid;
+                        fGoodError = fError;
+                    }
+                    else
+                    {
+                        dwBad = dwMid;
+                    }
+                }
+            }
+
+            fMaxError = std::max(fMaxError, fGoodError);
+            NewKeys.push_back(Keys[dwGood]);
+            dwStart = dwGood;
+        }
+
+        return NewKeys;
+    }
+
+    template <typename KeyType, typename ValueType>
+    bool IsChannelAnimated(const std::vector<KeyType>& Keys, ValueType KeyType::* pValue)
+    {
+        for (size_t i = 1; i < Keys.size(); ++i)
+        {
+            if (memcmp(&(Keys[i].*pValue), &(Keys[0].*pValue), sizeof(ValueType)) != 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Rest pose information for one frame of the scene hierarchy.
+    struct FrameRestInfo
+    {
+        ExportFrame*    pFrame;
+        INT             iParentIndex;
+        XMFLOAT4X4      matWorld;
+        XMFLOAT3        WorldPosition;
+        float           fWorldScale;
+        float           fReach;
+        size_t          TrackedAncestorCount;
+        size_t          TrackedDescendantDepth;
+        bool            bTracked;
+    };
+
+    float GetMaxAxisScale(const XMFLOAT4X4& matTransform)
+    {
+        const XMMATRIX m = XMLoadFloat4x4(&matTransform);
+        const float fX = XMVectorGetX(XMVector3Length(m.r[0]));
+        const float fY = XMVectorGetX(XMVector3Length(m.r[1]));
+        const float fZ = XMVectorGetX(XMVector3Length(m.r[2]));
+        return std::max(std::max(fX, fY), fZ);
+    }
 }
 
-bool OrientationLessEqual(const ExportAnimationOrientationKey& A, const ExportAnimationOrientationKey& B)
+bool PositionLess(const ExportAnimationPositionKey& A, const ExportAnimationPositionKey& B)
 {
-    return A.fTime <= B.fTime;
+    return A.fTime < B.fTime;
 }
 
-bool ScaleLessEqual(const ExportAnimationScaleKey& A, const ExportAnimationScaleKey& B)
+bool OrientationLess(const ExportAnimationOrientationKey& A, const ExportAnimationOrientationKey& B)
 {
-    return A.fTime <= B.fTime;
+    return A.fTime < B.fTime;
+}
+
+bool ScaleLess(const ExportAnimationScaleKey& A, const ExportAnimationScaleKey& B)
+{
+    return A.fTime < B.fTime;
+}
+
+template< typename KeyList, typename LessFunc >
+void SortKeyList(KeyList& Keys, LessFunc Less)
+{
+    // Captured keys are almost always in order already.  Keys with equal times keep the
+    // order they were added in.
+    if (!std::is_sorted(Keys.begin(), Keys.end(), Less))
+    {
+        std::stable_sort(Keys.begin(), Keys.end(), Less);
+    }
 }
 
 void ExportAnimationTransformTrack::SortKeys()
 {
-    std::sort(PositionKeys.begin(), PositionKeys.end(), PositionLessEqual);
-    std::sort(OrientationKeys.begin(), OrientationKeys.end(), OrientationLessEqual);
-    std::sort(ScaleKeys.begin(), ScaleKeys.end(), ScaleLessEqual);
+    SortKeyList(PositionKeys, PositionLess);
+    SortKeyList(OrientationKeys, OrientationLess);
+    SortKeyList(ScaleKeys, ScaleLess);
+}
+
+void ExportAnimationTransformTrack::ReduceKeys(const ExportAnimationErrorBounds& Bounds, ExportAnimationReductionStats& Stats)
+{
+    SortKeys();
+
+    // q and -q are the same rotation; keep neighboring keys in one hemisphere so that
+    // interpolating between the kept keys takes the short path.
+    for (size_t i = 1; i < OrientationKeys.size(); ++i)
+    {
+        const XMVECTOR qPrev = XMLoadFloat4(&OrientationKeys[i - 1].Orientation);
+        const XMVECTOR q = XMLoadFloat4(&OrientationKeys[i].Orientation);
+        if (XMVectorGetX(XMQuaternionDot(qPrev, q)) < 0.0f)
+        {
+            XMStoreFloat4(&OrientationKeys[i].Orientation, XMVectorNegate(q));
+        }
+    }
+
+    Stats.SourceKeyCount = PositionKeys.size() + OrientationKeys.size() + ScaleKeys.size();
+
+    PositionKeys = ReduceKeyList(PositionKeys, Bounds.fPositionError, Stats.fMaxPositionError);
+    OrientationKeys = ReduceKeyList(OrientationKeys, Bounds.fOrientationError, Stats.fMaxOrientationError);
+    ScaleKeys = ReduceKeyList(ScaleKeys, Bounds.fScaleError, Stats.fMaxScaleError);
+
+    Stats.KeyCount = PositionKeys.size() + OrientationKeys.size() + ScaleKeys.size();
+}
+
+size_t ExportAnimationTransformTrack::GetAnimatedChannelCount() const
+{
+    size_t dwCount = 0;
+    if (IsChannelAnimated(PositionKeys, &ExportAnimationPositionKey::Position))
+        ++dwCount;
+    if (IsChannelAnimated(OrientationKeys, &ExportAnimationOrientationKey::Orientation))
+        ++dwCount;
+    if (IsChannelAnimated(ScaleKeys, &ExportAnimationScaleKey::Scale))
+        ++dwCount;
+    return dwCount;
 }
 
 void ExportAnimationTransformTrack::EndianSwap()
@@ -455,6 +673,121 @@ ExportAnimation::~ExportAnimation()
 {
 }
 
+// Converts the world-space error limits into per-track limits.  A key error on one
+// track moves every frame below it, so the position budget is shared by the animated
+// tracks along the deepest chain through the track, and rotation and scale errors are
+// scaled by the distance to the farthest descendant.  Distances come from the scene's
+// rest pose.
+void ExportAnimation::ComputeTrackErrorBounds(std::vector< ExportAnimationErrorBounds >& TrackBounds)
+{
+    const float fPositionError = g_ExportCoreSettings.fAnimPositionError;
+    const float fOrientationError = XMConvertToRadians(g_ExportCoreSettings.fAnimRotationError);
+    const float fScaleError = g_ExportCoreSettings.fAnimScaleError;
+
+    // Flatten the hierarchy; parents always precede their children.
+    std::vector< FrameRestInfo > Frames;
+    std::unordered_map< const ExportFrame*, size_t > FrameIndices;
+    {
+        FrameRestInfo Root = {};
+        Root.pFrame = g_pScene;
+        Root.iParentIndex = -1;
+        Frames.push_back(Root);
+    }
+    for (size_t i = 0; i < Frames.size(); ++i)
+    {
+        ExportFrame* pFrame = Frames[i].pFrame;
+        FrameIndices[pFrame] = i;
+        const size_t dwChildCount = pFrame->GetChildCount();
+        for (size_t j = 0; j < dwChildCount; ++j)
+        {
+            FrameRestInfo Child = {};
+            Child.pFrame = pFrame->GetChildByIndex(j);
+            Child.iParentIndex = static_cast<INT>(i);
+            Frames.push_back(Child);
+        }
+    }
+
+    for (const auto pTrack : m_vTracks)
+    {
+        if (!pTrack)
+            continue;
+        const auto it = FrameIndices.find(pTrack->TransformTrack.pSourceFrame);
+        if (it != FrameIndices.end())
+        {
+            Frames[it->second].bTracked = true;
+        }
+    }
+
+    for (auto& Frame : Frames)
+    {
+        XMMATRIX matWorld = XMLoadFloat4x4(&Frame.pFrame->Transform().Matrix());
+        Frame.TrackedAncestorCount = Frame.bTracked ? 1 : 0;
+        if (Frame.iParentIndex >= 0)
+        {
+            const FrameRestInfo& Parent = Frames[Frame.iParentIndex];
+            matWorld = XMMatrixMultiply(matWorld, XMLoadFloat4x4(&Parent.matWorld));
+            Frame.TrackedAncestorCount += Parent.TrackedAncestorCount;
+        }
+        XMStoreFloat4x4(&Frame.matWorld, matWorld);
+        XMStoreFloat3(&Frame.WorldPosition, matWorld.r[3]);
+        Frame.fWorldScale = GetMaxAxisScale(Frame.matWorld);
+    }
+
+    for (size_t i = Frames.size(); i-- > 1; )
+    {
+        const FrameRestInfo& Frame = Frames[i];
+        FrameRestInfo& Parent = Frames[Frame.iParentIndex];
+        Parent.TrackedDescendantDepth = std::max(Parent.TrackedDescendantDepth, Frame.TrackedDescendantDepth + (Frame.bTracked ? 1 : 0));
+
+        const XMVECTOR vPosition = XMLoadFloat3(&Frame.WorldPosition);
+        for (INT iAncestor = Frame.iParentIndex; iAncestor >= 0; iAncestor = Frames[iAncestor].iParentIndex)
+        {
+            FrameRestInfo& Ancestor = Frames[iAncestor];
+            const float fDistance = XMVectorGetX(XMVector3Length(vPosition - XMLoadFloat3(&Ancestor.WorldPosition)));
+            Ancestor.fReach = std::max(Ancestor.fReach, fDistance);
+        }
+    }
+
+    TrackBounds.resize(m_vTracks.size());
+    for (size_t i = 0; i < m_vTracks.size(); ++i)
+    {
+        if (!m_vTracks[i])
+            continue;
+        const ExportAnimationTransformTrack& Track = m_vTracks[i]->TransformTrack;
+
+        size_t dwChainLength = 1;
+        float fParentScale = 1.0f;
+        float fLocalScale = 1.0f;
+        float fReach = 0.0f;
+        const auto it = FrameIndices.find(Track.pSourceFrame);
+        if (it != FrameIndices.end())
+        {
+            const FrameRestInfo& Frame = Frames[it->second];
+            dwChainLength = Frame.TrackedAncestorCount + Frame.TrackedDescendantDepth;
+            if (Frame.iParentIndex >= 0)
+            {
+                fParentScale = std::max(Frames[Frame.iParentIndex].fWorldScale, 1e-6f);
+            }
+            const XMFLOAT3& Scale = Frame.pFrame->Transform().Scale();
+            fLocalScale = std::min(std::min(fabsf(Scale.x), fabsf(Scale.y)), fabsf(Scale.z));
+            fReach = Frame.fReach;
+        }
+
+        // Split this track's share of the position budget between its animated channels.
+        const float fBudget = fPositionError / static_cast<float>(dwChainLength * std::max<size_t>(Track.GetAnimatedChannelCount(), 1));
+
+        ExportAnimationErrorBounds& Bounds = TrackBounds[i];
+        Bounds.fPositionError = fBudget / fParentScale;
+        Bounds.fOrientationError = fOrientationError;
+        Bounds.fScaleError = fScaleError;
+        if (fReach > 0.0f)
+        {
+            Bounds.fOrientationError = std::min(Bounds.fOrientationError, fBudget / fReach);
+            Bounds.fScaleError = std::min(Bounds.fScaleError, fBudget * fLocalScale / fReach);
+        }
+    }
+}
+
 void ExportAnimation::Optimize()
 {
     if (!g_ExportCoreSettings.bOptimizeAnimations)
@@ -462,16 +795,63 @@ void ExportAnimation::Optimize()
         return;
     }
 
-    ExportLog::LogMsg(4, "Optimizing animation with %zu tracks.", m_vTracks.size());
+    const size_t dwTrackCount = m_vTracks.size();
+    const UINT uThreadCount = static_cast<UINT>(std::min<size_t>(GetExportWorkerThreadCount(), std::max<size_t>(dwTrackCount, 1)));
+    ExportLog::LogMsg(4, "Optimizing animation with %zu tracks on %u thread(s).", dwTrackCount, uThreadCount);
+
+    const bool bErrorBounded = g_ExportCoreSettings.bErrorBoundedAnimation;
+    const ULONGLONG ullStartTime = GetTickCount64();
+    std::vector< ExportAnimationErrorBounds > TrackBounds;
+    if (bErrorBounded)
+    {
+        ComputeTrackErrorBounds(TrackBounds);
+    }
+    const ULONGLONG ullBoundsTime = GetTickCount64();
+
+    // Tracks are independent once their bounds are known.  Results go into per-track
+    // slots and are logged and compacted afterwards in track order, so the output does
+    // not depend on scheduling.
+    std::vector< ExportAnimationReductionStats > TrackStats(dwTrackCount);
+    std::vector< uint8_t > TrackEmpty(dwTrackCount);
+    ExportParallelFor(dwTrackCount, [&](size_t i)
+        {
+            ExportAnimationTrack* pTrack = m_vTracks[i];
+            if (!pTrack)
+                return;
+
+            if (bErrorBounded)
+            {
+                pTrack->TransformTrack.ReduceKeys(TrackBounds[i], TrackStats[i]);
+            }
+            else
+            {
+                pTrack->TransformTrack.OptimizeKeys();
+            }
+            TrackEmpty[i] = pTrack->TransformTrack.IsTrackEmpty();
+        });
+    const ULONGLONG ullReduceTime = GetTickCount64();
+
+    size_t dwSourceKeyCount = 0;
+    size_t dwKeyCount = 0;
     std::vector< ExportAnimationTrack* > NewTrackList;
-    for (size_t i = 0; i < m_vTracks.size(); i++)
+    for (size_t i = 0; i < dwTrackCount; i++)
     {
         ExportAnimationTrack* pTrack = m_vTracks[i];
         if (!pTrack)
             continue;
 
-        pTrack->TransformTrack.OptimizeKeys();
-        if (pTrack->TransformTrack.IsTrackEmpty())
+        if (bErrorBounded)
+        {
+            const ExportAnimationReductionStats& Stats = TrackStats[i];
+            dwSourceKeyCount += Stats.SourceKeyCount;
+            dwKeyCount += Stats.KeyCount;
+            ExportLog::LogMsg(3, "Track \"%s\": %zu keys reduced to %zu (%0.1f:1), max error %g units, %g degrees, %g scale.",
+                pTrack->GetName().SafeString(), Stats.SourceKeyCount, Stats.KeyCount,
+                Stats.KeyCount ? static_cast<float>(Stats.SourceKeyCount) / static_cast<float>(Stats.KeyCount) : 0.0f,
+                Stats.fMaxPositionError, XMConvertToDegrees(Stats.fMaxOrientationError), Stats.fMaxScaleError);
+        }
+
+        if (TrackEmpty[i])
         {
             delete pTrack;
         }
@@ -480,7 +860,14 @@ void ExportAnimation::Optimize()
             NewTrackList.push_back(pTrack);
         }
     }
+    if (bErrorBounded)
+    {
+        ExportLog::LogMsg(2, "Animation \"%s\": %zu keys reduced to %zu (%0.1f:1).", GetName().SafeString(), dwSourceKeyCount, dwKeyCount,
+            dwKeyCount ? static_cast<float>(dwSourceKeyCount) / static_cast<float>(dwKeyCount) : 0.0f);
+    }
     ExportLog::LogMsg(4, "Animation has %zu tracks after optimization.", NewTrackList.size());
+    ExportLog::LogMsg(3, "Animation \"%s\" optimization took %llu ms: %llu ms computing error bounds, %llu ms reducing tracks.",
+        GetName().SafeString(), ullReduceTime - ullStartTime, ullBoundsTime - ullStartTime, ullReduceTime - ullBoundsTime);
     m_vTracks = NewTrackList;
 }
 
@@ -38,6 +38,24 @@ namespace ATG
 
     class ExportFrame;
 
+    // Largest reconstruction error allowed for each channel of one track, in the
+    // track's parent space.  Orientation error is in radians.
+    struct ExportAnimationErrorBounds
+    {
+        float               fPositionError;
+        float               fOrientationError;
+        float               fScaleError;
+    };
+
+    struct ExportAnimationReductionStats
+    {
+        size_t              SourceKeyCount;
+        size_t              KeyCount;
+        float               fMaxPositionError;
+        float               fMaxOrientationError;
+        float               fMaxScaleError;
+    };
+
     class ExportAnimationTransformTrack
     {
     public:
@@ -49,6 +67,8 @@ namespace ATG
         void AddKey(float fTime, const DirectX::XMFLOAT4X4& matTransform);
         void AddKey(float fTime, const DirectX::XMFLOAT3& Position, const DirectX::XMFLOAT4& Orientation, const DirectX::XMFLOAT3& Scale);
         void OptimizeKeys();
+        void ReduceKeys(const ExportAnimationErrorBounds& Bounds, ExportAnimationReductionStats& Stats);
+        size_t GetAnimatedChannelCount() const;
         void SortKeys();
         void EndianSwap();
         float* GetPositionData() const noexcept { return (float*)(PositionKeys.data()); }
@@ -99,6 +119,8 @@ namespace ATG
         void Optimize();
         void EndianSwap();
         static void SetAnimationExportQuality(INT iPos, INT iOrientation, INT iScale);
+    protected:
+        void ComputeTrackErrorBounds(std::vector< ExportAnimationErrorBounds >& TrackBounds);
     public:
         float                               fStartTime;
         float                               fEndTime;
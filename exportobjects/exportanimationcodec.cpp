@@ -0,0 +1,403 @@
+//-------------------------------------------------------------------------------------
+// ExportAnimationCodec.cpp
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "exportanimationcodec.h"
+
+#include <cmath>
+
+using namespace DirectX;
+using namespace ATG;
+
+namespace
+{
+    constexpr float QUANTIZED_RANGE_SCALE = 65535.0f;
+
+    // Smallest-three components lie in [-1/sqrt(2), 1/sqrt(2)] and use 15 bits each.
+    constexpr float QUANTIZED_COMPONENT_SCALE = 32767.0f;
+    constexpr float SQRT2 = 1.41421356f;
+
+    // Size of one key of SDKANIMATION_DATA: float3 translation, float4 orientation and
+    // float3 scale.
+    constexpr size_t FLOAT_KEY_SIZE = 10 * sizeof(float);
+
+    template <typename KeyType>
+    size_t FindSegment(const std::vector<KeyType>& Keys, float fTime)
+    {
+        // Index of the last key at or before fTime.
+        const auto it = std::upper_bound(Keys.begin(), Keys.end(), fTime,
+            [](float fValue, const KeyType& Key) { return fValue < Key.fTime; });
+        return (it == Keys.begin()) ? 0 : static_cast<size_t>(it - Keys.begin()) - 1;
+    }
+
+    template <typename KeyType, typename ValueType, typename LoadFunc>
+    XMVECTOR SampleKeys(const std::vector<KeyType>& Keys, ValueType KeyType::* pValue, float fTime, LoadFunc Load, FXMVECTOR vDefault)
+    {
+        if (Keys.empty())
+            return vDefault;
+
+        const size_t i = FindSegment(Keys, fTime);
+        if (i + 1 >= Keys.size() || fTime <= Keys[i].fTime)
+            return Load(&(Keys[i].*pValue));
+
+        const KeyType& A = Keys[i];
+        const KeyType& B = Keys[i + 1];
+        const float fLerp = (fTime - A.fTime) / (B.fTime - A.fTime);
+        return XMVectorLerp(Load(&(A.*pValue)), Load(&(B.*pValue)), fLerp);
+    }
+
+    // Walks the keys once for evenly spaced sample times, giving the same values as
+    // SampleKeys at each time without searching for every sample.
+    template <typename KeyType, typename ValueType, typename OutputType, typename LoadFunc, typename BlendFunc, typename StoreFunc>
+    void ResampleKeys(const std::vector<KeyType>& Keys, ValueType KeyType::* pValue, size_t dwSampleCount, float fSampleInterval,
+        LoadFunc Load, BlendFunc Blend, StoreFunc Store, FXMVECTOR vDefault, OutputType* pOutput)
+    {
+        if (Keys.empty())
+        {
+            for (size_t i = 0; i < dwSampleCount; ++i)
+                Store(&pOutput[i], vDefault);
+            return;
+        }
+
+        size_t dwKey = 0;
+        for (size_t i = 0; i < dwSampleCount; ++i)
+        {
+            const float fTime = static_cast<float>(i) * fSampleInterval;
+            while (dwKey + 1 < Keys.size() && Keys[dwKey + 1].fTime <= fTime)
+                ++dwKey;
+
+            // Blending a held key with itself keeps its value; orientations are still
+            // normalized, as SampleAnimationTrack does.
+            const KeyType& A = Keys[dwKey];
+            if (dwKey + 1 >= Keys.size() || fTime <= A.fTime)
+            {
+                Store(&pOutput[i], Blend(Load(&(A.*pValue)), Load(&(A.*pValue)), 0.0f));
+                continue;
+            }
+            const KeyType& B = Keys[dwKey + 1];
+            Store(&pOutput[i], Blend(Load(&(A.*pValue)), Load(&(B.*pValue)), (fTime - A.fTime) / (B.fTime - A.fTime)));
+        }
+    }
+
+    inline uint16_t QuantizeRange(float fValue, float fMin, float fExtent)
+    {
+        if (fExtent <= 0.0f)
+            return 0;
+        const float fScaled = (fValue - fMin) / fExtent * QUANTIZED_RANGE_SCALE + 0.5f;
+        return static_cast<uint16_t>(std::min(std::max(fScaled, 0.0f), QUANTIZED_RANGE_SCALE));
+    }
+
+    inline float DequantizeRange(uint16_t uValue, float fMin, float fExtent)
+    {
+        return fMin + fExtent * (static_cast<float>(uValue) / QUANTIZED_RANGE_SCALE);
+    }
+
+    // Drops the largest component, which is made positive and rebuilt from the unit
+    // length on decode.  Its index is kept in the top bits of the first two values.
+    void EncodeSmallestThree(FXMVECTOR qOrientation, uint16_t* pPacked)
+    {
+        XMFLOAT4 q;
+        XMStoreFloat4(&q, XMQuaternionNormalize(qOrientation));
+        float Components[4] = { q.x, q.y, q.z, q.w };
+
+        uint32_t uLargest = 0;
+        for (uint32_t i = 1; i < 4; ++i)
+        {
+            if (fabsf(Components[i]) > fabsf(Components[uLargest]))
+                uLargest = i;
+        }
+        const float fSign = (Components[uLargest] < 0.0f) ? -1.0f : 1.0f;
+
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (i == uLargest)
+                continue;
+            const float fScaled = (Components[i] * fSign * SQRT2 * 0.5f + 0.5f) * QUANTIZED_COMPONENT_SCALE + 0.5f;
+            pPacked[j++] = static_cast<uint16_t>(std::min(std::max(fScaled, 0.0f), QUANTIZED_COMPONENT_SCALE));
+        }
+        pPacked[0] |= static_cast<uint16_t>((uLargest & 1) << 15);
+        pPacked[1] |= static_cast<uint16_t>((uLargest >> 1) << 15);
+    }
+
+    XMFLOAT4 DecodeSmallestThree(const uint16_t* pPacked)
+    {
+        const uint32_t uLargest = (pPacked[0] >> 15) | ((pPacked[1] >> 15) << 1);
+
+        float Components[4];
+        float fSumSq = 0.0f;
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            if (i == uLargest)
+                continue;
+            const float fValue = (static_cast<float>(pPacked[j++] & 0x7FFF) / QUANTIZED_COMPONENT_SCALE * 2.0f - 1.0f) / SQRT2;
+            Components[i] = fValue;
+            fSumSq += fValue * fValue;
+        }
+        Components[uLargest] = sqrtf(std::max(1.0f - fSumSq, 0.0f));
+
+        return XMFLOAT4(Components[0], Components[1], Components[2], Components[3]);
+    }
+
+    inline bool IsRangeAnimated(const XMFLOAT3& Extent) noexcept
+    {
+        return Extent.x > 0.0f || Extent.y > 0.0f || Extent.z > 0.0f;
+    }
+
+    void ComputeRange(const std::vector<XMFLOAT3>& Values, XMFLOAT3& Min, XMFLOAT3& Extent)
+    {
+        XMVECTOR vMin = XMLoadFloat3(&Values[0]);
+        XMVECTOR vMax = vMin;
+        for (const auto& Value : Values)
+        {
+            const XMVECTOR v = XMLoadFloat3(&Value);
+            vMin = XMVectorMin(vMin, v);
+            vMax = XMVectorMax(vMax, v);
+        }
+        XMStoreFloat3(&Min, vMin);
+        XMStoreFloat3(&Extent, vMax - vMin);
+    }
+
+    void QuantizeRangeChannel(const std::vector<XMFLOAT3>& Values, const XMFLOAT3& Min, const XMFLOAT3& Extent, std::vector<uint16_t>& Samples)
+    {
+        for (const auto& Value : Values)
+        {
+            Samples.push_back(QuantizeRange(Value.x, Min.x, Extent.x));
+            Samples.push_back(QuantizeRange(Value.y, Min.y, Extent.y));
+            Samples.push_back(QuantizeRange(Value.z, Min.z, Extent.z));
+        }
+    }
+
+    inline XMFLOAT3 DecodeRange(const uint16_t* pPacked, const XMFLOAT3& Min, const XMFLOAT3& Extent)
+    {
+        return XMFLOAT3(DequantizeRange(pPacked[0], Min.x, Extent.x),
+            DequantizeRange(pPacked[1], Min.y, Extent.y),
+            DequantizeRange(pPacked[2], Min.z, Extent.z));
+    }
+}
+
+void ATG::SampleAnimationTrack(const ExportAnimationTransformTrack& Track, float fTime, XMFLOAT3& Position, XMFLOAT4& Orientation, XMFLOAT3& Scale)
+{
+    auto LoadFloat3 = [](const XMFLOAT3* pValue) { return XMLoadFloat3(pValue); };
+
+    XMStoreFloat3(&Position, SampleKeys(Track.PositionKeys, &ExportAnimationPositionKey::Position, fTime, LoadFloat3, XMVectorZero()));
+    XMStoreFloat3(&Scale, SampleKeys(Track.ScaleKeys, &ExportAnimationScaleKey::Scale, fTime, LoadFloat3, XMVectorSplatOne()));
+
+    // Interpolate orientations along the short path.
+    XMVECTOR q = XMQuaternionIdentity();
+    const auto& Keys = Track.OrientationKeys;
+    if (!Keys.empty())
+    {
+        const size_t i = FindSegment(Keys, fTime);
+        q = XMLoadFloat4(&Keys[i].Orientation);
+        if (i + 1 < Keys.size() && fTime > Keys[i].fTime)
+        {
+            XMVECTOR qEnd = XMLoadFloat4(&Keys[i + 1].Orientation);
+            if (XMVectorGetX(XMQuaternionDot(q, qEnd)) < 0.0f)
+                qEnd = XMVectorNegate(qEnd);
+            const float fLerp = (fTime - Keys[i].fTime) / (Keys[i + 1].fTime - Keys[i].fTime);
+            q = XMVectorLerp(q, qEnd, fLerp);
+        }
+    }
+    XMStoreFloat4(&Orientation, XMQuaternionNormalize(q));
+}
+
+void ATG::ResampleAnimationTrack(const ExportAnimationTransformTrack& Track, size_t dwKeyCount, float fKeyInterval, XMFLOAT3* pPositions, XMFLOAT4* pOrientations, XMFLOAT3* pScales)
+{
+    auto LoadFloat3 = [](const XMFLOAT3* pValue) { return XMLoadFloat3(pValue); };
+    auto LoadFloat4 = [](const XMFLOAT4* pValue) { return XMLoadFloat4(pValue); };
+    auto StoreFloat3 = [](XMFLOAT3* pValue, FXMVECTOR v) { XMStoreFloat3(pValue, v); };
+    auto StoreFloat4 = [](XMFLOAT4* pValue, FXMVECTOR v) { XMStoreFloat4(pValue, v); };
+    auto Lerp = [](FXMVECTOR vA, FXMVECTOR vB, float fLerp) { return XMVectorLerp(vA, vB, fLerp); };
+
+    // Matches SampleAnimationTrack: short-path lerp, normalized even on held keys.
+    auto Nlerp = [](FXMVECTOR qA, FXMVECTOR qB, float fLerp)
+    {
+        const XMVECTOR qEnd = (XMVectorGetX(XMQuaternionDot(qA, qB)) < 0.0f) ? XMVectorNegate(qB) : qB;
+        return XMQuaternionNormalize(XMVectorLerp(qA, qEnd, fLerp));
+    };
+
+    ResampleKeys(Track.PositionKeys, &ExportAnimationPositionKey::Position, dwKeyCount, fKeyInterval, LoadFloat3, Lerp, StoreFloat3, XMVectorZero(), pPositions);
+    ResampleKeys(Track.OrientationKeys, &ExportAnimationOrientationKey::Orientation, dwKeyCount, fKeyInterval, LoadFloat4, Nlerp, StoreFloat4, XMQuaternionIdentity(), pOrientations);
+    ResampleKeys(Track.ScaleKeys, &ExportAnimationScaleKey::Scale, dwKeyCount, fKeyInterval, LoadFloat3, Lerp, StoreFloat3, XMVectorSplatOne(), pScales);
+}
+
+size_t ATG::GetQuantizedSampleCount(uint32_t Flags, size_t dwKeyCount) noexcept
+{
+    size_t dwChannelCount = 0;
+    for (uint32_t uFlag = QTF_TRANSLATION_ANIMATED; uFlag <= QTF_SCALE_ANIMATED; uFlag <<= 1)
+    {
+        if (Flags & uFlag)
+            ++dwChannelCount;
+    }
+    return dwChannelCount * dwKeyCount * QUANTIZED_VALUES_PER_KEY;
+}
+
+void ATG::QuantizeAnimationTrack(const ExportAnimationTransformTrack& Track, size_t dwKeyCount, float fKeyInterval, ExportQuantizedTrack& Result, ExportQuantizationStats& Stats)
+{
+    Result.Header = {};
+    Result.Samples.clear();
+    Stats = {};
+    if (dwKeyCount == 0)
+        return;
+
+    std::vector<XMFLOAT3> Positions(dwKeyCount);
+    std::vector<XMFLOAT4> Orientations(dwKeyCount);
+    std::vector<XMFLOAT3> Scales(dwKeyCount);
+    ResampleAnimationTrack(Track, dwKeyCount, fKeyInterval, Positions.data(), Orientations.data(), Scales.data());
+
+    auto& Header = Result.Header;
+    ComputeRange(Positions, Header.TranslationMin, Header.TranslationExtent);
+    ComputeRange(Scales, Header.ScaleMin, Header.ScaleExtent);
+    Header.Orientation = Orientations[0];
+
+    if (IsRangeAnimated(Header.TranslationExtent))
+        Header.Flags |= QTF_TRANSLATION_ANIMATED;
+    if (IsRangeAnimated(Header.ScaleExtent))
+        Header.Flags |= QTF_SCALE_ANIMATED;
+    for (const auto& Orientation : Orientations)
+    {
+        if (memcmp(&Orientation, &Header.Orientation, sizeof(XMFLOAT4)) != 0)
+        {
+            Header.Flags |= QTF_ORIENTATION_ANIMATED;
+            break;
+        }
+    }
+
+    Result.Samples.reserve(GetQuantizedSampleCount(Header.Flags, dwKeyCount));
+    if (Header.Flags & QTF_TRANSLATION_ANIMATED)
+    {
+        QuantizeRangeChannel(Positions, Header.TranslationMin, Header.TranslationExtent, Result.Samples);
+    }
+    if (Header.Flags & QTF_ORIENTATION_ANIMATED)
+    {
+        for (const auto& Orientation : Orientations)
+        {
+            uint16_t Packed[QUANTIZED_VALUES_PER_KEY];
+            EncodeSmallestThree(XMLoadFloat4(&Orientation), Packed);
+            Result.Samples.insert(Result.Samples.end(), Packed, Packed + QUANTIZED_VALUES_PER_KEY);
+        }
+    }
+    if (Header.Flags & QTF_SCALE_ANIMATED)
+    {
+        QuantizeRangeChannel(Scales, Header.ScaleMin, Header.ScaleExtent, Result.Samples);
+    }
+
+    Stats.SourceSize = dwKeyCount * FLOAT_KEY_SIZE;
+    Stats.QuantizedSize = sizeof(ExportQuantizedTrackHeader) + Result.Samples.size() * sizeof(uint16_t);
+    for (size_t i = 0; i < dwKeyCount; ++i)
+    {
+        XMFLOAT3 Position;
+        XMFLOAT4 Orientation;
+        XMFLOAT3 Scale;
+        DecodeQuantizedKey(Header, Result.Samples.data(), dwKeyCount, i, Position, Orientation, Scale);
+
+        const float fPositionError = XMVectorGetX(XMVector3Length(XMLoadFloat3(&Position) - XMLoadFloat3(&Positions[i])));
+
+        // Rotation angle from the chord between the unit quaternions, which keeps its
+        // precision for small angles.
+        const XMVECTOR qDecoded = XMLoadFloat4(&Orientation);
+        XMVECTOR qSource = XMLoadFloat4(&Orientations[i]);
+        if (XMVectorGetX(XMQuaternionDot(qDecoded, qSource)) < 0.0f)
+            qSource = XMVectorNegate(qSource);
+        const float fChord = XMVectorGetX(XMVector4Length(qDecoded - qSource));
+
+        XMFLOAT3 ScaleDelta;
+        XMStoreFloat3(&ScaleDelta, XMVectorAbs(XMLoadFloat3(&Scale) - XMLoadFloat3(&Scales[i])));
+
+        Stats.fMaxPositionError = std::max(Stats.fMaxPositionError, fPositionError);
+        Stats.fMaxOrientationError = std::max(Stats.fMaxOrientationError, 4.0f * asinf(std::min(fChord * 0.5f, 1.0f)));
+        Stats.fMaxScaleError = std::max(Stats.fMaxScaleError, std::max(std::max(ScaleDelta.x, ScaleDelta.y), ScaleDelta.z));
+    }
+}
+
+size_t ATG::GetQuantizedKeyCount(const ExportAnimation* pAnim) noexcept
+{
+    return static_cast<size_t>(pAnim->GetDuration() / pAnim->fSourceFrameInterval + 0.5f) + 1;
+}
+
+bool ATG::QuantizeAnimationTracks(ExportAnimation* pAnim, size_t dwKeyCount, std::vector<ExportQuantizedTrack>& Tracks, ExportQuantizationStats& TotalStats)
+{
+    const size_t dwTrackCount = pAnim->GetTrackCount();
+    for (size_t i = 0; i < dwTrackCount; ++i)
+    {
+        if (!pAnim->GetTrack(i))
+            return false;
+    }
+
+    Tracks.resize(dwTrackCount);
+    std::vector<ExportQuantizationStats> TrackStats(dwTrackCount);
+    ExportParallelFor(dwTrackCount, [&](size_t i)
+        {
+            QuantizeAnimationTrack(pAnim->GetTrack(i)->TransformTrack, dwKeyCount, pAnim->fSourceFrameInterval, Tracks[i], TrackStats[i]);
+        });
+
+    // Summed in track order so the totals do not depend on scheduling.
+    TotalStats = {};
+    for (const auto& Stats : TrackStats)
+    {
+        AddQuantizationStats(TotalStats, Stats);
+    }
+    return true;
+}
+
+void ATG::DecodeQuantizedKey(const ExportQuantizedTrackHeader& Header, const uint16_t* pSamples, size_t dwKeyCount, size_t dwKeyIndex, XMFLOAT3& Position, XMFLOAT4& Orientation, XMFLOAT3& Scale)
+{
+    const uint16_t* pChannel = pSamples;
+    const size_t dwChannelSize = dwKeyCount * QUANTIZED_VALUES_PER_KEY;
+    const size_t dwKeyOffset = dwKeyIndex * QUANTIZED_VALUES_PER_KEY;
+
+    if (Header.Flags & QTF_TRANSLATION_ANIMATED)
+    {
+        Position = DecodeRange(pChannel + dwKeyOffset, Header.TranslationMin, Header.TranslationExtent);
+        pChannel += dwChannelSize;
+    }
+    else
+    {
+        Position = Header.TranslationMin;
+    }
+
+    if (Header.Flags & QTF_ORIENTATION_ANIMATED)
+    {
+        Orientation = DecodeSmallestThree(pChannel + dwKeyOffset);
+        pChannel += dwChannelSize;
+    }
+    else
+    {
+        Orientation = Header.Orientation;
+    }
+
+    if (Header.Flags & QTF_SCALE_ANIMATED)
+    {
+        Scale = DecodeRange(pChannel + dwKeyOffset, Header.ScaleMin, Header.ScaleExtent);
+    }
+    else
+    {
+        Scale = Header.ScaleMin;
+    }
+}
+
+void ATG::AddQuantizationStats(ExportQuantizationStats& Total, const ExportQuantizationStats& Stats) noexcept
+{
+    Total.SourceSize += Stats.SourceSize;
+    Total.QuantizedSize += Stats.QuantizedSize;
+    Total.fMaxPositionError = std::max(Total.fMaxPositionError, Stats.fMaxPositionError);
+    Total.fMaxOrientationError = std::max(Total.fMaxOrientationError, Stats.fMaxOrientationError);
+    Total.fMaxScaleError = std::max(Total.fMaxScaleError, Stats.fMaxScaleError);
+}
+
+void ATG::LogQuantizationStats(const CHAR* strAnimationName, size_t dwTrackCount, const ExportQuantizationStats& Stats)
+{
+    const float fRatio = Stats.QuantizedSize ? static_cast<float>(Stats.SourceSize) / static_cast<float>(Stats.QuantizedSize) : 0.0f;
+    ExportLog::LogMsg(2, "Quantized animation \"%s\" (%zu tracks): %zu bytes reduced to %zu (%0.1f:1), max error %g units, %g degrees, %g scale.",
+        strAnimationName, dwTrackCount, Stats.SourceSize, Stats.QuantizedSize, fRatio,
+        Stats.fMaxPositionError, XMConvertToDegrees(Stats.fMaxOrientationError), Stats.fMaxScaleError);
+}
@@ -0,0 +1,90 @@
+//-------------------------------------------------------------------------------------
+// ExportAnimationCodec.h
+//
+// Quantized animation tracks.  Keys are sampled at a fixed interval, so times are
+// implicit key indices.  Orientations are stored as smallest-three quaternions, and
+// positions and scales are quantized to the range each track covers.  Every animated
+// channel stores three 16-bit values per key; constant channels store one float value.
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+#pragma once
+
+namespace ATG
+{
+    class ExportAnimation;
+    class ExportAnimationTransformTrack;
+
+    enum QUANTIZED_TRACK_FLAGS : uint32_t
+    {
+        QTF_TRANSLATION_ANIMATED = 0x1,
+        QTF_ORIENTATION_ANIMATED = 0x2,
+        QTF_SCALE_ANIMATED = 0x4,
+        QTF_ALL = QTF_TRANSLATION_ANIMATED | QTF_ORIENTATION_ANIMATED | QTF_SCALE_ANIMATED,
+    };
+
+    constexpr size_t QUANTIZED_VALUES_PER_KEY = 3;
+
+    // For an animated channel, Min + Extent * (value / 65535) recovers each component.
+    // For a constant channel, Min (or Orientation) is the value.
+    struct ExportQuantizedTrackHeader
+    {
+        uint32_t            Flags;
+        DirectX::XMFLOAT3   TranslationMin;
+        DirectX::XMFLOAT3   TranslationExtent;
+        DirectX::XMFLOAT4   Orientation;
+        DirectX::XMFLOAT3   ScaleMin;
+        DirectX::XMFLOAT3   ScaleExtent;
+    };
+
+    struct ExportQuantizedTrack
+    {
+        ExportQuantizedTrackHeader  Header;
+
+        // Channel-major: every translation key, then every orientation key, then every
+        // scale key, for the animated channels only.
+        std::vector<uint16_t>       Samples;
+    };
+
+    struct ExportQuantizationStats
+    {
+        size_t      SourceSize;
+        size_t      QuantizedSize;
+        float       fMaxPositionError;
+        float       fMaxOrientationError;
+        float       fMaxScaleError;
+    };
+
+    // Evaluates a track with linear interpolation between keys, holding the first and
+    // last keys outside their range.  The orientation is normalized.
+    void SampleAnimationTrack(const ExportAnimationTransformTrack& Track, float fTime, DirectX::XMFLOAT3& Position, DirectX::XMFLOAT4& Orientation, DirectX::XMFLOAT3& Scale);
+
+    // Samples dwKeyCount keys, fKeyInterval seconds apart, in one pass over the track.
+    // The results match SampleAnimationTrack at each time.
+    void ResampleAnimationTrack(const ExportAnimationTransformTrack& Track, size_t dwKeyCount, float fKeyInterval, DirectX::XMFLOAT3* pPositions, DirectX::XMFLOAT4* pOrientations, DirectX::XMFLOAT3* pScales);
+
+    // Samples dwKeyCount keys, fKeyInterval seconds apart, and quantizes them.  Stats
+    // receives the float32 and quantized sizes and the worst error after decoding.
+    void QuantizeAnimationTrack(const ExportAnimationTransformTrack& Track, size_t dwKeyCount, float fKeyInterval, ExportQuantizedTrack& Result, ExportQuantizationStats& Stats);
+
+    // Returns the number of keys to quantize an animation into: one per source frame,
+    // including both the first and the last frame.
+    size_t GetQuantizedKeyCount(const ExportAnimation* pAnim) noexcept;
+
+    // Quantizes every track of an animation across the worker threads, sampling at the
+    // animation's source frame interval.  Tracks[i] holds track i.  Returns false if the
+    // animation has a missing track.
+    bool QuantizeAnimationTracks(ExportAnimation* pAnim, size_t dwKeyCount, std::vector<ExportQuantizedTrack>& Tracks, ExportQuantizationStats& TotalStats);
+
+    size_t GetQuantizedSampleCount(uint32_t Flags, size_t dwKeyCount) noexcept;
+
+    // Reference decoder; pSamples points to the track's 16-bit values.
+    void DecodeQuantizedKey(const ExportQuantizedTrackHeader& Header, const uint16_t* pSamples, size_t dwKeyCount, size_t dwKeyIndex, DirectX::XMFLOAT3& Position, DirectX::XMFLOAT4& Orientation, DirectX::XMFLOAT3& Scale);
+
+    void AddQuantizationStats(ExportQuantizationStats& Total, const ExportQuantizationStats& Stats) noexcept;
+    void LogQuantizationStats(const CHAR* strAnimationName, size_t dwTrackCount, const ExportQuantizationStats& Stats);
+}
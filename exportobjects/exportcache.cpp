@@ -0,0 +1,539 @@
+//-------------------------------------------------------------------------------------
+// ExportCache.cpp
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "exportcache.h"
+
+using namespace ATG;
+
+namespace
+{
+    constexpr const CHAR* CACHE_ENTRY_HEADER = "ContentExporterCache 1";
+    constexpr const CHAR* CACHE_ENTRY_FILENAME = "entry.txt";
+    constexpr const CHAR* TEXTURE_CACHE_SUBDIRECTORY = "textures";
+    constexpr size_t SETTINGS_BUFFER_SIZE = 32 * 1024;
+    constexpr DWORD CACHE_LOCK_POLL_INTERVAL = 50;
+
+    constexpr ULONGLONG FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr ULONGLONG FNV_PRIME = 1099511628211ULL;
+
+    // Settings that change how an export runs but not what it writes.  Leaving them out
+    // of the key lets batch children, single runs and other machines share entries.
+    const CHAR* const s_strRuntimeOnlySettings[] = { "workerthreads", "forcetextureoverwrite" };
+
+    ULONGLONG HashBytes(ULONGLONG qwHash, const void* pData, size_t dwSize) noexcept
+    {
+        auto pBytes = static_cast<const BYTE*>(pData);
+        for (size_t i = 0; i < dwSize; ++i)
+        {
+            qwHash ^= pBytes[i];
+            qwHash *= FNV_PRIME;
+        }
+        return qwHash;
+    }
+
+    ULONGLONG HashString(ULONGLONG qwHash, const CHAR* strValue) noexcept
+    {
+        // Include the terminator so adjacent strings cannot run together.
+        return HashBytes(qwHash, strValue, strlen(strValue) + 1);
+    }
+
+    bool HashFileContents(const CHAR* strFileName, ULONGLONG& qwHash, ULONGLONG& qwSize)
+    {
+        HANDLE hFile = CreateFileA(strFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER FileSize = {};
+        if (!GetFileSizeEx(hFile, &FileSize))
+        {
+            CloseHandle(hFile);
+            return false;
+        }
+
+        qwSize = static_cast<ULONGLONG>(FileSize.QuadPart);
+        qwHash = FNV_OFFSET_BASIS;
+        if (qwSize == 0)
+        {
+            CloseHandle(hFile);
+            return true;
+        }
+
+        bool bResult = false;
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hMapping)
+        {
+            const void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            if (pView)
+            {
+                qwHash = HashBytes(qwHash, pView, static_cast<size_t>(qwSize));
+                UnmapViewOfFile(pView);
+                bResult = true;
+            }
+            CloseHandle(hMapping);
+        }
+        CloseHandle(hFile);
+        return bResult;
+    }
+
+    // Hashes marshaled "name=value;" settings, skipping the runtime-only ones.
+    ULONGLONG HashOutputSettings(ULONGLONG qwHash, const CHAR* strSettings) noexcept
+    {
+        const CHAR* strEntry = strSettings;
+        while (*strEntry)
+        {
+            const CHAR* strEnd = strchr(strEntry, ';');
+            const size_t dwLength = strEnd ? static_cast<size_t>(strEnd - strEntry) : strlen(strEntry);
+            const CHAR* strEquals = static_cast<const CHAR*>(memchr(strEntry, '=', dwLength));
+            const size_t dwNameLength = strEquals ? static_cast<size_t>(strEquals - strEntry) : dwLength;
+
+            bool bRuntimeOnly = false;
+            for (const CHAR* strName : s_strRuntimeOnlySettings)
+            {
+                if (strlen(strName) == dwNameLength && _strnicmp(strEntry, strName, dwNameLength) == 0)
+                {
+                    bRuntimeOnly = true;
+                    break;
+                }
+            }
+            if (!bRuntimeOnly)
+            {
+                // Include the separator so adjacent entries cannot run together.
+                qwHash = HashBytes(qwHash, strEntry, dwLength);
+                qwHash = HashBytes(qwHash, ";", 1);
+            }
+
+            if (!strEnd)
+                break;
+            strEntry = strEnd + 1;
+        }
+        return qwHash;
+    }
+
+    void StripNewline(CHAR* strLine)
+    {
+        CHAR* strNewline = strpbrk(strLine, "\r\n");
+        if (strNewline)
+        {
+            *strNewline = '\0';
+        }
+    }
+}
+
+ExportCache::ExportCache()
+    : m_bEnabled(false),
+    m_qwInputSize(0)
+{
+}
+
+bool ExportCache::Initialize(const CHAR* strCacheDirectory)
+{
+    m_bEnabled = false;
+
+    CHAR strFullPath[MAX_PATH];
+    const DWORD dwLength = GetFullPathNameA(strCacheDirectory, MAX_PATH, strFullPath, nullptr);
+    if (dwLength == 0 || dwLength >= MAX_PATH)
+    {
+        ExportLog::LogError("Invalid export cache directory \"%s\".", strCacheDirectory);
+        return false;
+    }
+
+    if (!CreateDirectoryA(strFullPath, nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        ExportLog::LogError("Could not create export cache directory \"%s\".", strFullPath);
+        return false;
+    }
+
+    m_CacheDirectory.SetPathOnly(strFullPath);
+    m_bEnabled = true;
+    ExportLog::LogMsg(2, "Using export cache directory \"%s\".", (const CHAR*)m_CacheDirectory);
+    return true;
+}
+
+bool ExportCache::BeginFile(const ExportPath& InputFileName, const ExportPath& OutputFileName, const CHAR* strExporterVersion)
+{
+    m_EntryDirectory = ExportPath();
+    m_Outputs.clear();
+    m_Dependencies.clear();
+
+    if (!m_bEnabled)
+        return false;
+
+    ULONGLONG qwInputHash = 0;
+    if (!HashFileContents(InputFileName, qwInputHash, m_qwInputSize))
+    {
+        ExportLog::LogWarning("Could not read \"%s\" for the export cache.", (const CHAR*)InputFileName);
+        return false;
+    }
+
+    auto strSettings = std::make_unique<CHAR[]>(SETTINGS_BUFFER_SIZE);
+    strSettings[0] = '\0';
+    if (!g_SettingsManager.MarshalAllSettings(strSettings.get(), static_cast<DWORD>(SETTINGS_BUFFER_SIZE), false))
+    {
+        ExportLog::LogWarning("Could not marshal export settings for the export cache.");
+        return false;
+    }
+
+    // The file names are part of the key since the outputs are restored in place, and
+    // some settings (such as animation renaming) derive content from the input name.
+    ULONGLONG qwContextHash = FNV_OFFSET_BASIS;
+    qwContextHash = HashString(qwContextHash, strExporterVersion);
+    qwContextHash = HashString(qwContextHash, InputFileName);
+    qwContextHash = HashString(qwContextHash, OutputFileName);
+    qwContextHash = HashOutputSettings(qwContextHash, strSettings.get());
+
+    CHAR strEntryName[64];
+    sprintf_s(strEntryName, "%016llx%016llx", qwInputHash, qwContextHash);
+
+    CHAR strEntryPath[MAX_PATH];
+    sprintf_s(strEntryPath, "%s%s", (const CHAR*)m_CacheDirectory, strEntryName);
+    m_EntryDirectory.SetPathOnly(strEntryPath);
+
+    ExportLog::LogMsg(4, "Export cache key for \"%s\" is %s.", (const CHAR*)InputFileName, strEntryName);
+    return true;
+}
+
+bool ExportCache::GetFileStamp(const CHAR* strFileName, FileStamp& Stamp)
+{
+    WIN32_FILE_ATTRIBUTE_DATA Data = {};
+    if (!GetFileAttributesExA(strFileName, GetFileExInfoStandard, &Data))
+        return false;
+    if (Data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        return false;
+
+    Stamp.FileName = strFileName;
+    Stamp.qwSize = (static_cast<ULONGLONG>(Data.nFileSizeHigh) << 32) | Data.nFileSizeLow;
+    Stamp.qwWriteTime = (static_cast<ULONGLONG>(Data.ftLastWriteTime.dwHighDateTime) << 32) | Data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+void ExportCache::AddUniqueFile(FileStampVector& Files, const CHAR* strFileName)
+{
+    if (!strFileName || !strFileName[0])
+        return;
+
+    for (const auto& File : Files)
+    {
+        if (_stricmp(File.FileName, strFileName) == 0)
+            return;
+    }
+
+    FileStamp Stamp;
+    Stamp.FileName = strFileName;
+    Stamp.qwSize = 0;
+    Stamp.qwWriteTime = 0;
+    Files.push_back(Stamp);
+}
+
+void ExportCache::AddOutputFile(const CHAR* strFileName)
+{
+    AddUniqueFile(m_Outputs, strFileName);
+}
+
+void ExportCache::AddDependency(const CHAR* strFileName)
+{
+    AddUniqueFile(m_Dependencies, strFileName);
+}
+
+void ExportCache::AddManifestFiles(ExportManifest* pManifest)
+{
+    const size_t dwFileCount = pManifest->GetFileCount();
+    for (size_t i = 0; i < dwFileCount; ++i)
+    {
+        const auto& File = pManifest->GetFile(i);
+        const bool bTexture = (File.FileType == EFT_TEXTURE2D || File.FileType == EFT_TEXTURECUBE || File.FileType == EFT_TEXTUREVOLUME);
+        if (bTexture)
+        {
+            // Source textures live outside the FBX file, so changes to them must
+            // invalidate the entry just like changes to the input file.
+            AddDependency(File.strSourceFileName.SafeString());
+            if (File.strSourceFileName == File.strIntermediateFileName)
+                continue;
+        }
+        AddOutputFile(File.strIntermediateFileName.SafeString());
+    }
+}
+
+bool ExportCache::ReadEntry(FileStampVector& Outputs, FileStampVector& Dependencies) const
+{
+    CHAR strEntryFileName[MAX_PATH];
+    sprintf_s(strEntryFileName, "%s%s", (const CHAR*)m_EntryDirectory, CACHE_ENTRY_FILENAME);
+
+    FILE* fp = nullptr;
+    fopen_s(&fp, strEntryFileName, "rt");
+    if (!fp)
+        return false;
+
+    bool bValid = false;
+    CHAR strLine[MAX_PATH + 128];
+    if (fgets(strLine, ARRAYSIZE(strLine), fp))
+    {
+        StripNewline(strLine);
+        bValid = (strcmp(strLine, CACHE_ENTRY_HEADER) == 0);
+    }
+
+    ULONGLONG qwInputSize = ~0ULL;
+    while (bValid && fgets(strLine, ARRAYSIZE(strLine), fp))
+    {
+        StripNewline(strLine);
+
+        FileStamp Stamp = {};
+        INT iPathOffset = 0;
+        if (sscanf_s(strLine, "input %llu", &qwInputSize) == 1)
+        {
+            continue;
+        }
+        else if (sscanf_s(strLine, "dep %llu %llu %n", &Stamp.qwSize, &Stamp.qwWriteTime, &iPathOffset) == 2 && iPathOffset > 0)
+        {
+            Stamp.FileName = strLine + iPathOffset;
+            Dependencies.push_back(Stamp);
+        }
+        else if (sscanf_s(strLine, "out %llu %llu %n", &Stamp.qwSize, &Stamp.qwWriteTime, &iPathOffset) == 2 && iPathOffset > 0)
+        {
+            Stamp.FileName = strLine + iPathOffset;
+            Outputs.push_back(Stamp);
+        }
+        else
+        {
+            bValid = false;
+        }
+    }
+    fclose(fp);
+
+    // The input hash is only 64 bits wide, so also check the size as a cheap guard.
+    return bValid && (qwInputSize == m_qwInputSize) && !Outputs.empty();
+}
+
+bool ExportCache::RestoreOutputs()
+{
+    if (!m_bEnabled || m_EntryDirectory.IsEmpty())
+        return false;
+
+    FileStampVector Outputs;
+    FileStampVector Dependencies;
+    if (!ReadEntry(Outputs, Dependencies))
+    {
+        ExportLog::LogMsg(3, "Export cache miss.");
+        return false;
+    }
+
+    for (const auto& Dependency : Dependencies)
+    {
+        FileStamp Current;
+        if (!GetFileStamp(Dependency.FileName, Current) || Current.qwSize != Dependency.qwSize || Current.qwWriteTime != Dependency.qwWriteTime)
+        {
+            ExportLog::LogMsg(3, "Export cache entry is stale; dependency \"%s\" has changed.", (const CHAR*)Dependency.FileName);
+            return false;
+        }
+    }
+
+    const size_t dwOutputCount = Outputs.size();
+    for (size_t i = 0; i < dwOutputCount; ++i)
+    {
+        const auto& Output = Outputs[i];
+
+        // CopyFile preserves the write time, so an output restored earlier still
+        // matches its recorded stamp and does not need to be copied again.
+        FileStamp Current;
+        if (GetFileStamp(Output.FileName, Current) && Current.qwSize == Output.qwSize && Current.qwWriteTime == Output.qwWriteTime)
+        {
+            ExportLog::LogMsg(4, "Output file \"%s\" is up to date.", (const CHAR*)Output.FileName);
+            continue;
+        }
+
+        CHAR strCachedFileName[MAX_PATH];
+        sprintf_s(strCachedFileName, "%s%zu.bin", (const CHAR*)m_EntryDirectory, i);
+        if (!CopyFileA(strCachedFileName, Output.FileName, FALSE))
+        {
+            ExportLog::LogWarning("Could not restore \"%s\" from the export cache.", (const CHAR*)Output.FileName);
+            return false;
+        }
+        ExportLog::LogMsg(2, "Restored \"%s\" from the export cache.", (const CHAR*)Output.FileName);
+    }
+
+    return true;
+}
+
+bool ExportCache::StoreOutputs()
+{
+    if (!m_bEnabled || m_EntryDirectory.IsEmpty())
+        return false;
+
+    if (!CreateDirectoryA(m_EntryDirectory, nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        ExportLog::LogWarning("Could not create export cache entry \"%s\".", (const CHAR*)m_EntryDirectory);
+        return false;
+    }
+
+    // Remove the old entry before any cached output is overwritten, so neither a failed
+    // copy nor another batch job can pair it with a mix of old and new outputs.
+    CHAR strEntryFileName[MAX_PATH];
+    sprintf_s(strEntryFileName, "%s%s", (const CHAR*)m_EntryDirectory, CACHE_ENTRY_FILENAME);
+    if (!DeleteFileA(strEntryFileName) && GetLastError() != ERROR_FILE_NOT_FOUND)
+    {
+        ExportLog::LogWarning("Could not replace export cache entry \"%s\".", strEntryFileName);
+        return false;
+    }
+
+    FileStampVector Outputs;
+    for (const auto& Output : m_Outputs)
+    {
+        FileStamp Stamp;
+        if (!GetFileStamp(Output.FileName, Stamp))
+            continue;
+
+        CHAR strCachedFileName[MAX_PATH];
+        sprintf_s(strCachedFileName, "%s%zu.bin", (const CHAR*)m_EntryDirectory, Outputs.size());
+        if (!CopyFileA(Output.FileName, strCachedFileName, FALSE))
+        {
+            ExportLog::LogWarning("Could not copy \"%s\" into the export cache.", (const CHAR*)Output.FileName);
+            return false;
+        }
+        Outputs.push_back(Stamp);
+    }
+
+    if (Outputs.empty())
+        return false;
+
+    // Write the entry under a temporary name and rename it into place, so a partially
+    // written entry is never mistaken for a valid one.
+    CHAR strTempFileName[MAX_PATH];
+    sprintf_s(strTempFileName, "%sentry.tmp", (const CHAR*)m_EntryDirectory);
+
+    FILE* fp = nullptr;
+    fopen_s(&fp, strTempFileName, "wt");
+    if (!fp)
+    {
+        ExportLog::LogWarning("Could not write export cache entry \"%s\".", strEntryFileName);
+        return false;
+    }
+
+    fprintf(fp, "%s\n", CACHE_ENTRY_HEADER);
+    fprintf(fp, "input %llu\n", m_qwInputSize);
+    for (const auto& Dependency : m_Dependencies)
+    {
+        FileStamp Stamp;
+        if (GetFileStamp(Dependency.FileName, Stamp))
+        {
+            fprintf(fp, "dep %llu %llu %s\n", Stamp.qwSize, Stamp.qwWriteTime, (const CHAR*)Stamp.FileName);
+        }
+    }
+    for (const auto& Output : Outputs)
+    {
+        fprintf(fp, "out %llu %llu %s\n", Output.qwSize, Output.qwWriteTime, (const CHAR*)Output.FileName);
+    }
+    fclose(fp);
+
+    if (!MoveFileExA(strTempFileName, strEntryFileName, MOVEFILE_REPLACE_EXISTING))
+    {
+        ExportLog::LogWarning("Could not write export cache entry \"%s\".", strEntryFileName);
+        DeleteFileA(strTempFileName);
+        return false;
+    }
+
+    ExportLog::LogMsg(3, "Stored %zu output file(s) in the export cache.", Outputs.size());
+    return true;
+}
+
+bool ExportCache::GetTextureCacheFileName(const CHAR* strSourceFileName, const CHAR* strConversionKey, const CHAR* strExtension, ExportPath& CacheFileName) const
+{
+    if (!m_bEnabled)
+        return false;
+
+    ULONGLONG qwSourceHash = 0;
+    ULONGLONG qwSourceSize = 0;
+    if (!HashFileContents(strSourceFileName, qwSourceHash, qwSourceSize))
+        return false;
+
+    const ULONGLONG qwConversionHash = HashBytes(HashString(FNV_OFFSET_BASIS, strConversionKey), &qwSourceSize, sizeof(qwSourceSize));
+
+    CHAR strDirectory[MAX_PATH];
+    sprintf_s(strDirectory, "%s%s", (const CHAR*)m_CacheDirectory, TEXTURE_CACHE_SUBDIRECTORY);
+    if (!CreateDirectoryA(strDirectory, nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+        return false;
+
+    if (*strExtension == '.')
+    {
+        ++strExtension;
+    }
+
+    CHAR strFileName[MAX_PATH];
+    sprintf_s(strFileName, "%s\\%016llx%016llx.%s", strDirectory, qwSourceHash, qwConversionHash, strExtension);
+    CacheFileName = strFileName;
+    return true;
+}
+
+bool ExportCache::CreateFileLocked(const ExportPath& FileName, bool bForceRecreate, const std::function<bool(const CHAR* strTempFileName)>& ProduceFunc)
+{
+    CHAR strLockFileName[MAX_PATH];
+    sprintf_s(strLockFileName, "%s.lock", (const CHAR*)FileName);
+
+    for (;;)
+    {
+        if (!bForceRecreate && ExportManifest::FileExists(FileName))
+            return true;
+
+        // The lock file is deleted when its handle closes, including when the owning
+        // process exits abnormally, so a crashed producer cannot wedge the cache.
+        HANDLE hLock = CreateFileA(strLockFileName, GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if (hLock == INVALID_HANDLE_VALUE)
+        {
+            const DWORD dwError = GetLastError();
+            if (dwError != ERROR_FILE_EXISTS && dwError != ERROR_ACCESS_DENIED && dwError != ERROR_SHARING_VIOLATION)
+                return false;
+
+            // Someone else is producing this file; whatever they write is fresh.
+            bForceRecreate = false;
+            Sleep(CACHE_LOCK_POLL_INTERVAL);
+            continue;
+        }
+
+        if (!bForceRecreate && ExportManifest::FileExists(FileName))
+        {
+            CloseHandle(hLock);
+            return true;
+        }
+
+        // Keep the extension on the temporary name, since writers pick the file format from it.
+        ExportPath TempFileName(FileName);
+        TempFileName.AppendToFileName(".partial");
+
+        bool bResult = ProduceFunc(TempFileName);
+        if (bResult)
+        {
+            bResult = (MoveFileExA(TempFileName, FileName, MOVEFILE_REPLACE_EXISTING) != FALSE);
+        }
+        if (!bResult)
+        {
+            DeleteFileA(TempFileName);
+        }
+
+        CloseHandle(hLock);
+        return bResult;
+    }
+}
+
+bool ExportCache::CopyFileIfChanged(const CHAR* strSourceFileName, const CHAR* strDestFileName)
+{
+    FileStamp Source;
+    FileStamp Dest;
+    if (GetFileStamp(strSourceFileName, Source) && GetFileStamp(strDestFileName, Dest)
+        && Source.qwSize == Dest.qwSize && Source.qwWriteTime == Dest.qwWriteTime)
+    {
+        return true;
+    }
+
+    // Concurrent exporters may share the destination, so it is replaced under a lock.
+    return CreateFileLocked(strDestFileName, true,
+        [&](const CHAR* strTempFileName) -> bool
+        {
+            return CopyFileA(strSourceFileName, strTempFileName, FALSE) != FALSE;
+        });
+}
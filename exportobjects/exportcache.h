@@ -0,0 +1,81 @@
+//-------------------------------------------------------------------------------------
+// ExportCache.h
+//
+// Persistent on-disk cache of export outputs, keyed by the contents of the input file,
+// the current export settings, and the exporter version.  A cache hit restores the
+// previously written output files without importing the scene again.
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+#pragma once
+
+#include <functional>
+
+namespace ATG
+{
+    class ExportManifest;
+
+    class ExportCache
+    {
+    public:
+        ExportCache();
+
+        // Enables the cache, creating the cache directory if it does not exist.
+        bool Initialize(const CHAR* strCacheDirectory);
+        bool IsEnabled() const noexcept { return m_bEnabled; }
+
+        // Hashes the input file and the marshalled settings, and selects the cache entry
+        // for this export.  Must be called after all settings have been applied.
+        bool BeginFile(const ExportPath& InputFileName, const ExportPath& OutputFileName, const CHAR* strExporterVersion);
+
+        // Copies the cached outputs of the current entry to their destinations.  Returns
+        // false on a cache miss, or if any dependency changed since the entry was stored.
+        bool RestoreOutputs();
+
+        // Records files for the current entry; call these after a successful export.
+        void AddOutputFile(const CHAR* strFileName);
+        void AddDependency(const CHAR* strFileName);
+        void AddManifestFiles(ExportManifest* pManifest);
+
+        // Copies the recorded outputs into the cache and writes the entry.
+        bool StoreOutputs();
+
+        // Returns the cache location for a converted texture, keyed by the contents of
+        // the source file and a string describing the conversion parameters.
+        bool GetTextureCacheFileName(const CHAR* strSourceFileName, const CHAR* strConversionKey, const CHAR* strExtension, ExportPath& CacheFileName) const;
+
+        // Calls ProduceFunc to write a file unless it already exists.  Producers are
+        // serialized through a lock file and write a temporary file that is renamed into
+        // place, so exporters that run concurrently create each file only once and never
+        // see a partly written one.
+        static bool CreateFileLocked(const ExportPath& FileName, bool bForceRecreate, const std::function<bool(const CHAR* strTempFileName)>& ProduceFunc);
+
+        // Copies a file unless the destination already has the same size and write time.
+        // The copy keeps the source's write time, so an unchanged source is copied once.
+        static bool CopyFileIfChanged(const CHAR* strSourceFileName, const CHAR* strDestFileName);
+
+    protected:
+        struct FileStamp
+        {
+            ExportPath  FileName;
+            ULONGLONG   qwSize;
+            ULONGLONG   qwWriteTime;
+        };
+        using FileStampVector = std::vector<FileStamp>;
+
+        static bool GetFileStamp(const CHAR* strFileName, FileStamp& Stamp);
+        static void AddUniqueFile(FileStampVector& Files, const CHAR* strFileName);
+        bool ReadEntry(FileStampVector& Outputs, FileStampVector& Dependencies) const;
+
+        bool            m_bEnabled;
+        ExportPath      m_CacheDirectory;
+        ExportPath      m_EntryDirectory;
+        ULONGLONG       m_qwInputSize;
+        FileStampVector m_Outputs;
+        FileStampVector m_Dependencies;
+    };
+}
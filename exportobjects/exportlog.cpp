@@ -11,6 +11,8 @@
 #include "stdafx.h"
 #include "exportlog.h"
 
+#include <mutex>
+
 namespace ATG
 {
     bool g_bLoggingEnabled = true;
@@ -27,17 +29,23 @@ namespace ATG
 
     CHAR g_strBuf[4096];
     void BroadcastMessage(UINT uMessageType, const CHAR* strMsg);
+
+    // Meshes and other objects may be processed on worker threads, so the shared
+    // message buffer, counters and listeners are only touched under this lock.
+    std::recursive_mutex g_LogMutex;
 }
 
 using namespace ATG;
 
 void ExportLog::AddListener(ILogListener* pListener)
 {
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     g_Listeners.push_back(pListener);
 }
 
 void ExportLog::ClearListeners()
 {
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     g_Listeners.clear();
 }
 
@@ -58,6 +66,7 @@ UINT ExportLog::GetLogLevel()
 
 bool ExportLog::GenerateLogReport(bool bEchoWarningsAndErrors)
 {
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     LogMsg(0, "%zu warning(s), %zu error(s).", g_dwWarningCount, g_dwErrorCount);
     if (!bEchoWarningsAndErrors)
         return (g_dwErrorCount > 0);
@@ -83,6 +92,7 @@ bool ExportLog::GenerateLogReport(bool bEchoWarningsAndErrors)
 
 void ExportLog::ResetCounters()
 {
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     StringList::iterator iter = g_WarningsList.begin();
     StringList::iterator end = g_WarningsList.end();
     while (iter != end)
@@ -131,6 +141,7 @@ void ATG::BroadcastMessage(UINT uMessageType, const CHAR* strMsg)
 
 void ExportLog::LogCommand(DWORD dwCommand, void* pData)
 {
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     LogListenerList::iterator iter = g_Listeners.begin();
     const LogListenerList::iterator end = g_Listeners.end();
 
@@ -146,6 +157,7 @@ void ExportLog::LogMsg(UINT uImportance, _In_z_ _Printf_format_string_ const CHA
 {
     if (!g_bLoggingEnabled || (uImportance > g_uLogLevel))
         return;
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     va_list args;
     va_start(args, strFormat);
     vsprintf_s(g_strBuf, strFormat, args);
@@ -168,6 +180,7 @@ void ExportLog::LogError(_In_z_ _Printf_format_string_ const CHAR* strFormat, ..
     if (!g_bLoggingEnabled)
         return;
 
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     ++g_dwErrorCount;
 
     strcpy_s(g_strBuf, "ERROR: ");
@@ -184,6 +197,7 @@ void ExportLog::LogWarning(_In_z_ _Printf_format_string_ const CHAR* strFormat,
     if (!g_bLoggingEnabled)
         return;
 
+    std::lock_guard<std::recursive_mutex> lock(g_LogMutex);
     ++g_dwWarningCount;
 
     strcpy_s(g_strBuf, "WARNING: ");
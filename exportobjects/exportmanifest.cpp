@@ -248,9 +248,10 @@ void ExportTextureConverter::ProcessTextureParameter(ExportMaterialParameter* pP
     pManifest->AddFile(fr);
 }
 
-void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileName, DXGI_FORMAT CompressedFormat, DXGI_FORMAT HDRFormat, bool bNormalMap)
+bool ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileName, DXGI_FORMAT CompressedFormat, DXGI_FORMAT HDRFormat, bool bNormalMap)
 {
     const bool iscompressed = IsCompressed(CompressedFormat) && g_bIntermediateDDSFormat;
+    bool bResult = true;
 
     if (bNormalMap)
     {
@@ -289,7 +290,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not load texture \"%s\" (DDS: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
-            return;
+            return false;
         }
     }
     else if (_stricmp(ext, ".tga") == 0)
@@ -298,7 +299,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not load texture \"%s\" (TGA: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
-            return;
+            return false;
         }
     }
     else if (_stricmp(ext, ".hdr") == 0)
@@ -308,7 +309,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not load texture \"%s\" (HDR: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
-            return;
+            return false;
         }
     }
     else if (_stricmp(ext, ".exr") == 0)
@@ -319,11 +320,11 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not load texture \"%s\" (EXR: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
-            return;
+            return false;
         }
 #else
         ExportLog::LogError("OpenEXR not supported for this build of the content exporter\n");
-        return;
+        return false;
 #endif
     }
     else
@@ -336,7 +337,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not load texture \"%s\" (WIC: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
-            return;
+            return false;
         }
     }
 
@@ -390,6 +391,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not compute normal map for \"%s\" (%08X).", strSourceFileName, static_cast<unsigned int>(hr));
+            bResult = false;
         }
         else
         {
@@ -409,6 +411,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Could not convert \"%s\" (%08X).", strSourceFileName, static_cast<unsigned int>(hr));
+            bResult = false;
         }
         else
         {
@@ -428,6 +431,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
         if (FAILED(hr))
         {
             ExportLog::LogError("Failing generating mimaps for \"%s\" (WIC: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
+            bResult = false;
         }
         else
         {
@@ -452,6 +456,7 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
             if (FAILED(hr))
             {
                 ExportLog::LogError("Failing compressing \"%s\" (WIC: %08X).", strSourceFileName, static_cast<unsigned int>(hr));
+                bResult = false;
             }
             else
             {
@@ -488,16 +493,116 @@ void ConvertImageFormat(const CHAR* strSourceFileName, const CHAR* strDestFileNa
     if (FAILED(hr))
     {
         ExportLog::LogError("Could not write texture to file \"%s\" (%08X).", strDestFileName, static_cast<unsigned int>(hr));
+        return false;
+    }
+
+    return bResult;
+}
+
+bool ConvertImageFormatCached(ExportCache* pCache, const ExportFileRecord& File, bool bNormalMap)
+{
+    // Everything that changes the converted pixels goes into the key, including the
+    // exporter version for codec changes; the destination name does not, so a texture
+    // shared by many scenes is converted only once.
+    const auto& Settings = g_pScene->Settings();
+    CHAR strConversionKey[256];
+    sprintf_s(strConversionKey, "ver=%s;fmt=%d;hdr=%d;nmap=%d;dds=%d;bgr=%d;nosrgb=%d;mips=%d", g_pScene->Information().ExporterName.SafeString(),
+        static_cast<int>(File.CompressedTextureFormat), static_cast<int>(File.HDRTextureFormat), bNormalMap ? 1 : 0,
+        g_bIntermediateDDSFormat ? 1 : 0, Settings.bBGRvsRGB ? 1 : 0, Settings.bIgnoreSRGB ? 1 : 0, Settings.bGenerateTextureMipMaps ? 1 : 0);
+
+    char ext[_MAX_EXT];
+    _splitpath_s(File.strIntermediateFileName.SafeString(), nullptr, 0, nullptr, 0, nullptr, 0, ext, _MAX_EXT);
+
+    ExportPath CacheFileName;
+    if (!pCache->GetTextureCacheFileName(File.strSourceFileName, strConversionKey, ext, CacheFileName))
+        return false;
+
+    const bool bConverted = ExportCache::CreateFileLocked(CacheFileName, false,
+        [&](const CHAR* strTempFileName) -> bool
+        {
+            return ConvertImageFormat(File.strSourceFileName, strTempFileName, File.CompressedTextureFormat, File.HDRTextureFormat, bNormalMap);
+        });
+    if (!bConverted)
+        return false;
+
+    ExportLog::LogMsg(4, "Copying converted texture \"%s\" from the texture cache to \"%s\".", File.strSourceFileName.SafeString(), File.strIntermediateFileName.SafeString());
+    if (!ExportCache::CopyFileIfChanged(CacheFileName, File.strIntermediateFileName))
+    {
+        // The caller converts the texture directly instead
+        ExportLog::LogWarning("Could not copy texture \"%s\" from the texture cache.", File.strIntermediateFileName.SafeString());
+        return false;
     }
+    return true;
 }
 
-void ExportTextureConverter::PerformTextureFileOperations(ExportManifest* pManifest)
+void PerformTextureFileOperation(const ExportFileRecord& File, ExportCache* pCache)
+{
+    // The main thread initializes COM, but the worker threads need it for WIC as well.
+    const HRESULT hrCOM = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    // Batch exports run several exporter processes that may share texture destinations,
+    // so destinations are written under a lock, through a temporary file.
+    const bool bForceOverwrite = g_pScene->Settings().bForceTextureOverwrite;
+
+    // pCache is null when the cache is disabled or bypassed.
+    switch (File.TextureOperation)
+    {
+    case ETO_NOTHING:
+        // Copy file to intermediate location.
+        ExportLog::LogMsg(4, "Copying texture \"%s\" to \"%s\"...", File.strSourceFileName.SafeString(), File.strIntermediateFileName.SafeString());
+        if (pCache)
+        {
+            // An existing destination may be stale, so compare it against the source.
+            ExportCache::CopyFileIfChanged(File.strSourceFileName, File.strIntermediateFileName);
+        }
+        else
+        {
+            ExportCache::CreateFileLocked(File.strIntermediateFileName, bForceOverwrite,
+                [&](const CHAR* strTempFileName) -> bool
+                {
+                    return CopyFile(File.strSourceFileName, strTempFileName, false) != FALSE;
+                });
+        }
+        ExportLog::LogMsg(4, "Texture copy complete.");
+        break;
+    case ETO_CONVERTFORMAT:
+    case ETO_BUMPMAP_TO_NORMALMAP:
+    {
+        // Convert source file to intermediate location, converting bump maps to normal maps.
+        const bool bNormalMap = (File.TextureOperation == ETO_BUMPMAP_TO_NORMALMAP);
+        if (pCache && ConvertImageFormatCached(pCache, File, bNormalMap))
+            break;
+        ExportCache::CreateFileLocked(File.strIntermediateFileName, bForceOverwrite,
+            [&](const CHAR* strTempFileName) -> bool
+            {
+                return ConvertImageFormat(File.strSourceFileName, strTempFileName, File.CompressedTextureFormat, File.HDRTextureFormat, bNormalMap);
+            });
+        break;
+    }
+    }
+
+    if (SUCCEEDED(hrCOM))
+    {
+        CoUninitialize();
+    }
+}
+
+void ExportTextureConverter::PerformTextureFileOperations(ExportManifest* pManifest, ExportCache* pCache)
 {
     if (g_pScene->Settings().bForceTextureOverwrite)
     {
         ExportLog::LogMsg(4, "Reprocessing and overwriting all destination textures.");
     }
 
+    // Forcing an overwrite bypasses the texture cache rather than rewriting shared entries.
+    bool bUseCache = pCache && pCache->IsEnabled();
+    if (bUseCache && g_pScene->Settings().bForceTextureOverwrite)
+    {
+        ExportLog::LogMsg(3, "Texture overwriting is forced; bypassing the texture cache.");
+        bUseCache = false;
+    }
+
+    std::vector<size_t> Jobs;
     for (size_t i = 0; i < pManifest->GetFileCount(); i++)
     {
         const auto& File = pManifest->GetFile(i);
@@ -509,29 +614,26 @@ void ExportTextureConverter::PerformTextureFileOperations(ExportManifest* pManif
         if (File.strSourceFileName == File.strIntermediateFileName)
             continue;
 
-        if (ExportManifest::FileExists(File.strIntermediateFileName.SafeString()) && !g_pScene->Settings().bForceTextureOverwrite)
+        // With the texture cache an existing destination may be stale, so it is compared
+        // against the cached conversion, or the source for a plain copy, instead.
+        if (!bUseCache && ExportManifest::FileExists(File.strIntermediateFileName.SafeString()) && !g_pScene->Settings().bForceTextureOverwrite)
         {
             ExportLog::LogMsg(4, "Destination texture file \"%s\" already exists.", File.strIntermediateFileName.SafeString());
             continue;
         }
 
-        switch (File.TextureOperation)
-        {
-        case ETO_NOTHING:
-            // Copy file to intermediate location.
-            ExportLog::LogMsg(4, "Copying texture \"%s\" to \"%s\"...", File.strSourceFileName.SafeString(), File.strIntermediateFileName.SafeString());
-            CopyFile(File.strSourceFileName, File.strIntermediateFileName, false);
-            ExportLog::LogMsg(4, "Texture copy complete.");
-            break;
-        case ETO_CONVERTFORMAT:
-            // Convert source file to intermediate location.
-            ConvertImageFormat(File.strSourceFileName, File.strIntermediateFileName, File.CompressedTextureFormat, File.HDRTextureFormat, false);
-            break;
-        case ETO_BUMPMAP_TO_NORMALMAP:
-            // Convert source file to a normal map, copy to intermediate file location.
-            ConvertImageFormat(File.strSourceFileName, File.strIntermediateFileName, File.CompressedTextureFormat, File.HDRTextureFormat, true);
-            break;
-        }
+        Jobs.push_back(i);
     }
+
+    if (Jobs.empty())
+        return;
+
+    ExportLog::LogMsg(3, "Processing %zu texture file(s) on up to %u thread(s).", Jobs.size(), GetExportWorkerThreadCount());
+
+    // Each job writes a distinct destination file, since the manifest is keyed by it.
+    ExportParallelFor(Jobs.size(), [&](size_t i)
+        {
+            PerformTextureFileOperation(pManifest->GetFile(Jobs[i]), bUseCache ? pCache : nullptr);
+        });
 }
 
@@ -65,6 +65,7 @@ namespace ATG
     };
 
     class ExportScene;
+    class ExportCache;
     class ExportMaterial;
     class ExportMaterialParameter;
 
@@ -72,7 +73,7 @@ namespace ATG
     {
     public:
         static void ProcessScene(ExportScene* pScene, ExportManifest* pManifest, const ExportPath& TextureSubPath, bool bIntermediateDDSFormat);
-        static void PerformTextureFileOperations(ExportManifest* pManifest);
+        static void PerformTextureFileOperations(ExportManifest* pManifest, ExportCache* pCache = nullptr);
 
     protected:
         static void ProcessMaterial(ExportMaterial* pMaterial, ExportManifest* pManifest);
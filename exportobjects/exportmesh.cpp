@@ -14,6 +14,7 @@
 #include "DirectXMesh.h"
 #include "UVAtlas.h"
 
+#include <atomic>
 #include <conio.h>
 
 using namespace DirectX;
@@ -91,71 +92,76 @@ namespace
     }
 
 
-    void TransformAndWriteVector(BYTE* pDest, XMFLOAT3* normal, const XMFLOAT3& Src, DWORD dwDestFormat)
+    // Packing kernels.  Each one converts a whole stream into a strided destination
+    // with the format switch hoisted out of the loop, so the per-vertex work is a few
+    // straight-line DirectXMath operations.
+    template<class TStoreFunc>
+    void PackStream(BYTE* pDest, size_t DestStride, const XMFLOAT3* pSrc, size_t Count, TStoreFunc StoreFunc)
     {
-        XMFLOAT3 SrcTransformed;
-        g_pScene->GetDCCTransformer()->TransformDirection(&SrcTransformed, &Src);
+        for (size_t i = 0; i < Count; ++i, pDest += DestStride)
+        {
+            StoreFunc(pDest, XMLoadFloat3(&pSrc[i]));
+        }
+    }
 
-        if (normal)
+    template<class TStoreFunc>
+    void PackStream(BYTE* pDest, size_t DestStride, const XMFLOAT4* pSrc, size_t Count, TStoreFunc StoreFunc)
+    {
+        for (size_t i = 0; i < Count; ++i, pDest += DestStride)
         {
-            memcpy(normal, &SrcTransformed, sizeof(XMFLOAT3));
+            StoreFunc(pDest, XMLoadFloat4(&pSrc[i]));
         }
+    }
 
+    // Packs already transformed normals, tangents or binormals.
+    void PackVectorStream(BYTE* pDest, size_t DestStride, const XMFLOAT3* pSrc, size_t Count, DWORD dwDestFormat)
+    {
         switch (dwDestFormat)
         {
         case D3DDECLTYPE_FLOAT3:
-        {
-            *reinterpret_cast<XMFLOAT3*>(pDest) = SrcTransformed;
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(p), v); });
             break;
-        }
+
         case D3DDECLTYPE_UBYTE4N: // Biased to get normals [-1,1] into range
-        {
-            XMVECTOR v = XMLoadFloat3(&SrcTransformed);
-            v = v * g_XMOneHalf;
-            v += g_XMOneHalf;
-            v = XMVectorSelect(g_XMOne, v, g_XMSelect1110);
-            XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(pDest), v);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v)
+            {
+                XMVECTOR b = XMVectorAdd(XMVectorMultiply(v, g_XMOneHalf), g_XMOneHalf);
+                b = XMVectorSelect(g_XMOne, b, g_XMSelect1110);
+                XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(p), b);
+            });
             break;
-        }
+
         case D3DDECLTYPE_SHORT4N:
-        {
-            *reinterpret_cast<XMSHORTN4*>(pDest) = XMSHORTN4(SrcTransformed.x, SrcTransformed.y, SrcTransformed.z, 1);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreShortN4(reinterpret_cast<XMSHORTN4*>(p), XMVectorSetW(v, 1.0f)); });
             break;
-        }
+
         case D3DDECLTYPE_FLOAT16_4:
-        {
-            *reinterpret_cast<XMHALF4*>(pDest) = XMHALF4(SrcTransformed.x, SrcTransformed.y, SrcTransformed.z, 1);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreHalf4(reinterpret_cast<XMHALF4*>(p), XMVectorSetW(v, 1.0f)); });
             break;
-        }
-        case D3DDECLTYPE_DXGI_R10G10B10A2_UNORM: // Biased to get normals [-1,1] into range
-        {
-            XMVECTOR v = XMLoadFloat3(&SrcTransformed);
-            v = v * g_XMOneHalf;
-            v += g_XMOneHalf;
 
-            XMStoreUDecN4(reinterpret_cast<XMUDECN4*>(pDest), v);
+        case D3DDECLTYPE_DXGI_R10G10B10A2_UNORM: // Biased to get normals [-1,1] into range
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v)
+            {
+                XMStoreUDecN4(reinterpret_cast<XMUDECN4*>(p), XMVectorAdd(XMVectorMultiply(v, g_XMOneHalf), g_XMOneHalf));
+            });
             break;
-        }
-        case D3DDECLTYPE_DXGI_R11G11B10_FLOAT: // Biased to get normals [-1,1] into range
-        {
-            XMVECTOR v = XMLoadFloat3(&SrcTransformed);
-            v = v * g_XMOneHalf;
-            v += g_XMOneHalf;
 
-            XMStoreFloat3PK(reinterpret_cast<XMFLOAT3PK*>(pDest), v);
+        case D3DDECLTYPE_DXGI_R11G11B10_FLOAT: // Biased to get normals [-1,1] into range
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v)
+            {
+                XMStoreFloat3PK(reinterpret_cast<XMFLOAT3PK*>(p), XMVectorAdd(XMVectorMultiply(v, g_XMOneHalf), g_XMOneHalf));
+            });
             break;
-        }
+
         case D3DDECLTYPE_DXGI_R8G8B8A8_SNORM:
-        {
-            *reinterpret_cast<XMBYTEN4*>(pDest) = XMBYTEN4(SrcTransformed.x, SrcTransformed.y, SrcTransformed.z, 1);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreByteN4(reinterpret_cast<XMBYTEN4*>(p), XMVectorSetW(v, 1.0f)); });
             break;
-        }
+
         case D3DDECLTYPE_XBOX_R10G10B10_SNORM_A2_UNORM:
-        {
             // Xbox One specific format
-            *reinterpret_cast<XMXDECN4*>(pDest) = XMXDECN4(SrcTransformed.x, SrcTransformed.y, SrcTransformed.z, 1);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreXDecN4(reinterpret_cast<XMXDECN4*>(p), XMVectorSetW(v, 1.0f)); });
             break;
-        }
+
         default:
             assert(false);
             break;
@@ -163,54 +169,81 @@ namespace
     }
 
 
-    void WriteColor(BYTE* pDest, const XMFLOAT4& Src, DWORD dwDestFormat)
+    void PackColorStream(BYTE* pDest, size_t DestStride, const XMFLOAT4* pSrc, size_t Count, DWORD dwDestFormat)
     {
         static const XMVECTORF32 s_8BitBias = { 0.5f / 255.f, 0.5f / 255.f, 0.5f / 255.f, 0.5f / 255.f };
 
         switch (dwDestFormat)
         {
         case D3DDECLTYPE_D3DCOLOR:
-        {
-            XMVECTOR clr = XMLoadFloat4(&Src);
-            clr = XMVectorAdd(clr, s_8BitBias);
-            XMStoreColor(reinterpret_cast<XMCOLOR*>(pDest), clr);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreColor(reinterpret_cast<XMCOLOR*>(p), XMVectorAdd(v, s_8BitBias)); });
             break;
-        }
+
         case D3DDECLTYPE_UBYTE4N:
-        {
-            XMVECTOR clr = XMLoadFloat4(&Src);
-            clr = XMVectorAdd(clr, s_8BitBias);
-            XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(pDest), clr);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(p), XMVectorAdd(v, s_8BitBias)); });
             break;
-        }
+
         case D3DDECLTYPE_FLOAT4:
-            *reinterpret_cast<XMFLOAT4*>(pDest) = Src;
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(p), v); });
             break;
+
         case D3DDECLTYPE_FLOAT16_4:
-            *reinterpret_cast<XMHALF4*>(pDest) = XMHALF4(Src.x, Src.y, Src.z, Src.z);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreHalf4(reinterpret_cast<XMHALF4*>(p), XMVectorSwizzle<0, 1, 2, 2>(v)); });
             break;
+
         case D3DDECLTYPE_DXGI_R10G10B10A2_UNORM:
-        {
-            const XMVECTOR clr = XMLoadFloat4(&Src);
-            XMStoreUDecN4(reinterpret_cast<XMUDECN4*>(pDest), clr);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreUDecN4(reinterpret_cast<XMUDECN4*>(p), v); });
             break;
-        }
+
         case D3DDECLTYPE_DXGI_R11G11B10_FLOAT:
-        {
-            const XMVECTOR clr = XMLoadFloat4(&Src);
-            XMStoreFloat3PK(reinterpret_cast<XMFLOAT3PK*>(pDest), clr);
+            PackStream(pDest, DestStride, pSrc, Count, [](BYTE* p, FXMVECTOR v) { XMStoreFloat3PK(reinterpret_cast<XMFLOAT3PK*>(p), v); });
             break;
-        }
+
         default:
             assert(false);
             break;
         }
     }
-}
 
-namespace ATG
-{
-    ExportMeshTriangleAllocator g_MeshTriangleAllocator;
+
+    // Packs bone weights as UBYTE4N and bone indices as UBYTE4.  Weights are truncated
+    // to 8 bits and then renormalized so each vertex sums to exactly 255.
+    void PackSkinDataStream(BYTE* pDest, size_t DestStride, const XMFLOAT4* pWeights, const XMUBYTE4* pIndices, size_t Count)
+    {
+        static const XMVECTORF32 s_UByteMax = { 255.0f, 255.0f, 255.0f, 255.0f };
+
+        for (size_t i = 0; i < Count; ++i, pDest += DestStride)
+        {
+            const XMVECTOR v = XMVectorTruncate(XMVectorMultiply(XMLoadFloat4(&pWeights[i]), s_UByteMax));
+            XMStoreUByte4(reinterpret_cast<XMUBYTE4*>(pDest), v);
+            NormalizeBoneWeights(pDest);
+            memcpy(pDest + 4, &pIndices[i], sizeof(XMUBYTE4));
+        }
+    }
+
+
+    // Writes one texture coordinate stream, reading Count vertices of SrcStride bytes.
+    void PackTexCoordStream(BYTE* pDest, size_t DestStride, const float* pSrc, size_t SrcStride, size_t Count, UINT uComponents, bool bHalf)
+    {
+        if (bHalf && uComponents > 1)
+        {
+            // One batched float-to-half conversion per component, which uses F16C when
+            // DirectXMath is built with it.  A third component is padded to four by the
+            // zeroed vertex buffer.
+            for (UINT c = 0; c < uComponents; ++c)
+            {
+                XMConvertFloatToHalfStream(reinterpret_cast<HALF*>(pDest) + c, DestStride, pSrc + c, SrcStride, Count);
+            }
+            return;
+        }
+
+        const size_t uSize = uComponents * sizeof(float);
+        auto pSrcBytes = reinterpret_cast<const BYTE*>(pSrc);
+        for (size_t i = 0; i < Count; ++i, pDest += DestStride, pSrcBytes += SrcStride)
+        {
+            memcpy(pDest, pSrcBytes, uSize);
+        }
+    }
 }
 
 using namespace ATG;
@@ -252,11 +285,7 @@ ExportMesh::~ExportMesh()
 
 void ExportMesh::ClearRawTriangles()
 {
-    if (m_RawTriangles.size() > 0)
-    {
-        g_MeshTriangleAllocator.ClearAllTriangles();
-        m_RawTriangles.clear();
-    }
+    m_RawTriangles.Clear();
 }
 
 void ExportMesh::ByteSwap()
@@ -387,147 +416,302 @@ void ExportIB::Allocate()
     }
 }
 
-void ExportMeshTriangleAllocator::Terminate()
+ExportMeshRawTriangleStreams::ExportMeshRawTriangleStreams()
+    : m_bInitialized(false),
+    m_bNormals(false),
+    m_bColors(false),
+    m_bSkinData(false),
+    m_uUVSetCount(0),
+    m_uUVSetSize(0)
 {
-    AllocationBlockList::iterator iter = m_AllocationBlocks.begin();
-    const AllocationBlockList::iterator end = m_AllocationBlocks.end();
-    while (iter != end)
-    {
-        AllocationBlock& block = *iter;
-        delete[] block.pTriangleArray;
-        ++iter;
-    }
-    m_AllocationBlocks.clear();
-    m_uTotalCount = 0;
-    m_uAllocatedCount = 0;
 }
 
-void ExportMeshTriangleAllocator::SetSizeHint(UINT uAnticipatedSize)
+void ExportMeshRawTriangleStreams::Initialize(const ExportVertexFormat& Format)
 {
-    if (uAnticipatedSize <= m_uTotalCount)
-        return;
-    const UINT uNewCount = std::max<UINT>(uAnticipatedSize - m_uTotalCount, 10000);
-    AllocationBlock NewBlock;
-    NewBlock.m_uTriangleCount = uNewCount;
-    NewBlock.pTriangleArray = new ExportMeshTriangle[uNewCount];
-    m_AllocationBlocks.push_back(NewBlock);
-    m_uTotalCount += uNewCount;
+    Clear();
+    m_bNormals = Format.m_bNormal;
+    m_bColors = Format.m_bVertexColor;
+    m_bSkinData = Format.m_bSkinData;
+    m_uUVSetCount = std::min<UINT>(Format.m_uUVSetCount, 8);
+    m_uUVSetSize = std::min<UINT>(Format.m_uUVSetSize, 4);
+    m_bInitialized = true;
 }
 
-ExportMeshTriangle* ExportMeshTriangleAllocator::GetNewTriangle()
+void ExportMeshRawTriangleStreams::Reserve(size_t uTriangleCount)
 {
-    if (m_uAllocatedCount == m_uTotalCount)
-        SetSizeHint(m_uTotalCount + 10000);
-    UINT uIndex = m_uAllocatedCount;
-    m_uAllocatedCount++;
-    AllocationBlockList::iterator iter = m_AllocationBlocks.begin();
-    const AllocationBlockList::iterator end = m_AllocationBlocks.end();
-    while (iter != end)
-    {
-        AllocationBlock& block = *iter;
-        if (uIndex < block.m_uTriangleCount)
+    assert(m_bInitialized);
+    const size_t uCornerCount = uTriangleCount * 3;
+    m_SubsetIndices.reserve(uTriangleCount);
+    m_PolygonIndices.reserve(uTriangleCount);
+    m_DCCVertexIndices.reserve(uCornerCount);
+    m_Positions.reserve(uCornerCount);
+    if (m_bNormals)
+        m_Normals.reserve(uCornerCount);
+    if (m_bColors)
+        m_Colors.reserve(uCornerCount);
+    if (m_bSkinData)
+    {
+        m_BoneIndices.reserve(uCornerCount);
+        m_BoneWeights.reserve(uCornerCount);
+    }
+    m_TexCoords.reserve(uCornerCount * m_uUVSetCount * m_uUVSetSize);
+}
+
+void ExportMeshRawTriangleStreams::AddTriangle(const ExportMeshTriangle* pTriangle)
+{
+    assert(m_bInitialized);
+    m_SubsetIndices.push_back(pTriangle->SubsetIndex);
+    m_PolygonIndices.push_back(pTriangle->PolygonIndex);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const ExportMeshVertex& Vertex = pTriangle->Vertex[i];
+        m_DCCVertexIndices.push_back(Vertex.DCCVertexIndex);
+        m_Positions.push_back(Vertex.Position);
+        if (m_bNormals)
+            m_Normals.push_back(Vertex.Normal);
+        if (m_bColors)
+            m_Colors.push_back(Vertex.Color);
+        if (m_bSkinData)
+        {
+            m_BoneIndices.push_back(Vertex.BoneIndices);
+            m_BoneWeights.push_back(Vertex.BoneWeights);
+        }
+        for (UINT t = 0; t < m_uUVSetCount; ++t)
         {
-            ExportMeshTriangle* pTriangle = &block.pTriangleArray[uIndex];
-            pTriangle->Initialize();
-            return pTriangle;
+            const float* pTexCoord = &Vertex.TexCoords[t].x;
+            m_TexCoords.insert(m_TexCoords.end(), pTexCoord, pTexCoord + m_uUVSetSize);
         }
-        uIndex -= block.m_uTriangleCount;
-        ++iter;
     }
-    assert(false);
-    return nullptr;
 }
 
-void ExportMeshTriangleAllocator::ClearAllTriangles()
+void ExportMeshRawTriangleStreams::GetVertex(size_t uCorner, ExportMeshVertex* pVertex) const
 {
-    m_uAllocatedCount = 0;
+    pVertex->Initialize();
+    pVertex->DCCVertexIndex = m_DCCVertexIndices[uCorner];
+    pVertex->Position = m_Positions[uCorner];
+    if (m_bNormals)
+        pVertex->Normal = m_Normals[uCorner];
+    if (m_bColors)
+        pVertex->Color = m_Colors[uCorner];
+    if (m_bSkinData)
+    {
+        pVertex->BoneIndices = m_BoneIndices[uCorner];
+        pVertex->BoneWeights = m_BoneWeights[uCorner];
+    }
+    if (m_uUVSetCount > 0)
+    {
+        const float* pSrc = GetTexCoords(uCorner);
+        for (UINT t = 0; t < m_uUVSetCount; ++t)
+        {
+            memcpy(&pVertex->TexCoords[t], pSrc, m_uUVSetSize * sizeof(float));
+            pSrc += m_uUVSetSize;
+        }
+    }
 }
 
-bool ExportMeshVertex::Equals(const ExportMeshVertex* pOtherVertex) const
+void ExportMeshRawTriangleStreams::Clear()
 {
-    if (!pOtherVertex)
-        return false;
-
-    if (pOtherVertex == this)
-        return true;
-
-    XMVECTOR v0 = XMLoadFloat3(&Position);
-    XMVECTOR v1 = XMLoadFloat3(&pOtherVertex->Position);
-    if (XMVector3NotEqual(v0, v1))
-        return false;
-
-    v0 = XMLoadFloat3(&Normal);
-    v1 = XMLoadFloat3(&pOtherVertex->Normal);
-    if (XMVector3NotEqual(v0, v1))
-        return false;
-
-    for (size_t i = 0; i < 8; i++)
-    {
-        v0 = XMLoadFloat4(&TexCoords[i]);
-        v1 = XMLoadFloat4(&pOtherVertex->TexCoords[i]);
-        if (XMVector4NotEqual(v0, v1))
-            return false;
-    }
-
-    v0 = XMLoadFloat4(&Color);
-    v1 = XMLoadFloat4(&pOtherVertex->Color);
-    if (XMVector4NotEqual(v0, v1))
-        return false;
+    // swap with empty containers so the storage is released, not just emptied
+    std::vector<INT>().swap(m_SubsetIndices);
+    std::vector<INT>().swap(m_PolygonIndices);
+    std::vector<UINT>().swap(m_DCCVertexIndices);
+    std::vector<XMFLOAT3>().swap(m_Positions);
+    std::vector<XMFLOAT3>().swap(m_Normals);
+    std::vector<XMFLOAT4>().swap(m_Colors);
+    std::vector<XMUBYTE4>().swap(m_BoneIndices);
+    std::vector<XMFLOAT4>().swap(m_BoneWeights);
+    std::vector<float>().swap(m_TexCoords);
+    m_bInitialized = false;
+}
 
-    return true;
+size_t ExportMeshRawTriangleStreams::GetMemoryUsage() const noexcept
+{
+    return m_SubsetIndices.capacity() * sizeof(INT)
+        + m_PolygonIndices.capacity() * sizeof(INT)
+        + m_DCCVertexIndices.capacity() * sizeof(UINT)
+        + m_Positions.capacity() * sizeof(XMFLOAT3)
+        + m_Normals.capacity() * sizeof(XMFLOAT3)
+        + m_Colors.capacity() * sizeof(XMFLOAT4)
+        + m_BoneIndices.capacity() * sizeof(XMUBYTE4)
+        + m_BoneWeights.capacity() * sizeof(XMFLOAT4)
+        + m_TexCoords.capacity() * sizeof(float);
 }
 
-UINT FindOrAddVertex(ExportMeshVertexArray& ExistingVertexArray, ExportMeshVertex* pTestVertex)
+void ExportMesh::ReserveRawTriangles(size_t uTriangleCount)
 {
-    for (size_t i = 0; i < ExistingVertexArray.size(); i++)
-    {
-        ExportMeshVertex* pVertex = ExistingVertexArray[i];
-        if (pVertex->Equals(pTestVertex))
-            return static_cast<UINT>(i);
-    }
-    const UINT index = static_cast<UINT>(ExistingVertexArray.size());
-    ExistingVertexArray.push_back(pTestVertex);
-    return index;
+    // The vertex format must be complete before any raw triangles are stored
+    if (!m_RawTriangles.IsInitialized())
+        m_RawTriangles.Initialize(m_VertexFormat);
+    m_RawTriangles.Reserve(uTriangleCount);
 }
 
-void ExportMesh::AddRawTriangle(ExportMeshTriangle* pTriangle)
+void ExportMesh::AddRawTriangle(const ExportMeshTriangle* pTriangle)
 {
-    m_RawTriangles.push_back(pTriangle);
+    if (!m_RawTriangles.IsInitialized())
+        m_RawTriangles.Initialize(m_VertexFormat);
+    m_RawTriangles.AddTriangle(pTriangle);
     m_uDCCVertexCount = std::max<UINT>(m_uDCCVertexCount, pTriangle->Vertex[0].DCCVertexIndex + 1);
     m_uDCCVertexCount = std::max<UINT>(m_uDCCVertexCount, pTriangle->Vertex[1].DCCVertexIndex + 1);
     m_uDCCVertexCount = std::max<UINT>(m_uDCCVertexCount, pTriangle->Vertex[2].DCCVertexIndex + 1);
 }
 
-UINT FindOrAddVertexFast(ExportMeshVertexArray& ExistingVertexArray, ExportMeshVertex* pTestVertex)
+namespace
 {
-    UINT uIndex = pTestVertex->DCCVertexIndex;
-    assert(uIndex < ExistingVertexArray.size());
-    ExportMeshVertex* pVertex = ExistingVertexArray[uIndex];
-    if (pVertex)
-    {
-        ExportMeshVertex* pLastVertex = nullptr;
-        while (pVertex)
+    constexpr UINT INVALID_VERTEX_INDEX = UINT32_MAX;
+
+    //---------------------------------------------------------------------------------
+    // Collapses raw triangle corners into unique vertices.  Only the attributes that
+    // are present in the raw triangle streams are hashed and compared, and candidates
+    // are looked up through hash buckets, so the cost per corner stays constant no
+    // matter how many seams split a single DCC vertex.
+    //---------------------------------------------------------------------------------
+    class VertexWelder
+    {
+    public:
+        VertexWelder(const ExportMeshRawTriangleStreams& Streams, size_t nDCCVertexCount)
+            : m_Streams(Streams),
+            m_uTexCoordCount(Streams.GetUVSetCount() * Streams.GetUVSetSize()),
+            m_uDCCVertexCount(nDCCVertexCount),
+            m_uEntryCount(0)
         {
-            uIndex = pVertex->DCCVertexIndex;
-            if (pVertex->Equals(pTestVertex))
-                return uIndex;
-            pLastVertex = pVertex;
-            pVertex = pVertex->pNextDuplicateVertex;
+            size_t nBuckets = 1024;
+            while (nBuckets < nDCCVertexCount * 2)
+                nBuckets <<= 1;
+            m_BucketHeads.resize(nBuckets, INVALID_VERTEX_INDEX);
+            m_NextInBucket.resize(nDCCVertexCount, INVALID_VERTEX_INDEX);
+            m_Hashes.resize(nDCCVertexCount, 0);
         }
-        assert(pVertex == nullptr);
-        uIndex = static_cast<UINT>(ExistingVertexArray.size());
-        ExistingVertexArray.push_back(pTestVertex);
-        pTestVertex->DCCVertexIndex = uIndex;
-        if (pLastVertex)
+
+        // VertexCorners maps each final vertex to the raw corner it was taken from.
+        // The first corner seen for a DCC vertex keeps the DCC index as its final
+        // index; distinct corners that share the DCC vertex are appended at the end.
+        UINT FindOrAddVertex(std::vector<UINT>& VertexCorners, UINT uCorner)
         {
-            pLastVertex->pNextDuplicateVertex = pTestVertex;
+            const UINT uDCCIndex = m_Streams.GetDCCVertexIndex(uCorner);
+            assert(uDCCIndex < m_uDCCVertexCount);
+            const uint32_t uHash = HashCorner(uCorner);
+
+            if (VertexCorners[uDCCIndex] == INVALID_VERTEX_INDEX)
+            {
+                VertexCorners[uDCCIndex] = uCorner;
+                AddEntry(uDCCIndex, uHash);
+                return uDCCIndex;
+            }
+
+            const size_t uBucket = uHash & (m_BucketHeads.size() - 1);
+            for (UINT uIndex = m_BucketHeads[uBucket]; uIndex != INVALID_VERTEX_INDEX; uIndex = m_NextInBucket[uIndex])
+            {
+                if (m_Hashes[uIndex] != uHash)
+                    continue;
+                const UINT uOtherCorner = VertexCorners[uIndex];
+                if (m_Streams.GetDCCVertexIndex(uOtherCorner) == uDCCIndex && CornerEquals(uOtherCorner, uCorner))
+                    return uIndex;
+            }
+
+            const auto uNewIndex = static_cast<UINT>(VertexCorners.size());
+            VertexCorners.push_back(uCorner);
+            m_NextInBucket.push_back(INVALID_VERTEX_INDEX);
+            m_Hashes.push_back(0);
+            AddEntry(uNewIndex, uHash);
+            return uNewIndex;
         }
-    }
-    else
-    {
-        ExistingVertexArray[uIndex] = pTestVertex;
-    }
-    return uIndex;
+
+    private:
+        static inline uint32_t HashFloat(uint32_t uHash, float fValue)
+        {
+            // +0 and -0 compare as equal, so they have to hash the same way
+            if (fValue == 0.0f)
+                fValue = 0.0f;
+            uint32_t uBits;
+            memcpy(&uBits, &fValue, sizeof(uint32_t));
+            uHash ^= uBits;
+            uHash *= 0x9E3779B1u;
+            return uHash ^ (uHash >> 15);
+        }
+
+        static inline uint32_t HashFloats(uint32_t uHash, const float* pValues, UINT uCount)
+        {
+            for (UINT i = 0; i < uCount; ++i)
+                uHash = HashFloat(uHash, pValues[i]);
+            return uHash;
+        }
+
+        static inline bool FloatsEqual(const float* pA, const float* pB, UINT uCount)
+        {
+            for (UINT i = 0; i < uCount; ++i)
+            {
+                if (pA[i] != pB[i])
+                    return false;
+            }
+            return true;
+        }
+
+        uint32_t HashCorner(UINT uCorner) const
+        {
+            uint32_t uHash = 0x811C9DC5u ^ m_Streams.GetDCCVertexIndex(uCorner);
+            uHash = HashFloats(uHash, &m_Streams.GetPosition(uCorner).x, 3);
+            if (m_Streams.HasNormals())
+                uHash = HashFloats(uHash, &m_Streams.GetNormal(uCorner).x, 3);
+            if (m_uTexCoordCount > 0)
+                uHash = HashFloats(uHash, m_Streams.GetTexCoords(uCorner), m_uTexCoordCount);
+            if (m_Streams.HasColors())
+                uHash = HashFloats(uHash, &m_Streams.GetColor(uCorner).x, 4);
+            uHash ^= uHash >> 16;
+            uHash *= 0x85EBCA6Bu;
+            uHash ^= uHash >> 13;
+            return uHash;
+        }
+
+        bool CornerEquals(UINT uCornerA, UINT uCornerB) const
+        {
+            if (!FloatsEqual(&m_Streams.GetPosition(uCornerA).x, &m_Streams.GetPosition(uCornerB).x, 3))
+                return false;
+            if (m_Streams.HasNormals() && !FloatsEqual(&m_Streams.GetNormal(uCornerA).x, &m_Streams.GetNormal(uCornerB).x, 3))
+                return false;
+            if (m_uTexCoordCount > 0 && !FloatsEqual(m_Streams.GetTexCoords(uCornerA), m_Streams.GetTexCoords(uCornerB), m_uTexCoordCount))
+                return false;
+            if (m_Streams.HasColors() && !FloatsEqual(&m_Streams.GetColor(uCornerA).x, &m_Streams.GetColor(uCornerB).x, 4))
+                return false;
+            return true;
+        }
+
+        void AddEntry(UINT uIndex, uint32_t uHash)
+        {
+            if (++m_uEntryCount > m_BucketHeads.size())
+                GrowBuckets();
+            const size_t uBucket = uHash & (m_BucketHeads.size() - 1);
+            m_Hashes[uIndex] = uHash;
+            m_NextInBucket[uIndex] = m_BucketHeads[uBucket];
+            m_BucketHeads[uBucket] = uIndex;
+        }
+
+        void GrowBuckets()
+        {
+            const size_t nBuckets = m_BucketHeads.size() * 2;
+            std::vector<UINT> OldHeads(nBuckets, INVALID_VERTEX_INDEX);
+            OldHeads.swap(m_BucketHeads);
+            for (UINT uHead : OldHeads)
+            {
+                UINT uIndex = uHead;
+                while (uIndex != INVALID_VERTEX_INDEX)
+                {
+                    const UINT uNext = m_NextInBucket[uIndex];
+                    const size_t uBucket = m_Hashes[uIndex] & (nBuckets - 1);
+                    m_NextInBucket[uIndex] = m_BucketHeads[uBucket];
+                    m_BucketHeads[uBucket] = uIndex;
+                    uIndex = uNext;
+                }
+            }
+        }
+
+        const ExportMeshRawTriangleStreams& m_Streams;
+        UINT                                m_uTexCoordCount;
+        size_t                              m_uDCCVertexCount;
+        size_t                              m_uEntryCount;
+        std::vector<UINT>                   m_BucketHeads;
+        std::vector<UINT>                   m_NextInBucket;
+        std::vector<uint32_t>               m_Hashes;
+    };
 }
 
 void ExportMesh::SetVertexNormalCount(UINT uCount)
@@ -537,65 +721,67 @@ void ExportMesh::SetVertexNormalCount(UINT uCount)
     m_VertexFormat.m_bBinormal = (uCount > 2);
 }
 
-bool SubsetLess(const  ExportMeshTriangle* pA, const ExportMeshTriangle* pB)
-{
-    return pA->SubsetIndex < pB->SubsetIndex;
-}
-
-void ExportMesh::SortRawTrianglesBySubsetIndex()
+void ExportMesh::SortRawTrianglesBySubsetIndex(std::vector<UINT>& TriangleOrder) const
 {
-    if (m_RawTriangles.empty())
-        return;
+    const size_t dwTriangleCount = m_RawTriangles.GetTriangleCount();
+    TriangleOrder.resize(dwTriangleCount);
+    for (size_t i = 0; i < dwTriangleCount; ++i)
+        TriangleOrder[i] = static_cast<UINT>(i);
 
-    std::stable_sort(m_RawTriangles.begin(), m_RawTriangles.end(), SubsetLess);
+    std::stable_sort(TriangleOrder.begin(), TriangleOrder.end(),
+        [&](UINT uA, UINT uB) { return m_RawTriangles.GetSubsetIndex(uA) < m_RawTriangles.GetSubsetIndex(uB); });
 }
 
 void ExportMesh::Optimize(DWORD dwFlags)
 {
-    if (m_RawTriangles.empty())
+    if (m_RawTriangles.GetTriangleCount() == 0)
         return;
 
-    ExportLog::LogMsg(4, "Optimizing mesh \"%s\" with %zu triangles.", GetName().SafeString(), m_RawTriangles.size());
+    ExportLog::LogMsg(4, "Optimizing mesh \"%s\" with %zu triangles.", GetName().SafeString(), m_RawTriangles.GetTriangleCount());
+    ExportLog::LogMsg(5, "Raw triangle storage is %zu bytes.", m_RawTriangles.GetMemoryUsage());
 
     // Apply a AttributeSort optimization
-    SortRawTrianglesBySubsetIndex();
+    std::vector<UINT> TriangleOrder;
+    SortRawTrianglesBySubsetIndex(TriangleOrder);
 
     ExportIBSubset* pCurrentIBSubset = nullptr;
     INT iCurrentSubsetIndex = -1;
     std::vector<UINT> IndexData;
-    IndexData.reserve(m_RawTriangles.size() * 3);
-    ExportMeshVertexArray VertexData;
-    VertexData.resize(m_uDCCVertexCount, nullptr);
+    IndexData.reserve(m_RawTriangles.GetTriangleCount() * 3);
+    std::vector<UINT> VertexData;
+    VertexData.resize(m_uDCCVertexCount, INVALID_VERTEX_INDEX);
+    VertexWelder Welder(m_RawTriangles, m_uDCCVertexCount);
 
     bool bFlipTriangles = g_pScene->Settings().bFlipTriangles;
     if (dwFlags & FLIP_TRIANGLES)
         bFlipTriangles = !bFlipTriangles;
 
     // loop through raw triangles
-    const size_t dwTriangleCount = m_RawTriangles.size();
+    const size_t dwTriangleCount = m_RawTriangles.GetTriangleCount();
     m_TriangleToPolygonMapping.clear();
     m_TriangleToPolygonMapping.reserve(dwTriangleCount);
 
-    m_pAttributes.reset(new uint32_t[dwTriangleCount]);
+    uint32_t* pAttributes = m_Topology.CreateAttributes(dwTriangleCount);
     for (size_t i = 0; i < dwTriangleCount; i++)
     {
-        ExportMeshTriangle* pTriangle = m_RawTriangles[i];
+        const UINT uTriangle = TriangleOrder[i];
+        const INT iSubsetIndex = m_RawTriangles.GetSubsetIndex(uTriangle);
         // create a new subset if one is encountered
         // note: subset index will be monotonically increasing
-        assert(pTriangle->SubsetIndex >= iCurrentSubsetIndex);
-        if (pTriangle->SubsetIndex > iCurrentSubsetIndex)
+        assert(iSubsetIndex >= iCurrentSubsetIndex);
+        if (iSubsetIndex > iCurrentSubsetIndex)
         {
             pCurrentIBSubset = new ExportIBSubset();
             pCurrentIBSubset->SetName("Default");
             pCurrentIBSubset->SetStartIndex(static_cast<UINT>(IndexData.size()));
             m_vSubsets.push_back(pCurrentIBSubset);
-            iCurrentSubsetIndex = pTriangle->SubsetIndex;
+            iCurrentSubsetIndex = iSubsetIndex;
         }
         // collapse the triangle verts into the final vertex list
         // this removes unnecessary duplicates, and retains necessary duplicates
-        const UINT uIndexA = FindOrAddVertexFast(VertexData, &pTriangle->Vertex[0]);
-        const UINT uIndexB = FindOrAddVertexFast(VertexData, &pTriangle->Vertex[1]);
-        const UINT uIndexC = FindOrAddVertexFast(VertexData, &pTriangle->Vertex[2]);
+        const UINT uIndexA = Welder.FindOrAddVertex(VertexData, uTriangle * 3);
+        const UINT uIndexB = Welder.FindOrAddVertex(VertexData, uTriangle * 3 + 1);
+        const UINT uIndexC = Welder.FindOrAddVertex(VertexData, uTriangle * 3 + 2);
         // record final indices into the index list
         IndexData.push_back(uIndexA);
         if (bFlipTriangles)
@@ -608,8 +794,8 @@ void ExportMesh::Optimize(DWORD dwFlags)
             IndexData.push_back(uIndexB);
             IndexData.push_back(uIndexC);
         }
-        m_pAttributes[i] = static_cast<uint32_t>(iCurrentSubsetIndex);
-        m_TriangleToPolygonMapping.push_back(pTriangle->PolygonIndex);
+        pAttributes[i] = static_cast<uint32_t>(iCurrentSubsetIndex);
+        m_TriangleToPolygonMapping.push_back(m_RawTriangles.GetPolygonIndex(uTriangle));
         pCurrentIBSubset->IncrementIndexCount(3);
     }
     ExportLog::LogMsg(3, "Triangle list mesh: %zu verts, %zu indices, %zu subsets", VertexData.size(), IndexData.size(), m_vSubsets.size());
@@ -713,15 +899,27 @@ void ExportMesh::Optimize(DWORD dwFlags)
         ComputeUVAtlas();
     }
 
-    m_pVBPositions.reset();
+    // Meshlet bounds are computed from the final vertex order, so positions are kept
+    // through vertex cache optimization when meshlets are requested.
+    const bool bGenerateMeshlets = (dwFlags & GENERATE_MESHLETS) != 0;
+    if (!bGenerateMeshlets)
+    {
+        m_pVBPositions.reset();
+    }
 
     if (dwFlags & VCACHE_OPT)
     {
         OptimizeVcache();
     }
 
-    m_pAttributes.reset();
-    m_pAdjacency.reset();
+    if (bGenerateMeshlets)
+    {
+        BuildMeshlets(bFlipTriangles);
+        m_pVBPositions.reset();
+    }
+
+    // Nothing after optimization reads the topology.
+    m_Topology.Reset();
     ClearRawTriangles();
     ComputeBounds();
 
@@ -784,11 +982,11 @@ void ExportMesh::CleanMesh(bool breakBowTies)
     std::vector<uint32_t> dups;
     if (m_pIB->GetIndexSize() == 2)
     {
-        hr = Clean(reinterpret_cast<uint16_t*>(m_pIB->GetIndexData()), nFaces, nVerts, m_pAdjacency.get(), m_pAttributes.get(), dups, breakBowTies);
+        hr = Clean(reinterpret_cast<uint16_t*>(m_pIB->GetIndexData()), nFaces, nVerts, m_Topology.GetAdjacency(), m_Topology.GetAttributes(), dups, breakBowTies);
     }
     else
     {
-        hr = Clean(reinterpret_cast<uint32_t*>(m_pIB->GetIndexData()), nFaces, nVerts, m_pAdjacency.get(), m_pAttributes.get(), dups, breakBowTies);
+        hr = Clean(reinterpret_cast<uint32_t*>(m_pIB->GetIndexData()), nFaces, nVerts, m_Topology.GetAdjacency(), m_Topology.GetAttributes(), dups, breakBowTies);
     }
     if (FAILED(hr))
     {
@@ -864,6 +1062,15 @@ void ExportMesh::CleanMesh(bool breakBowTies)
     m_pVBPositions.swap(pos);
     m_pVBNormals.swap(normals);
     m_pVBTexCoords.swap(texcoords);
+
+    // Cleaning keeps the faces and appends copies of the duplicated vertices.
+    std::vector<uint32_t> vertexRemap(nNewVerts);
+    for (size_t i = 0; i < nVerts; ++i)
+    {
+        vertexRemap[i] = static_cast<uint32_t>(i);
+    }
+    std::copy(dups.cbegin(), dups.cend(), vertexRemap.begin() + nVerts);
+    m_Topology.RemapVertices(vertexRemap.data(), nNewVerts);
 }
 
 void ExportMesh::ComputeVertexTangentSpaces()
@@ -958,12 +1165,129 @@ void ExportMesh::ComputeVertexTangentSpaces()
     writer.reset();
 }
 
+uint32_t* ExportMeshTopology::CreateAttributes(size_t nFaces)
+{
+    Reset();
+    m_nFaces = nFaces;
+    m_pAttributes.reset(new uint32_t[nFaces]);
+    return m_pAttributes.get();
+}
+
+HRESULT ExportMeshTopology::Generate(const ExportIB* pIB, const XMFLOAT3* pPositions, size_t nVerts, float fEpsilon)
+{
+    assert(pIB != nullptr);
+
+    const size_t nFaces = pIB->GetIndexCount() / 3;
+    assert(!m_pAttributes || nFaces == m_nFaces);
+
+    m_pAdjacency.reset(new uint32_t[nFaces * 3]);
+    m_pPointReps.reset(new uint32_t[nVerts]);
+
+    HRESULT hr = E_FAIL;
+    if (pIB->GetIndexSize() == 2)
+    {
+        hr = GenerateAdjacencyAndPointReps(reinterpret_cast<const uint16_t*>(pIB->GetIndexData()), nFaces, pPositions, nVerts, fEpsilon,
+            m_pPointReps.get(), m_pAdjacency.get());
+    }
+    else
+    {
+        hr = GenerateAdjacencyAndPointReps(reinterpret_cast<const uint32_t*>(pIB->GetIndexData()), nFaces, pPositions, nVerts, fEpsilon,
+            m_pPointReps.get(), m_pAdjacency.get());
+    }
+
+    if (FAILED(hr))
+    {
+        m_pAdjacency.reset();
+        m_pPointReps.reset();
+        return hr;
+    }
+
+    m_nFaces = nFaces;
+    m_nVerts = nVerts;
+    return S_OK;
+}
+
+void ExportMeshTopology::RemapVertices(const uint32_t* pVertexRemap, size_t nNewVerts)
+{
+    if (!m_pPointReps)
+        return;
+
+    // Old representatives map to the first new vertex copied from them; a vertex
+    // whose representative was dropped becomes its own representative.
+    std::vector<uint32_t> firstNewVertex(m_nVerts, UINT32_MAX);
+    for (size_t i = 0; i < nNewVerts; ++i)
+    {
+        const uint32_t uOld = pVertexRemap[i];
+        if (uOld != UINT32_MAX && firstNewVertex[uOld] == UINT32_MAX)
+        {
+            firstNewVertex[uOld] = static_cast<uint32_t>(i);
+        }
+    }
+
+    std::unique_ptr<uint32_t[]> pointReps(new uint32_t[nNewVerts]);
+    for (size_t i = 0; i < nNewVerts; ++i)
+    {
+        const uint32_t uOld = pVertexRemap[i];
+        const uint32_t uRep = (uOld != UINT32_MAX) ? firstNewVertex[m_pPointReps[uOld]] : UINT32_MAX;
+        pointReps[i] = (uRep != UINT32_MAX) ? uRep : static_cast<uint32_t>(i);
+    }
+
+    m_pPointReps.swap(pointReps);
+    m_nVerts = nNewVerts;
+}
+
+void ExportMeshTopology::RemapFaces(const uint32_t* pFaceRemap)
+{
+    std::vector<uint32_t> newFaceIndex(m_nFaces, UINT32_MAX);
+    for (size_t i = 0; i < m_nFaces; ++i)
+    {
+        if (pFaceRemap[i] != UINT32_MAX)
+        {
+            newFaceIndex[pFaceRemap[i]] = static_cast<uint32_t>(i);
+        }
+    }
+
+    if (m_pAttributes)
+    {
+        std::unique_ptr<uint32_t[]> attributes(new uint32_t[m_nFaces]);
+        for (size_t i = 0; i < m_nFaces; ++i)
+        {
+            attributes[i] = (pFaceRemap[i] != UINT32_MAX) ? m_pAttributes[pFaceRemap[i]] : 0;
+        }
+        m_pAttributes.swap(attributes);
+    }
+
+    if (m_pAdjacency)
+    {
+        std::unique_ptr<uint32_t[]> adjacency(new uint32_t[m_nFaces * 3]);
+        for (size_t i = 0; i < m_nFaces; ++i)
+        {
+            const uint32_t uOld = pFaceRemap[i];
+            for (size_t j = 0; j < 3; ++j)
+            {
+                const uint32_t uNeighbor = (uOld != UINT32_MAX) ? m_pAdjacency[uOld * 3 + j] : UINT32_MAX;
+                adjacency[i * 3 + j] = (uNeighbor != UINT32_MAX) ? newFaceIndex[uNeighbor] : UINT32_MAX;
+            }
+        }
+        m_pAdjacency.swap(adjacency);
+    }
+}
+
+void ExportMeshTopology::Reset()
+{
+    m_pAttributes.reset();
+    m_pAdjacency.reset();
+    m_pPointReps.reset();
+    m_nFaces = 0;
+    m_nVerts = 0;
+}
+
 void ExportMesh::ComputeAdjacency()
 {
     assert(m_pIB != 0);
     assert(m_pVB != 0);
 
-    if (m_pAdjacency)
+    if (m_Topology.HasAdjacency())
         return;
 
     if (!m_pVBPositions)
@@ -972,54 +1296,47 @@ void ExportMesh::ComputeAdjacency()
         return;
     }
 
-    const size_t nFaces = m_pIB->GetIndexCount() / 3;
     const size_t nVerts = m_pVB->GetVertexCount();
 
-    m_pAdjacency.reset(new uint32_t[nFaces * 3]);
-
     const float epsilon = (g_pScene->Settings().bGeometricAdjacency) ? 1e-5f : 0.f;
 
-    HRESULT hr = E_FAIL;
-    if (m_pIB->GetIndexSize() == 2)
-    {
-        hr = GenerateAdjacencyAndPointReps(reinterpret_cast<const uint16_t*>(m_pIB->GetIndexData()), nFaces, m_pVBPositions.get(), nVerts, epsilon,
-            nullptr, m_pAdjacency.get());
-    }
-    else
-    {
-        hr = GenerateAdjacencyAndPointReps(reinterpret_cast<const uint32_t*>(m_pIB->GetIndexData()), nFaces, m_pVBPositions.get(), nVerts, epsilon,
-            nullptr, m_pAdjacency.get());
-    }
-
+    const HRESULT hr = m_Topology.Generate(m_pIB.get(), m_pVBPositions.get(), nVerts, epsilon);
     if (FAILED(hr))
     {
         ExportLog::LogError("Mesh \"%s\" failed to compute adjacency (%08X).", GetName().SafeString(), static_cast<unsigned int>(hr));
-        m_pAdjacency.reset();
         return;
     }
+
+    ExportLog::LogMsg(4, "Generated adjacency and point reps for %zu faces and %zu verts.", m_pIB->GetIndexCount() / 3, nVerts);
 }
 
+// Meshes are optimized on several threads at once, so only the main thread prints
+// progress and polls the console.  ESC there cancels every atlas still being built.
+static std::atomic<ULONGLONG> s_UVAtlasLastTick(0);
+static std::atomic<bool> s_bUVAtlasCanceled(false);
+
 static HRESULT __cdecl UVAtlasCallback(float fPercentDone)
 {
-    static ULONGLONG s_lastTick = 0;
-
-    const ULONGLONG tick = GetTickCount64();
-
-    if ((tick - s_lastTick) > 1000)
+    if (IsExportMainThread())
     {
-        wprintf(L"%.2f%%   \r", fPercentDone * 100);
-        s_lastTick = tick;
-    }
+        const ULONGLONG tick = GetTickCount64();
 
-    if (_kbhit())
-    {
-        if (_getch() == 27)
+        if ((tick - s_UVAtlasLastTick.load()) > 1000)
         {
-            return E_ABORT;
+            wprintf(L"%.2f%%   \r", fPercentDone * 100);
+            s_UVAtlasLastTick.store(tick);
+        }
+
+        if (_kbhit())
+        {
+            if (_getch() == 27)
+            {
+                s_bUVAtlasCanceled.store(true);
+            }
         }
     }
 
-    return S_OK;
+    return s_bUVAtlasCanceled.load() ? E_ABORT : S_OK;
 }
 
 void ExportMesh::ComputeUVAtlas()
@@ -1037,7 +1354,7 @@ void ExportMesh::ComputeUVAtlas()
 
     ComputeAdjacency();
 
-    if (!m_pAdjacency)
+    if (!m_Topology.HasAdjacency())
     {
         ExportLog::LogError("UV atlas creation failed for mesh \"%s\"; requires adjacency.", GetName().SafeString());
         return;
@@ -1068,7 +1385,7 @@ void ExportMesh::ComputeUVAtlas()
         m_pIB->GetIndexData(), indexFormat, nFaces,
         0, g_pScene->Settings().fUVAtlasMaxStretch, texSize, texSize,
         g_pScene->Settings().fUVAtlasGutter,
-        m_pAdjacency.get(), nullptr,
+        m_Topology.GetAdjacency(), nullptr,
         nullptr,
         UVAtlasCallback, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
         uvOptions, vb, ib,
@@ -1162,6 +1479,9 @@ void ExportMesh::ComputeUVAtlas()
         memcpy(m_pIB->GetIndexData(), ib.data(), sizeof(uint32_t) * 3 * nFaces);
     }
 
+    // The atlas keeps the faces and splits vertices along chart seams.
+    m_Topology.RemapVertices(vertexRemapArray.data(), nNewVerts);
+
     // Invalidate other data
     m_pVBNormals.reset();
     m_pVBTexCoords.reset();
@@ -1190,7 +1510,7 @@ void ExportMesh::OptimizeVcache()
         ExportLog::LogMsg(4, "Optimize mesh for vertex cache (vcache: %u, restart: %u) using Hoppe TVC algorithm...", vertexCache, restart);
     }
 
-    if (!m_pAttributes)
+    if (!m_Topology.GetAttributes())
     {
         ExportLog::LogError("Optimize mesh for vertex cache failed for mesh \"%s\"; requires attributes.", GetName().SafeString());
         return;
@@ -1198,7 +1518,7 @@ void ExportMesh::OptimizeVcache()
 
     ComputeAdjacency();
 
-    if (!m_pAdjacency)
+    if (!m_Topology.HasAdjacency())
     {
         ExportLog::LogError("Optimize mesh for vertex cache failed for mesh \"%s\"; requires adjacency.", GetName().SafeString());
         return;
@@ -1229,21 +1549,21 @@ void ExportMesh::OptimizeVcache()
     {
         if (useLRU)
         {
-            hr = OptimizeFacesLRUEx(reinterpret_cast<const uint16_t*>(m_pIB->GetIndexData()), nFaces, m_pAttributes.get(), faceRemap.get());
+            hr = OptimizeFacesLRUEx(reinterpret_cast<const uint16_t*>(m_pIB->GetIndexData()), nFaces, m_Topology.GetAttributes(), faceRemap.get());
         }
         else
         {
-            hr = OptimizeFacesEx(reinterpret_cast<const uint16_t*>(m_pIB->GetIndexData()), nFaces, m_pAdjacency.get(), m_pAttributes.get(),
+            hr = OptimizeFacesEx(reinterpret_cast<const uint16_t*>(m_pIB->GetIndexData()), nFaces, m_Topology.GetAdjacency(), m_Topology.GetAttributes(),
                 faceRemap.get(), vertexCache, restart);
         }
     }
     else if (useLRU)
     {
-        hr = OptimizeFacesLRUEx(reinterpret_cast<const uint32_t*>(m_pIB->GetIndexData()), nFaces, m_pAttributes.get(), faceRemap.get());
+        hr = OptimizeFacesLRUEx(reinterpret_cast<const uint32_t*>(m_pIB->GetIndexData()), nFaces, m_Topology.GetAttributes(), faceRemap.get());
     }
     else
     {
-        hr = OptimizeFacesEx(reinterpret_cast<const uint32_t*>(m_pIB->GetIndexData()), nFaces, m_pAdjacency.get(), m_pAttributes.get(),
+        hr = OptimizeFacesEx(reinterpret_cast<const uint32_t*>(m_pIB->GetIndexData()), nFaces, m_Topology.GetAdjacency(), m_Topology.GetAttributes(),
             faceRemap.get(), vertexCache, restart);
     }
     if (FAILED(hr))
@@ -1342,15 +1662,142 @@ void ExportMesh::OptimizeVcache()
     m_pIB.swap(newIB);
     m_pVB.swap(newVB);
 
+    // Faces and vertices were only reordered, so the topology is remapped.
+    m_Topology.RemapFaces(faceRemap.get());
+    m_Topology.RemapVertices(vertRemap.get(), nVerts);
+
+    // Positions are only still present when meshlets will be built from them.
+    if (m_pVBPositions)
+    {
+        std::unique_ptr<XMFLOAT3[]> pos(new XMFLOAT3[nVerts]);
+        hr = FinalizeVB(m_pVBPositions.get(), sizeof(XMFLOAT3), nVerts, nullptr, 0, vertRemap.get(), pos.get());
+        if (FAILED(hr))
+        {
+            ExportLog::LogError("Finalize positions for post-transform vertex cache failed for mesh \"%s\" (%08X)", GetName().SafeString(), static_cast<unsigned int>(hr));
+            pos.reset();
+        }
+        m_pVBPositions.swap(pos);
+    }
+
     // Invalidate other data
-    m_pVBPositions.reset();
     m_pVBNormals.reset();
     m_pVBTexCoords.reset();
-    m_pAttributes.reset();
-    m_pAdjacency.reset();
 }
 
-void ExportMesh::BuildVertexBuffer(ExportMeshVertexArray& VertexArray, DWORD dwFlags)
+void ExportMesh::BuildMeshlets(bool bClockwise)
+{
+    assert(m_pIB != 0);
+    assert(m_pVB != 0);
+
+    static_assert(sizeof(ExportMeshlet) == sizeof(Meshlet), "Meshlet layout mismatch");
+    static_assert(sizeof(ExportMeshletCullData) == sizeof(CullData)
+        && offsetof(ExportMeshletCullData, NormalCone) == offsetof(CullData, NormalCone)
+        && offsetof(ExportMeshletCullData, ApexOffset) == offsetof(CullData, ApexOffset), "Meshlet cull data layout mismatch");
+    static_assert(sizeof(MeshletTriangle) == sizeof(uint32_t), "Meshlet triangle layout mismatch");
+
+    if (!g_pScene->Settings().bLittleEndian)
+    {
+        ExportLog::LogWarning("Meshlets are not generated for big-endian output; skipping mesh \"%s\".", GetName().SafeString());
+        return;
+    }
+
+    if (!m_pVBPositions)
+    {
+        ExportLog::LogError("Meshlet generation failed for mesh \"%s\"; requires positions.", GetName().SafeString());
+        return;
+    }
+
+    // Adjacency is optional, but it keeps meshlets spatially coherent.  It is already
+    // cached when the mesh was cleaned or optimized.
+    ComputeAdjacency();
+
+    const size_t nFaces = m_pIB->GetIndexCount() / 3;
+    const size_t nVerts = m_pVB->GetVertexCount();
+    const DWORD indexSize = m_pIB->GetIndexSize();
+    const size_t maxVerts = static_cast<size_t>(g_pScene->Settings().iMeshletMaxVertices);
+    const size_t maxPrims = static_cast<size_t>(g_pScene->Settings().iMeshletMaxPrimitives);
+
+    ExportLog::LogMsg(4, "Generating meshlets (max %zu verts, %zu prims)...", maxVerts, maxPrims);
+
+    const ULONGLONG qwStartTime = GetTickCount64();
+
+    // Meshlets never span subsets, so each subset can be drawn or culled on its own.
+    const size_t nSubsets = m_vSubsets.size();
+    std::vector<std::pair<size_t, size_t>> subsets(nSubsets);
+    for (size_t i = 0; i < nSubsets; ++i)
+    {
+        subsets[i] = std::make_pair(static_cast<size_t>(m_vSubsets[i]->GetStartIndex() / 3), static_cast<size_t>(m_vSubsets[i]->GetIndexCount() / 3));
+    }
+    std::vector<std::pair<size_t, size_t>> meshletSubsets(nSubsets);
+
+    std::vector<Meshlet> meshlets;
+    std::vector<uint8_t> uniqueVertexIB;
+    std::vector<MeshletTriangle> primitiveIndices;
+    HRESULT hr = S_OK;
+    if (indexSize == 2)
+    {
+        hr = ComputeMeshlets(reinterpret_cast<const uint16_t*>(m_pIB->GetIndexData()), nFaces, m_pVBPositions.get(), nVerts,
+            subsets.data(), nSubsets, m_Topology.GetAdjacency(), meshlets, uniqueVertexIB, primitiveIndices, meshletSubsets.data(), maxVerts, maxPrims);
+    }
+    else
+    {
+        hr = ComputeMeshlets(reinterpret_cast<const uint32_t*>(m_pIB->GetIndexData()), nFaces, m_pVBPositions.get(), nVerts,
+            subsets.data(), nSubsets, m_Topology.GetAdjacency(), meshlets, uniqueVertexIB, primitiveIndices, meshletSubsets.data(), maxVerts, maxPrims);
+    }
+    if (FAILED(hr))
+    {
+        ExportLog::LogError("Meshlet generation failed for mesh \"%s\" (%08X)", GetName().SafeString(), static_cast<unsigned int>(hr));
+        return;
+    }
+
+    // Normal cones depend on which side is the front face.
+    std::vector<CullData> cullData(meshlets.size());
+    const MESHLET_FLAGS cullFlags = bClockwise ? MESHLET_WIND_CW : MESHLET_DEFAULT;
+    if (indexSize == 2)
+    {
+        hr = ComputeCullData(m_pVBPositions.get(), nVerts, meshlets.data(), meshlets.size(),
+            reinterpret_cast<const uint16_t*>(uniqueVertexIB.data()), uniqueVertexIB.size() / sizeof(uint16_t),
+            primitiveIndices.data(), primitiveIndices.size(), cullData.data(), cullFlags);
+    }
+    else
+    {
+        hr = ComputeCullData(m_pVBPositions.get(), nVerts, meshlets.data(), meshlets.size(),
+            reinterpret_cast<const uint32_t*>(uniqueVertexIB.data()), uniqueVertexIB.size() / sizeof(uint32_t),
+            primitiveIndices.data(), primitiveIndices.size(), cullData.data(), cullFlags);
+    }
+    if (FAILED(hr))
+    {
+        ExportLog::LogError("Meshlet cull data generation failed for mesh \"%s\" (%08X)", GetName().SafeString(), static_cast<unsigned int>(hr));
+        return;
+    }
+
+    // Commit changes
+    m_Meshlets.uMaxVertices = static_cast<UINT>(maxVerts);
+    m_Meshlets.uMaxPrimitives = static_cast<UINT>(maxPrims);
+    m_Meshlets.Meshlets.resize(meshlets.size());
+    memcpy(m_Meshlets.Meshlets.data(), meshlets.data(), meshlets.size() * sizeof(ExportMeshlet));
+    m_Meshlets.CullData.resize(cullData.size());
+    memcpy(m_Meshlets.CullData.data(), cullData.data(), cullData.size() * sizeof(ExportMeshletCullData));
+    m_Meshlets.UniqueVertexIndices.swap(uniqueVertexIB);
+    m_Meshlets.Primitives.resize(primitiveIndices.size());
+    memcpy(m_Meshlets.Primitives.data(), primitiveIndices.data(), primitiveIndices.size() * sizeof(uint32_t));
+
+    for (size_t i = 0; i < nSubsets; ++i)
+    {
+        m_vSubsets[i]->SetMeshletRange(static_cast<UINT>(meshletSubsets[i].first), static_cast<UINT>(meshletSubsets[i].second));
+    }
+
+    const size_t nMeshlets = meshlets.size();
+    const size_t nUniqueVerts = m_Meshlets.UniqueVertexIndices.size() / indexSize;
+    ExportLog::LogMsg(3, "Meshlets: %zu for %zu subsets; average %.1f verts and %.1f prims per meshlet; %.2f vertex transforms per vertex",
+        nMeshlets, nSubsets,
+        nMeshlets ? static_cast<float>(nUniqueVerts) / static_cast<float>(nMeshlets) : 0.0f,
+        nMeshlets ? static_cast<float>(primitiveIndices.size()) / static_cast<float>(nMeshlets) : 0.0f,
+        nVerts ? static_cast<float>(nUniqueVerts) / static_cast<float>(nVerts) : 0.0f);
+    ExportLog::LogMsg(4, "Meshlet generation took %llu ms.", GetTickCount64() - qwStartTime);
+}
+
+void ExportMesh::BuildVertexBuffer(const std::vector<UINT>& VertexCorners, DWORD dwFlags)
 {
     UINT uVertexSize = 0;
     INT iCurrentVertexOffset = 0;
@@ -1595,7 +2042,7 @@ void ExportMesh::BuildVertexBuffer(ExportMeshVertexArray& VertexArray, DWORD dwF
         return;
 
     // create vertex buffer and allocate storage
-    const size_t nVerts = VertexArray.size();
+    const size_t nVerts = VertexCorners.size();
 
     m_pVB = std::make_unique<ExportVB>();
     m_pVB->SetVertexCount(nVerts);
@@ -1620,115 +2067,166 @@ void ExportMesh::BuildVertexBuffer(ExportMeshVertexArray& VertexArray, DWORD dwF
         memset(m_pVBTexCoords.get(), 0, sizeof(XMFLOAT2) * nVerts);
     }
 
-    // copy raw vertex data into the packed vertex buffer
-    for (size_t i = 0; i < nVerts; i++)
+    // Pack the vertex buffer a chunk at a time: gather each chunk's corners from the raw
+    // triangle streams into contiguous staging arrays, transform them as whole streams,
+    // then quantize one attribute stream at a time into the interleaved vertex buffer.
+    constexpr size_t VERTEX_CHUNK_SIZE = 256;
+
+    const IDCCTransformer* pTransformer = g_pScene->GetDCCTransformer();
+    const size_t VertexStride = uVertexSize;
+
+    const UINT uUVSetSize = m_VertexFormat.m_uUVSetSize;
+    const UINT uUVSetCount = (iUVOffset != -1 && uUVSetSize >= 1 && uUVSetSize <= 4) ? std::min<UINT>(m_VertexFormat.m_uUVSetCount, 8) : 0;
+    const UINT uRawUVSetCount = std::min(m_RawTriangles.GetUVSetCount(), uUVSetCount);
+    const UINT uRawUVSetSize = m_RawTriangles.GetUVSetSize();
+    const UINT uTangentSpaceIndex = g_pScene->Settings().iTangentSpaceIndex;
+    const bool bTangentSpaceTexCoords = (uTangentSpaceIndex < uUVSetCount) && (uUVSetSize > 1);
+
+    // Compressed sets are 1 float or 2 or 4 halfs; uncompressed sets are uUVSetSize floats.
+    const size_t TexCoordSetSize = bCompressVertexData ? ((uUVSetSize == 1 || uUVSetSize == 2) ? 4 : 8) : uUVSetSize * sizeof(float);
+
+    // The raw streams carry no tangent frames (ComputeVertexTangentSpaces generates them
+    // later), so every vertex receives the same packed zero vector.
+    BYTE PackedZeroVector[16] = {};
+    const size_t PackedVectorSize = static_cast<size_t>(GetElementSizeFromDeclType(dwNormalType));
+    if (iTangentOffset != -1 || iBinormalOffset != -1)
     {
-        auto pDestVertex = m_pVB->GetVertex(i);
-        ExportMeshVertex* pSrcVertex = VertexArray[i];
-        if (!pSrcVertex)
+        const XMFLOAT3 Zero(0.0f, 0.0f, 0.0f);
+        XMFLOAT3 ZeroTransformed;
+        pTransformer->TransformDirection(&ZeroTransformed, &Zero);
+        PackVectorStream(PackedZeroVector, 0, &ZeroTransformed, 1, dwNormalType);
+    }
+
+    // Matches the defaults of ExportMeshVertex::Initialize.
+    const XMFLOAT4 DefaultBoneWeights(1.0f, 0.0f, 0.0f, 0.0f);
+    const XMUBYTE4 DefaultBoneIndices(static_cast<uint32_t>(0));
+
+    std::vector<XMFLOAT3> SrcPositions((iPositionOffset != -1) ? VERTEX_CHUNK_SIZE : 0);
+    std::vector<XMFLOAT3> SrcNormals((iNormalOffset != -1) ? VERTEX_CHUNK_SIZE : 0);
+    std::vector<XMFLOAT4> Colors((iColorOffset != -1) ? VERTEX_CHUNK_SIZE : 0);
+    std::vector<XMFLOAT4> BoneWeights((iSkinDataOffset != -1) ? VERTEX_CHUNK_SIZE : 0);
+    std::vector<XMUBYTE4> BoneIndices((iSkinDataOffset != -1) ? VERTEX_CHUNK_SIZE : 0);
+    std::vector<XMFLOAT4> TexCoords(VERTEX_CHUNK_SIZE * uUVSetCount);
+    std::vector<size_t> InvalidVertices;
+
+    for (size_t uChunkStart = 0; uChunkStart < nVerts; uChunkStart += VERTEX_CHUNK_SIZE)
+    {
+        const size_t uChunkCount = std::min(VERTEX_CHUNK_SIZE, nVerts - uChunkStart);
+        BYTE* pChunkVertices = m_pVB->GetVertex(uChunkStart);
+
+        // Gather.  Unused slots are staged as zeros and cleared again after packing.
+        InvalidVertices.clear();
+        if (uUVSetCount > 0)
         {
-            continue;
+            memset(TexCoords.data(), 0, sizeof(XMFLOAT4) * uChunkCount * uUVSetCount);
         }
+        for (size_t i = 0; i < uChunkCount; ++i)
+        {
+            const UINT uCorner = VertexCorners[uChunkStart + i];
+            if (uCorner == INVALID_VERTEX_INDEX)
+            {
+                InvalidVertices.push_back(i);
+                if (iPositionOffset != -1)
+                    SrcPositions[i] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+                if (iNormalOffset != -1)
+                    SrcNormals[i] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+                if (iColorOffset != -1)
+                    Colors[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+                if (iSkinDataOffset != -1)
+                {
+                    BoneWeights[i] = DefaultBoneWeights;
+                    BoneIndices[i] = DefaultBoneIndices;
+                }
+                continue;
+            }
 
+            if (iPositionOffset != -1)
+                SrcPositions[i] = m_RawTriangles.GetPosition(uCorner);
+            if (iNormalOffset != -1)
+                SrcNormals[i] = m_RawTriangles.HasNormals() ? m_RawTriangles.GetNormal(uCorner) : XMFLOAT3(0.0f, 0.0f, 0.0f);
+            if (iColorOffset != -1)
+                Colors[i] = m_RawTriangles.HasColors() ? m_RawTriangles.GetColor(uCorner) : XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f);
+            if (iSkinDataOffset != -1)
+            {
+                if (m_RawTriangles.HasSkinData())
+                {
+                    BoneWeights[i] = m_RawTriangles.GetBoneWeights(uCorner);
+                    BoneIndices[i] = m_RawTriangles.GetBoneIndices(uCorner);
+                }
+                else
+                {
+                    BoneWeights[i] = DefaultBoneWeights;
+                    BoneIndices[i] = DefaultBoneIndices;
+                }
+            }
+            if (uRawUVSetCount > 0)
+            {
+                const float* pSrc = m_RawTriangles.GetTexCoords(uCorner);
+                XMFLOAT4* pDest = &TexCoords[i * uUVSetCount];
+                for (UINT t = 0; t < uRawUVSetCount; ++t)
+                {
+                    memcpy(&pDest[t], pSrc, uRawUVSetSize * sizeof(float));
+                    pSrc += uRawUVSetSize;
+                }
+            }
+        }
+
+        // Transform and pack each stream.
         if (iPositionOffset != -1)
         {
-            auto pDest = reinterpret_cast<XMFLOAT3*>(pDestVertex + iPositionOffset);
-            g_pScene->GetDCCTransformer()->TransformPosition(pDest, &pSrcVertex->Position);
-
-            memcpy(&m_pVBPositions[i], pDest, sizeof(XMFLOAT3));
+            XMFLOAT3* pPositions = &m_pVBPositions[uChunkStart];
+            pTransformer->TransformPositionStream(pPositions, SrcPositions.data(), uChunkCount);
+            PackStream(pChunkVertices + iPositionOffset, VertexStride, pPositions, uChunkCount,
+                [](BYTE* p, FXMVECTOR v) { XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(p), v); });
         }
         if (iNormalOffset != -1)
         {
-            TransformAndWriteVector(pDestVertex + iNormalOffset, &m_pVBNormals[i], pSrcVertex->Normal, dwNormalType);
+            XMFLOAT3* pNormals = &m_pVBNormals[uChunkStart];
+            pTransformer->TransformDirectionStream(pNormals, SrcNormals.data(), uChunkCount);
+            PackVectorStream(pChunkVertices + iNormalOffset, VertexStride, pNormals, uChunkCount, dwNormalType);
         }
         if (iSkinDataOffset != -1)
         {
-            BYTE* pDest = pDestVertex + iSkinDataOffset;
-            BYTE* pBoneWeights = pDest;
-            *pDest++ = static_cast<BYTE>(static_cast<int>(pSrcVertex->BoneWeights.x * 255.0f));
-            *pDest++ = static_cast<BYTE>(static_cast<int>(pSrcVertex->BoneWeights.y * 255.0f));
-            *pDest++ = static_cast<BYTE>(static_cast<int>(pSrcVertex->BoneWeights.z * 255.0f));
-            *pDest++ = static_cast<BYTE>(static_cast<int>(pSrcVertex->BoneWeights.w * 255.0f));
-            NormalizeBoneWeights(pBoneWeights);
-            *pDest++ = pSrcVertex->BoneIndices.x;
-            *pDest++ = pSrcVertex->BoneIndices.y;
-            *pDest++ = pSrcVertex->BoneIndices.z;
-            *pDest++ = pSrcVertex->BoneIndices.w;
+            PackSkinDataStream(pChunkVertices + iSkinDataOffset, VertexStride, BoneWeights.data(), BoneIndices.data(), uChunkCount);
         }
-        if (iTangentOffset != -1)
+        if (iColorOffset != -1)
         {
-            TransformAndWriteVector(pDestVertex + iTangentOffset, nullptr, pSrcVertex->Tangent, dwNormalType);
+            PackColorStream(pChunkVertices + iColorOffset, VertexStride, Colors.data(), uChunkCount, dwColorType);
         }
-        if (iBinormalOffset != -1)
+        for (UINT t = 0; t < uUVSetCount; ++t)
         {
-            TransformAndWriteVector(pDestVertex + iBinormalOffset, nullptr, pSrcVertex->Binormal, dwNormalType);
+            PackTexCoordStream(pChunkVertices + iUVOffset + t * TexCoordSetSize, VertexStride,
+                &TexCoords[t].x, uUVSetCount * sizeof(XMFLOAT4), uChunkCount, uUVSetSize, bCompressVertexData);
         }
-        if (iColorOffset != -1)
+        if (bTangentSpaceTexCoords)
         {
-            WriteColor(pDestVertex + iColorOffset, pSrcVertex->Color, dwColorType);
+            for (size_t i = 0; i < uChunkCount; ++i)
+            {
+                memcpy(&m_pVBTexCoords[uChunkStart + i], &TexCoords[i * uUVSetCount + uTangentSpaceIndex], sizeof(XMFLOAT2));
+            }
         }
-        if (iUVOffset != -1)
+        if (iTangentOffset != -1 || iBinormalOffset != -1)
         {
-            const UINT iTangentSpaceIndex = g_pScene->Settings().iTangentSpaceIndex;
-            if (m_VertexFormat.m_uUVSetCount > iTangentSpaceIndex)
+            BYTE* pDest = pChunkVertices;
+            for (size_t i = 0; i < uChunkCount; ++i, pDest += VertexStride)
             {
-                if (m_VertexFormat.m_uUVSetSize > 1)
-                {
-                    memcpy(&m_pVBTexCoords[i], &pSrcVertex->TexCoords[iTangentSpaceIndex], sizeof(XMFLOAT2));
-                }
+                if (iTangentOffset != -1)
+                    memcpy(pDest + iTangentOffset, PackedZeroVector, PackedVectorSize);
+                if (iBinormalOffset != -1)
+                    memcpy(pDest + iBinormalOffset, PackedZeroVector, PackedVectorSize);
             }
+        }
 
-            if (bCompressVertexData)
-            {
-                auto pDest = reinterpret_cast<DWORD*>(pDestVertex + iUVOffset);
-                for (size_t t = 0; t < m_VertexFormat.m_uUVSetCount; t++)
-                {
-                    switch (m_VertexFormat.m_uUVSetSize)
-                    {
-                    case 1:
-                    {
-                        memcpy(pDest, &pSrcVertex->TexCoords[t], sizeof(float));
-                        pDest++;
-                        break;
-                    }
-                    case 2:
-                    {
-                        auto pFloat16 = reinterpret_cast<HALF*>(pDest);
-                        XMConvertFloatToHalfStream(pFloat16, sizeof(HALF), reinterpret_cast<const float*>(&pSrcVertex->TexCoords[t]), sizeof(float), 2);
-                        pDest++;
-                        break;
-                    }
-                    case 3:
-                    {
-                        pDest[1] = 0;
-                        auto pFloat16 = reinterpret_cast<HALF*>(pDest);
-                        XMConvertFloatToHalfStream(pFloat16, sizeof(HALF), reinterpret_cast<const float*>(&pSrcVertex->TexCoords[t]), sizeof(float), 3);
-                        pDest += 2;
-                        break;
-                    }
-                    case 4:
-                    {
-                        auto pFloat16 = reinterpret_cast<HALF*>(pDest);
-                        XMConvertFloatToHalfStream(pFloat16, sizeof(HALF), reinterpret_cast<const float*>(&pSrcVertex->TexCoords[t]), sizeof(float), 4);
-                        pDest += 2;
-                        break;
-                    }
-                    default:
-                        assert(false);
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                size_t uStride = m_VertexFormat.m_uUVSetSize * sizeof(float);
-                BYTE* pDest = pDestVertex + iUVOffset;
-                for (UINT t = 0; t < m_VertexFormat.m_uUVSetCount; t++)
-                {
-                    memcpy(pDest, &pSrcVertex->TexCoords[t], uStride);
-                    pDest += uStride;
-                }
-            }
+        // Vertices without a source corner stay zeroed, as allocated.
+        for (const size_t i : InvalidVertices)
+        {
+            memset(pChunkVertices + i * VertexStride, 0, VertexStride);
+            if (iPositionOffset != -1)
+                m_pVBPositions[uChunkStart + i] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            if (iNormalOffset != -1)
+                m_pVBNormals[uChunkStart + i] = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            if (bTangentSpaceTexCoords)
+                m_pVBTexCoords[uChunkStart + i] = XMFLOAT2(0.0f, 0.0f);
         }
     }
 }
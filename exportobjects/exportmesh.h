@@ -177,6 +177,8 @@ namespace ATG
         ExportIBSubset()
             : m_uStartIndex(0),
             m_uIndexCount(0),
+            m_uMeshletStart(0),
+            m_uMeshletCount(0),
             m_PrimitiveType(TriangleList)
         {
         }
@@ -185,22 +187,56 @@ namespace ATG
         void SetIndexCount(UINT uIndexCount) { m_uIndexCount = uIndexCount; }
         UINT GetStartIndex() const noexcept { return m_uStartIndex; }
         UINT GetIndexCount() const noexcept { return m_uIndexCount; }
+        void SetMeshletRange(UINT uMeshletStart, UINT uMeshletCount) { m_uMeshletStart = uMeshletStart; m_uMeshletCount = uMeshletCount; }
+        UINT GetMeshletStart() const noexcept { return m_uMeshletStart; }
+        UINT GetMeshletCount() const noexcept { return m_uMeshletCount; }
         void SetPrimitiveType(PrimitiveType NewPT) { m_PrimitiveType = NewPT; }
         PrimitiveType GetPrimitiveType() const noexcept { return m_PrimitiveType; }
     protected:
         UINT            m_uStartIndex;
         UINT            m_uIndexCount;
+        UINT            m_uMeshletStart;
+        UINT            m_uMeshletCount;
         PrimitiveType   m_PrimitiveType;
     };
 
+    // Meshlets for mesh-shader pipelines.  A meshlet's vertices are the unique vertex
+    // indices [VertOffset, VertOffset + VertCount), stored at the index buffer's index
+    // size, and its triangles are the primitives [PrimOffset, PrimOffset + PrimCount),
+    // each packing three 10-bit meshlet-local vertex indices.  The layouts match
+    // DirectXMesh's Meshlet, MeshletTriangle and CullData.
+    struct ExportMeshlet
+    {
+        uint32_t    VertCount;
+        uint32_t    VertOffset;
+        uint32_t    PrimCount;
+        uint32_t    PrimOffset;
+    };
+
+    struct ExportMeshletCullData
+    {
+        DirectX::BoundingSphere             BoundingSphere;
+        DirectX::PackedVector::XMUBYTEN4    NormalCone;
+        float                               ApexOffset;
+    };
+
+    struct ExportMeshletData
+    {
+        UINT                                    uMaxVertices;
+        UINT                                    uMaxPrimitives;
+        std::vector<ExportMeshlet>              Meshlets;
+        std::vector<ExportMeshletCullData>      CullData;
+        std::vector<uint8_t>                    UniqueVertexIndices;
+        std::vector<uint32_t>                   Primitives;
+    };
+
     class ExportMaterial;
 
     struct ExportMeshVertex
     {
     public:
         ExportMeshVertex() :
-            DCCVertexIndex(0),
-            pNextDuplicateVertex(nullptr)
+            DCCVertexIndex(0)
         {
             Initialize();
         }
@@ -219,13 +255,8 @@ namespace ATG
         DirectX::XMFLOAT4               BoneWeights;
         DirectX::XMFLOAT4               TexCoords[8];
         DirectX::XMFLOAT4               Color;
-        ExportMeshVertex* pNextDuplicateVertex;
-
-        bool Equals(const ExportMeshVertex* pOtherVertex) const;
     };
 
-    using ExportMeshVertexArray = std::vector< ExportMeshVertex* >;
-
     struct ExportMeshTriangle
     {
     public:
@@ -248,37 +279,6 @@ namespace ATG
 
     using ExportMeshTriangleArray = std::vector< ExportMeshTriangle* >;
 
-    class ExportMeshTriangleAllocator
-    {
-    public:
-        ExportMeshTriangleAllocator()
-            : m_uAllocatedCount(0),
-            m_uTotalCount(0)
-        {
-        }
-        ~ExportMeshTriangleAllocator()
-        {
-            Terminate();
-        }
-        void Initialize() { SetSizeHint(50000); }
-        void Terminate();
-        void SetSizeHint(UINT uAnticipatedSize);
-        ExportMeshTriangle* GetNewTriangle();
-        void ClearAllTriangles();
-    private:
-        struct AllocationBlock
-        {
-            ExportMeshTriangle* pTriangleArray;
-            UINT m_uTriangleCount;
-        };
-        using AllocationBlockList = std::list < AllocationBlock >;
-        AllocationBlockList m_AllocationBlocks;
-        UINT m_uTotalCount;
-        UINT m_uAllocatedCount;
-    };
-
-    extern ExportMeshTriangleAllocator g_MeshTriangleAllocator;
-
     struct ExportVertexFormat
     {
     public:
@@ -303,6 +303,62 @@ namespace ATG
         UINT        m_uUVSetSize;
     };
 
+    // Compact structure-of-arrays storage for the raw triangles of a mesh.  Only the
+    // vertex streams enabled in the vertex format at initialization time are stored;
+    // corner c of triangle t lives at index t * 3 + c in every per-corner stream.
+    class ExportMeshRawTriangleStreams
+    {
+    public:
+        ExportMeshRawTriangleStreams();
+
+        void Initialize(const ExportVertexFormat& Format);
+        void Reserve(size_t uTriangleCount);
+        void AddTriangle(const ExportMeshTriangle* pTriangle);
+        void GetVertex(size_t uCorner, ExportMeshVertex* pVertex) const;
+        void Clear();
+
+        bool IsInitialized() const noexcept { return m_bInitialized; }
+        size_t GetTriangleCount() const noexcept { return m_SubsetIndices.size(); }
+        size_t GetMemoryUsage() const noexcept;
+
+        INT GetSubsetIndex(size_t uTriangle) const noexcept { return m_SubsetIndices[uTriangle]; }
+        INT GetPolygonIndex(size_t uTriangle) const noexcept { return m_PolygonIndices[uTriangle]; }
+
+        UINT GetDCCVertexIndex(size_t uCorner) const noexcept { return m_DCCVertexIndices[uCorner]; }
+        const DirectX::XMFLOAT3& GetPosition(size_t uCorner) const noexcept { return m_Positions[uCorner]; }
+
+        bool HasNormals() const noexcept { return m_bNormals; }
+        const DirectX::XMFLOAT3& GetNormal(size_t uCorner) const noexcept { return m_Normals[uCorner]; }
+
+        bool HasColors() const noexcept { return m_bColors; }
+        const DirectX::XMFLOAT4& GetColor(size_t uCorner) const noexcept { return m_Colors[uCorner]; }
+
+        bool HasSkinData() const noexcept { return m_bSkinData; }
+        const DirectX::PackedVector::XMUBYTE4& GetBoneIndices(size_t uCorner) const noexcept { return m_BoneIndices[uCorner]; }
+        const DirectX::XMFLOAT4& GetBoneWeights(size_t uCorner) const noexcept { return m_BoneWeights[uCorner]; }
+
+        UINT GetUVSetCount() const noexcept { return m_uUVSetCount; }
+        UINT GetUVSetSize() const noexcept { return m_uUVSetSize; }
+        const float* GetTexCoords(size_t uCorner) const noexcept { return &m_TexCoords[uCorner * m_uUVSetCount * m_uUVSetSize]; }
+
+    private:
+        bool                                            m_bInitialized;
+        bool                                            m_bNormals;
+        bool                                            m_bColors;
+        bool                                            m_bSkinData;
+        UINT                                            m_uUVSetCount;
+        UINT                                            m_uUVSetSize;
+        std::vector< INT >                              m_SubsetIndices;
+        std::vector< INT >                              m_PolygonIndices;
+        std::vector< UINT >                             m_DCCVertexIndices;
+        std::vector< DirectX::XMFLOAT3 >                m_Positions;
+        std::vector< DirectX::XMFLOAT3 >                m_Normals;
+        std::vector< DirectX::XMFLOAT4 >                m_Colors;
+        std::vector< DirectX::PackedVector::XMUBYTE4 >  m_BoneIndices;
+        std::vector< DirectX::XMFLOAT4 >                m_BoneWeights;
+        std::vector< float >                            m_TexCoords;
+    };
+
 
     class ExportMeshBase :
         public ExportBase
@@ -348,6 +404,39 @@ namespace ATG
 
     class ExportSubDProcessMesh;
 
+    // Face topology shared by the mesh optimization passes: per-face attributes,
+    // adjacency and point reps.  Adjacency and point reps are generated together on
+    // first use.  Passes that split or reorder vertices, or reorder faces, remap the
+    // cache in place instead of dropping it.
+    class ExportMeshTopology
+    {
+    public:
+        ExportMeshTopology() noexcept : m_nFaces(0), m_nVerts(0) {}
+
+        uint32_t* CreateAttributes(size_t nFaces);
+        HRESULT Generate(const ExportIB* pIB, const DirectX::XMFLOAT3* pPositions, size_t nVerts, float fEpsilon);
+
+        // pVertexRemap[i] is the old vertex that new vertex i copies, or UINT32_MAX.
+        void RemapVertices(const uint32_t* pVertexRemap, size_t nNewVerts);
+
+        // pFaceRemap[i] is the old index of new face i; the caller reorders the IB.
+        void RemapFaces(const uint32_t* pFaceRemap);
+
+        void Reset();
+
+        bool HasAdjacency() const noexcept { return m_pAdjacency != nullptr; }
+        const uint32_t* GetAttributes() const noexcept { return m_pAttributes.get(); }
+        const uint32_t* GetAdjacency() const noexcept { return m_pAdjacency.get(); }
+        const uint32_t* GetPointReps() const noexcept { return m_pPointReps.get(); }
+
+    protected:
+        std::unique_ptr<uint32_t[]> m_pAttributes;
+        std::unique_ptr<uint32_t[]> m_pAdjacency;
+        std::unique_ptr<uint32_t[]> m_pPointReps;
+        size_t                      m_nFaces;
+        size_t                      m_nVerts;
+    };
+
     class ExportMesh :
         public ExportMeshBase
     {
@@ -359,6 +448,7 @@ namespace ATG
             FORCE_SUBD_CONVERSION = 4,
             CLEAN_MESHES = 8,
             VCACHE_OPT = 16,
+            GENERATE_MESHLETS = 32,
         };
 
         ExportMesh(ExportString name);
@@ -374,7 +464,8 @@ namespace ATG
         size_t GetVertexDeclElementCount() const noexcept { return m_VertexElements.size(); }
         const D3DVERTEXELEMENT9& GetVertexDeclElement(size_t uIndex) const noexcept { return m_VertexElements[uIndex]; }
 
-        void AddRawTriangle(ExportMeshTriangle* pTriangle);
+        void ReserveRawTriangles(size_t uTriangleCount);
+        void AddRawTriangle(const ExportMeshTriangle* pTriangle);
         void Optimize(DWORD dwFlags);
         void ByteSwap();
 
@@ -383,21 +474,26 @@ namespace ATG
 
         ExportSubDProcessMesh* GetSubDMesh() { return m_pSubDMesh; }
 
+        // Meshlet ranges for each subset are on the ExportIBSubset.
+        bool HasMeshlets() const noexcept { return !m_Meshlets.Meshlets.empty(); }
+        const ExportMeshletData& GetMeshlets() const noexcept { return m_Meshlets; }
+
         size_t GetTriangleCount() const noexcept { return m_TriangleToPolygonMapping.size(); }
         INT GetPolygonForTriangle(size_t dwTriangleIndex) const noexcept { return m_TriangleToPolygonMapping[dwTriangleIndex]; }
 
         void AddInfluence(ExportString InfluenceName) override { m_InfluenceNames.push_back(InfluenceName); m_VertexFormat.m_bSkinData = true; }
 
     protected:
-        void BuildVertexBuffer(ExportMeshVertexArray& VertexArray, DWORD dwFlags);
+        void BuildVertexBuffer(const std::vector<UINT>& VertexCorners, DWORD dwFlags);
         void ClearRawTriangles();
         void CleanMesh(bool breakBowTies);
         void ComputeVertexTangentSpaces();
         void ComputeAdjacency();
         void ComputeUVAtlas();
         void OptimizeVcache();
+        void BuildMeshlets(bool bClockwise);
         void ComputeBoneSubsetGroups();
-        void SortRawTrianglesBySubsetIndex();
+        void SortRawTrianglesBySubsetIndex(std::vector<UINT>& TriangleOrder) const;
         void ComputeBounds();
 
     protected:
@@ -406,9 +502,9 @@ namespace ATG
         std::unique_ptr<DirectX::XMFLOAT3[]>        m_pVBPositions;
         std::unique_ptr<DirectX::XMFLOAT3[]>        m_pVBNormals;
         std::unique_ptr<DirectX::XMFLOAT2[]>        m_pVBTexCoords;
-        std::unique_ptr<uint32_t[]>                 m_pAdjacency;
-        std::unique_ptr<uint32_t[]>                 m_pAttributes;
-        ExportMeshTriangleArray                     m_RawTriangles;
+        ExportMeshTopology                          m_Topology;
+        ExportMeshletData                           m_Meshlets;
+        ExportMeshRawTriangleStreams                m_RawTriangles;
         std::vector< INT >                          m_TriangleToPolygonMapping;
         ExportVertexFormat                          m_VertexFormat;
         std::vector< D3DVERTEXELEMENT9 >            m_VertexElements;
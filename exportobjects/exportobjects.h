@@ -16,6 +16,7 @@
 #include "ExportFrame.h"
 #include "ExportMaterial.h"
 #include "ExportAnimation.h"
+#include "ExportAnimationCodec.h"
 #include "ExportLight.h"
 #include "ExportScene.h"
 #include "ExportCamera.h"
@@ -25,3 +26,5 @@
 #include "ExportMaterialDatabase.h"
 #include "ExportSubD.h"
 #include "ExportPath.h"
+#include "ExportParallel.h"
+#include "ExportCache.h"
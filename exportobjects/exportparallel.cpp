@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------------------------
+// ExportParallel.cpp
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+#include "exportparallel.h"
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+using namespace ATG;
+
+namespace
+{
+    thread_local bool t_bInsideParallelTask = false;
+    thread_local bool t_bHelperThread = false;
+
+    struct ParallelForState
+    {
+        std::atomic<size_t> NextTask;
+        std::mutex          ExceptionMutex;
+        std::exception_ptr  pFirstException;
+    };
+
+    void RunTasks(ParallelForState& State, size_t uTaskCount, const std::function<void(size_t)>& TaskFunc)
+    {
+        const bool bWasInside = t_bInsideParallelTask;
+        t_bInsideParallelTask = true;
+        for (;;)
+        {
+            const size_t uTask = State.NextTask.fetch_add(1);
+            if (uTask >= uTaskCount)
+                break;
+
+            // An exception must not escape a worker thread.  Keep the first one for the
+            // caller and stop handing out tasks.
+            try
+            {
+                TaskFunc(uTask);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> Lock(State.ExceptionMutex);
+                if (!State.pFirstException)
+                    State.pFirstException = std::current_exception();
+                State.NextTask = uTaskCount;
+                break;
+            }
+        }
+        t_bInsideParallelTask = bWasInside;
+    }
+}
+
+UINT ATG::GetExportWorkerThreadCount()
+{
+    const INT iSetting = g_ExportCoreSettings.iWorkerThreadCount;
+    if (iSetting > 0)
+        return static_cast<UINT>(iSetting);
+    return std::max<UINT>(std::thread::hardware_concurrency(), 1);
+}
+
+bool ATG::IsExportWorkerThread()
+{
+    return t_bInsideParallelTask;
+}
+
+bool ATG::IsExportMainThread()
+{
+    return !t_bHelperThread;
+}
+
+void ATG::ExportParallelFor(size_t uTaskCount, const std::function<void(size_t)>& TaskFunc)
+{
+    if (uTaskCount == 0)
+        return;
+
+    ParallelForState State;
+    State.NextTask = 0;
+
+    size_t uThreadCount = std::min<size_t>(GetExportWorkerThreadCount(), uTaskCount);
+    if (t_bInsideParallelTask)
+        uThreadCount = 1;
+
+    std::vector<std::thread> Workers;
+    Workers.reserve(uThreadCount - 1);
+    for (size_t i = 1; i < uThreadCount; ++i)
+    {
+        Workers.emplace_back([&]()
+            {
+                t_bHelperThread = true;
+                RunTasks(State, uTaskCount, TaskFunc);
+            });
+    }
+
+    RunTasks(State, uTaskCount, TaskFunc);
+
+    for (auto& Worker : Workers)
+    {
+        Worker.join();
+    }
+
+    if (State.pFirstException)
+        std::rethrow_exception(State.pFirstException);
+}
@@ -0,0 +1,37 @@
+//-------------------------------------------------------------------------------------
+// ExportParallel.h
+//
+// A small fork/join helper that spreads independent export tasks across worker
+// threads.
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+#pragma once
+
+#include <functional>
+
+namespace ATG
+{
+    // Returns the number of threads ExportParallelFor will use, based on the
+    // "workerthreads" setting (0 selects one thread per logical processor).
+    UINT GetExportWorkerThreadCount();
+
+    // Returns true on threads that are currently running an ExportParallelFor task.
+    bool IsExportWorkerThread();
+
+    // Returns false on the helper threads ExportParallelFor starts.  The thread that
+    // calls ExportParallelFor runs tasks too, but still counts as the main thread.
+    bool IsExportMainThread();
+
+    // Calls TaskFunc(i) exactly once for every i in [0, uTaskCount) and returns when
+    // all calls have completed.  Tasks are picked up in index order by the calling
+    // thread and the workers; callers should write results into per-index slots so
+    // the output does not depend on scheduling.  Nested calls run serially on the
+    // calling worker.  If a task throws, no further tasks are started, and the first
+    // exception is rethrown on the calling thread once every worker has finished.
+    void ExportParallelFor(size_t uTaskCount, const std::function<void(size_t)>& TaskFunc);
+}
@@ -26,6 +26,12 @@ void ExportStatistics::FinalReport()
     }
     ExportLog::LogMsg(2, "Export complete in %0.2f seconds; %0.2f seconds for scene parse and %0.2f seconds for file writing.",
         (float)ExportTotalTime / 1000.0f, (float)ExportParseTime / 1000.0f, (float)ExportSaveTime / 1000.0f);
+
+    ExportStringPoolStatistics StringStats = {};
+    ExportString::GetPoolStatistics(StringStats);
+    ExportLog::LogMsg(4, "String pool: %zu strings in %zu slots (average probe %0.2f, longest %zu); %zu KB of %zu KB arena used.",
+        StringStats.StringCount, StringStats.TableSize, StringStats.AverageProbeLength, StringStats.MaxProbeLength,
+        StringStats.ArenaBytesUsed / 1024, StringStats.ArenaBytesReserved / 1024);
 }
 
 ExportScene::ExportScene()
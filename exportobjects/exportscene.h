@@ -74,6 +74,23 @@ namespace ATG
         virtual void TransformPosition(DirectX::XMFLOAT3* pDestPosition, const DirectX::XMFLOAT3* pSrcPosition) const = 0;
         virtual void TransformDirection(DirectX::XMFLOAT3* pDestDirection, const DirectX::XMFLOAT3* pSrcDirection) const = 0;
         virtual float TransformLength(float fInputLength) const = 0;
+
+        // Stream forms of TransformPosition and TransformDirection; the source and
+        // destination must not overlap.  The defaults call the per-element methods.
+        virtual void TransformPositionStream(DirectX::XMFLOAT3* pDestPositions, const DirectX::XMFLOAT3* pSrcPositions, size_t Count) const
+        {
+            for (size_t i = 0; i < Count; ++i)
+            {
+                TransformPosition(&pDestPositions[i], &pSrcPositions[i]);
+            }
+        }
+        virtual void TransformDirectionStream(DirectX::XMFLOAT3* pDestDirections, const DirectX::XMFLOAT3* pSrcDirections, size_t Count) const
+        {
+            for (size_t i = 0; i < Count; ++i)
+            {
+                TransformDirection(&pDestDirections[i], &pSrcDirections[i]);
+            }
+        }
     };
 
     class ExportScene :
@@ -604,6 +604,7 @@ ExportCoreSettings::ExportCoreSettings()
     g_SettingsManager.AddBool(pCategoryScene, "Export Cameras", "exportcameras", true, &bExportCameras);
     g_SettingsManager.AddBool(pCategoryScene, "Export in Bind Pose", "exportbindpose", true, &bSetBindPoseBeforeSceneParse);
     g_SettingsManager.AddFloatBounded(pCategoryScene, "Export Scene Scale (1.0 = default)", "exportscale", 1.0f, 0.0f, 1000000.f, &fExportScale);
+    g_SettingsManager.AddIntBounded(pCategoryScene, "Worker Threads (0 = one per processor)", "workerthreads", 0, 0, 256, &iWorkerThreadCount);
     pCategoryScene->ReverseChildOrder();
 
     auto pCategoryMeshes = g_SettingsManager.AddRootCategory("Meshes");
@@ -655,6 +656,9 @@ ExportCoreSettings::ExportCoreSettings()
     g_SettingsManager.AddIntBounded(pCategoryOpt, "Vertex cache size for optimizemesh", "vcache", 12, 0, 64, &iVcacheSize);
     g_SettingsManager.AddIntBounded(pCategoryOpt, "Strip restart length for optimizemesh", "restart", 7, 0, 64, &iStripRestart);
     g_SettingsManager.AddBool(pCategoryOpt, "Clean up meshes (implied by optimizemeshes)", "cleanmeshes", false, &bCleanMeshes);
+    g_SettingsManager.AddBool(pCategoryOpt, "Generate meshlets for mesh shaders", "meshlets", false, &bGenerateMeshlets);
+    g_SettingsManager.AddIntBounded(pCategoryOpt, "Max vertices per meshlet", "meshletverts", 128, 32, 256, &iMeshletMaxVertices);
+    g_SettingsManager.AddIntBounded(pCategoryOpt, "Max primitives per meshlet", "meshletprims", 128, 32, 256, &iMeshletMaxPrimitives);
     pCategoryOpt->ReverseChildOrder();
 
     auto pCategoryUVAtlas = g_SettingsManager.AddCategory(pCategoryMeshes, "UV Atlas Generation");
@@ -669,6 +673,7 @@ ExportCoreSettings::ExportCoreSettings()
 
     auto pCategorySubD = g_SettingsManager.AddCategory(pCategoryMeshes, "Subdivision Surfaces");
     g_SettingsManager.AddBool(pCategorySubD, "Convert Poly Meshes to Subdivision Surfaces", "convertmeshtosubd", false, &bConvertMeshesToSubD);
+    g_SettingsManager.AddBool(pCategorySubD, "Reorder Subdivision Patches for Control Point Cache Reuse", "optimizesubdpatches", false, &bOptimizeSubDPatches);
     pCategorySubD->ReverseChildOrder();
 
     pCategoryMeshes->ReverseChildOrder();
@@ -693,8 +698,16 @@ ExportCoreSettings::ExportCoreSettings()
     g_SettingsManager.AddBool(pCategoryAnimation, "Optimize Animations", "optimizeanimations", true, &bOptimizeAnimations);
     g_SettingsManager.AddBool(pCategoryAnimation, "Rename Animations To Match Output File Name", "renameanimations", true, &bRenameAnimationsToFileName);
     g_SettingsManager.AddIntBounded(pCategoryAnimation, "Animation Baking Sample Count Per Frame", "animsamplecount", 1, 1, 10, &iAnimSampleCountPerFrame);
+    g_SettingsManager.AddBool(pCategoryAnimation, "Sample Animations Only Where Curves Change", "adaptiveanimcapture", false, &bAdaptiveAnimationCapture);
     g_SettingsManager.AddIntBounded(pCategoryAnimation, "Position Curve Quality", "positioncurvequality", 50, 0, 100, &iAnimPositionExportQuality);
     g_SettingsManager.AddIntBounded(pCategoryAnimation, "Orientation Curve Quality", "orientationcurvequality", 50, 0, 100, &iAnimOrientationExportQuality);
+    g_SettingsManager.AddBool(pCategoryAnimation, "Reduce Keys to a Maximum Error (ignores curve quality)", "errorboundedanim", false, &bErrorBoundedAnimation);
+    g_SettingsManager.AddFloatBounded(pCategoryAnimation, "Maximum Position Error Through Hierarchy (world units)", "animpositionerror", 0.001f, 0.0f, 1000.0f, &fAnimPositionError);
+    g_SettingsManager.AddFloatBounded(pCategoryAnimation, "Maximum Rotation Error (degrees)", "animrotationerror", 0.05f, 0.0f, 180.0f, &fAnimRotationError);
+    g_SettingsManager.AddFloatBounded(pCategoryAnimation, "Maximum Scale Error", "animscaleerror", 0.001f, 0.0f, 1000.0f, &fAnimScaleError);
+    g_SettingsManager.AddBool(pCategoryAnimation, "Write Quantized Animation Tracks", "quantizeanimations", false, &bQuantizeAnimations);
+    g_SettingsManager.AddBool(pCategoryAnimation, "Write Sparse SDKMESH Animation Tracks", "sparseanimations", false, &bSparseAnimations);
+    g_SettingsManager.AddBool(pCategoryAnimation, "Write All Animations to One SDKMESH Multi-Clip File", "multiclipanimations", false, &bMultiClipAnimations);
     g_SettingsManager.AddString(pCategoryAnimation, "Animation Root Node Name (default includes all nodes)", "animationrootnode", "", strAnimationRootNodeName);
     pCategoryAnimation->ReverseChildOrder();
 
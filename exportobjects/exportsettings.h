@@ -177,6 +177,7 @@ namespace ATG
         bool        bExportBinormal;
         bool        bSetBindPoseBeforeSceneParse;
         INT         iAnimSampleCountPerFrame;
+        bool        bAdaptiveAnimationCapture;
         INT         iAnimPositionExportQuality;
         INT         iAnimOrientationExportQuality;
         bool        bRenameAnimationsToFileName;
@@ -194,6 +195,7 @@ namespace ATG
         bool        bForceTextureOverwrite;
         bool        bUseEmissiveTexture;
         bool        bConvertMeshesToSubD;
+        bool        bOptimizeSubDPatches;
         bool        bGeometricAdjacency;
         INT         iGenerateUVAtlasOnTexCoordIndex;
         float       fUVAtlasMaxStretch;
@@ -205,12 +207,23 @@ namespace ATG
         CHAR        strMeshNameDecoration[SETTINGS_STRING_LENGTH];
         CHAR        strAnimationRootNodeName[SETTINGS_STRING_LENGTH];
         bool        bOptimizeAnimations;
+        bool        bErrorBoundedAnimation;
+        float       fAnimPositionError;
+        float       fAnimRotationError;
+        float       fAnimScaleError;
+        bool        bQuantizeAnimations;
+        bool        bSparseAnimations;
+        bool        bMultiClipAnimations;
         bool        bCleanMeshes;
         bool        bOptimizeVCache;
         DWORD       dwOptimizationAlgorithm;
         INT         iVcacheSize;
         INT         iStripRestart;
+        bool        bGenerateMeshlets;
+        INT         iMeshletMaxVertices;
+        INT         iMeshletMaxPrimitives;
         float       fExportScale;
+        INT         iWorkerThreadCount;
     };
 
     extern ExportCoreSettings       g_ExportCoreSettings;
@@ -0,0 +1,241 @@
+//-------------------------------------------------------------------------------------
+// ExportString.cpp
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace ATG;
+
+namespace
+{
+    constexpr ULONGLONG FNV_OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr ULONGLONG FNV_PRIME = 1099511628211ULL;
+
+    constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+    inline ULONGLONG HashStringAndLength(const CHAR* strString, size_t& dwLength) noexcept
+    {
+        ULONGLONG qwHash = FNV_OFFSET_BASIS;
+        auto p = reinterpret_cast<const BYTE*>(strString);
+        for (; *p; ++p)
+        {
+            BYTE c = *p;
+            if (c >= 'A' && c <= 'Z')
+                c += 'a' - 'A';
+            qwHash = (qwHash ^ c) * FNV_PRIME;
+        }
+        dwLength = static_cast<size_t>(reinterpret_cast<const CHAR*>(p) - strString);
+        return qwHash;
+    }
+
+    // Bump allocator for pooled string storage.  Strings live for the whole process,
+    // so blocks are never released.
+    class ExportStringArena
+    {
+    public:
+        ExportStringArena() noexcept
+            : m_pCurrent(nullptr),
+            m_dwRemaining(0),
+            m_dwBytesReserved(0),
+            m_dwBytesUsed(0)
+        {
+        }
+
+        CHAR* Allocate(size_t dwSize)
+        {
+            if (dwSize > m_dwRemaining)
+            {
+                // Oversized strings get a block of their own so the current block keeps
+                // its free space.
+                const size_t dwBlockSize = std::max(dwSize, ARENA_BLOCK_SIZE);
+                m_Blocks.emplace_back(new CHAR[dwBlockSize]);
+                m_dwBytesReserved += dwBlockSize;
+                if (dwBlockSize > ARENA_BLOCK_SIZE)
+                {
+                    m_dwBytesUsed += dwSize;
+                    return m_Blocks.back().get();
+                }
+                m_pCurrent = m_Blocks.back().get();
+                m_dwRemaining = dwBlockSize;
+            }
+            CHAR* pResult = m_pCurrent;
+            m_pCurrent += dwSize;
+            m_dwRemaining -= dwSize;
+            m_dwBytesUsed += dwSize;
+            return pResult;
+        }
+
+        size_t GetBytesReserved() const noexcept { return m_dwBytesReserved; }
+        size_t GetBytesUsed() const noexcept { return m_dwBytesUsed; }
+
+    private:
+        std::vector<std::unique_ptr<CHAR[]>>    m_Blocks;
+        CHAR*                                   m_pCurrent;
+        size_t                                  m_dwRemaining;
+        size_t                                  m_dwBytesReserved;
+        size_t                                  m_dwBytesUsed;
+    };
+
+    // Open-addressing intern table with linear probing.  Each slot keeps the full hash
+    // next to the pooled pointer, so a probe only touches string data on a likely
+    // match.  Lookups take the lock shared; only inserts take it exclusively.
+    class ExportStringPool
+    {
+    public:
+        ExportStringPool()
+            : m_Slots(EXPORTSTRING_TABLESIZE),
+            m_dwCount(0)
+        {
+            static_assert((EXPORTSTRING_TABLESIZE & (EXPORTSTRING_TABLESIZE - 1)) == 0, "EXPORTSTRING_TABLESIZE must be a power of 2");
+            InitializeSRWLock(&m_Lock);
+        }
+
+        const CHAR* AddString(const CHAR* strString)
+        {
+            size_t dwLength = 0;
+            const ULONGLONG qwHash = HashStringAndLength(strString, dwLength);
+
+            AcquireSRWLockShared(&m_Lock);
+            const CHAR* strResult = Find(strString, qwHash);
+            ReleaseSRWLockShared(&m_Lock);
+            if (strResult)
+                return strResult;
+
+            AcquireSRWLockExclusive(&m_Lock);
+
+            // Another thread may have added the string between the two locks.
+            strResult = Find(strString, qwHash);
+            if (!strResult)
+            {
+                if ((m_dwCount + 1) * 2 > m_Slots.size())
+                {
+                    Grow();
+                }
+
+                CHAR* strCopy = m_Arena.Allocate(dwLength + 1);
+                memcpy(strCopy, strString, dwLength + 1);
+                Insert(strCopy, qwHash);
+                ++m_dwCount;
+                strResult = strCopy;
+            }
+
+            ReleaseSRWLockExclusive(&m_Lock);
+            return strResult;
+        }
+
+        void GetStatistics(ExportStringPoolStatistics& Stats)
+        {
+            AcquireSRWLockShared(&m_Lock);
+
+            const size_t dwMask = m_Slots.size() - 1;
+            size_t dwTotalProbes = 0;
+            size_t dwMaxProbes = 0;
+            for (size_t i = 0; i < m_Slots.size(); ++i)
+            {
+                const Slot& CurrentSlot = m_Slots[i];
+                if (!CurrentSlot.strString)
+                    continue;
+                // Number of slots a lookup of this string inspects.
+                const size_t dwProbes = ((i - static_cast<size_t>(CurrentSlot.qwHash)) & dwMask) + 1;
+                dwTotalProbes += dwProbes;
+                dwMaxProbes = std::max(dwMaxProbes, dwProbes);
+            }
+
+            Stats.StringCount = m_dwCount;
+            Stats.TableSize = m_Slots.size();
+            Stats.MaxProbeLength = dwMaxProbes;
+            Stats.AverageProbeLength = m_dwCount ? static_cast<float>(dwTotalProbes) / static_cast<float>(m_dwCount) : 0.0f;
+            Stats.ArenaBytesReserved = m_Arena.GetBytesReserved();
+            Stats.ArenaBytesUsed = m_Arena.GetBytesUsed();
+
+            ReleaseSRWLockShared(&m_Lock);
+        }
+
+    private:
+        struct Slot
+        {
+            ULONGLONG   qwHash;
+            const CHAR* strString;
+
+            Slot() noexcept : qwHash(0), strString(nullptr) {}
+        };
+
+        const CHAR* Find(const CHAR* strString, ULONGLONG qwHash) const
+        {
+            const size_t dwMask = m_Slots.size() - 1;
+            for (size_t i = static_cast<size_t>(qwHash) & dwMask; ; i = (i + 1) & dwMask)
+            {
+                const Slot& CurrentSlot = m_Slots[i];
+                if (!CurrentSlot.strString)
+                    return nullptr;
+                if (CurrentSlot.qwHash == qwHash && EXPORTSTRING_COMPARE(CurrentSlot.strString, strString) == 0)
+                    return CurrentSlot.strString;
+            }
+        }
+
+        void Insert(const CHAR* strString, ULONGLONG qwHash)
+        {
+            const size_t dwMask = m_Slots.size() - 1;
+            size_t i = static_cast<size_t>(qwHash) & dwMask;
+            while (m_Slots[i].strString)
+            {
+                i = (i + 1) & dwMask;
+            }
+            m_Slots[i].qwHash = qwHash;
+            m_Slots[i].strString = strString;
+        }
+
+        void Grow()
+        {
+            std::vector<Slot> OldSlots;
+            OldSlots.swap(m_Slots);
+            m_Slots.resize(OldSlots.size() * 2);
+            for (const Slot& OldSlot : OldSlots)
+            {
+                if (OldSlot.strString)
+                {
+                    Insert(OldSlot.strString, OldSlot.qwHash);
+                }
+            }
+        }
+
+        SRWLOCK             m_Lock;
+        std::vector<Slot>   m_Slots;
+        size_t              m_dwCount;
+        ExportStringArena   m_Arena;
+    };
+
+    ExportStringPool& GetStringPool()
+    {
+        // Intentionally never destroyed; ExportStrings in global objects may still point
+        // into the pool during static destruction.
+        static ExportStringPool* s_pPool = new ExportStringPool();
+        return *s_pPool;
+    }
+}
+
+ULONGLONG ExportString::HashString(const CHAR* strString) noexcept
+{
+    size_t dwLength = 0;
+    return HashStringAndLength(strString, dwLength);
+}
+
+const CHAR* ExportString::AddString(const CHAR* strString)
+{
+    if (!strString)
+        return nullptr;
+
+    // Strings may be pooled from worker threads during parallel mesh optimization.
+    return GetStringPool().AddString(strString);
+}
+
+void ExportString::GetPoolStatistics(ExportStringPoolStatistics& Stats)
+{
+    GetStringPool().GetStatistics(Stats);
+}
@@ -13,8 +13,9 @@
 
 // Change EXPORTSTRING_COMPARE to strcmp to do case-sensitive string pooling.
 #define EXPORTSTRING_COMPARE _stricmp
-// EXPORTSTRING_HASHSIZE must be a power of 2, so just change the shift value.
-#define EXPORTSTRING_HASHSIZE (1 << 4)
+// EXPORTSTRING_TABLESIZE is the initial slot count of the pool's hash table; it must
+// be a power of 2, so just change the shift value.
+#define EXPORTSTRING_TABLESIZE (1 << 12)
 
 namespace ATG
 {
@@ -62,6 +63,16 @@ namespace ATG
         std::unique_ptr<CHAR[]> m_strValue;
     };
 
+    struct ExportStringPoolStatistics
+    {
+        size_t  StringCount;
+        size_t  TableSize;
+        size_t  MaxProbeLength;
+        float   AverageProbeLength;
+        size_t  ArenaBytesReserved;
+        size_t  ArenaBytesUsed;
+    };
+
     class ExportString
     {
     public:
@@ -77,41 +88,16 @@ namespace ATG
 
         operator const CHAR* () const noexcept { return m_strString; }
         inline const CHAR* SafeString() const;
-        inline static BYTE HashString(const CHAR* strString);
+
+        // Full-length hash, case-folded so it agrees with EXPORTSTRING_COMPARE.
+        static ULONGLONG HashString(const CHAR* strString) noexcept;
+        static void GetPoolStatistics(ExportStringPoolStatistics& Stats);
     protected:
-        inline static const CHAR* AddString(const CHAR* strString);
+        static const CHAR* AddString(const CHAR* strString);
     protected:
         const CHAR* m_strString;
     };
 
-    const CHAR* ExportString::AddString(const CHAR* strString)
-    {
-        if (!strString)
-            return nullptr;
-        using StringList = std::list< const CHAR* >;
-        static StringList s_StringLists[EXPORTSTRING_HASHSIZE];
-
-        BYTE uBucketIndex = HashString(strString) & (EXPORTSTRING_HASHSIZE - 1);
-        StringList& CurrentList = s_StringLists[uBucketIndex];
-
-        StringList::iterator iter = CurrentList.begin();
-        const StringList::iterator end = CurrentList.end();
-
-        while (iter != end)
-        {
-            const CHAR* strTest = *iter;
-            if (EXPORTSTRING_COMPARE(strTest, strString) == 0)
-                return strTest;
-            ++iter;
-        }
-
-        const size_t dwSize = strlen(strString) + 1;
-        CHAR* strCopy = new CHAR[dwSize];
-        strcpy_s(strCopy, dwSize, strString);
-        CurrentList.push_back(strCopy);
-        return strCopy;
-    }
-
     bool ExportString::operator== (const CHAR* strRHS) const
     {
         if (!strRHS)
@@ -136,19 +122,4 @@ namespace ATG
         return m_strString;
     }
 
-    BYTE ExportString::HashString(const CHAR* strString)
-    {
-        BYTE sum = 0;
-        auto p = reinterpret_cast<const BYTE*>(strString);
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F); else return sum;
-        if (*p) sum += (*p++ & 0x1F);
-        return sum;
-    }
-
 };
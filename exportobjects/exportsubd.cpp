@@ -36,8 +36,23 @@ void ExportSubDProcessMesh::Initialize(ExportMesh* pMesh)
     CreateDegenerateGeometry();
     ComputeAdjacency();
     SortPatches();
+
+    if (g_pScene->Settings().bOptimizeSubDPatches)
+    {
+        LogPatchCacheMissRates("before optimization");
+        ReorderPatches();
+        LogPatchCacheMissRates("after optimization");
+    }
+    else
+    {
+        LogPatchCacheMissRates("(not optimized)");
+    }
+
+    const ULONGLONG qwStartTime = GetTickCount64();
     BuildQuadPatchBuffer();
     BuildTriPatchBuffer();
+    ExportLog::LogMsg(3, "Building subdivision surface patch buffers took %llu ms.", GetTickCount64() - qwStartTime);
+
     ConvertSubsets();
 
     ClearIntermediateBuffers();
@@ -73,6 +88,8 @@ void ExportSubDProcessMesh::ClearIntermediateBuffers()
     m_PositionToDegeneratePositionMapping.clear();
     m_IncidentBoundaryEdgesPerPosition.clear();
     m_BoundaryEdges.clear();
+    m_EdgeFaces.clear();
+    m_PositionWelder.Clear();
 }
 
 void ExportSubDProcessMesh::BuildMesh()
@@ -82,9 +99,13 @@ void ExportSubDProcessMesh::BuildMesh()
     m_Positions.clear();
     m_MeshVertexToPositionMapping.clear();
     m_PositionToMeshVertexMapping.clear();
+    m_PositionWelder.Clear();
+
+    const ULONGLONG qwStartTime = GetTickCount64();
 
     const size_t dwVertexCount = m_pPolyMesh->GetVB()->GetVertexCount();
     m_MeshVertexToPositionMapping.resize(dwVertexCount, -1);
+    m_PositionWelder.Reserve(dwVertexCount);
 
     // compute triangle count
     const size_t dwIndexCount = m_pPolyMesh->GetIB()->GetIndexCount();
@@ -208,6 +229,7 @@ void ExportSubDProcessMesh::BuildMesh()
     assert(dwTriangleCount == (m_Triangles.size() + m_Quads.size() * 2));
 
     ExportLog::LogMsg(3, "Subdivision surface control mesh complete; %zu triangles and %zu quads found, %zu unique positions.", m_Triangles.size(), m_Quads.size(), m_Positions.size());
+    ExportLog::LogMsg(3, "Building the subdivision surface control mesh took %llu ms.", GetTickCount64() - qwStartTime);
 }
 
 INT ExportSubDProcessMesh::CreateOrAddPosition(const XMFLOAT3& vPosition, INT iMeshVertexIndex)
@@ -216,29 +238,16 @@ INT ExportSubDProcessMesh::CreateOrAddPosition(const XMFLOAT3& vPosition, INT iM
     INT iCurrentIndex = m_MeshVertexToPositionMapping[iMeshVertexIndex];
     if (iCurrentIndex == -1)
     {
-        const XMVECTOR p0 = XMLoadFloat3(&vPosition);
-
-        const size_t dwPositionCount = m_Positions.size();
-        for (size_t i = 0; i < dwPositionCount; ++i)
+        const INT iNewIndex = static_cast<INT>(m_Positions.size());
+        iCurrentIndex = m_PositionWelder.FindOrAdd(vPosition, iNewIndex);
+        if (iCurrentIndex == iNewIndex)
         {
-            const XMVECTOR pi = XMLoadFloat3(&m_Positions[i]);
-            if (XMVector3Equal(p0, pi))
-            {
-                iCurrentIndex = static_cast<INT>(i);
-                m_MeshVertexToPositionMapping[iMeshVertexIndex] = iCurrentIndex;
-                return iCurrentIndex;
-            }
+            m_Positions.push_back(vPosition);
+            m_PositionToMeshVertexMapping.push_back(iMeshVertexIndex);
         }
-        iCurrentIndex = static_cast<INT>(dwPositionCount);
-        m_Positions.push_back(vPosition);
-        m_PositionToMeshVertexMapping.push_back(iMeshVertexIndex);
         m_MeshVertexToPositionMapping[iMeshVertexIndex] = iCurrentIndex;
-        return iCurrentIndex;
-    }
-    else
-    {
-        return iCurrentIndex;
     }
+    return iCurrentIndex;
 }
 
 void ExportSubDProcessMesh::AddTriangle(INT iPolyIndex, INT iSubsetIndex, const INT* pIndices, const INT* pMeshIndices)
@@ -311,10 +320,14 @@ void ExportSubDProcessMesh::BuildBoundaryEdgeTable()
     assert(m_pPolyMesh != nullptr);
 
     m_BoundaryEdges.clear();
+    m_EdgeFaces.clear();
 
     const size_t dwTotalEdgeCount = m_Triangles.size() * 3 + m_Quads.size() * 4;
     ExportLog::LogMsg(4, "Scanning %zu edges in control mesh for boundary edges.", dwTotalEdgeCount);
 
+    // interior edges are shared by two faces
+    m_EdgeFaces.reserve(dwTotalEdgeCount / 2 + 1);
+
     // add the edges in all of the triangles
     const size_t dwTriangleCount = m_Triangles.size();
     for (size_t dwTriangleIndex = 0; dwTriangleIndex < dwTriangleCount; ++dwTriangleIndex)
@@ -327,6 +340,7 @@ void ExportSubDProcessMesh::BuildBoundaryEdgeTable()
             const INT iPositionIndexB = tri.iIndices[(iEdgeIndex + 1) % 3];
             AddOrRemoveEdge(iPositionIndexA, iPositionIndexB, static_cast<INT>(dwTriangleIndex), -1, iEdgeIndex);
         }
+        AddTriangleEdges(static_cast<INT>(dwTriangleIndex));
     }
 
     // add the edges in all of the quads
@@ -341,6 +355,7 @@ void ExportSubDProcessMesh::BuildBoundaryEdgeTable()
             const INT iPositionIndexB = quad.iIndices[(iEdgeIndex + 1) % 4];
             AddOrRemoveEdge(iPositionIndexA, iPositionIndexB, -1, static_cast<INT>(dwQuadIndex), iEdgeIndex);
         }
+        AddQuadEdges(static_cast<INT>(dwQuadIndex));
     }
 
     const size_t dwBoundaryEdgeCount = m_BoundaryEdges.size();
@@ -404,16 +419,7 @@ INT ExportSubDProcessMesh::AddOrRemoveEdge(INT iPositionIndexA, INT iPositionInd
     assert(iPositionIndexA >= 0);
     assert(iPositionIndexB >= 0);
 
-    // compute a unique hash for this edge, with the smaller index in the MSW and the larger index in the LSW
-    UINT64 EdgeHashKey = 0;
-    if (iPositionIndexA < iPositionIndexB)
-    {
-        EdgeHashKey = ((UINT64)iPositionIndexA << 32) | (UINT64)iPositionIndexB;
-    }
-    else
-    {
-        EdgeHashKey = ((UINT64)iPositionIndexB << 32) | (UINT64)iPositionIndexA;
-    }
+    const UINT64 EdgeHashKey = GetEdgeKey(iPositionIndexA, iPositionIndexB);
 
     // search for the edge in the table
     const EdgeMap::iterator iter = m_BoundaryEdges.find(EdgeHashKey);
@@ -437,6 +443,102 @@ INT ExportSubDProcessMesh::AddOrRemoveEdge(INT iPositionIndexA, INT iPositionInd
     }
 }
 
+UINT64 ExportSubDProcessMesh::GetEdgeKey(INT iPositionIndexA, INT iPositionIndexB) noexcept
+{
+    // compute a unique hash for this edge, with the smaller index in the MSW and the larger index in the LSW
+    if (iPositionIndexA < iPositionIndexB)
+    {
+        return ((UINT64)iPositionIndexA << 32) | (UINT64)iPositionIndexB;
+    }
+    else
+    {
+        return ((UINT64)iPositionIndexB << 32) | (UINT64)iPositionIndexA;
+    }
+}
+
+namespace
+{
+    void InsertFaceIndex(std::vector<INT>& Faces, INT iFaceIndex)
+    {
+        // faces are usually added in ascending order
+        if (Faces.empty() || Faces.back() < iFaceIndex)
+        {
+            Faces.push_back(iFaceIndex);
+            return;
+        }
+        auto iter = std::lower_bound(Faces.begin(), Faces.end(), iFaceIndex);
+        if (*iter != iFaceIndex)
+        {
+            Faces.insert(iter, iFaceIndex);
+        }
+    }
+
+    void EraseFaceIndex(std::vector<INT>& Faces, INT iFaceIndex)
+    {
+        auto iter = std::lower_bound(Faces.begin(), Faces.end(), iFaceIndex);
+        if (iter != Faces.end() && *iter == iFaceIndex)
+        {
+            Faces.erase(iter);
+        }
+    }
+
+    INT FindFaceIndex(const std::vector<INT>& Faces, INT iExcludeThisFace) noexcept
+    {
+        for (const INT iFaceIndex : Faces)
+        {
+            if (iFaceIndex != iExcludeThisFace)
+                return iFaceIndex;
+        }
+        return -1;
+    }
+}
+
+void ExportSubDProcessMesh::AddTriangleEdges(INT iTriangleIndex)
+{
+    const Triangle& tri = m_Triangles[iTriangleIndex];
+    for (INT iEdgeIndex = 0; iEdgeIndex < 3; ++iEdgeIndex)
+    {
+        const INT iPositionIndexA = tri.iIndices[iEdgeIndex];
+        const INT iPositionIndexB = tri.iIndices[(iEdgeIndex + 1) % 3];
+        if (iPositionIndexA != iPositionIndexB)
+        {
+            InsertFaceIndex(m_EdgeFaces[GetEdgeKey(iPositionIndexA, iPositionIndexB)].Triangles, iTriangleIndex);
+        }
+    }
+}
+
+void ExportSubDProcessMesh::AddQuadEdges(INT iQuadIndex)
+{
+    const Quad& quad = m_Quads[iQuadIndex];
+    for (INT iEdgeIndex = 0; iEdgeIndex < 4; ++iEdgeIndex)
+    {
+        const INT iPositionIndexA = quad.iIndices[iEdgeIndex];
+        const INT iPositionIndexB = quad.iIndices[(iEdgeIndex + 1) % 4];
+        if (iPositionIndexA != iPositionIndexB)
+        {
+            InsertFaceIndex(m_EdgeFaces[GetEdgeKey(iPositionIndexA, iPositionIndexB)].Quads, iQuadIndex);
+        }
+    }
+}
+
+void ExportSubDProcessMesh::RemoveQuadEdges(INT iQuadIndex)
+{
+    const Quad& quad = m_Quads[iQuadIndex];
+    for (INT iEdgeIndex = 0; iEdgeIndex < 4; ++iEdgeIndex)
+    {
+        const EdgeFaceMap::iterator iter = m_EdgeFaces.find(GetEdgeKey(quad.iIndices[iEdgeIndex], quad.iIndices[(iEdgeIndex + 1) % 4]));
+        if (iter == m_EdgeFaces.end())
+            continue;
+
+        EdgeFaces& Faces = (*iter).second;
+        EraseFaceIndex(Faces.Quads, iQuadIndex);
+        if (Faces.Quads.empty() && Faces.Triangles.empty())
+        {
+            m_EdgeFaces.erase(iter);
+        }
+    }
+}
+
 void ExportSubDProcessMesh::CreateDegenerateGeometry()
 {
     if (m_BoundaryEdges.empty())
@@ -498,6 +600,7 @@ void ExportSubDProcessMesh::CreateDegenerateGeometry()
             quad.iIndices[3] = iPositionIndexA;
         }
         m_Quads.push_back(quad);
+        AddQuadEdges(static_cast<INT>(m_Quads.size() - 1));
 
         ++iter;
     }
@@ -821,45 +924,20 @@ XMFLOAT3 ExportSubDProcessMesh::GetQuadCenter(INT iQuadIndex)
 
 INT ExportSubDProcessMesh::FindTriangleWithEdge(INT iStartPositionIndex, INT iEndPositionIndex, INT iExcludeThisTriangle)
 {
-    const INT iTriangleCount = static_cast<INT>(m_Triangles.size());
-    for (INT i = 0; i < iTriangleCount; ++i)
-    {
-        if (i == iExcludeThisTriangle)
-            continue;
-
-        const Triangle& tri = m_Triangles[i];
-
-        if (tri.iIndices[0] != iStartPositionIndex && tri.iIndices[1] != iStartPositionIndex && tri.iIndices[2] != iStartPositionIndex)
-            continue;
+    const EdgeFaceMap::const_iterator iter = m_EdgeFaces.find(GetEdgeKey(iStartPositionIndex, iEndPositionIndex));
+    if (iter == m_EdgeFaces.end())
+        return -1;
 
-        if (tri.iIndices[0] != iEndPositionIndex && tri.iIndices[1] != iEndPositionIndex && tri.iIndices[2] != iEndPositionIndex)
-            continue;
-
-        return i;
-    }
-    return -1;
+    return FindFaceIndex((*iter).second.Triangles, iExcludeThisTriangle);
 }
 
 INT ExportSubDProcessMesh::FindQuadWithEdge(INT iStartPositionIndex, INT iEndPositionIndex, INT iExcludeThisQuad)
 {
-    const INT iQuadCount = static_cast<INT>(m_Quads.size());
-    for (INT i = 0; i < iQuadCount; ++i)
-    {
-        if (i == iExcludeThisQuad)
-            continue;
+    const EdgeFaceMap::const_iterator iter = m_EdgeFaces.find(GetEdgeKey(iStartPositionIndex, iEndPositionIndex));
+    if (iter == m_EdgeFaces.end())
+        return -1;
 
-        const Quad& quad = m_Quads[i];
-        for (INT iEdge = 0; iEdge < 4; ++iEdge)
-        {
-            const INT iCornerA = quad.iIndices[iEdge];
-            const INT iCornerB = quad.iIndices[(iEdge + 1) % 4];
-            if (iCornerA == iStartPositionIndex && iCornerB == iEndPositionIndex)
-                return i;
-            if (iCornerB == iStartPositionIndex && iCornerA == iEndPositionIndex)
-                return i;
-        }
-    }
-    return -1;
+    return FindFaceIndex((*iter).second.Quads, iExcludeThisQuad);
 }
 
 INT ExportSubDProcessMesh::FindLocalIndexInTriangle(INT iTriangleIndex, INT iPositionIndex)
@@ -1039,9 +1117,12 @@ void ExportSubDProcessMesh::RemoveValenceTwoQuads(std::deque<INT>& BadQuads)
             {
                 ExportLog::LogMsg(4, "Merging quad %d into quad %d, and eliminating quad %d.", iQuadBIndex, iQuadAIndex, iQuadBIndex);
 
-                // Merge the second quad into the first quad.
+                // Merge the second quad into the first quad, and move the first quad's
+                // entries in the edge index to its new edges.
                 bMatchedQuad = true;
+                RemoveQuadEdges(iQuadAIndex);
                 MergeQuads(QuadA, QuadB);
+                AddQuadEdges(iQuadAIndex);
 
                 // The first quad needs to have its adjacency recomputed.
                 QuadsForAdjacency.push_back(iQuadAIndex);
@@ -1075,67 +1156,331 @@ void ExportSubDProcessMesh::RemoveValenceTwoQuads(std::deque<INT>& BadQuads)
     }
 }
 
-bool QuadPatchSortPredicate(const ExportSubDProcessMesh::Quad& QuadA, const ExportSubDProcessMesh::Quad& QuadB)
+INT GetQuadPatchSortScore(const ExportSubDProcessMesh::Quad& Quad)
 {
-    INT iScoreA = 0;
-    if (!QuadA.bDegenerate)
+    INT iScore = 0;
+    if (!Quad.bDegenerate)
     {
-        iScoreA += QuadA.iMeshSubsetIndex;
-        if (QuadA.bValence[0] != 4 || QuadA.bValence[1] != 4 || QuadA.bValence[2] != 4 || QuadA.bValence[3] != 4)
+        iScore += Quad.iMeshSubsetIndex;
+        if (Quad.bValence[0] != 4 || Quad.bValence[1] != 4 || Quad.bValence[2] != 4 || Quad.bValence[3] != 4)
         {
-            iScoreA += 1000000;
+            iScore += 1000000;
         }
     }
+    return iScore;
+}
 
-    INT iScoreB = 0;
-    if (!QuadB.bDegenerate)
+INT GetTrianglePatchSortScore(const ExportSubDProcessMesh::Triangle& Triangle)
+{
+    INT iScore = Triangle.iMeshSubsetIndex;
+    if (Triangle.bValence[0] != 4 || Triangle.bValence[1] != 4 || Triangle.bValence[2] != 4)
     {
-        iScoreB += QuadB.iMeshSubsetIndex;
-        if (QuadB.bValence[0] != 4 || QuadB.bValence[1] != 4 || QuadB.bValence[2] != 4 || QuadB.bValence[3] != 4)
-        {
-            iScoreB += 1000000;
-        }
+        iScore += 1000000;
     }
+    return iScore;
+}
 
-    return iScoreA < iScoreB;
+bool QuadPatchSortPredicate(const ExportSubDProcessMesh::Quad& QuadA, const ExportSubDProcessMesh::Quad& QuadB)
+{
+    return GetQuadPatchSortScore(QuadA) < GetQuadPatchSortScore(QuadB);
 }
 
 bool TrianglePatchSortPredicate(const ExportSubDProcessMesh::Triangle& TriangleA, const ExportSubDProcessMesh::Triangle& TriangleB)
 {
-    INT iScoreA = TriangleA.iMeshSubsetIndex;
-    if (TriangleA.bValence[0] != 4 || TriangleA.bValence[1] != 4 || TriangleA.bValence[2] != 4)
+    return GetTrianglePatchSortScore(TriangleA) < GetTrianglePatchSortScore(TriangleB);
+}
+
+void ExportSubDProcessMesh::SortPatches()
+{
+    std::stable_sort(m_Quads.begin(), m_Quads.end(), QuadPatchSortPredicate);
+    std::stable_sort(m_Triangles.begin(), m_Triangles.end(), TrianglePatchSortPredicate);
+}
+
+namespace
+{
+    // Control points the vertex shader transforms before the hull shader runs; a
+    // regular quad patch uses 16, so the simulated cache holds two patches' worth.
+    constexpr size_t PATCH_CACHE_SIZE = ExportSubDProcessMesh::MAX_POINT_COUNT;
+
+    constexpr size_t PATCHES_PER_CHUNK = 1024;
+
+    inline bool IsDegeneratePatch(const ExportSubDProcessMesh::Quad& Quad) noexcept { return Quad.bDegenerate; }
+    inline bool IsDegeneratePatch(const ExportSubDProcessMesh::Triangle&) noexcept { return false; }
+
+    inline INT GetPatchSortScore(const ExportSubDProcessMesh::Quad& Quad) { return GetQuadPatchSortScore(Quad); }
+    inline INT GetPatchSortScore(const ExportSubDProcessMesh::Triangle& Triangle) { return GetTrianglePatchSortScore(Triangle); }
+
+    // Writes the mesh vertex indices a patch reads, in patch buffer order: the corners,
+    // then the neighbors.
+    template<typename PatchType>
+    size_t GetPatchControlPoints(const PatchType& Patch, const std::vector<INT>& PositionToMeshVertexMapping, INT* pControlPoints)
     {
-        iScoreA += 1000000;
+        size_t dwCount = 0;
+        for (const INT iMeshIndex : Patch.iMeshIndices)
+        {
+            pControlPoints[dwCount++] = iMeshIndex;
+        }
+        for (const INT iPositionIndex : Patch.iNeighbors)
+        {
+            if (iPositionIndex == -1)
+                break;
+            pControlPoints[dwCount++] = PositionToMeshVertexMapping[iPositionIndex];
+        }
+        return dwCount;
     }
 
-    INT iScoreB = TriangleB.iMeshSubsetIndex;
-    if (TriangleB.bValence[0] != 4 || TriangleB.bValence[1] != 4 || TriangleB.bValence[2] != 4)
+    // FIFO model of the post-transform vertex cache.  A vertex is cached if fewer
+    // than PATCH_CACHE_SIZE misses have occurred since it was loaded.
+    class PatchCacheSimulator
     {
-        iScoreB += 1000000;
+    public:
+        explicit PatchCacheSimulator(size_t dwVertexCount)
+            : m_LoadTimes(dwVertexCount, 0),
+            m_qwMissCount(PATCH_CACHE_SIZE)
+        {
+        }
+
+        bool IsCached(INT iMeshIndex) const noexcept { return (m_qwMissCount - m_LoadTimes[iMeshIndex]) < PATCH_CACHE_SIZE; }
+
+        void Access(INT iMeshIndex) noexcept
+        {
+            if (!IsCached(iMeshIndex))
+            {
+                m_LoadTimes[iMeshIndex] = m_qwMissCount++;
+            }
+        }
+
+        size_t GetMissCount() const noexcept { return static_cast<size_t>(m_qwMissCount - PATCH_CACHE_SIZE); }
+
+    private:
+        std::vector<UINT64> m_LoadTimes;
+        UINT64              m_qwMissCount;
+    };
+
+    // ACMR is control point cache misses per patch; ATVR is misses per distinct
+    // control point, with 1.0 the ideal.
+    template<typename PatchType>
+    void ComputePatchCacheMissRate(const std::vector<PatchType>& Patches, const std::vector<INT>& PositionToMeshVertexMapping, size_t dwVertexCount, float& fACMR, float& fATVR)
+    {
+        PatchCacheSimulator Cache(dwVertexCount);
+        std::vector<bool> Referenced(dwVertexCount, false);
+        size_t dwPatchCount = 0;
+        size_t dwReferencedCount = 0;
+
+        INT iControlPoints[ExportSubDProcessMesh::MAX_POINT_COUNT];
+        for (const PatchType& Patch : Patches)
+        {
+            if (IsDegeneratePatch(Patch))
+                continue;
+
+            const size_t dwCount = GetPatchControlPoints(Patch, PositionToMeshVertexMapping, iControlPoints);
+            for (size_t i = 0; i < dwCount; ++i)
+            {
+                Cache.Access(iControlPoints[i]);
+                if (!Referenced[iControlPoints[i]])
+                {
+                    Referenced[iControlPoints[i]] = true;
+                    ++dwReferencedCount;
+                }
+            }
+            ++dwPatchCount;
+        }
+
+        const float fMissCount = static_cast<float>(Cache.GetMissCount());
+        fACMR = dwPatchCount ? fMissCount / static_cast<float>(dwPatchCount) : 0.0f;
+        fATVR = dwReferencedCount ? fMissCount / static_cast<float>(dwReferencedCount) : 0.0f;
     }
 
-    return iScoreA < iScoreB;
+    // Greedy reordering for control point reuse.  Patches only move within runs of
+    // equal sort score, so the subset and regular/extraordinary grouping from
+    // SortPatches is kept.  After each patch, the next is the unplaced patch in the
+    // run that shares a corner position with it and has the most control points
+    // still cached; if there is none, the first unplaced patch in the run.
+    template<typename PatchType>
+    void ReorderPatchesForCache(std::vector<PatchType>& Patches, size_t dwPositionCount, const std::vector<INT>& PositionToMeshVertexMapping, size_t dwVertexCount)
+    {
+        constexpr size_t CORNER_COUNT = sizeof(PatchType::iIndices) / sizeof(INT);
+        const size_t dwPatchCount = Patches.size();
+        if (dwPatchCount < 2)
+            return;
+
+        // Patches that use each position as a corner, as offsets into CornerPatches.
+        std::vector<UINT> CornerStart(dwPositionCount + 1, 0);
+        for (const PatchType& Patch : Patches)
+        {
+            for (const INT iPositionIndex : Patch.iIndices)
+            {
+                ++CornerStart[iPositionIndex + 1];
+            }
+        }
+        for (size_t i = 0; i < dwPositionCount; ++i)
+        {
+            CornerStart[i + 1] += CornerStart[i];
+        }
+        std::vector<UINT> CornerPatches(CornerStart[dwPositionCount]);
+        {
+            std::vector<UINT> CornerFill(CornerStart.begin(), CornerStart.end() - 1);
+            for (size_t i = 0; i < dwPatchCount; ++i)
+            {
+                for (const INT iPositionIndex : Patches[i].iIndices)
+                {
+                    CornerPatches[CornerFill[iPositionIndex]++] = static_cast<UINT>(i);
+                }
+            }
+        }
+
+        PatchCacheSimulator Cache(dwVertexCount);
+        std::vector<bool> Placed(dwPatchCount, false);
+        std::vector<UINT> Order;
+        Order.reserve(dwPatchCount);
+
+        INT iControlPoints[ExportSubDProcessMesh::MAX_POINT_COUNT];
+        size_t dwRunStart = 0;
+        while (dwRunStart < dwPatchCount)
+        {
+            const INT iRunScore = GetPatchSortScore(Patches[dwRunStart]);
+            size_t dwRunEnd = dwRunStart + 1;
+            while (dwRunEnd < dwPatchCount && GetPatchSortScore(Patches[dwRunEnd]) == iRunScore)
+            {
+                ++dwRunEnd;
+            }
+
+            // Degenerate patches are not written, so they keep their place at the
+            // front of the run.
+            size_t dwNextUnplaced = dwRunStart;
+            for (size_t i = dwRunStart; i < dwRunEnd; ++i)
+            {
+                if (IsDegeneratePatch(Patches[i]))
+                {
+                    Order.push_back(static_cast<UINT>(i));
+                    Placed[i] = true;
+                }
+            }
+
+            for (;;)
+            {
+                while (dwNextUnplaced < dwRunEnd && Placed[dwNextUnplaced])
+                {
+                    ++dwNextUnplaced;
+                }
+                if (dwNextUnplaced == dwRunEnd)
+                    break;
+
+                size_t dwCurrent = dwNextUnplaced;
+                for (;;)
+                {
+                    Placed[dwCurrent] = true;
+                    Order.push_back(static_cast<UINT>(dwCurrent));
+
+                    const PatchType& Current = Patches[dwCurrent];
+                    const size_t dwCount = GetPatchControlPoints(Current, PositionToMeshVertexMapping, iControlPoints);
+                    for (size_t i = 0; i < dwCount; ++i)
+                    {
+                        Cache.Access(iControlPoints[i]);
+                    }
+
+                    size_t dwBest = dwPatchCount;
+                    size_t dwBestHits = 0;
+                    for (size_t dwCorner = 0; dwCorner < CORNER_COUNT; ++dwCorner)
+                    {
+                        const INT iPositionIndex = Current.iIndices[dwCorner];
+                        for (UINT j = CornerStart[iPositionIndex]; j < CornerStart[iPositionIndex + 1]; ++j)
+                        {
+                            const size_t dwCandidate = CornerPatches[j];
+                            if (Placed[dwCandidate] || dwCandidate < dwRunStart || dwCandidate >= dwRunEnd)
+                                continue;
+
+                            const size_t dwCandidateCount = GetPatchControlPoints(Patches[dwCandidate], PositionToMeshVertexMapping, iControlPoints);
+                            size_t dwHits = 0;
+                            for (size_t i = 0; i < dwCandidateCount; ++i)
+                            {
+                                if (Cache.IsCached(iControlPoints[i]))
+                                    ++dwHits;
+                            }
+
+                            // ties go to the earlier patch, so the result is deterministic
+                            if (dwHits > dwBestHits || (dwHits == dwBestHits && dwHits > 0 && dwCandidate < dwBest))
+                            {
+                                dwBest = dwCandidate;
+                                dwBestHits = dwHits;
+                            }
+                        }
+                    }
+
+                    if (dwBest == dwPatchCount)
+                        break;
+                    dwCurrent = dwBest;
+                }
+            }
+
+            dwRunStart = dwRunEnd;
+        }
+
+        assert(Order.size() == dwPatchCount);
+
+        std::vector<PatchType> Reordered;
+        Reordered.reserve(dwPatchCount);
+        for (const UINT i : Order)
+        {
+            Reordered.push_back(Patches[i]);
+        }
+
+        // The greedy order is not guaranteed to beat the sorted order; keep whichever
+        // misses less.
+        float fOldACMR, fNewACMR, fATVR;
+        ComputePatchCacheMissRate(Patches, PositionToMeshVertexMapping, dwVertexCount, fOldACMR, fATVR);
+        ComputePatchCacheMissRate(Reordered, PositionToMeshVertexMapping, dwVertexCount, fNewACMR, fATVR);
+        if (fNewACMR < fOldACMR)
+        {
+            Patches.swap(Reordered);
+        }
+    }
 }
 
-void ExportSubDProcessMesh::SortPatches()
+void ExportSubDProcessMesh::ReorderPatches()
 {
-    std::stable_sort(m_Quads.begin(), m_Quads.end(), QuadPatchSortPredicate);
-    std::stable_sort(m_Triangles.begin(), m_Triangles.end(), TrianglePatchSortPredicate);
+    const ULONGLONG qwStartTime = GetTickCount64();
+
+    const size_t dwVertexCount = m_pPolyMesh->GetVB()->GetVertexCount();
+    ReorderPatchesForCache(m_Quads, m_Positions.size(), m_PositionToMeshVertexMapping, dwVertexCount);
+    ReorderPatchesForCache(m_Triangles, m_Positions.size(), m_PositionToMeshVertexMapping, dwVertexCount);
+
+    ExportLog::LogMsg(3, "Reordering subdivision surface patches took %llu ms.", GetTickCount64() - qwStartTime);
+}
+
+void ExportSubDProcessMesh::LogPatchCacheMissRates(const CHAR* strWhen)
+{
+    const size_t dwVertexCount = m_pPolyMesh->GetVB()->GetVertexCount();
+
+    float fACMR = 0;
+    float fATVR = 0;
+    if (!m_Quads.empty())
+    {
+        ComputePatchCacheMissRate(m_Quads, m_PositionToMeshVertexMapping, dwVertexCount, fACMR, fATVR);
+        ExportLog::LogMsg(4, "Quad patch control point cache miss rate %s - ACMR %f, ATVR %f", strWhen, fACMR, fATVR);
+    }
+    if (!m_Triangles.empty())
+    {
+        ComputePatchCacheMissRate(m_Triangles, m_PositionToMeshVertexMapping, dwVertexCount, fACMR, fATVR);
+        ExportLog::LogMsg(4, "Triangle patch control point cache miss rate %s - ACMR %f, ATVR %f", strWhen, fACMR, fATVR);
+    }
 }
 
 void ExportSubDProcessMesh::BuildQuadPatchBuffer()
 {
     const size_t dwQuadCount = m_Quads.size();
 
-    size_t dwActiveQuadCount = 0;
+    std::vector<UINT> ActiveQuads;
+    ActiveQuads.reserve(dwQuadCount);
     for (size_t i = 0; i < dwQuadCount; ++i)
     {
         if (!m_Quads[i].bDegenerate)
         {
-            ++dwActiveQuadCount;
+            ActiveQuads.push_back(static_cast<UINT>(i));
         }
     }
 
+    const size_t dwActiveQuadCount = ActiveQuads.size();
     if (dwActiveQuadCount == 0)
         return;
 
@@ -1150,40 +1495,42 @@ void ExportSubDProcessMesh::BuildQuadPatchBuffer()
     m_pQuadPatchIB->SetIndexSize(4);
     m_pQuadPatchIB->Allocate();
 
-    auto pIndexData = reinterpret_cast<DWORD*>(m_pQuadPatchIB->GetIndexData());
-
-    DWORD dwIndex = 0;
-    for (size_t i = 0; i < dwQuadCount; ++i)
+    // Each patch owns its own slot in both buffers, so chunks of patches are written
+    // on the worker threads.
+    auto pIndexBase = reinterpret_cast<DWORD*>(m_pQuadPatchIB->GetIndexData());
+    const size_t dwChunkCount = (dwActiveQuadCount + PATCHES_PER_CHUNK - 1) / PATCHES_PER_CHUNK;
+    ExportParallelFor(dwChunkCount, [&](size_t dwChunk)
     {
-        const Quad& quad = m_Quads[i];
-        if (quad.bDegenerate)
-            continue;
+        const size_t dwFirst = dwChunk * PATCHES_PER_CHUNK;
+        const size_t dwLast = std::min(dwFirst + PATCHES_PER_CHUNK, dwActiveQuadCount);
+        for (size_t dwIndex = dwFirst; dwIndex < dwLast; ++dwIndex)
+        {
+            const Quad& quad = m_Quads[ActiveQuads[dwIndex]];
 
-        auto pPatchData = reinterpret_cast<PatchData*>(m_pQuadPatchDataVB->GetVertex(dwIndex));
-        ZeroMemory(pPatchData, sizeof(PatchData));
+            auto pPatchData = reinterpret_cast<PatchData*>(m_pQuadPatchDataVB->GetVertex(dwIndex));
+            ZeroMemory(pPatchData, sizeof(PatchData));
 
-        for (DWORD j = 0; j < 4; ++j)
-        {
-            pPatchData->bValence[j] = quad.bValence[j];
-            pPatchData->bPrefix[j] = quad.bPrefix[j];
-        }
+            for (DWORD j = 0; j < 4; ++j)
+            {
+                pPatchData->bValence[j] = quad.bValence[j];
+                pPatchData->bPrefix[j] = quad.bPrefix[j];
+            }
 
-        memcpy(pIndexData, quad.iMeshIndices, 4 * sizeof(INT));
+            DWORD* pIndexData = pIndexBase + dwIndex * MAX_POINT_COUNT;
+            memcpy(pIndexData, quad.iMeshIndices, 4 * sizeof(INT));
 
-        for (DWORD j = 0; j < MAX_QUAD_NEIGHBOR_COUNT; ++j)
-        {
-            const INT iPositionIndex = quad.iNeighbors[j];
-            if (iPositionIndex != -1)
+            for (DWORD j = 0; j < MAX_QUAD_NEIGHBOR_COUNT; ++j)
             {
-                const INT iMeshIndex = m_PositionToMeshVertexMapping[iPositionIndex];
-                assert(iMeshIndex != -1);
-                pIndexData[j + 4] = static_cast<DWORD>(iMeshIndex);
+                const INT iPositionIndex = quad.iNeighbors[j];
+                if (iPositionIndex != -1)
+                {
+                    const INT iMeshIndex = m_PositionToMeshVertexMapping[iPositionIndex];
+                    assert(iMeshIndex != -1);
+                    pIndexData[j + 4] = static_cast<DWORD>(iMeshIndex);
+                }
             }
         }
-
-        ++dwIndex;
-        pIndexData += MAX_POINT_COUNT;
-    }
+    });
 }
 
 void ExportSubDProcessMesh::BuildTriPatchBuffer()
@@ -1203,34 +1550,39 @@ void ExportSubDProcessMesh::BuildTriPatchBuffer()
     m_pTrianglePatchIB->SetIndexSize(4);
     m_pTrianglePatchIB->Allocate();
 
-    auto pIndexData = reinterpret_cast<DWORD*>(m_pTrianglePatchIB->GetIndexData());
-    for (size_t i = 0; i < dwTriangleCount; ++i)
+    auto pIndexBase = reinterpret_cast<DWORD*>(m_pTrianglePatchIB->GetIndexData());
+    const size_t dwChunkCount = (dwTriangleCount + PATCHES_PER_CHUNK - 1) / PATCHES_PER_CHUNK;
+    ExportParallelFor(dwChunkCount, [&](size_t dwChunk)
     {
-        const Triangle& Triangle = m_Triangles[i];
-        auto pPatchData = reinterpret_cast<PatchData*>(m_pTrianglePatchDataVB->GetVertex(i));
-        ZeroMemory(pPatchData, sizeof(PatchData));
-
-        for (DWORD j = 0; j < 3; ++j)
+        const size_t dwFirst = dwChunk * PATCHES_PER_CHUNK;
+        const size_t dwLast = std::min(dwFirst + PATCHES_PER_CHUNK, dwTriangleCount);
+        for (size_t i = dwFirst; i < dwLast; ++i)
         {
-            pPatchData->bValence[j] = Triangle.bValence[j];
-            pPatchData->bPrefix[j] = Triangle.bPrefix[j];
-        }
+            const Triangle& Triangle = m_Triangles[i];
+            auto pPatchData = reinterpret_cast<PatchData*>(m_pTrianglePatchDataVB->GetVertex(i));
+            ZeroMemory(pPatchData, sizeof(PatchData));
+
+            for (DWORD j = 0; j < 3; ++j)
+            {
+                pPatchData->bValence[j] = Triangle.bValence[j];
+                pPatchData->bPrefix[j] = Triangle.bPrefix[j];
+            }
 
-        memcpy(pIndexData, Triangle.iMeshIndices, 3 * sizeof(INT));
+            DWORD* pIndexData = pIndexBase + i * MAX_POINT_COUNT;
+            memcpy(pIndexData, Triangle.iMeshIndices, 3 * sizeof(INT));
 
-        for (DWORD j = 0; j < MAX_TRIANGLE_NEIGHBOR_COUNT; ++j)
-        {
-            const INT iPositionIndex = Triangle.iNeighbors[j];
-            if (iPositionIndex != -1)
+            for (DWORD j = 0; j < MAX_TRIANGLE_NEIGHBOR_COUNT; ++j)
             {
-                const INT iMeshIndex = m_PositionToMeshVertexMapping[iPositionIndex];
-                assert(iMeshIndex != -1);
-                pIndexData[j + 3] = static_cast<DWORD>(iMeshIndex);
+                const INT iPositionIndex = Triangle.iNeighbors[j];
+                if (iPositionIndex != -1)
+                {
+                    const INT iMeshIndex = m_PositionToMeshVertexMapping[iPositionIndex];
+                    assert(iMeshIndex != -1);
+                    pIndexData[j + 3] = static_cast<DWORD>(iMeshIndex);
+                }
             }
         }
-
-        pIndexData += MAX_POINT_COUNT;
-    }
+    });
 }
 
 void ExportSubDProcessMesh::ConvertSubsets()
@@ -24,6 +24,60 @@ namespace ATG
         DWORD           dwPatchCount;
     };
 
+    // Welds equal positions to a single index in constant expected time.  Positions
+    // compare per component, as XMVector3Equal does, so +0 and -0 weld together and
+    // NaN positions never weld.
+    class ExportPositionWelder
+    {
+    public:
+        void Clear() { m_Lookup.clear(); }
+        void Reserve(size_t dwPositionCount) { m_Lookup.reserve(dwPositionCount); }
+
+        // Returns the index of a previously added equal position, or adds vPosition
+        // with iNewIndex and returns iNewIndex.
+        INT FindOrAdd(const DirectX::XMFLOAT3& vPosition, INT iNewIndex)
+        {
+            return m_Lookup.emplace(vPosition, iNewIndex).first->second;
+        }
+
+    protected:
+        struct PositionHash
+        {
+            size_t operator()(const DirectX::XMFLOAT3& vPosition) const noexcept
+            {
+                constexpr ULONGLONG FNV_OFFSET_BASIS = 14695981039346656037ULL;
+                constexpr ULONGLONG FNV_PRIME = 1099511628211ULL;
+
+                // -0 must hash like +0, since the two compare equal.
+                const float fComponents[3] =
+                {
+                    (vPosition.x == 0.0f) ? 0.0f : vPosition.x,
+                    (vPosition.y == 0.0f) ? 0.0f : vPosition.y,
+                    (vPosition.z == 0.0f) ? 0.0f : vPosition.z
+                };
+
+                ULONGLONG qwHash = FNV_OFFSET_BASIS;
+                for (const float fComponent : fComponents)
+                {
+                    uint32_t uBits;
+                    memcpy(&uBits, &fComponent, sizeof(uBits));
+                    qwHash = (qwHash ^ uBits) * FNV_PRIME;
+                }
+                return static_cast<size_t>(qwHash ^ (qwHash >> 32));
+            }
+        };
+        struct PositionEqual
+        {
+            bool operator()(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b) const noexcept
+            {
+                return a.x == b.x && a.y == b.y && a.z == b.z;
+            }
+        };
+        using PositionMap = std::unordered_map< DirectX::XMFLOAT3, INT, PositionHash, PositionEqual >;
+
+        PositionMap m_Lookup;
+    };
+
     class ExportSubDProcessMesh
     {
     public:
@@ -69,6 +123,16 @@ namespace ATG
         };
         using EdgeMap = std::unordered_map< UINT64, Edge >;
 
+        // Every face that uses an edge, in ascending index order, so a lookup returns
+        // the same face that a scan of m_Triangles or m_Quads would find first.  The
+        // index is stale once SortPatches reorders the faces.
+        struct EdgeFaces
+        {
+            std::vector< INT >  Triangles;
+            std::vector< INT >  Quads;
+        };
+        using EdgeFaceMap = std::unordered_map< UINT64, EdgeFaces >;
+
         std::vector< Triangle >             m_Triangles;
         std::vector< Quad >                 m_Quads;
         std::vector< DirectX::XMFLOAT3 >    m_Positions;
@@ -77,6 +141,8 @@ namespace ATG
         std::vector< INT >                  m_PositionToDegeneratePositionMapping;
         std::vector< INT >                  m_IncidentBoundaryEdgesPerPosition;
         EdgeMap                             m_BoundaryEdges;
+        EdgeFaceMap                         m_EdgeFaces;
+        ExportPositionWelder                m_PositionWelder;
 
         ExportMesh* m_pPolyMesh;
         ExportIB* m_pQuadPatchIB;
@@ -114,6 +180,11 @@ namespace ATG
         void BuildBoundaryEdgeTable();
         INT AddOrRemoveEdge(INT iPositionIndexA, INT iPositionIndexB, INT iTriangleIndex, INT iQuadIndex, INT iLocalIndex);
 
+        static UINT64 GetEdgeKey(INT iPositionIndexA, INT iPositionIndexB) noexcept;
+        void AddTriangleEdges(INT iTriangleIndex);
+        void AddQuadEdges(INT iQuadIndex);
+        void RemoveQuadEdges(INT iQuadIndex);
+
         void CreateDegenerateGeometry();
         INT CreateOrAddDegeneratePosition(INT iPositionIndex);
 
@@ -134,6 +205,8 @@ namespace ATG
         DirectX::XMFLOAT3 GetQuadCenter(INT iQuadIndex);
 
         void SortPatches();
+        void ReorderPatches();
+        void LogPatchCacheMissRates(const CHAR* strWhen);
 
         void BuildQuadPatchBuffer();
         void BuildTriPatchBuffer();
@@ -13,8 +13,339 @@
 #include "stdafx.h"
 #include "ExportXmlParser.h"
 
+#include <intrin.h>
+
 using namespace ATG;
 
+namespace
+{
+    //-------------------------------------------------------------------------------------
+    // SSE2 scanning helpers for the mapped parser.  Each loads 16 bytes at a time and
+    // never reads past pEnd.
+    //-------------------------------------------------------------------------------------
+    inline UINT FirstSetBit(int iMask) noexcept
+    {
+        unsigned long uIndex = 0;
+        _BitScanForward(&uIndex, static_cast<unsigned long>(iMask));
+        return uIndex;
+    }
+
+    inline const CHAR* FindChar(const CHAR* p, const CHAR* pEnd, CHAR c) noexcept
+    {
+        const __m128i vC = _mm_set1_epi8(c);
+        while (pEnd - p >= 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const int iMask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, vC));
+            if (iMask)
+                return p + FirstSetBit(iMask);
+            p += 16;
+        }
+        while (p < pEnd && *p != c)
+            ++p;
+        return p;
+    }
+
+    inline const CHAR* FindEitherChar(const CHAR* p, const CHAR* pEnd, CHAR a, CHAR b) noexcept
+    {
+        const __m128i vA = _mm_set1_epi8(a);
+        const __m128i vB = _mm_set1_epi8(b);
+        while (pEnd - p >= 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const int iMask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, vA), _mm_cmpeq_epi8(v, vB)));
+            if (iMask)
+                return p + FirstSetBit(iMask);
+            p += 16;
+        }
+        while (p < pEnd && *p != a && *p != b)
+            ++p;
+        return p;
+    }
+
+    // Finds a three character terminator such as "-->" or "]]>".
+    inline const CHAR* FindTerminator(const CHAR* p, const CHAR* pEnd, const CHAR* strTerminator) noexcept
+    {
+        for (;;)
+        {
+            p = FindChar(p, pEnd, strTerminator[0]);
+            if (pEnd - p < 3)
+                return pEnd;
+            if (p[1] == strTerminator[1] && p[2] == strTerminator[2])
+                return p;
+            ++p;
+        }
+    }
+
+    inline bool IsSpace(CHAR c) noexcept
+    {
+        return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+    }
+
+    inline bool IsWhitespaceOnly(const CHAR* p, const CHAR* pEnd) noexcept
+    {
+        const __m128i vSpace = _mm_set1_epi8(' ');
+        const __m128i vTab = _mm_set1_epi8('\t');
+        const __m128i vLF = _mm_set1_epi8('\n');
+        const __m128i vCR = _mm_set1_epi8('\r');
+        while (pEnd - p >= 16)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i vIsSpace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, vSpace), _mm_cmpeq_epi8(v, vTab)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, vLF), _mm_cmpeq_epi8(v, vCR)));
+            if (_mm_movemask_epi8(vIsSpace) != 0xFFFF)
+                return false;
+            p += 16;
+        }
+        for (; p < pEnd; ++p)
+        {
+            if (!IsSpace(*p))
+                return false;
+        }
+        return true;
+    }
+
+    inline const CHAR* SkipSpace(const CHAR* p, const CHAR* pEnd) noexcept
+    {
+        while (p < pEnd && IsSpace(*p))
+            ++p;
+        return p;
+    }
+
+    inline bool IsNameStartChar(CHAR c) noexcept
+    {
+        return ((c >= 'A') && (c <= 'Z')) || ((c >= 'a') && (c <= 'z')) || (c == '_') || (c == ':');
+    }
+
+    inline bool IsNameChar(CHAR c) noexcept
+    {
+        return IsNameStartChar(c) || ((c >= '0') && (c <= '9')) || (c == '-') || (c == '.');
+    }
+
+    inline const CHAR* SkipName(const CHAR* p, const CHAR* pEnd) noexcept
+    {
+        while (p < pEnd && IsNameChar(*p))
+            ++p;
+        return p;
+    }
+
+    // Appends the UTF-8 encoding of a character reference.
+    CHAR* EncodeUTF8(CHAR* pDest, UINT uCodePoint) noexcept
+    {
+        if (uCodePoint < 0x80)
+        {
+            *pDest++ = static_cast<CHAR>(uCodePoint);
+        }
+        else if (uCodePoint < 0x800)
+        {
+            *pDest++ = static_cast<CHAR>(0xC0 | (uCodePoint >> 6));
+            *pDest++ = static_cast<CHAR>(0x80 | (uCodePoint & 0x3F));
+        }
+        else if (uCodePoint < 0x10000)
+        {
+            *pDest++ = static_cast<CHAR>(0xE0 | (uCodePoint >> 12));
+            *pDest++ = static_cast<CHAR>(0x80 | ((uCodePoint >> 6) & 0x3F));
+            *pDest++ = static_cast<CHAR>(0x80 | (uCodePoint & 0x3F));
+        }
+        else
+        {
+            *pDest++ = static_cast<CHAR>(0xF0 | (uCodePoint >> 18));
+            *pDest++ = static_cast<CHAR>(0x80 | ((uCodePoint >> 12) & 0x3F));
+            *pDest++ = static_cast<CHAR>(0x80 | ((uCodePoint >> 6) & 0x3F));
+            *pDest++ = static_cast<CHAR>(0x80 | (uCodePoint & 0x3F));
+        }
+        return pDest;
+    }
+
+    // Decodes escapes (when requested) and widens a UTF-8 span for the WCHAR callbacks.
+    bool WidenSpan(const CHAR* pSrc, UINT SrcLen, bool bDecodeEscapes, std::vector<CHAR>& Decoded, std::vector<WCHAR>& Dest)
+    {
+        if (bDecodeEscapes && memchr(pSrc, '&', SrcLen))
+        {
+            Decoded.resize(SrcLen);
+            UINT DecodedLen = 0;
+            if (!XMLDecodeSpan(pSrc, SrcLen, Decoded.data(), DecodedLen))
+                return false;
+            pSrc = Decoded.data();
+            SrcLen = DecodedLen;
+        }
+
+        Dest.resize(SrcLen);
+        if (SrcLen == 0)
+            return true;
+
+        const int iLength = MultiByteToWideChar(CP_UTF8, 0, pSrc, static_cast<int>(SrcLen), Dest.data(), static_cast<int>(SrcLen));
+        if (iLength <= 0)
+            return false;
+        Dest.resize(static_cast<size_t>(iLength));
+        return true;
+    }
+}
+
+
+//-------------------------------------------------------------------------------------
+// Name: XMLDecodeSpan
+// Desc: Decodes character and entity references in a UTF-8 span
+//-------------------------------------------------------------------------------------
+bool ATG::XMLDecodeSpan(const CHAR* pSrc, UINT SrcLen, CHAR* pDest, UINT& DestLen)
+{
+    const CHAR* pEnd = pSrc + SrcLen;
+    CHAR* pOut = pDest;
+    while (pSrc < pEnd)
+    {
+        const CHAR* pAmp = FindChar(pSrc, pEnd, '&');
+        memmove(pOut, pSrc, static_cast<size_t>(pAmp - pSrc));
+        pOut += pAmp - pSrc;
+        if (pAmp == pEnd)
+            break;
+
+        const CHAR* pSemicolon = FindChar(pAmp, pEnd, ';');
+        if (pSemicolon == pEnd)
+            return false;
+
+        const CHAR* pRef = pAmp + 1;
+        const size_t RefLen = static_cast<size_t>(pSemicolon - pRef);
+        if (RefLen >= 2 && pRef[0] == '#')
+        {
+            UINT uValue = 0;
+            const bool bHex = (pRef[1] == 'x');
+            for (const CHAR* p = pRef + (bHex ? 2 : 1); p < pSemicolon; ++p)
+            {
+                const CHAR c = *p;
+                UINT uDigit;
+                if ((c >= '0') && (c <= '9'))
+                    uDigit = static_cast<UINT>(c - '0');
+                else if (bHex && (c >= 'a') && (c <= 'f'))
+                    uDigit = static_cast<UINT>(c - 'a' + 10);
+                else if (bHex && (c >= 'A') && (c <= 'F'))
+                    uDigit = static_cast<UINT>(c - 'A' + 10);
+                else
+                    return false;
+                uValue = uValue * (bHex ? 16 : 10) + uDigit;
+                if (uValue > 0x10FFFF)
+                    return false;
+            }
+            pOut = EncodeUTF8(pOut, uValue);
+        }
+        else if (RefLen == 2 && !strncmp(pRef, "lt", 2))
+            *pOut++ = '<';
+        else if (RefLen == 2 && !strncmp(pRef, "gt", 2))
+            *pOut++ = '>';
+        else if (RefLen == 3 && !strncmp(pRef, "amp", 3))
+            *pOut++ = '&';
+        else if (RefLen == 4 && !strncmp(pRef, "apos", 4))
+            *pOut++ = '\'';
+        else if (RefLen == 4 && !strncmp(pRef, "quot", 4))
+            *pOut++ = '"';
+        else
+            return false;
+
+        pSrc = pSemicolon + 1;
+    }
+    DestLen = static_cast<UINT>(pOut - pDest);
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Name: ISAXCallback span defaults
+// Desc: Forward UTF-8 spans from the mapped parser to the WCHAR callbacks.  A span
+//       that cannot be decoded returns E_INVALID_XML_SYNTAX, which the parser reports
+//       with the line and position of the span.
+//-------------------------------------------------------------------------------------
+HRESULT ISAXCallback::ElementBeginSpan(const CHAR* strName, UINT NameLen,
+    const XMLSpanAttribute* pAttributes, UINT NumAttributes)
+{
+    std::vector<CHAR> Decoded;
+    std::vector<WCHAR> Name;
+    if (!WidenSpan(strName, NameLen, false, Decoded, Name))
+        return E_INVALID_XML_SYNTAX;
+
+    // Widen every attribute into one buffer, then point the attributes into it once it
+    // has stopped growing.
+    std::vector<WCHAR> AttributeText;
+    std::vector<WCHAR> Widened;
+    UINT Offsets[XML_MAX_ATTRIBUTES_PER_ELEMENT * 2] = {};
+    XMLAttribute Attributes[XML_MAX_ATTRIBUTES_PER_ELEMENT] = {};
+    for (UINT i = 0; i < NumAttributes; ++i)
+    {
+        if (!WidenSpan(pAttributes[i].strName, pAttributes[i].NameLen, false, Decoded, Widened))
+            return E_INVALID_XML_SYNTAX;
+        Offsets[i * 2] = static_cast<UINT>(AttributeText.size());
+        Attributes[i].NameLen = static_cast<UINT>(Widened.size());
+        AttributeText.insert(AttributeText.end(), Widened.begin(), Widened.end());
+
+        if (!WidenSpan(pAttributes[i].strValue, pAttributes[i].ValueLen, true, Decoded, Widened))
+            return E_INVALID_XML_SYNTAX;
+        Offsets[i * 2 + 1] = static_cast<UINT>(AttributeText.size());
+        Attributes[i].ValueLen = static_cast<UINT>(Widened.size());
+        AttributeText.insert(AttributeText.end(), Widened.begin(), Widened.end());
+    }
+    for (UINT i = 0; i < NumAttributes; ++i)
+    {
+        Attributes[i].strName = AttributeText.data() + Offsets[i * 2];
+        Attributes[i].strValue = AttributeText.data() + Offsets[i * 2 + 1];
+    }
+
+    return ElementBegin(Name.data(), static_cast<UINT>(Name.size()), Attributes, NumAttributes);
+}
+
+HRESULT ISAXCallback::ElementContentSpan(const CHAR* strData, UINT DataLen)
+{
+    std::vector<CHAR> Decoded;
+    std::vector<WCHAR> Content;
+    if (!WidenSpan(strData, DataLen, true, Decoded, Content))
+        return E_INVALID_XML_SYNTAX;
+
+    // Deliver the content in the same size pieces as ParseXMLFile.
+    const UINT ContentLen = static_cast<UINT>(Content.size());
+    for (UINT Start = 0; ; Start += XML_WRITE_BUFFER_SIZE)
+    {
+        const UINT Length = std::min(ContentLen - Start, XML_WRITE_BUFFER_SIZE);
+        const bool bMore = (Start + Length) < ContentLen;
+        const HRESULT hr = ElementContent(Content.data() + Start, Length, bMore);
+        if (FAILED(hr) || !bMore)
+            return hr;
+    }
+}
+
+HRESULT ISAXCallback::ElementEndSpan(const CHAR* strName, UINT NameLen)
+{
+    std::vector<CHAR> Decoded;
+    std::vector<WCHAR> Name;
+    if (!WidenSpan(strName, NameLen, false, Decoded, Name))
+        return E_INVALID_XML_SYNTAX;
+
+    return ElementEnd(Name.data(), static_cast<UINT>(Name.size()));
+}
+
+HRESULT ISAXCallback::CDATASpan(const CHAR* strCDATA, UINT CDATALen)
+{
+    std::vector<CHAR> Decoded;
+    std::vector<WCHAR> Data;
+    if (!WidenSpan(strCDATA, CDATALen, false, Decoded, Data))
+        return E_INVALID_XML_SYNTAX;
+
+    HRESULT hr = CDATABegin();
+    if (FAILED(hr))
+        return hr;
+
+    const UINT DataLen = static_cast<UINT>(Data.size());
+    for (UINT Start = 0; ; Start += XML_WRITE_BUFFER_SIZE)
+    {
+        const UINT Length = std::min(DataLen - Start, XML_WRITE_BUFFER_SIZE);
+        const bool bMore = (Start + Length) < DataLen;
+        hr = CDATAData(Data.data() + Start, Length, bMore);
+        if (FAILED(hr))
+            return hr;
+        if (!bMore)
+            break;
+    }
+
+    return CDATAEnd();
+}
+
+
 //-------------------------------------------------------------------------------------
 // Name: XMLParser::XMLParser
 //-------------------------------------------------------------------------------------
@@ -934,6 +1265,340 @@ HRESULT XMLParser::ParseXMLBuffer(const CHAR* strBuffer, UINT uBufferSize)
     return hr;
 }
 
+
+//-------------------------------------------------------------------------------------
+// Name: XMLParser::SetSpanPosition
+// Desc: Computes the line number and position of a point in a mapped buffer.  The
+//       span parser does not track these while scanning, so this is only called
+//       before an error is reported
+//-------------------------------------------------------------------------------------
+void XMLParser::SetSpanPosition(const CHAR* pStart, const CHAR* pPosition)
+{
+    UINT LineNum = 1;
+    const CHAR* pLineStart = pStart;
+    for (const CHAR* p = FindChar(pStart, pPosition, '\n'); p < pPosition; p = FindChar(p + 1, pPosition, '\n'))
+    {
+        ++LineNum;
+        pLineStart = p + 1;
+    }
+
+    m_pISAXCallback->m_LineNum = LineNum;
+    m_pISAXCallback->m_LinePos = static_cast<UINT>(pPosition - pLineStart) + 1;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Name: XMLParser::SpanParseLoop
+// Desc: Parses an 8-bit buffer in place, accepting the same syntax as MainParseLoop.
+//       Content is scanned 16 bytes at a time for the next '<', and tags for their
+//       closing quote or '>', so no character is copied
+//-------------------------------------------------------------------------------------
+HRESULT XMLParser::SpanParseLoop(const CHAR* pStart, const CHAR* pEnd)
+{
+    HRESULT hr = S_OK;
+
+    if (FAILED(m_pISAXCallback->StartDocument()))
+        return E_ABORT;
+
+    const CHAR* p = pStart;
+
+    // Skip a UTF-8 byte order mark
+    if ((pEnd - p >= 3) && (static_cast<BYTE>(p[0]) == 0xEF) && (static_cast<BYTE>(p[1]) == 0xBB) && (static_cast<BYTE>(p[2]) == 0xBF))
+        p += 3;
+
+    if ((p == pEnd) || (*p != '<'))
+    {
+        Error(E_INVALID_XML_SYNTAX, "Unrecognized encoding (parser does not support UTF-8 language encodings)");
+        return E_INVALID_XML_SYNTAX;
+    }
+
+    // Reports a syntax error at pAt
+    auto SyntaxError = [&](const CHAR* pAt, const CHAR* strMessage) -> HRESULT
+    {
+        SetSpanPosition(pStart, pAt);
+        Error(E_INVALID_XML_SYNTAX, "%s", strMessage);
+        return E_INVALID_XML_SYNTAX;
+    };
+
+    // A failed callback aborts the parse, except for entity references the default
+    // span callbacks could not decode, which are reported as syntax errors.
+    auto CallbackFailed = [&](HRESULT hrCallback, const CHAR* pAt) -> HRESULT
+    {
+        if (hrCallback == E_INVALID_XML_SYNTAX)
+            return SyntaxError(pAt, "Malformed or unrecognized entity reference (should be lt, gt, amp, apos, quot, &# or &#x)");
+        return E_ABORT;
+    };
+
+    const size_t uTotal = static_cast<size_t>(pEnd - pStart);
+    const size_t uProgressStep = std::max<size_t>(uTotal / 1000, 64 * 1024);
+    size_t uNextProgress = uProgressStep;
+
+    for (;; )
+    {
+        const size_t uConsumed = static_cast<size_t>(p - pStart);
+        if (uConsumed >= uNextProgress)
+        {
+            m_pISAXCallback->SetParseProgress(static_cast<DWORD>((uint64_t(uConsumed) * 1000) / uint64_t(uTotal)));
+            uNextProgress = uConsumed + uProgressStep;
+        }
+
+        // Element content up to the next tag
+        const CHAR* pTag = FindChar(p, pEnd, '<');
+        if ((pTag != p) && !IsWhitespaceOnly(p, pTag))
+        {
+            if (FAILED(hr = m_pISAXCallback->ElementContentSpan(p, static_cast<UINT>(pTag - p))))
+                return CallbackFailed(hr, p);
+        }
+
+        if (pTag == pEnd)
+            break;
+
+        p = pTag + 1;
+        if (p == pEnd)
+            return SyntaxError(p, "Unexpected EOF while parsing XML file");
+
+        if (*p == '!')
+        {
+            if ((pEnd - p >= 3) && (p[1] == '-') && (p[2] == '-'))
+            {
+                const CHAR* pClose = FindTerminator(p + 3, pEnd, "-->");
+                if (pClose == pEnd)
+                    return SyntaxError(pEnd, "Unexpected EOF while parsing XML file");
+                p = pClose + 3;
+                continue;
+            }
+
+            if ((pEnd - p < 8) || strncmp(p, "![CDATA[", 8))
+                return SyntaxError(p, "Expecting '<![CDATA['");
+
+            const CHAR* pData = p + 8;
+            const CHAR* pClose = FindTerminator(pData, pEnd, "]]>");
+            if (pClose == pEnd)
+                return SyntaxError(pEnd, "Unexpected EOF while parsing XML file");
+
+            if (FAILED(hr = m_pISAXCallback->CDATASpan(pData, static_cast<UINT>(pClose - pData))))
+                return CallbackFailed(hr, pData);
+
+            p = pClose + 3;
+        }
+        else if (*p == '/')
+        {
+            const CHAR* pName = p + 1;
+            if ((pName == pEnd) || !IsNameStartChar(*pName))
+                return SyntaxError(pName, "Names must start with an alphabetic character or _ or :");
+            p = SkipName(pName, pEnd);
+
+            if (FAILED(hr = m_pISAXCallback->ElementEndSpan(pName, static_cast<UINT>(p - pName))))
+                return CallbackFailed(hr, pName);
+
+            p = SkipSpace(p, pEnd);
+            if ((p == pEnd) || (*p != '>'))
+                return SyntaxError(p, "Expecting '>' after name for closing entity reference");
+            ++p;
+        }
+        else if (*p == '?')
+        {
+            // just skip any xml header tag since not really important after identifying character set
+            p = FindChar(p, pEnd, '>');
+            if (p == pEnd)
+                return SyntaxError(pEnd, "Unexpected EOF while parsing XML file");
+            ++p;
+        }
+        else
+        {
+            XMLSpanAttribute Attributes[XML_MAX_ATTRIBUTES_PER_ELEMENT] = {};
+            UINT NumAttrs = 0;
+
+            const CHAR* pName = p;
+            if (!IsNameStartChar(*pName))
+                return SyntaxError(pName, "Names must start with an alphabetic character or _ or :");
+            p = SkipName(pName, pEnd);
+            const UINT NameLen = static_cast<UINT>(p - pName);
+
+            p = SkipSpace(p, pEnd);
+
+            // read attributes
+            while ((p < pEnd) && (*p != '>') && (*p != '/'))
+            {
+                if (NumAttrs >= XML_MAX_ATTRIBUTES_PER_ELEMENT)
+                {
+                    SetSpanPosition(pStart, p);
+                    Error(E_INVALID_XML_SYNTAX, "Elements may not have more than %d attributes", XML_MAX_ATTRIBUTES_PER_ELEMENT);
+                    return E_INVALID_XML_SYNTAX;
+                }
+
+                XMLSpanAttribute& Attribute = Attributes[NumAttrs];
+
+                // Attribute name
+                if (!IsNameStartChar(*p))
+                    return SyntaxError(p, "Names must start with an alphabetic character or _ or :");
+                Attribute.strName = p;
+                p = SkipName(p, pEnd);
+                Attribute.NameLen = static_cast<UINT>(p - Attribute.strName);
+
+                p = SkipSpace(p, pEnd);
+                if ((p == pEnd) || (*p != '='))
+                    return SyntaxError(p, "Expecting '=' character after attribute name");
+
+                p = SkipSpace(p + 1, pEnd);
+                if ((p == pEnd) || ((*p != '"') && (*p != '\'')))
+                    return SyntaxError(p, "Attribute values must be enclosed in quotes");
+
+                // The value ends at the matching quote; a '<' before it is an error
+                const CHAR chQuote = *p++;
+                const CHAR* pValueEnd = FindEitherChar(p, pEnd, chQuote, '<');
+                if (pValueEnd == pEnd)
+                    return SyntaxError(pEnd, "Unexpected EOF while parsing XML file");
+                if (*pValueEnd == '<')
+                    return SyntaxError(pValueEnd, "Illegal character '<' in element tag");
+
+                Attribute.strValue = p;
+                Attribute.ValueLen = static_cast<UINT>(pValueEnd - p);
+                ++NumAttrs;
+
+                p = SkipSpace(pValueEnd + 1, pEnd);
+            }
+
+            if (p == pEnd)
+                return SyntaxError(pEnd, "Unexpected EOF while parsing XML file");
+
+            if (FAILED(hr = m_pISAXCallback->ElementBeginSpan(pName, NameLen, Attributes, NumAttrs)))
+                return CallbackFailed(hr, pName);
+
+            if (*p == '/')
+            {
+                ++p;
+                if ((p == pEnd) || (*p != '>'))
+                    return SyntaxError(p, "Expecting '>' after '/' in element tag");
+
+                if (FAILED(hr = m_pISAXCallback->ElementEndSpan(pName, NameLen)))
+                    return CallbackFailed(hr, pName);
+            }
+            ++p;
+        }
+    }
+
+    if (FAILED(m_pISAXCallback->EndDocument()))
+        return E_ABORT;
+
+    return S_OK;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Name: XMLParser::ParseXMLFileMapped
+// Desc: Maps the file into memory and parses it in place with SpanParseLoop
+//-------------------------------------------------------------------------------------
+HRESULT XMLParser::ParseXMLFileMapped(const CHAR* strFilename)
+{
+    if (!m_pISAXCallback)
+        return E_NOINTERFACE;
+
+    m_pISAXCallback->m_LineNum = 1;
+    m_pISAXCallback->m_LinePos = 0;
+    m_pISAXCallback->m_strFilename = strFilename;  // save this off only while we parse the file
+
+    HANDLE hFile = CreateFile(strFilename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        Error(E_COULD_NOT_OPEN_FILE, "Error opening file");
+        m_pISAXCallback->m_strFilename = nullptr;
+        return E_COULD_NOT_OPEN_FILE;
+    }
+
+    HRESULT hr = S_OK;
+    LARGE_INTEGER iFileSize = {};
+    HANDLE hMapping = nullptr;
+    const void* pView = nullptr;
+
+    if (!GetFileSizeEx(hFile, &iFileSize) || (static_cast<uint64_t>(iFileSize.QuadPart) > SIZE_MAX))
+    {
+        Error(E_COULD_NOT_OPEN_FILE, "Error opening file");
+        hr = E_COULD_NOT_OPEN_FILE;
+    }
+    else if (iFileSize.QuadPart == 0)
+    {
+        // Empty files cannot be mapped; report them the same way as ParseXMLFile
+        hr = ParseXMLBufferSpans("", 0);
+    }
+    else
+    {
+        hMapping = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hMapping)
+            pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (!pView)
+        {
+            Error(E_COULD_NOT_OPEN_FILE, "Error mapping file");
+            hr = E_COULD_NOT_OPEN_FILE;
+        }
+        else
+        {
+            hr = ParseXMLBufferSpans(static_cast<const CHAR*>(pView), static_cast<size_t>(iFileSize.QuadPart));
+        }
+    }
+
+    if (pView)
+        UnmapViewOfFile(pView);
+    if (hMapping)
+        CloseHandle(hMapping);
+    CloseHandle(hFile);
+
+    // we no longer own strFilename, so un-set it
+    m_pISAXCallback->m_strFilename = nullptr;
+
+    return hr;
+}
+
+
+//-------------------------------------------------------------------------------------
+// Name: XMLParser::ParseXMLBufferSpans
+// Desc: Parses an 8-bit buffer in place; UTF-16 buffers go to ParseXMLBuffer
+//-------------------------------------------------------------------------------------
+HRESULT XMLParser::ParseXMLBufferSpans(const CHAR* strBuffer, size_t uBufferSize)
+{
+    if (!m_pISAXCallback)
+        return E_NOINTERFACE;
+
+    if (uBufferSize >= 2)
+    {
+        const BYTE b0 = static_cast<BYTE>(strBuffer[0]);
+        const BYTE b1 = static_cast<BYTE>(strBuffer[1]);
+        const bool bUTF16 = ((b0 == 0xFF) && (b1 == 0xFE)) || ((b0 == 0xFE) && (b1 == 0xFF)) ||
+            ((b0 == 0x3C) && (b1 == 0x00)) || ((b0 == 0x00) && (b1 == 0x3C));
+        if (bUTF16)
+        {
+            if (uBufferSize > UINT32_MAX)
+            {
+                Error(E_INVALID_XML_SYNTAX, "UTF-16 XML files larger than 4 GB are not supported");
+                return E_INVALID_XML_SYNTAX;
+            }
+
+            // ParseXMLBuffer clears the filename, so keep the caller's
+            const CHAR* strFilename = m_pISAXCallback->m_strFilename;
+            const HRESULT hr = ParseXMLBuffer(strBuffer, static_cast<UINT>(uBufferSize));
+            m_pISAXCallback->m_strFilename = strFilename;
+            return hr;
+        }
+    }
+
+    const bool bOwnFilename = (m_pISAXCallback->m_strFilename == nullptr);
+    if (bOwnFilename)
+    {
+        m_pISAXCallback->m_LineNum = 1;
+        m_pISAXCallback->m_LinePos = 0;
+        m_pISAXCallback->m_strFilename = "";  // save this off only while we parse the file
+    }
+
+    const HRESULT hr = SpanParseLoop(strBuffer, strBuffer + uBufferSize);
+
+    if (bOwnFilename)
+        m_pISAXCallback->m_strFilename = nullptr;
+
+    return hr;
+}
+
+
 //-------------------------------------------------------------------------------------
 // XMLParser::Error()
 //      Logs an error through the callback interface
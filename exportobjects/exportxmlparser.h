@@ -39,6 +39,22 @@ namespace ATG
         UINT    ValueLen;
     };
 
+    //-------------------------------------------------------------------------------------
+    // Attributes reported by XMLParser::ParseXMLFileMapped.  The spans point into the
+    // mapped file, are not null terminated, and still contain any entity references.
+    struct XMLSpanAttribute
+    {
+        const CHAR* strName;
+        UINT        NameLen;
+        const CHAR* strValue;
+        UINT        ValueLen;
+    };
+
+    // Decodes the entity and character references in a span.  pDest must have room for
+    // SrcLen characters; decoding never makes a span longer.  Returns false on a
+    // malformed or unrecognized reference.
+    bool XMLDecodeSpan(const CHAR* pSrc, UINT SrcLen, CHAR* pDest, UINT& DestLen);
+
     //-------------------------------------------------------------------------------------
     class ISAXCallback
     {
@@ -63,6 +79,16 @@ namespace ATG
 
         virtual void     SetParseProgress(DWORD dwProgress) { }
 
+        // UTF-8 span events, used by XMLParser::ParseXMLFileMapped.  Override these to
+        // consume the mapped file without copying.  The defaults decode and widen each
+        // span and forward it to the WCHAR methods above.  In mapped mode the line
+        // number and position are only updated before Error is called.
+        virtual HRESULT  ElementBeginSpan(const CHAR* strName, UINT NameLen,
+            const XMLSpanAttribute* pAttributes, UINT NumAttributes);
+        virtual HRESULT  ElementContentSpan(const CHAR* strData, UINT DataLen);
+        virtual HRESULT  ElementEndSpan(const CHAR* strName, UINT NameLen);
+        virtual HRESULT  CDATASpan(const CHAR* strCDATA, UINT CDATALen);
+
         const CHAR* GetFilename() const noexcept { return m_strFilename; }
         UINT             GetLineNumber() const noexcept { return m_LineNum; }
         UINT             GetLinePosition() const noexcept { return m_LinePos; }
@@ -102,8 +128,21 @@ namespace ATG
 
         HRESULT    ParseXMLBuffer(const CHAR* strBuffer, UINT uBufferSize);
 
+        //      Memory-maps the file and scans it in place 16 bytes at a time, passing
+        //         UTF-8 spans that point into the mapping to the callback's span methods.
+        //         UTF-16 files are handed to ParseXMLFile.  Return codes are the same as
+        //         for ParseXMLFile
+
+        HRESULT    ParseXMLFileMapped(const CHAR* strFilename);
+
+        //      Parses an 8-bit buffer the same way as ParseXMLFileMapped
+
+        HRESULT    ParseXMLBufferSpans(const CHAR* strBuffer, size_t uBufferSize);
+
     private:
         HRESULT    MainParseLoop();
+        HRESULT    SpanParseLoop(const CHAR* pStart, const CHAR* pEnd);
+        void       SetSpanPosition(const CHAR* pStart, const CHAR* pPosition);
 
         HRESULT    AdvanceCharacter(bool bOkToFail = false);
         void       SkipNextAdvance();
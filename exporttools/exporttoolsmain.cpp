@@ -0,0 +1,425 @@
+//-------------------------------------------------------------------------------------
+// ExportToolsMain.cpp
+//
+// Entry point for the export tools application, which checks exported files and times
+// exporter components outside of the content exporter itself.
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#define EXPORT_TOOLS_TITLE CONTENT_EXPORTER_GLOBAL_TITLE " Tools"
+
+using namespace ATG;
+
+class ConsoleOutListener : public ILogListener
+{
+protected:
+    HANDLE  m_hOut;
+    WORD    m_wDefaultConsoleTextAttributes;
+    WORD    m_wBackgroundAttributes;
+public:
+    ConsoleOutListener()
+    {
+        m_hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        CONSOLE_SCREEN_BUFFER_INFO csbi;
+        GetConsoleScreenBufferInfo(m_hOut, &csbi);
+        m_wDefaultConsoleTextAttributes = csbi.wAttributes;
+        m_wBackgroundAttributes = m_wDefaultConsoleTextAttributes & 0x00F0;
+    }
+    void LogMessage(const CHAR* strMessage) override
+    {
+        puts(strMessage);
+    }
+    void LogWarning(const CHAR* strMessage) override
+    {
+        SetConsoleTextAttribute(m_hOut, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY | m_wBackgroundAttributes);
+        LogMessage(strMessage);
+        SetConsoleTextAttribute(m_hOut, m_wDefaultConsoleTextAttributes);
+    }
+    void LogError(const CHAR* strMessage) override
+    {
+        SetConsoleTextAttribute(m_hOut, FOREGROUND_RED | FOREGROUND_INTENSITY | m_wBackgroundAttributes);
+        LogMessage(strMessage);
+        SetConsoleTextAttribute(m_hOut, m_wDefaultConsoleTextAttributes);
+    }
+};
+
+ConsoleOutListener g_ConsoleOutListener;
+DebugSpewListener g_DebugSpewListener;
+
+using FileNameVector = std::vector<const CHAR*>;
+
+//-------------------------------------------------------------------------------------
+// SDKMESH validation
+//-------------------------------------------------------------------------------------
+
+bool IsSDKMeshAnimationFile(const CHAR* strFileName)
+{
+    const size_t dwLength = strlen(strFileName);
+    return dwLength >= 5 && _stricmp(strFileName + dwLength - 5, "_anim") == 0;
+}
+
+int ValidateSDKMeshFiles(const FileNameVector& InputFileNames)
+{
+    LARGE_INTEGER qwFrequency = {};
+    QueryPerformanceFrequency(&qwFrequency);
+    const double fTicksToMilliseconds = 1000.0 / static_cast<double>(qwFrequency.QuadPart);
+
+    size_t dwValidFiles = 0;
+    size_t dwTotalProblems = 0;
+    UINT64 qwTotalBytes = 0;
+    double fTotalMilliseconds = 0.0;
+
+    for (const CHAR* strFileName : InputFileNames)
+    {
+        const bool bAnimation = IsSDKMeshAnimationFile(strFileName);
+
+        // The timed region covers mapping the file and touching every table, list and
+        // index the validator inspects, which is what a runtime loader would pay.
+        LARGE_INTEGER qwStart, qwEnd;
+        QueryPerformanceCounter(&qwStart);
+
+        bool bOpened = false;
+        size_t dwProblems = 0;
+        UINT64 qwFileSize = 0;
+        if (bAnimation)
+        {
+            SDKAnimationFileView View;
+            bOpened = View.Open(strFileName);
+            if (bOpened)
+            {
+                dwProblems = View.Validate();
+                qwFileSize = View.GetFileSize();
+            }
+        }
+        else
+        {
+            SDKMeshFileView View;
+            bOpened = View.Open(strFileName);
+            if (bOpened)
+            {
+                dwProblems = View.Validate();
+                qwFileSize = View.GetFileSize();
+            }
+        }
+
+        QueryPerformanceCounter(&qwEnd);
+        const double fMilliseconds = static_cast<double>(qwEnd.QuadPart - qwStart.QuadPart) * fTicksToMilliseconds;
+
+        if (!bOpened)
+        {
+            ++dwTotalProblems;
+            continue;
+        }
+
+        qwTotalBytes += qwFileSize;
+        fTotalMilliseconds += fMilliseconds;
+        dwTotalProblems += dwProblems;
+        if (dwProblems == 0)
+        {
+            ++dwValidFiles;
+            ExportLog::LogMsg(1, "    OK     \"%s\" (%llu bytes, %0.3f ms)", strFileName, qwFileSize, fMilliseconds);
+        }
+        else
+        {
+            ExportLog::LogError("INVALID \"%s\" (%zu problem(s), %0.3f ms)", strFileName, dwProblems, fMilliseconds);
+        }
+    }
+
+    const double fMegabytes = static_cast<double>(qwTotalBytes) / (1024.0 * 1024.0);
+    const double fMegabytesPerSecond = (fTotalMilliseconds > 0.0) ? fMegabytes * 1000.0 / fTotalMilliseconds : 0.0;
+
+    ExportLog::LogMsg(0, "----------------------------------------------------------");
+    ExportLog::LogMsg(0, "%zu of %zu file(s) valid, %zu problem(s).", dwValidFiles, InputFileNames.size(), dwTotalProblems);
+    ExportLog::LogMsg(0, "Loaded and validated %0.2f MB in %0.2f ms (%0.1f MB/s).", fMegabytes, fTotalMilliseconds, fMegabytesPerSecond);
+
+    return (dwTotalProblems == 0) ? 0 : 1;
+}
+
+//-------------------------------------------------------------------------------------
+// XML parser benchmark
+//-------------------------------------------------------------------------------------
+
+// Counts parse events.  The span overrides keep the mapped parser on its zero-copy
+// path; the WCHAR methods count the events of the buffered parser.
+class XMLBenchmarkCallback : public ISAXCallback
+{
+public:
+    XMLBenchmarkCallback() noexcept : m_dwElements(0), m_dwAttributes(0) {}
+
+    HRESULT StartDocument() override { return S_OK; }
+    HRESULT EndDocument() override { return S_OK; }
+
+    HRESULT ElementBegin(const WCHAR* /*strName*/, UINT /*NameLen*/, const XMLAttribute* /*pAttributes*/, UINT NumAttributes) override
+    {
+        ++m_dwElements;
+        m_dwAttributes += NumAttributes;
+        return S_OK;
+    }
+    HRESULT ElementContent(const WCHAR* /*strData*/, UINT /*DataLen*/, bool /*More*/) override { return S_OK; }
+    HRESULT ElementEnd(const WCHAR* /*strName*/, UINT /*NameLen*/) override { return S_OK; }
+
+    HRESULT CDATABegin() override { return S_OK; }
+    HRESULT CDATAData(const WCHAR* /*strCDATA*/, UINT /*CDATALen*/, bool /*bMore*/) override { return S_OK; }
+    HRESULT CDATAEnd() override { return S_OK; }
+
+    HRESULT ElementBeginSpan(const CHAR* /*strName*/, UINT /*NameLen*/, const XMLSpanAttribute* /*pAttributes*/, UINT NumAttributes) override
+    {
+        ++m_dwElements;
+        m_dwAttributes += NumAttributes;
+        return S_OK;
+    }
+    HRESULT ElementContentSpan(const CHAR* /*strData*/, UINT /*DataLen*/) override { return S_OK; }
+    HRESULT ElementEndSpan(const CHAR* /*strName*/, UINT /*NameLen*/) override { return S_OK; }
+    HRESULT CDATASpan(const CHAR* /*strCDATA*/, UINT /*CDATALen*/) override { return S_OK; }
+
+    void Error(HRESULT /*hError*/, const CHAR* strMessage) override
+    {
+        ExportLog::LogError("%s(%u,%u): %s", GetFilename(), GetLineNumber(), GetLinePosition(), strMessage);
+    }
+
+    size_t  m_dwElements;
+    size_t  m_dwAttributes;
+};
+
+int BenchmarkXMLFiles(const FileNameVector& InputFileNames)
+{
+    LARGE_INTEGER qwFrequency = {};
+    QueryPerformanceFrequency(&qwFrequency);
+    const double fTicksToMilliseconds = 1000.0 / static_cast<double>(qwFrequency.QuadPart);
+
+    size_t dwFailures = 0;
+    UINT64 qwTotalBytes = 0;
+    double fTotalBufferedMilliseconds = 0.0;
+    double fTotalMappedMilliseconds = 0.0;
+
+    for (const CHAR* strFileName : InputFileNames)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA FileData = {};
+        if (!GetFileAttributesEx(strFileName, GetFileExInfoStandard, &FileData))
+        {
+            ExportLog::LogError("Could not open \"%s\".", strFileName);
+            ++dwFailures;
+            continue;
+        }
+        const UINT64 qwFileSize = (static_cast<UINT64>(FileData.nFileSizeHigh) << 32) | FileData.nFileSizeLow;
+
+        XMLParser Parser;
+        LARGE_INTEGER qwStart, qwEnd;
+
+        XMLBenchmarkCallback BufferedCallback;
+        Parser.RegisterSAXCallbackInterface(&BufferedCallback);
+        QueryPerformanceCounter(&qwStart);
+        const HRESULT hrBuffered = Parser.ParseXMLFile(strFileName);
+        QueryPerformanceCounter(&qwEnd);
+        const double fBufferedMilliseconds = static_cast<double>(qwEnd.QuadPart - qwStart.QuadPart) * fTicksToMilliseconds;
+
+        XMLBenchmarkCallback MappedCallback;
+        Parser.RegisterSAXCallbackInterface(&MappedCallback);
+        QueryPerformanceCounter(&qwStart);
+        const HRESULT hrMapped = Parser.ParseXMLFileMapped(strFileName);
+        QueryPerformanceCounter(&qwEnd);
+        const double fMappedMilliseconds = static_cast<double>(qwEnd.QuadPart - qwStart.QuadPart) * fTicksToMilliseconds;
+
+        if (FAILED(hrBuffered) || FAILED(hrMapped))
+        {
+            ExportLog::LogError("FAILED \"%s\" (buffered %08X, mapped %08X)", strFileName, static_cast<unsigned int>(hrBuffered), static_cast<unsigned int>(hrMapped));
+            ++dwFailures;
+            continue;
+        }
+
+        if (BufferedCallback.m_dwElements != MappedCallback.m_dwElements || BufferedCallback.m_dwAttributes != MappedCallback.m_dwAttributes)
+        {
+            ExportLog::LogError("MISMATCH \"%s\" (buffered %zu elements, %zu attributes; mapped %zu elements, %zu attributes)", strFileName,
+                BufferedCallback.m_dwElements, BufferedCallback.m_dwAttributes, MappedCallback.m_dwElements, MappedCallback.m_dwAttributes);
+            ++dwFailures;
+            continue;
+        }
+
+        qwTotalBytes += qwFileSize;
+        fTotalBufferedMilliseconds += fBufferedMilliseconds;
+        fTotalMappedMilliseconds += fMappedMilliseconds;
+        ExportLog::LogMsg(1, "    OK     \"%s\" (%llu bytes, %zu elements, %zu attributes, buffered %0.3f ms, mapped %0.3f ms)", strFileName, qwFileSize,
+            MappedCallback.m_dwElements, MappedCallback.m_dwAttributes, fBufferedMilliseconds, fMappedMilliseconds);
+    }
+
+    const double fMegabytes = static_cast<double>(qwTotalBytes) / (1024.0 * 1024.0);
+    const double fBufferedMegabytesPerSecond = (fTotalBufferedMilliseconds > 0.0) ? fMegabytes * 1000.0 / fTotalBufferedMilliseconds : 0.0;
+    const double fMappedMegabytesPerSecond = (fTotalMappedMilliseconds > 0.0) ? fMegabytes * 1000.0 / fTotalMappedMilliseconds : 0.0;
+
+    ExportLog::LogMsg(0, "----------------------------------------------------------");
+    ExportLog::LogMsg(0, "%zu of %zu file(s) parsed identically.", InputFileNames.size() - dwFailures, InputFileNames.size());
+    ExportLog::LogMsg(0, "Buffered parser: %0.2f MB in %0.2f ms (%0.1f MB/s).", fMegabytes, fTotalBufferedMilliseconds, fBufferedMegabytesPerSecond);
+    ExportLog::LogMsg(0, "Mapped parser:   %0.2f MB in %0.2f ms (%0.1f MB/s, %0.2fx).", fMegabytes, fTotalMappedMilliseconds, fMappedMegabytesPerSecond,
+        (fTotalMappedMilliseconds > 0.0) ? fTotalBufferedMilliseconds / fTotalMappedMilliseconds : 0.0);
+
+    return (dwFailures == 0) ? 0 : 1;
+}
+
+//-------------------------------------------------------------------------------------
+// Subdivision surface welding benchmark
+//-------------------------------------------------------------------------------------
+
+// Builds an unwelded cage of dwGridSize x dwGridSize quads, four vertices per quad, as
+// meshes with split normals or texture coordinates arrive from the importer.
+void BuildSubDBenchmarkCage(size_t dwGridSize, std::vector<DirectX::XMFLOAT3>& Positions)
+{
+    static const size_t s_CornerOffsets[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+    Positions.clear();
+    Positions.reserve(dwGridSize * dwGridSize * 4);
+    const float fScale = 1.0f / static_cast<float>(dwGridSize);
+    for (size_t y = 0; y < dwGridSize; ++y)
+    {
+        for (size_t x = 0; x < dwGridSize; ++x)
+        {
+            for (const auto& Offset : s_CornerOffsets)
+            {
+                const float fX = static_cast<float>(x + Offset[0]) * fScale;
+                const float fZ = static_cast<float>(y + Offset[1]) * fScale;
+                Positions.emplace_back(fX, sinf(fX * DirectX::XM_2PI) * cosf(fZ * DirectX::XM_2PI) * 0.25f, fZ);
+            }
+        }
+    }
+}
+
+int BenchmarkSubDWelding(const FileNameVector& /*InputFileNames*/)
+{
+    static const size_t s_GridSizes[] = { 32, 64, 128, 256, 512, 1024 };
+
+    LARGE_INTEGER qwFrequency = {};
+    QueryPerformanceFrequency(&qwFrequency);
+    const double fTicksToMilliseconds = 1000.0 / static_cast<double>(qwFrequency.QuadPart);
+
+    size_t dwFailures = 0;
+    std::vector<DirectX::XMFLOAT3> Positions;
+
+    for (const size_t dwGridSize : s_GridSizes)
+    {
+        BuildSubDBenchmarkCage(dwGridSize, Positions);
+        const size_t dwVertexCount = Positions.size();
+        LARGE_INTEGER qwStart, qwEnd;
+
+        size_t dwPositionCount = 0;
+        QueryPerformanceCounter(&qwStart);
+        {
+            ExportPositionWelder Welder;
+            Welder.Reserve(dwVertexCount);
+            for (size_t i = 0; i < dwVertexCount; ++i)
+            {
+                const INT iNewIndex = static_cast<INT>(dwPositionCount);
+                if (Welder.FindOrAdd(Positions[i], iNewIndex) == iNewIndex)
+                    ++dwPositionCount;
+            }
+        }
+        QueryPerformanceCounter(&qwEnd);
+        const double fMilliseconds = static_cast<double>(qwEnd.QuadPart - qwStart.QuadPart) * fTicksToMilliseconds;
+        const double fNanosecondsPerVertex = fMilliseconds * 1000000.0 / static_cast<double>(dwVertexCount);
+
+        // Every grid point is shared by up to four quads.
+        const size_t dwExpectedPositionCount = (dwGridSize + 1) * (dwGridSize + 1);
+        if (dwPositionCount != dwExpectedPositionCount)
+        {
+            ExportLog::LogError("MISMATCH %zux%zu cage welded to %zu positions, expected %zu", dwGridSize, dwGridSize, dwPositionCount, dwExpectedPositionCount);
+            ++dwFailures;
+            continue;
+        }
+
+        ExportLog::LogMsg(1, "    %4zux%-4zu %8zu verts -> %7zu positions, %8.2f ms (%0.1f ns/vert)", dwGridSize, dwGridSize, dwVertexCount,
+            dwPositionCount, fMilliseconds, fNanosecondsPerVertex);
+    }
+
+    ExportLog::LogMsg(0, "----------------------------------------------------------");
+    ExportLog::LogMsg(0, "%zu of %zu cage(s) welded correctly.", std::size(s_GridSizes) - dwFailures, std::size(s_GridSizes));
+
+    return (dwFailures == 0) ? 0 : 1;
+}
+
+//-------------------------------------------------------------------------------------
+// Command line
+//-------------------------------------------------------------------------------------
+
+using ToolCommandCallback = int(*)(const FileNameVector& InputFileNames);
+
+struct ToolCommand
+{
+    const CHAR* strCommandLine;
+    const CHAR* strAnnotation;
+    const CHAR* strDescription;
+    bool bNeedsInputFiles;
+    ToolCommandCallback pCallback;
+};
+
+const ToolCommand g_ToolCommands[] = {
+    { "validatesdkmesh", " <files>", "Loads exported SDKMESH or SDKMESH animation files, validates their layout, and times the loads", true, ValidateSDKMeshFiles },
+    { "xmlbenchmark", " <files>", "Parses XML files with the buffered and memory-mapped parsers and compares their throughput and results", true, BenchmarkXMLFiles },
+    { "subdbenchmark", "", "Times subdivision surface position welding on synthetic cages of increasing size", false, BenchmarkSubDWelding },
+};
+
+void PrintHelp()
+{
+    ExportLog::LogMsg(0, "\nUsage: ExportTools -<command> [\"filename1\" \"filename2\" ... \"filenameN\"]");
+    ExportLog::LogMsg(0, "\nCommands:");
+    for (const auto& Command : g_ToolCommands)
+    {
+        ExportLog::LogMsg(0, "    -%s%s : %s", Command.strCommandLine, Command.strAnnotation, Command.strDescription);
+    }
+    ExportLog::LogMsg(0, "");
+}
+
+int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
+{
+    ExportLog::AddListener(&g_ConsoleOutListener);
+    if (IsDebuggerPresent())
+    {
+        ExportLog::AddListener(&g_DebugSpewListener);
+    }
+
+    ExportLog::SetLogLevel(1);
+    ExportLog::EnableLogging(true);
+
+    ExportLog::LogMsg(0, "----------------------------------------------------------");
+    ExportLog::LogMsg(0, "%s version %d.%d.%d", EXPORT_TOOLS_TITLE, CONTENT_EXPORTER_MAJOR_VERSION, CONTENT_EXPORTER_MINOR_VERSION, CONTENT_EXPORTER_REVISION);
+    ExportLog::LogMsg(0, CONTENT_EXPORTER_VENDOR);
+    ExportLog::LogMsg(0, CONTENT_EXPORTER_COPYRIGHT);
+    ExportLog::LogMsg(0, "----------------------------------------------------------");
+
+    if (argc < 2 || (argv[1][0] != '-' && argv[1][0] != '/'))
+    {
+        PrintHelp();
+        return 1;
+    }
+
+    const CHAR* strCommand = argv[1] + 1;
+    const ToolCommand* pCommand = nullptr;
+    for (const auto& Command : g_ToolCommands)
+    {
+        if (_stricmp(strCommand, Command.strCommandLine) == 0)
+        {
+            pCommand = &Command;
+            break;
+        }
+    }
+    if (!pCommand)
+    {
+        ExportLog::LogError("Unknown command \"%s\".", argv[1]);
+        PrintHelp();
+        return 1;
+    }
+
+    FileNameVector InputFileNames(argv + 2, argv + argc);
+    if (pCommand->bNeedsInputFiles && InputFileNames.empty())
+    {
+        ExportLog::LogError("No input filename(s) provided.");
+        PrintHelp();
+        return 1;
+    }
+
+    return pCommand->pCallback(InputFileNames);
+}
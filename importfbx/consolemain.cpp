@@ -14,6 +14,9 @@
 #include "stdafx.h"
 #include <conio.h>
 
+#include <string>
+#include <thread>
+
 #include <DirectXMesh.h>
 #include <DirectXTex.h>
 #include <UVAtlas.h>
@@ -90,6 +93,14 @@ enum ExportFileFormat
 
 INT g_ExportFileFormat = FILEFORMAT_SDKMESH;
 
+// Batch mode exports each input file in its own child exporter process, so every file
+// gets an isolated scene, manifest, FBX SDK instance, and log.
+bool g_bBatchExport = false;
+DWORD g_dwBatchJobCount = 0;
+std::vector<const CHAR*> g_BatchCommandStrings;
+
+ExportCache g_ExportCache;
+
 using MacroCommandCallback = bool(*)(const CHAR* strArgument, bool& bUsedArgument);
 
 struct MacroCommand
@@ -421,6 +432,34 @@ bool MacroLoadFileList(const CHAR* strArgument, bool& bUsedArgument)
     return true;
 }
 
+bool MacroSetCacheDirectory(const CHAR* strArgument, bool& bUsedArgument)
+{
+    if (!strArgument)
+    {
+        ExportLog::LogError("Missing export cache directory");
+        return false;
+    }
+    bUsedArgument = true;
+
+    return g_ExportCache.Initialize(strArgument);
+}
+
+bool MacroBatchJobs(const CHAR* strArgument, bool& bUsedArgument)
+{
+    if (!strArgument)
+    {
+        ExportLog::LogError("Missing batch job count");
+        return false;
+    }
+    bUsedArgument = true;
+
+    INT iValue = atoi(strArgument);
+    iValue = std::min(MAXIMUM_WAIT_OBJECTS, std::max(0, iValue));
+    g_dwBatchJobCount = static_cast<DWORD>(iValue);
+    g_bBatchExport = true;
+    return true;
+}
+
 MacroCommand g_MacroCommands[] = {
 #ifdef _DEBUG
     { "attach", "", "Wait for debugger attach", MacroAttach },
@@ -447,6 +486,8 @@ MacroCommand g_MacroCommands[] = {
     { "savesettings", " <filename>", "Saves all settings to the specified filename", MacroSaveSettings },
     { "loadsettings", " <filename>", "Loads settings from the specified filename", MacroLoadSettings },
     { "filelist", " <filename>", "Loads a list of input filenames from the specified filename", MacroLoadFileList },
+    { "cachedir", " <path>", "Reuses scene outputs and converted textures from the specified cache when their inputs and settings are unchanged", MacroSetCacheDirectory },
+    { "batchjobs", " <count>", "Exports input files concurrently in up to <count> isolated exporter processes (0 = one per processor)", MacroBatchJobs },
     { "loglevel", " <ranged value 1 - 10>", "Sets the message logging level, higher values show more messages", MacroSetLogLevel },
 };
 
@@ -709,6 +750,18 @@ void ParseInputFileName(const CHAR* strFileName)
 
 std::vector<CHAR*> g_CommandStrings;
 
+bool IsBatchForwardedCommand(const CHAR* strCommand)
+{
+    // Options that only make sense for the batch controller are not passed to the per-file exporters.
+    static const CHAR* s_strControllerCommands[] = { "batchjobs", "filelist", "savesettings", "help", "?", "attach" };
+    for (const CHAR* strControllerCommand : s_strControllerCommands)
+    {
+        if (_stricmp(strCommand, strControllerCommand) == 0)
+            return false;
+    }
+    return true;
+}
+
 bool ParseCommandLine(INT argc, CHAR* argv[])
 {
     assert(argc >= 1);
@@ -735,6 +788,15 @@ bool ParseCommandLine(INT argc, CHAR* argv[])
             if (!ParseCommand(strCommand + 1, strArgument, bCommandWithParameter))
                 return false;
 
+            if (IsBatchForwardedCommand(strCommand + 1))
+            {
+                g_BatchCommandStrings.push_back(strCommand);
+                if (bCommandWithParameter)
+                {
+                    g_BatchCommandStrings.push_back(strArgument);
+                }
+            }
+
             if (bCommandWithParameter)
             {
                 ++i;
@@ -773,6 +835,279 @@ void BuildOutputFileName(const ExportPath& InputFileName)
     }
 }
 
+struct BatchJob
+{
+    ExportPath  InputFileName;
+    CHAR        strLogFileName[MAX_PATH] = {};
+    HANDLE      hProcess = nullptr;
+    DWORD       dwExitCode = 1;
+    size_t      dwWarningCount = 0;
+    size_t      dwErrorCount = 0;
+    bool        bLaunched = false;
+    bool        bFinished = false;
+};
+
+void AppendCommandLineArgument(std::string& CommandLine, const CHAR* strArgument)
+{
+    if (!CommandLine.empty())
+    {
+        CommandLine += ' ';
+    }
+
+    if (*strArgument && !strpbrk(strArgument, " \t\""))
+    {
+        CommandLine += strArgument;
+        return;
+    }
+
+    // Quote using the same rules the CRT uses to split the command line back into argv.
+    CommandLine += '"';
+    size_t dwBackslashCount = 0;
+    for (const CHAR* pChar = strArgument; *pChar; ++pChar)
+    {
+        if (*pChar == '\\')
+        {
+            ++dwBackslashCount;
+            continue;
+        }
+        if (*pChar == '"')
+        {
+            CommandLine.append(dwBackslashCount * 2 + 1, '\\');
+        }
+        else
+        {
+            CommandLine.append(dwBackslashCount, '\\');
+        }
+        dwBackslashCount = 0;
+        CommandLine += *pChar;
+    }
+    CommandLine.append(dwBackslashCount * 2, '\\');
+    CommandLine += '"';
+}
+
+bool LaunchBatchJob(BatchJob& Job, const CHAR* strExecutable, DWORD dwChildWorkerThreads)
+{
+    CHAR strTempPath[MAX_PATH];
+    if (!GetTempPathA(MAX_PATH, strTempPath) || !GetTempFileNameA(strTempPath, "cex", 0, Job.strLogFileName))
+    {
+        ExportLog::LogError("Could not create a log file for \"%s\".", (const CHAR*)Job.InputFileName);
+        Job.strLogFileName[0] = '\0';
+        return false;
+    }
+
+    SECURITY_ATTRIBUTES sa = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+    HANDLE hLogFile = CreateFileA(Job.strLogFileName, GENERIC_WRITE, FILE_SHARE_READ, &sa, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, nullptr);
+    if (hLogFile == INVALID_HANDLE_VALUE)
+    {
+        ExportLog::LogError("Could not open log file \"%s\".", Job.strLogFileName);
+        return false;
+    }
+
+    std::string CommandLine;
+    AppendCommandLineArgument(CommandLine, strExecutable);
+    for (const CHAR* strCommand : g_BatchCommandStrings)
+    {
+        AppendCommandLineArgument(CommandLine, strCommand);
+    }
+    if (dwChildWorkerThreads > 0)
+    {
+        AppendCommandLineArgument(CommandLine, "-workerthreads");
+        AppendCommandLineArgument(CommandLine, std::to_string(dwChildWorkerThreads).c_str());
+    }
+    AppendCommandLineArgument(CommandLine, Job.InputFileName);
+
+    STARTUPINFOA si = {};
+    si.cb = sizeof(STARTUPINFOA);
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdOutput = hLogFile;
+    si.hStdError = hLogFile;
+
+    // Processes are only ever launched from this thread, and the log handle is closed
+    // right after the launch, so no child inherits another child's log file.
+    PROCESS_INFORMATION pi = {};
+    const BOOL bCreated = CreateProcessA(strExecutable, &CommandLine[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &si, &pi);
+    CloseHandle(hLogFile);
+
+    if (!bCreated)
+    {
+        ExportLog::LogError("Could not start exporter process for \"%s\" (%08X).", (const CHAR*)Job.InputFileName, static_cast<unsigned int>(HRESULT_FROM_WIN32(GetLastError())));
+        return false;
+    }
+
+    CloseHandle(pi.hThread);
+    Job.hProcess = pi.hProcess;
+    Job.bLaunched = true;
+    return true;
+}
+
+void ReportBatchJob(BatchJob& Job, size_t dwIndex, size_t dwJobCount)
+{
+    ExportLog::LogMsg(0, "---- [%zu/%zu] %s ----", dwIndex + 1, dwJobCount, (const CHAR*)Job.InputFileName);
+
+    if (!Job.strLogFileName[0])
+        return;
+
+    FILE* fp = nullptr;
+    fopen_s(&fp, Job.strLogFileName, "rt");
+    if (fp)
+    {
+        CHAR strLine[4096];
+        while (fgets(strLine, ARRAYSIZE(strLine), fp))
+        {
+            CHAR* strNewline = strchr(strLine, '\n');
+            if (strNewline)
+            {
+                *strNewline = '\0';
+            }
+
+            size_t dwWarnings = 0;
+            size_t dwErrors = 0;
+            if (sscanf_s(strLine, "%zu warning(s), %zu error(s).", &dwWarnings, &dwErrors) == 2)
+            {
+                Job.dwWarningCount += dwWarnings;
+                Job.dwErrorCount += dwErrors;
+            }
+
+            ExportLog::LogMsg(0, "%s", strLine);
+        }
+        fclose(fp);
+    }
+    else
+    {
+        ExportLog::LogWarning("Could not read log file \"%s\".", Job.strLogFileName);
+    }
+
+    DeleteFileA(Job.strLogFileName);
+}
+
+int RunBatchExport()
+{
+    CHAR strExecutable[MAX_PATH];
+    const DWORD dwLength = GetModuleFileNameA(nullptr, strExecutable, MAX_PATH);
+    if (dwLength == 0 || dwLength >= MAX_PATH)
+    {
+        ExportLog::LogError("Could not determine the exporter executable path.");
+        return 1;
+    }
+
+    const size_t dwJobCount = g_InputFileNames.size();
+    const DWORD dwProcessorCount = std::max<DWORD>(std::thread::hardware_concurrency(), 1);
+
+    DWORD dwMaxRunning = g_dwBatchJobCount ? g_dwBatchJobCount : dwProcessorCount;
+    dwMaxRunning = std::min<DWORD>(dwMaxRunning, MAXIMUM_WAIT_OBJECTS);
+    dwMaxRunning = static_cast<DWORD>(std::min<size_t>(dwMaxRunning, dwJobCount));
+
+    // Unless the worker thread count was set explicitly, split the processors between
+    // the concurrent exporters instead of letting each one claim all of them.
+    DWORD dwChildWorkerThreads = 0;
+    if (g_pScene->Settings().iWorkerThreadCount == 0)
+    {
+        dwChildWorkerThreads = std::max<DWORD>(dwProcessorCount / dwMaxRunning, 1);
+    }
+
+    ExportLog::LogMsg(1, "Batch exporting %zu file(s) with up to %u concurrent exporter process(es).", dwJobCount, dwMaxRunning);
+
+    const ULONGLONG qwStartTime = GetTickCount64();
+
+    std::vector<BatchJob> Jobs(dwJobCount);
+    for (size_t i = 0; i < dwJobCount; ++i)
+    {
+        Jobs[i].InputFileName = g_InputFileNames[i];
+    }
+
+    std::vector<size_t> RunningJobs;
+    std::vector<HANDLE> RunningHandles;
+    RunningJobs.reserve(dwMaxRunning);
+    RunningHandles.reserve(dwMaxRunning);
+
+    size_t dwNextLaunch = 0;
+    size_t dwNextReport = 0;
+    while (dwNextReport < dwJobCount)
+    {
+        while (RunningJobs.size() < dwMaxRunning && dwNextLaunch < dwJobCount)
+        {
+            BatchJob& Job = Jobs[dwNextLaunch];
+            if (LaunchBatchJob(Job, strExecutable, dwChildWorkerThreads))
+            {
+                RunningJobs.push_back(dwNextLaunch);
+            }
+            else
+            {
+                Job.bFinished = true;
+            }
+            ++dwNextLaunch;
+        }
+
+        if (!RunningJobs.empty())
+        {
+            RunningHandles.clear();
+            for (const size_t dwJob : RunningJobs)
+            {
+                RunningHandles.push_back(Jobs[dwJob].hProcess);
+            }
+
+            const DWORD dwResult = WaitForMultipleObjects(static_cast<DWORD>(RunningHandles.size()), RunningHandles.data(), FALSE, INFINITE);
+            size_t dwFinished = dwResult - WAIT_OBJECT_0;
+            if (dwFinished >= RunningHandles.size())
+            {
+                // Should not happen, but fall back to waiting on the oldest process.
+                dwFinished = 0;
+                WaitForSingleObject(RunningHandles[0], INFINITE);
+            }
+
+            BatchJob& Job = Jobs[RunningJobs[dwFinished]];
+            if (!GetExitCodeProcess(Job.hProcess, &Job.dwExitCode))
+            {
+                Job.dwExitCode = 1;
+            }
+            CloseHandle(Job.hProcess);
+            Job.hProcess = nullptr;
+            Job.bFinished = true;
+            RunningJobs.erase(RunningJobs.begin() + static_cast<ptrdiff_t>(dwFinished));
+        }
+
+        // Relay logs in input order so the merged output does not depend on scheduling.
+        while (dwNextReport < dwJobCount && Jobs[dwNextReport].bFinished)
+        {
+            ReportBatchJob(Jobs[dwNextReport], dwNextReport, dwJobCount);
+            ++dwNextReport;
+        }
+    }
+
+    const float fSeconds = static_cast<float>(GetTickCount64() - qwStartTime) * 0.001f;
+
+    ExportLog::LogMsg(0, "----------------------------------------------------------");
+    ExportLog::LogMsg(0, "Batch export results:");
+
+    size_t dwSucceeded = 0;
+    size_t dwTotalWarnings = 0;
+    size_t dwTotalErrors = 0;
+    for (const auto& Job : Jobs)
+    {
+        dwTotalWarnings += Job.dwWarningCount;
+        dwTotalErrors += Job.dwErrorCount;
+
+        if (Job.bLaunched && Job.dwExitCode == 0)
+        {
+            ++dwSucceeded;
+            ExportLog::LogMsg(0, "    OK     \"%s\" (%zu warning(s))", (const CHAR*)Job.InputFileName, Job.dwWarningCount);
+        }
+        else if (Job.bLaunched)
+        {
+            ExportLog::LogError("FAILED \"%s\" (exit code %08X, %zu warning(s), %zu error(s))", (const CHAR*)Job.InputFileName, static_cast<unsigned int>(Job.dwExitCode), Job.dwWarningCount, Job.dwErrorCount);
+        }
+        else
+        {
+            ExportLog::LogError("FAILED \"%s\" (exporter process was not started)", (const CHAR*)Job.InputFileName);
+        }
+    }
+
+    ExportLog::LogMsg(0, "%zu of %zu file(s) exported successfully in %0.2f seconds.", dwSucceeded, dwJobCount, fSeconds);
+    ExportLog::LogMsg(0, "All files: %zu warning(s), %zu error(s).", dwTotalWarnings, dwTotalErrors);
+
+    return (dwSucceeded == dwJobCount) ? 0 : 1;
+}
+
 int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
 {
     g_WorkingPath = ExportPath::GetCurrentPath();
@@ -829,6 +1164,11 @@ int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
         return 1;
     }
 
+    if (g_bBatchExport && g_InputFileNames.size() > 1)
+    {
+        return RunBatchExport();
+    }
+
     ExportCoreSettings InitialSettings = g_pScene->Settings();
 
     if (InitialSettings.bForceIndex32Format && (InitialSettings.dwFeatureLevel <= D3D_FEATURE_LEVEL_9_1))
@@ -891,6 +1231,13 @@ int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
             ExportLog::LogError("Output filename is invalid.");
             return 1;
         }
+
+        if (g_ExportCache.BeginFile(InputFileName, g_CurrentOutputFileName, g_strExporterName) && g_ExportCache.RestoreOutputs())
+        {
+            ExportLog::LogMsg(1, "\"%s\" is up to date; outputs were restored from the export cache.", (const CHAR*)InputFileName);
+            continue;
+        }
+
         g_pScene->Statistics().StartExport();
         g_pScene->Statistics().StartSceneParse();
 
@@ -913,7 +1260,7 @@ int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
                 WriteSDKMeshFile(g_CurrentOutputFileName, &g_Manifest, (g_ExportFileFormat == FILEFORMAT_SDKMESH_V2) ? true : false);
                 if (bExportMaterials)
                 {
-                    ExportTextureConverter::PerformTextureFileOperations(&g_Manifest);
+                    ExportTextureConverter::PerformTextureFileOperations(&g_Manifest, &g_ExportCache);
                 }
             }
             else
@@ -922,7 +1269,7 @@ int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
                 {
                     ExportTextureConverter::ProcessScene(g_pScene, &g_Manifest, "textures\\", false);
                     WriteXATGFile(g_CurrentOutputFileName, &g_Manifest);
-                    ExportTextureConverter::PerformTextureFileOperations(&g_Manifest);
+                    ExportTextureConverter::PerformTextureFileOperations(&g_Manifest, &g_ExportCache);
                     BundleTextures();
                 }
                 else
@@ -931,7 +1278,7 @@ int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
                     WriteXATGFile(g_CurrentOutputFileName, &g_Manifest);
                     if (bExportMaterials)
                     {
-                        ExportTextureConverter::PerformTextureFileOperations(&g_Manifest);
+                        ExportTextureConverter::PerformTextureFileOperations(&g_Manifest, &g_ExportCache);
                     }
                 }
             }
@@ -940,7 +1287,27 @@ int __cdecl main(_In_ int argc, _In_z_count_(argc) char* argv[])
         g_pScene->Statistics().EndExport();
         g_pScene->Statistics().FinalReport();
         if (ExportLog::GenerateLogReport())
+        {
             bFoundErrors = true;
+        }
+        else if (g_ExportCache.IsEnabled())
+        {
+            g_ExportCache.AddOutputFile(g_CurrentOutputFileName);
+            if (g_ExportFileFormat == FILEFORMAT_SDKMESH || g_ExportFileFormat == FILEFORMAT_SDKMESH_V2)
+            {
+                CHAR strAnimFileName[MAX_PATH];
+                sprintf_s(strAnimFileName, "%s_anim", (const CHAR*)g_CurrentOutputFileName);
+                g_ExportCache.AddOutputFile(strAnimFileName);
+            }
+            else
+            {
+                ExportPath BlobFileName(g_CurrentOutputFileName);
+                BlobFileName.ChangeExtension("pmem");
+                g_ExportCache.AddOutputFile(BlobFileName);
+            }
+            g_ExportCache.AddManifestFiles(&g_Manifest);
+            g_ExportCache.StoreOutputs();
+        }
 
         if ((i + 1) < dwInputFileCount)
         {
@@ -11,6 +11,7 @@
 #include "StdAfx.h"
 #include "FBXImportMain.h"
 #include "ParseMisc.h"
+#include "ParseMesh.h"
 #include "ParseAnimation.h"
 
 using namespace ATG;
@@ -141,6 +142,31 @@ float FBXTransformer::TransformLength(float fInputLength) const
     return fInputLength * m_fUnitScale;
 }
 
+XMMATRIX XM_CALLCONV FBXTransformer::GetDirectionMatrix() const
+{
+    // The same axis swap or Z flip as TransformDirection, expressed as a matrix so
+    // whole streams can be transformed with DirectXMath's batched routines.
+    if (m_bMaxConversion)
+    {
+        return XMMATRIX(1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    return XMMatrixScaling(1.0f, 1.0f, m_bFlipZ ? -1.0f : 1.0f);
+}
+
+void FBXTransformer::TransformPositionStream(XMFLOAT3* pDestPositions, const XMFLOAT3* pSrcPositions, size_t Count) const
+{
+    const XMMATRIX M = XMMatrixMultiply(GetDirectionMatrix(), XMMatrixScaling(m_fUnitScale, m_fUnitScale, m_fUnitScale));
+    XMVector3TransformNormalStream(pDestPositions, sizeof(XMFLOAT3), pSrcPositions, sizeof(XMFLOAT3), Count, M);
+}
+
+void FBXTransformer::TransformDirectionStream(XMFLOAT3* pDestDirections, const XMFLOAT3* pSrcDirections, size_t Count) const
+{
+    XMVector3TransformNormalStream(pDestDirections, sizeof(XMFLOAT3), pSrcDirections, sizeof(XMFLOAT3), Count, GetDirectionMatrix());
+}
+
 
 HRESULT FBXImport::Initialize()
 {
@@ -173,6 +199,7 @@ HRESULT FBXImport::Initialize()
 
 void FBXImport::ClearScene()
 {
+    ClearParsedMeshes();
     g_pFBXScene->Clear();
 }
 
@@ -292,10 +319,14 @@ HRESULT FBXImport::ImportFile(const CHAR* strFileName)
         FixupNode(g_pScene, matIdentity);
     }
 
+    OptimizeParsedMeshes();
+
     if (g_pScene->Settings().bExportAnimations)
     {
         ParseAnimation(g_pFBXScene);
-        if (g_pScene->Settings().bRenameAnimationsToFileName)
+
+        // A multi-clip file keeps every take, so the clips keep their take names.
+        if (g_pScene->Settings().bRenameAnimationsToFileName && !g_pScene->Settings().bMultiClipAnimations)
         {
             const auto AnimName = g_CurrentOutputFileName.GetFileNameWithoutExtension();
 
@@ -26,6 +26,8 @@ public:
     void TransformPosition(DirectX::XMFLOAT3* pDestPosition, const DirectX::XMFLOAT3* pSrcPosition) const override;
     void TransformDirection(DirectX::XMFLOAT3* pDestDirection, const DirectX::XMFLOAT3* pSrcDirection) const override;
     float TransformLength(float fInputLength) const override;
+    void TransformPositionStream(DirectX::XMFLOAT3* pDestPositions, const DirectX::XMFLOAT3* pSrcPositions, size_t Count) const override;
+    void TransformDirectionStream(DirectX::XMFLOAT3* pDestDirections, const DirectX::XMFLOAT3* pSrcDirections, size_t Count) const override;
 
     // Sets unit scale for exporting all geometry - works with characters too.
     void SetUnitScale(const float fScale)
@@ -39,6 +41,8 @@ public:
     }
 
 protected:
+    DirectX::XMMATRIX XM_CALLCONV GetDirectionMatrix() const;
+
     float m_fUnitScale;
     bool  m_bMaxConversion;
     bool  m_bFlipZ;
@@ -20,6 +20,7 @@ struct AnimationScanNode
 {
     INT iParentIndex;
     FbxNode* pNode;
+    ExportFrame* pSourceFrame;
     ExportAnimationTrack* pTrack;
     DWORD dwFlags;
     XMFLOAT4X4 matGlobal;
@@ -48,6 +49,7 @@ void ParseNode(FbxNode* pNode, ScanList& scanlist, DWORD dwFlags, INT iParentInd
         AnimationScanNode asn = {};
         asn.iParentIndex = iParentIndex;
         asn.pNode = pNode;
+        asn.pSourceFrame = g_pScene->FindFrameByDCCObject(pNode);
         asn.dwFlags = dwFlags;
         scanlist.push_back(asn);
     }
@@ -72,22 +74,8 @@ static XMFLOAT4X4 ConvertMatrix(const FbxMatrix& matrix)
 }
 
 
-void AddKey(AnimationScanNode& asn, const AnimationScanNode* pParent, const FbxAMatrix& matFBXGlobal, float fTime)
+void AddLocalKey(AnimationScanNode& asn, const XMFLOAT4X4& matLocal, float fTime)
 {
-    const XMFLOAT4X4 matGlobal = ConvertMatrix(matFBXGlobal);
-    asn.matGlobal = matGlobal;
-    const XMFLOAT4X4 matLocal = matGlobal;
-    if (pParent)
-    {
-        XMMATRIX m = XMLoadFloat4x4(&pParent->matGlobal);
-        const XMMATRIX matInvParentGlobal = XMMatrixInverse(nullptr, m);
-
-        m = XMLoadFloat4x4(&matGlobal);
-        m = XMMatrixMultiply(m, matInvParentGlobal);
-
-        XMStoreFloat4x4(&matLocal, m);
-    }
-
     XMMATRIX matLocalFinal;
     g_pScene->GetDCCTransformer()->TransformMatrix(reinterpret_cast<XMFLOAT4X4*>(&matLocalFinal), &matLocal);
 
@@ -108,6 +96,44 @@ void AddKey(AnimationScanNode& asn, const AnimationScanNode* pParent, const FbxA
     asn.pTrack->TransformTrack.AddKey(fTime, trans, rot, scale);
 }
 
+static XMFLOAT4X4 RemoveParentTransform(const XMFLOAT4X4& matGlobal, const XMFLOAT4X4& matParentGlobal)
+{
+    XMMATRIX m = XMLoadFloat4x4(&matParentGlobal);
+    const XMMATRIX matInvParentGlobal = XMMatrixInverse(nullptr, m);
+
+    m = XMLoadFloat4x4(&matGlobal);
+    m = XMMatrixMultiply(m, matInvParentGlobal);
+
+    XMFLOAT4X4 matLocal;
+    XMStoreFloat4x4(&matLocal, m);
+    return matLocal;
+}
+
+void AddKey(AnimationScanNode& asn, const AnimationScanNode* pParent, const FbxAMatrix& matFBXGlobal, float fTime)
+{
+    const XMFLOAT4X4 matGlobal = ConvertMatrix(matFBXGlobal);
+    asn.matGlobal = matGlobal;
+    XMFLOAT4X4 matLocal = matGlobal;
+    if (pParent)
+    {
+        matLocal = RemoveParentTransform(matGlobal, pParent->matGlobal);
+    }
+
+    AddLocalKey(asn, matLocal, fTime);
+}
+
+#if (FBXSDK_VERSION_MAJOR > 2014 || ((FBXSDK_VERSION_MAJOR==2014) && (FBXSDK_VERSION_MINOR>1) ) )
+static FbxAnimEvaluator* GetEvaluator(FbxScene* pFbxScene)
+{
+    return pFbxScene->GetAnimationEvaluator();
+}
+#else
+static FbxAnimEvaluator* GetEvaluator(FbxScene* pFbxScene)
+{
+    return pFbxScene->GetEvaluator();
+}
+#endif
+
 void CaptureAnimation(ScanList& scanlist, const ExportAnimation* pAnim, FbxScene* pFbxScene)
 {
     const float fDeltaTime = pAnim->fSourceSamplingInterval;
@@ -119,6 +145,8 @@ void CaptureAnimation(ScanList& scanlist, const ExportAnimation* pAnim, FbxScene
 
     ExportLog::LogMsg(2, "Capturing animation data from %zu nodes, from time %0.3f to %0.3f, at an interval of %0.3f seconds.", dwNodeCount, fStartTime, fEndTime, fDeltaTime);
 
+    auto pAnimEvaluator = GetEvaluator(pFbxScene);
+
     while (fCurrentTime <= fEndTime)
     {
         FbxTime CurrentTime;
@@ -127,12 +155,6 @@ void CaptureAnimation(ScanList& scanlist, const ExportAnimation* pAnim, FbxScene
         {
             AnimationScanNode& asn = scanlist[i];
 
-#if (FBXSDK_VERSION_MAJOR > 2014 || ((FBXSDK_VERSION_MAJOR==2014) && (FBXSDK_VERSION_MINOR>1) ) )
-            auto pAnimEvaluator = pFbxScene->GetAnimationEvaluator();
-#else
-            auto pAnimEvaluator = pFbxScene->GetEvaluator();
-#endif
-
             auto matGlobal = pAnimEvaluator->GetNodeGlobalTransform(asn.pNode, CurrentTime);
             AnimationScanNode* pParent = nullptr;
             if (asn.iParentIndex >= 0)
@@ -143,7 +165,228 @@ void CaptureAnimation(ScanList& scanlist, const ExportAnimation* pAnim, FbxScene
     }
 }
 
-void ParseAnimStack(FbxScene* pFbxScene, FbxString* strAnimStackName)
+//-------------------------------------------------------------------------------------
+// Adaptive capture
+//
+// Rather than evaluating every node at every sample step, each node is evaluated only
+// at the sample steps where one of the curves driving its local transform is changing:
+// the steps bracketing each key, and every step inside a segment that is not flat.
+// Steps between samples are reconstructed by the linear interpolation the writers
+// already apply between keys, which is exact across flat segments.
+//-------------------------------------------------------------------------------------
+
+using CurveList = std::vector<FbxAnimCurve*>;
+
+static void GatherPropertyCurves(FbxProperty& Property, FbxAnimStack* pAnimStack, CurveList& Curves)
+{
+    const int iLayerCount = pAnimStack->GetMemberCount<FbxAnimLayer>();
+    for (int iLayer = 0; iLayer < iLayerCount; ++iLayer)
+    {
+        auto pCurveNode = Property.GetCurveNode(pAnimStack->GetMember<FbxAnimLayer>(iLayer));
+        if (!pCurveNode)
+            continue;
+
+        const unsigned int uChannelCount = pCurveNode->GetChannelsCount();
+        for (unsigned int uChannel = 0; uChannel < uChannelCount; ++uChannel)
+        {
+            const int iCurveCount = pCurveNode->GetCurveCount(uChannel);
+            for (int iCurve = 0; iCurve < iCurveCount; ++iCurve)
+            {
+                auto pCurve = pCurveNode->GetCurve(uChannel, static_cast<unsigned int>(iCurve));
+                if (pCurve && pCurve->KeyGetCount() > 0)
+                {
+                    Curves.push_back(pCurve);
+                }
+            }
+        }
+    }
+}
+
+static void GatherNodeCurves(FbxNode* pNode, FbxAnimStack* pAnimStack, CurveList& Curves)
+{
+    FbxProperty* TransformProperties[] =
+    {
+        &pNode->LclTranslation,
+        &pNode->LclRotation,
+        &pNode->LclScaling,
+        &pNode->RotationOffset,
+        &pNode->RotationPivot,
+        &pNode->PreRotation,
+        &pNode->PostRotation,
+        &pNode->ScalingOffset,
+        &pNode->ScalingPivot,
+    };
+    for (auto pProperty : TransformProperties)
+    {
+        GatherPropertyCurves(*pProperty, pAnimStack, Curves);
+    }
+}
+
+// Returns true if the curve holds a single value over the segment from key i to key i + 1.
+static bool IsSegmentFlat(FbxAnimCurve* pCurve, int i)
+{
+    const auto Interpolation = pCurve->KeyGetInterpolation(i);
+    if (Interpolation == FbxAnimCurveDef::eInterpolationConstant)
+        return true;
+
+    if (pCurve->KeyGetValue(i) != pCurve->KeyGetValue(i + 1))
+        return false;
+
+    if (Interpolation == FbxAnimCurveDef::eInterpolationLinear)
+        return true;
+
+    return pCurve->KeyGetRightDerivative(i) == 0.0f && pCurve->KeyGetLeftDerivative(i + 1) == 0.0f;
+}
+
+static bool IsCurveFlat(FbxAnimCurve* pCurve)
+{
+    const int iKeyCount = pCurve->KeyGetCount();
+    for (int i = 0; i + 1 < iKeyCount; ++i)
+    {
+        // A constant segment still steps to the next key's value.
+        if (pCurve->KeyGetValue(i) != pCurve->KeyGetValue(i + 1) || !IsSegmentFlat(pCurve, i))
+            return false;
+    }
+    return true;
+}
+
+// Marks the sample steps needed to reproduce the curve.  Step k is at time
+// fStartTime + k * fDeltaTime, for k in [0, StepFlags.size()).
+static void MarkCurveSamples(FbxAnimCurve* pCurve, double fStartTime, double fDeltaTime, std::vector<uint8_t>& StepFlags)
+{
+    if (IsCurveFlat(pCurve))
+        return;
+
+    const INT64 iLastStep = static_cast<INT64>(StepFlags.size()) - 1;
+    auto GetStep = [&](int iKey) -> double
+    {
+        return (pCurve->KeyGetTime(iKey).GetSecondDouble() - fStartTime) / fDeltaTime;
+    };
+    auto MarkRange = [&](double fFirst, double fLast)
+    {
+        const INT64 iFirst = std::max<INT64>(static_cast<INT64>(floor(fFirst)), 0);
+        const INT64 iLast = std::min<INT64>(static_cast<INT64>(ceil(fLast)), iLastStep);
+        for (INT64 k = iFirst; k <= iLast; ++k)
+        {
+            StepFlags[static_cast<size_t>(k)] = 1;
+        }
+    };
+
+    // Outside its keys a curve is extrapolated, which may repeat or oscillate; sample
+    // those ranges at every step.
+    const int iKeyCount = pCurve->KeyGetCount();
+    MarkRange(-1.0, GetStep(0));
+    MarkRange(GetStep(iKeyCount - 1), static_cast<double>(iLastStep) + 1.0);
+
+    for (int i = 0; i + 1 < iKeyCount; ++i)
+    {
+        const double fSegmentStart = GetStep(i);
+        const double fSegmentEnd = GetStep(i + 1);
+        if (IsSegmentFlat(pCurve, i))
+        {
+            MarkRange(fSegmentStart, fSegmentStart);
+            MarkRange(fSegmentEnd, fSegmentEnd);
+        }
+        else
+        {
+            MarkRange(fSegmentStart, fSegmentEnd);
+        }
+    }
+}
+
+static bool IsAdaptiveCaptureSupported(FbxScene* pFbxScene, FbxAnimStack* pAnimStack)
+{
+    // Constraints drive nodes without any curves on the nodes themselves.
+    if (pFbxScene->GetSrcObjectCount<FbxConstraint>() > 0)
+    {
+        ExportLog::LogMsg(3, "Scene contains constraints; using full-rate animation capture.");
+        return false;
+    }
+    return pAnimStack->GetMemberCount<FbxAnimLayer>() > 0;
+}
+
+void CaptureAnimationAdaptive(ScanList& scanlist, const ExportAnimation* pAnim, FbxScene* pFbxScene, FbxAnimStack* pAnimStack)
+{
+    const double fDeltaTime = pAnim->fSourceSamplingInterval;
+    const double fStartTime = pAnim->fStartTime;
+    const double fEndTime = pAnim->fEndTime;
+    const size_t dwStepCount = static_cast<size_t>(std::max(floor((fEndTime - fStartTime) / fDeltaTime + 1e-4), 0.0)) + 1;
+
+    const size_t dwNodeCount = scanlist.size();
+
+    ExportLog::LogMsg(2, "Capturing animation data from %zu nodes at curve keys, from time %0.3f to %0.3f, at an interval of %0.3f seconds.", dwNodeCount, fStartTime, fEndTime, fDeltaTime);
+
+    auto pAnimEvaluator = GetEvaluator(pFbxScene);
+
+    std::vector<uint8_t> StepFlags(dwStepCount);
+    CurveList Curves;
+    size_t dwSampleCount = 0;
+    for (size_t i = 0; i < dwNodeCount; ++i)
+    {
+        AnimationScanNode& asn = scanlist[i];
+
+        // A local transform depends only on the node's own curves, unless it is relative
+        // to the scene root or the node uses an RrSs or Rrs scale inheritance.
+        Curves.clear();
+        GatherNodeCurves(asn.pNode, pAnimStack, Curves);
+
+        FbxTransform::EInheritType InheritType = FbxTransform::eInheritRSrs;
+        asn.pNode->GetTransformationInheritType(InheritType);
+        const bool bInheritRSrs = (InheritType == FbxTransform::eInheritRSrs);
+        if (asn.iParentIndex < 0 || !bInheritRSrs)
+        {
+            for (auto pAncestor = asn.pNode->GetParent(); pAncestor; pAncestor = pAncestor->GetParent())
+            {
+                GatherNodeCurves(pAncestor, pAnimStack, Curves);
+            }
+        }
+
+        std::fill(StepFlags.begin(), StepFlags.end(), uint8_t(0));
+        StepFlags.front() = 1;
+        StepFlags.back() = 1;
+        for (auto pCurve : Curves)
+        {
+            MarkCurveSamples(pCurve, fStartTime, fDeltaTime, StepFlags);
+        }
+
+        for (size_t k = 0; k < dwStepCount; ++k)
+        {
+            if (!StepFlags[k])
+                continue;
+
+            const double fTime = std::min(fStartTime + static_cast<double>(k) * fDeltaTime, fEndTime);
+            FbxTime CurrentTime;
+            CurrentTime.SetSecondDouble(fTime);
+
+            // The property-built local transform only matches the global transform
+            // relative to the parent's when the node inherits RSrs.  For other
+            // inheritance types, divide out the parent's global transform the way the
+            // full-rate capture does.
+            XMFLOAT4X4 matLocal;
+            if (asn.iParentIndex < 0)
+            {
+                matLocal = ConvertMatrix(pAnimEvaluator->GetNodeGlobalTransform(asn.pNode, CurrentTime));
+            }
+            else if (bInheritRSrs)
+            {
+                matLocal = ConvertMatrix(pAnimEvaluator->GetNodeLocalTransform(asn.pNode, CurrentTime));
+            }
+            else
+            {
+                const AnimationScanNode& Parent = scanlist[asn.iParentIndex];
+                const XMFLOAT4X4 matGlobal = ConvertMatrix(pAnimEvaluator->GetNodeGlobalTransform(asn.pNode, CurrentTime));
+                const XMFLOAT4X4 matParentGlobal = ConvertMatrix(pAnimEvaluator->GetNodeGlobalTransform(Parent.pNode, CurrentTime));
+                matLocal = RemoveParentTransform(matGlobal, matParentGlobal);
+            }
+            AddLocalKey(asn, matLocal, static_cast<float>(fTime - fStartTime));
+            ++dwSampleCount;
+        }
+    }
+
+    ExportLog::LogMsg(3, "Evaluated %zu of %zu node samples.", dwSampleCount, dwNodeCount * dwStepCount);
+}
+
+void ParseAnimStack(FbxScene* pFbxScene, FbxString* strAnimStackName, const ScanList& SourceScanList)
 {
     // TODO - Ignore "Default"? FBXSDK_TAKENODE_DEFAULT_NAME
 
@@ -152,6 +395,8 @@ void ParseAnimStack(FbxScene* pFbxScene, FbxString* strAnimStackName)
         return;
 
 #if (FBXSDK_VERSION_MAJOR > 2014 || ((FBXSDK_VERSION_MAJOR==2014) && (FBXSDK_VERSION_MINOR>1) ) )
+    // The evaluator always evaluates the scene's current stack.
+    pFbxScene->SetCurrentAnimationStack(curAnimStack);
     pFbxScene->GetAnimationEvaluator()->Reset();
 #else
     pFbxScene->GetEvaluator()->SetContext(curAnimStack);
@@ -196,14 +441,8 @@ void ParseAnimStack(FbxScene* pFbxScene, FbxString* strAnimStackName)
     pAnim->fSourceFrameInterval = fFrameTime;
     pAnim->fSourceSamplingInterval = fSampleTime;
 
-    bool bIncludeAllNodes = true;
-    if (strlen(g_pScene->Settings().strAnimationRootNodeName) > 0)
-    {
-        bIncludeAllNodes = false;
-    }
-
-    ScanList scanlist;
-    ParseNode(pFbxScene->GetRootNode(), scanlist, 0, -1, bIncludeAllNodes);
+    // Each stack captures into its own copy of the shared scan list.
+    ScanList scanlist(SourceScanList);
 
     const size_t dwTrackCount = scanlist.size();
     for (size_t i = 0; i < dwTrackCount; ++i)
@@ -212,12 +451,19 @@ void ParseAnimStack(FbxScene* pFbxScene, FbxString* strAnimStackName)
         ExportLog::LogMsg(4, "Track: %s", strTrackName);
         auto pTrack = new ExportAnimationTrack();
         pTrack->SetName(strTrackName);
-        pTrack->TransformTrack.pSourceFrame = g_pScene->FindFrameByDCCObject(scanlist[i].pNode);
+        pTrack->TransformTrack.pSourceFrame = scanlist[i].pSourceFrame;
         pAnim->AddTrack(pTrack);
         scanlist[i].pTrack = pTrack;
     }
 
-    CaptureAnimation(scanlist, pAnim, pFbxScene);
+    if (g_pScene->Settings().bAdaptiveAnimationCapture && IsAdaptiveCaptureSupported(pFbxScene, curAnimStack))
+    {
+        CaptureAnimationAdaptive(scanlist, pAnim, pFbxScene, curAnimStack);
+    }
+    else
+    {
+        CaptureAnimation(scanlist, pAnim, pFbxScene);
+    }
 
     pAnim->Optimize();
 }
@@ -233,8 +479,24 @@ void ParseAnimation(FbxScene* pFbxScene)
     pFbxScene->FillAnimStackNameArray(AnimStackNameArray);
 
     const DWORD dwAnimStackCount = static_cast<DWORD>(AnimStackNameArray.GetCount());
-    for (DWORD i = 0; i < dwAnimStackCount; ++i)
+    if (dwAnimStackCount > 0)
     {
-        ParseAnimStack(pFbxScene, AnimStackNameArray.GetAt(i));
+        bool bIncludeAllNodes = true;
+        if (strlen(g_pScene->Settings().strAnimationRootNodeName) > 0)
+        {
+            bIncludeAllNodes = false;
+        }
+
+        // The node hierarchy and frame lookups are the same for every stack, so they are
+        // scanned once.
+        ScanList scanlist;
+        ParseNode(pFbxScene->GetRootNode(), scanlist, 0, -1, bIncludeAllNodes);
+
+        for (DWORD i = 0; i < dwAnimStackCount; ++i)
+        {
+            ParseAnimStack(pFbxScene, AnimStackNameArray.GetAt(i), scanlist);
+        }
     }
+
+    FbxArrayDelete(AnimStackNameArray);
 }
@@ -163,6 +163,76 @@ bool ParseMeshSkinning(const FbxMesh* pMesh, SkinData* pSkinData)
     return true;
 }
 
+namespace
+{
+    // A mesh that has been parsed but not optimized yet.
+    struct PendingMesh
+    {
+        ExportMesh* pMesh;
+        ExportModel* pModel;
+        DWORD dwOptimizationFlags;
+        std::vector<ExportMaterial*> MaterialList;
+        DWORD dwNonConformingSubDPolys;
+    };
+
+    std::vector<PendingMesh> g_PendingMeshes;
+
+    void FinalizeMesh(const PendingMesh& Pending)
+    {
+        ExportMesh* pMesh = Pending.pMesh;
+        ExportModel* pModel = Pending.pModel;
+        const std::vector<ExportMaterial*>& MaterialList = Pending.MaterialList;
+        const size_t dwMaterialCount = MaterialList.size();
+        if (!pMesh->GetSubDMesh())
+        {
+            for (size_t dwSubset = 0; dwSubset < dwMaterialCount; ++dwSubset)
+            {
+                auto pMaterial = MaterialList[dwSubset];
+                auto pSubset = pMesh->GetSubset(dwSubset);
+                CHAR strUniqueSubsetName[100];
+                sprintf_s(strUniqueSubsetName, "subset%zu_%s", dwSubset, pMaterial->GetName().SafeString());
+                pSubset->SetName(strUniqueSubsetName);
+                pModel->SetSubsetBinding(pSubset->GetName(), pMaterial);
+            }
+        }
+        else
+        {
+            auto pSubDMesh = pMesh->GetSubDMesh();
+            const size_t dwSubsetCount = pSubDMesh->GetSubsetCount();
+            for (size_t dwSubset = 0; dwSubset < dwSubsetCount; ++dwSubset)
+            {
+                auto pSubset = pSubDMesh->GetSubset(dwSubset);
+                assert(pSubset != nullptr);
+                assert(pSubset->iOriginalMeshSubset < static_cast<INT>(dwMaterialCount));
+                auto pMaterial = MaterialList[pSubset->iOriginalMeshSubset];
+                CHAR strUniqueSubsetName[100];
+                sprintf_s(strUniqueSubsetName, "subset%zu_%s", dwSubset, pMaterial->GetName().SafeString());
+                pSubset->Name = strUniqueSubsetName;
+                pModel->SetSubsetBinding(pSubset->Name, pMaterial, true);
+            }
+        }
+
+        if (Pending.dwNonConformingSubDPolys > 0)
+        {
+            ExportLog::LogWarning("Encountered %u polygons with 5 or more sides in mesh \"%s\", which were subdivided into quad and triangle patches.  Mesh appearance may have been affected.", Pending.dwNonConformingSubDPolys, pMesh->GetName().SafeString());
+        }
+
+        // update statistics
+        if (pMesh->GetSubDMesh())
+        {
+            g_pScene->Statistics().SubDMeshesProcessed++;
+            g_pScene->Statistics().SubDQuadsProcessed += pMesh->GetSubDMesh()->GetQuadPatchCount();
+            g_pScene->Statistics().SubDTrisProcessed += pMesh->GetSubDMesh()->GetTrianglePatchCount();
+        }
+        else
+        {
+            g_pScene->Statistics().TrisExported += pMesh->GetIB()->GetIndexCount() / 3;
+            g_pScene->Statistics().VertsExported += pMesh->GetVB()->GetVertexCount();
+            g_pScene->Statistics().MeshesExported++;
+        }
+    }
+}
+
 void ParseMesh(FbxNode* pNode, FbxMesh* pFbxMesh, ExportFrame* pParentFrame, bool bSubDProcess, const CHAR* strSuffix)
 {
     if (!g_pScene->Settings().bExportMeshes)
@@ -307,7 +377,7 @@ void ParseMesh(FbxNode* pNode, FbxMesh* pFbxMesh, ExportFrame* pParentFrame, boo
         dwMeshOptimizationFlags |= ExportMesh::COMPRESS_VERTEX_DATA;
 
     // Assume that polys are usually quads.
-    g_MeshTriangleAllocator.SetSizeHint(dwPolyCount * 2);
+    pMesh->ReserveRawTriangles(dwPolyCount * 2);
 
     const DWORD dwVertexCount = pFbxMesh->GetControlPointsCount();
     auto pVertexPositions = pFbxMesh->GetControlPoints();
@@ -352,6 +422,11 @@ void ParseMesh(FbxNode* pNode, FbxMesh* pFbxMesh, ExportFrame* pParentFrame, boo
 
     const bool bInvertTexVCoord = g_pScene->Settings().bInvertTexVCoord;
 
+    // The mesh copies the streams it uses out of each raw triangle, so a single
+    // scratch triangle is reused for the whole mesh.  Every stream enabled in the
+    // vertex format is written below, so it does not need to be reset per triangle.
+    ExportMeshTriangle ScratchTriangle;
+
     // Loop over polygons.
     DWORD basePolyIndex = 0;
     for (DWORD dwPolyIndex = 0; dwPolyIndex < dwPolyCount; ++dwPolyIndex)
@@ -405,7 +480,7 @@ void ParseMesh(FbxNode* pNode, FbxMesh* pFbxMesh, ExportFrame* pParentFrame, boo
             pFbxMesh->GetPolygonVertexNormal(iPolyIndex, iVertIndex[2], vNormals[2]);
 
             // Build the raw triangle.
-            auto pTriangle = g_MeshTriangleAllocator.GetNewTriangle();
+            auto pTriangle = &ScratchTriangle;
 
             // Store polygon index
             pTriangle->PolygonIndex = static_cast<INT>(dwPolyIndex);
@@ -576,60 +651,59 @@ void ParseMesh(FbxNode* pNode, FbxMesh* pFbxMesh, ExportFrame* pParentFrame, boo
         dwMeshOptimizationFlags |= ExportMesh::CLEAN_MESHES | ExportMesh::VCACHE_OPT;
     }
 
-    pMesh->Optimize(dwMeshOptimizationFlags);
-
-    ExportModel* pModel = new ExportModel(pMesh);
-    const size_t dwMaterialCount = MaterialList.size();
-    if (!pMesh->GetSubDMesh())
+    // Subdivision surfaces are drawn as patches, so they get no meshlets.
+    if (g_pScene->Settings().bGenerateMeshlets && !bSubDProcess)
     {
-        for (size_t dwSubset = 0; dwSubset < dwMaterialCount; ++dwSubset)
-        {
-            auto pMaterial = MaterialList[dwSubset];
-            auto pSubset = pMesh->GetSubset(dwSubset);
-            CHAR strUniqueSubsetName[100];
-            sprintf_s(strUniqueSubsetName, "subset%zu_%s", dwSubset, pMaterial->GetName().SafeString());
-            pSubset->SetName(strUniqueSubsetName);
-            pModel->SetSubsetBinding(pSubset->GetName(), pMaterial);
-        }
+        dwMeshOptimizationFlags |= ExportMesh::GENERATE_MESHLETS;
     }
-    else
-    {
-        auto pSubDMesh = pMesh->GetSubDMesh();
-        const size_t dwSubsetCount = pSubDMesh->GetSubsetCount();
-        for (size_t dwSubset = 0; dwSubset < dwSubsetCount; ++dwSubset)
+
+    // The model is attached to the scene now so frame and mesh order match the FBX
+    // hierarchy; optimization and subset binding happen in OptimizeParsedMeshes().
+    ExportModel* pModel = new ExportModel(pMesh);
+    pParentFrame->AddModel(pModel);
+    g_pScene->AddMesh(pMesh);
+
+    PendingMesh Pending;
+    Pending.pMesh = pMesh;
+    Pending.pModel = pModel;
+    Pending.dwOptimizationFlags = dwMeshOptimizationFlags;
+    Pending.MaterialList.swap(MaterialList);
+    Pending.dwNonConformingSubDPolys = bSubDProcess ? dwNonConformingSubDPolys : 0;
+    g_PendingMeshes.push_back(std::move(Pending));
+}
+
+void OptimizeParsedMeshes()
+{
+    const size_t dwMeshCount = g_PendingMeshes.size();
+    if (!dwMeshCount)
+        return;
+
+    const UINT uThreadCount = static_cast<UINT>(std::min<size_t>(GetExportWorkerThreadCount(), dwMeshCount));
+    ExportLog::LogMsg(2, "Optimizing %zu meshes on %u thread(s).", dwMeshCount, uThreadCount);
+    const ULONGLONG ullStartTime = GetTickCount64();
+
+    // Meshes only read shared state while they are optimized, so each one is an
+    // independent task.  Everything that touches the scene is done afterwards in
+    // parse order, which keeps the output identical to a serial export.
+    ExportParallelFor(dwMeshCount, [](size_t i)
         {
-            auto pSubset = pSubDMesh->GetSubset(dwSubset);
-            assert(pSubset != nullptr);
-            assert(pSubset->iOriginalMeshSubset < static_cast<INT>(dwMaterialCount));
-            auto pMaterial = MaterialList[pSubset->iOriginalMeshSubset];
-            CHAR strUniqueSubsetName[100];
-            sprintf_s(strUniqueSubsetName, "subset%zu_%s", dwSubset, pMaterial->GetName().SafeString());
-            pSubset->Name = strUniqueSubsetName;
-            pModel->SetSubsetBinding(pSubset->Name, pMaterial, true);
-        }
-    }
+            const PendingMesh& Pending = g_PendingMeshes[i];
+            Pending.pMesh->Optimize(Pending.dwOptimizationFlags);
+        });
 
-    if (bSubDProcess && (dwNonConformingSubDPolys > 0))
-    {
-        ExportLog::LogWarning("Encountered %u polygons with 5 or more sides in mesh \"%s\", which were subdivided into quad and triangle patches.  Mesh appearance may have been affected.", dwNonConformingSubDPolys, pMesh->GetName().SafeString());
-    }
+    ExportLog::LogMsg(3, "Mesh optimization took %llu ms.", GetTickCount64() - ullStartTime);
 
-    // update statistics
-    if (pMesh->GetSubDMesh())
-    {
-        g_pScene->Statistics().SubDMeshesProcessed++;
-        g_pScene->Statistics().SubDQuadsProcessed += pMesh->GetSubDMesh()->GetQuadPatchCount();
-        g_pScene->Statistics().SubDTrisProcessed += pMesh->GetSubDMesh()->GetTrianglePatchCount();
-    }
-    else
+    for (size_t i = 0; i < dwMeshCount; ++i)
     {
-        g_pScene->Statistics().TrisExported += pMesh->GetIB()->GetIndexCount() / 3;
-        g_pScene->Statistics().VertsExported += pMesh->GetVB()->GetVertexCount();
-        g_pScene->Statistics().MeshesExported++;
+        FinalizeMesh(g_PendingMeshes[i]);
     }
 
-    pParentFrame->AddModel(pModel);
-    g_pScene->AddMesh(pMesh);
+    g_PendingMeshes.clear();
+}
+
+void ClearParsedMeshes()
+{
+    g_PendingMeshes.clear();
 }
 
 void ParseSubDiv(FbxNode* pNode, const FbxSubDiv* pFbxSubD, ExportFrame* pParentFrame)
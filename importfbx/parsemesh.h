@@ -13,3 +13,5 @@
 
 void ParseMesh(FbxNode* pNode, FbxMesh* pFbxMesh, ATG::ExportFrame* pParentFrame, bool bSubDProcess = false, const CHAR* strSuffix = nullptr);
 void ParseSubDiv(FbxNode* pNode, const FbxSubDiv* pFbxSubD, ATG::ExportFrame* pParentFrame);
+void OptimizeParsedMeshes();
+void ClearParsedMeshes();
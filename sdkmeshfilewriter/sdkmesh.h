@@ -37,6 +37,12 @@ namespace DXUT
     // }
 
 
+    // Optional chunks, SDKMESH_FILE_VERSION_V2 only
+    // { SDKMESH_CHUNK_HEADER       header->HeaderSize + header->NonBufferDataSize + header->BufferDataSize
+    //      chunk data
+    // }
+
+
     // .SDDKANIM files
 
     // SDKANIMATION_FILE_HEADER
@@ -130,6 +136,9 @@ namespace DXUT
 //--------------------------------------------------------------------------------------
     constexpr uint32_t SDKMESH_FILE_VERSION = 101;
     constexpr uint32_t SDKMESH_FILE_VERSION_V2 = 200;
+    constexpr uint32_t SDKANIMATION_FILE_VERSION_QUANTIZED = 110;
+    constexpr uint32_t SDKANIMATION_FILE_VERSION_SPARSE = 120;
+    constexpr uint32_t SDKANIMATION_FILE_VERSION_MULTICLIP = 130;
 
     constexpr uint32_t MAX_VERTEX_ELEMENTS = 32;
     constexpr uint32_t MAX_VERTEX_STREAMS = 16;
@@ -137,6 +146,7 @@ namespace DXUT
     constexpr uint32_t MAX_MESH_NAME = 100;
     constexpr uint32_t MAX_SUBSET_NAME = 100;
     constexpr uint32_t MAX_MATERIAL_NAME = 100;
+    constexpr uint32_t MAX_ANIMATION_NAME = 100;
     constexpr uint32_t MAX_TEXTURE_NAME = MAX_PATH;
     constexpr uint32_t MAX_MATERIAL_PATH = MAX_PATH;
     constexpr uint32_t INVALID_FRAME = uint32_t(-1);
@@ -145,6 +155,8 @@ namespace DXUT
     constexpr uint32_t INVALID_SUBSET = uint32_t(-1);
     constexpr uint32_t INVALID_ANIMATION_DATA = uint32_t(-1);
 
+    constexpr uint32_t SDKMESH_CHUNK_MESHLETS = 0x54454C4D; // 'MLET'
+
     //--------------------------------------------------------------------------------------
     // Enumerated Types.
     //--------------------------------------------------------------------------------------
@@ -175,6 +187,13 @@ namespace DXUT
         FTT_ABSOLUTE, // This is not currently used but is here to support absolute transformations in the future
     };
 
+    enum SDKANIMATION_QUANTIZED_FLAGS
+    {
+        SQF_TRANSLATION_ANIMATED = 0x1,
+        SQF_ORIENTATION_ANIMATED = 0x2,
+        SQF_SCALING_ANIMATED = 0x4,
+    };
+
     //--------------------------------------------------------------------------------------
     // Structures.
     //--------------------------------------------------------------------------------------
@@ -342,6 +361,142 @@ namespace DXUT
         uint64_t DataOffset;
     };
 
+    // In SDKANIMATION_FILE_VERSION_QUANTIZED files, each SDKANIMATION_FRAME_DATA::DataOffset
+    // points to one of these.  It is followed by NumAnimationKeys x 3 uint16_t values for
+    // each animated channel, in the order translation, orientation, scaling, and padded to
+    // 8 bytes.  Translation and scaling values decode as Min + Extent * (value / 65535).
+    // Orientations are smallest-three quaternions: the top bits of the first two values
+    // give the index of the dropped largest component, and the low 15 bits of each map
+    // [0, 32767] to [-1/sqrt(2), 1/sqrt(2)].  A constant channel uses Min or Orientation.
+    struct SDKANIMATION_QUANTIZED_TRACK
+    {
+        uint32_t Flags;
+        DirectX::XMFLOAT3 TranslationMin;
+        DirectX::XMFLOAT3 TranslationExtent;
+        DirectX::XMFLOAT4 Orientation;
+        DirectX::XMFLOAT3 ScalingMin;
+        DirectX::XMFLOAT3 ScalingExtent;
+    };
+
+    // In SDKANIMATION_FILE_VERSION_SPARSE files, each SDKANIMATION_FRAME_DATA::DataOffset
+    // points to one of these.  It is followed by TranslationKeyCount translation keys,
+    // OrientationKeyCount orientation keys and ScalingKeyCount scaling keys, and padded to
+    // 8 bytes.  Key times are in seconds and increase within a channel; values are held
+    // outside the first and last keys.  A constant channel has a single key, and a channel
+    // with no keys uses the identity.
+    struct SDKANIMATION_SPARSE_TRACK
+    {
+        uint32_t TranslationKeyCount;
+        uint32_t OrientationKeyCount;
+        uint32_t ScalingKeyCount;
+        uint32_t Reserved;
+    };
+
+    struct SDKANIMATION_TRANSLATION_KEY
+    {
+        float Time;
+        DirectX::XMFLOAT3 Translation;
+    };
+
+    struct SDKANIMATION_ORIENTATION_KEY
+    {
+        float Time;
+        DirectX::XMFLOAT4 Orientation;
+    };
+
+    struct SDKANIMATION_SCALING_KEY
+    {
+        float Time;
+        DirectX::XMFLOAT3 Scaling;
+    };
+
+    // SDKANIMATION_FILE_VERSION_MULTICLIP files hold several clips over one frame table.
+    // The animation data starts with NumFrames SDKANIMATION_FRAME_DATA records, whose
+    // DataOffset is unused, followed by an SDKANIMATION_CLIP_TABLE and its clips.  Each
+    // clip's TrackOffsetsOffset points to NumFrames uint64_t offsets of the clip's
+    // SDKANIMATION_SPARSE_TRACK for each frame, or 0 where the clip does not animate the
+    // frame.  All offsets are relative to the start of the animation data, and the header's
+    // NumAnimationKeys is that of the longest clip.
+    struct SDKANIMATION_CLIP_TABLE
+    {
+        uint32_t NumClips;
+        uint32_t Reserved;
+    };
+
+    struct SDKANIMATION_CLIP
+    {
+        char ClipName[MAX_ANIMATION_NAME];
+        float Duration;
+        uint32_t NumAnimationKeys;
+        uint32_t Reserved;
+        uint64_t TrackOffsetsOffset;
+    };
+
+    // SDKMESH_FILE_VERSION_V2 files may be followed by chunks, starting right after the
+    // buffer data.  Each chunk is an SDKMESH_CHUNK_HEADER and SizeBytes of data, padded to
+    // 8 bytes.  Offsets inside a chunk are from the start of the file.  Loaders that stop
+    // at the end of the buffer data are unaffected, and chunk types a loader does not
+    // know can be skipped.
+    struct SDKMESH_CHUNK_HEADER
+    {
+        uint32_t Type;
+        uint32_t Reserved;
+        uint64_t SizeBytes;
+    };
+
+    // An SDKMESH_CHUNK_MESHLETS chunk starts with an SDKMESH_MESHLET_CHUNK, followed by
+    // NumMeshes SDKMESH_MESHLET_MESH records and their arrays.  A record's subset list has
+    // one entry per entry of its mesh's subset list, in the same order.  A meshlet's
+    // vertices are the unique vertex indices [VertOffset, VertOffset + VertCount), of
+    // IndexType, and its triangles are the primitives [PrimOffset, PrimOffset + PrimCount),
+    // each a uint32_t packing three 10-bit meshlet-local vertex indices.
+    struct SDKMESH_MESHLET_CHUNK
+    {
+        uint32_t NumMeshes;
+        uint32_t MaxVertices;
+        uint32_t MaxPrimitives;
+        uint32_t Reserved;
+    };
+
+    struct SDKMESH_MESHLET_MESH
+    {
+        uint32_t Mesh;
+        uint32_t NumSubsets;
+        uint32_t NumMeshlets;
+        uint32_t IndexType;
+        uint64_t NumUniqueVertexIndices;
+        uint64_t NumPrimitives;
+        uint64_t SubsetOffset;
+        uint64_t MeshletOffset;
+        uint64_t CullDataOffset;
+        uint64_t UniqueVertexIndexOffset;
+        uint64_t PrimitiveOffset;
+    };
+
+    struct SDKMESH_MESHLET_SUBSET
+    {
+        uint32_t MeshletStart;
+        uint32_t MeshletCount;
+    };
+
+    struct SDKMESH_MESHLET
+    {
+        uint32_t VertCount;
+        uint32_t VertOffset;
+        uint32_t PrimCount;
+        uint32_t PrimOffset;
+    };
+
+    // NormalCone packs the cone axis (xyz) and cutoff (w) as UNORM bytes mapped from
+    // [-1, 1].  The cone apex is BoundingSphereCenter - axis * ApexOffset.
+    struct SDKMESH_MESHLET_CULL_DATA
+    {
+        DirectX::XMFLOAT3 BoundingSphereCenter;
+        float BoundingSphereRadius;
+        uint32_t NormalCone;
+        float ApexOffset;
+    };
+
 #pragma pack(pop)
 
 } // namespace
@@ -358,3 +513,16 @@ static_assert(sizeof(DXUT::SDKMESH_MATERIAL_V2) == sizeof(DXUT::SDKMESH_MATERIAL
 static_assert(sizeof(DXUT::SDKANIMATION_FILE_HEADER) == 40, "SDK Mesh structure size incorrect");
 static_assert(sizeof(DXUT::SDKANIMATION_DATA) == 40, "SDK Mesh structure size incorrect");
 static_assert(sizeof(DXUT::SDKANIMATION_FRAME_DATA) == 112, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_QUANTIZED_TRACK) == 68, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_SPARSE_TRACK) == 16, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_TRANSLATION_KEY) == 16, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_ORIENTATION_KEY) == 20, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_SCALING_KEY) == 16, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_CLIP_TABLE) == 8, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKANIMATION_CLIP) == 120, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKMESH_CHUNK_HEADER) == 16, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKMESH_MESHLET_CHUNK) == 16, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKMESH_MESHLET_MESH) == 72, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKMESH_MESHLET_SUBSET) == 8, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKMESH_MESHLET) == 16, "SDK Mesh structure size incorrect");
+static_assert(sizeof(DXUT::SDKMESH_MESHLET_CULL_DATA) == 24, "SDK Mesh structure size incorrect");
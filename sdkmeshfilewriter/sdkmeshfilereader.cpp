@@ -0,0 +1,1144 @@
+//-------------------------------------------------------------------------------------
+// SDKMeshFileReader.cpp
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+#include "stdafx.h"
+#include "SDKmesh.h"
+#include "SDKMeshFileReader.h"
+
+#include <cmath>
+#include <cstdarg>
+
+using namespace DirectX;
+using namespace ATG;
+using namespace DXUT;
+
+namespace
+{
+    constexpr UINT64 SDKMESH_BUFFER_ALIGNMENT = 4096;
+    constexpr UINT64 SDKMESH_TABLE_ALIGNMENT = 8;
+    constexpr size_t MAX_REPORTED_PROBLEMS = 32;
+
+    // Counts layout problems, logging the first few so a badly broken file does not
+    // flood the log.
+    class ProblemReporter
+    {
+    public:
+        explicit ProblemReporter(const CHAR* strFileName) noexcept
+            : m_strFileName(strFileName),
+            m_dwCount(0)
+        {
+        }
+        ~ProblemReporter()
+        {
+            if (m_dwCount > MAX_REPORTED_PROBLEMS)
+            {
+                ExportLog::LogError("%s: %zu further problem(s) not shown.", m_strFileName, m_dwCount - MAX_REPORTED_PROBLEMS);
+            }
+        }
+
+        void operator()(_In_z_ _Printf_format_string_ const CHAR* strFormat, ...)
+        {
+            if (++m_dwCount > MAX_REPORTED_PROBLEMS)
+                return;
+
+            CHAR strMessage[512];
+            va_list args;
+            va_start(args, strFormat);
+            vsprintf_s(strMessage, strFormat, args);
+            va_end(args);
+            ExportLog::LogError("%s: %s", m_strFileName, strMessage);
+        }
+
+        size_t GetCount() const noexcept { return m_dwCount; }
+
+    private:
+        const CHAR* m_strFileName;
+        size_t      m_dwCount;
+    };
+
+    constexpr UINT64 RoundUp8B(UINT64 Value) noexcept
+    {
+        return ((Value + 7) / 8) * 8;
+    }
+
+    template<size_t TLength>
+    bool IsTerminated(const char(&strName)[TLength]) noexcept
+    {
+        return memchr(strName, '\0', TLength) != nullptr;
+    }
+
+    bool IsValidReference(uint32_t uIndex, uint32_t uCount) noexcept
+    {
+        return uIndex == uint32_t(-1) || uIndex < uCount;
+    }
+
+    bool IsStripType(uint32_t uPrimitiveType) noexcept
+    {
+        return uPrimitiveType == PT_TRIANGLE_STRIP || uPrimitiveType == PT_LINE_STRIP
+            || uPrimitiveType == PT_TRIANGLE_STRIP_ADJ || uPrimitiveType == PT_LINE_STRIP_ADJ;
+    }
+
+    template<class TIndex>
+    bool IndicesInRange(const TIndex* pIndices, UINT64 Count, UINT64 VertexCount, bool bAllowRestart) noexcept
+    {
+        const TIndex Restart = TIndex(-1);
+        for (UINT64 i = 0; i < Count; ++i)
+        {
+            const TIndex Index = pIndices[i];
+            if (Index >= VertexCount && !(bAllowRestart && Index == Restart))
+                return false;
+        }
+        return true;
+    }
+}
+
+//-------------------------------------------------------------------------------------
+// SDKMeshMappedFile
+//-------------------------------------------------------------------------------------
+
+SDKMeshMappedFile::SDKMeshMappedFile() noexcept
+    : m_hFile(INVALID_HANDLE_VALUE),
+    m_hMapping(nullptr),
+    m_pData(nullptr),
+    m_Size(0),
+    m_strFileName{}
+{
+}
+
+bool SDKMeshMappedFile::Open(const CHAR* strFileName)
+{
+    Close();
+    strcpy_s(m_strFileName, strFileName);
+
+    m_hFile = CreateFileA(strFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER FileSize = {};
+    if (!GetFileSizeEx(m_hFile, &FileSize) || FileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+    m_Size = static_cast<UINT64>(FileSize.QuadPart);
+
+    m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_hMapping)
+    {
+        Close();
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_pData)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void SDKMeshMappedFile::Close() noexcept
+{
+    if (m_pData)
+    {
+        UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+    if (m_hMapping)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = INVALID_HANDLE_VALUE;
+    }
+    m_Size = 0;
+}
+
+//-------------------------------------------------------------------------------------
+// SDKMeshFileView
+//-------------------------------------------------------------------------------------
+
+bool SDKMeshFileView::Open(const CHAR* strFileName)
+{
+    if (!m_File.Open(strFileName))
+    {
+        ExportLog::LogError("Could not open SDKMESH file \"%s\".", strFileName);
+        return false;
+    }
+    return true;
+}
+
+const SDKMESH_HEADER* SDKMeshFileView::GetHeader() const noexcept
+{
+    if (m_File.GetSize() < sizeof(SDKMESH_HEADER))
+        return nullptr;
+    return reinterpret_cast<const SDKMESH_HEADER*>(m_File.GetData());
+}
+
+const SDKMESH_VERTEX_BUFFER_HEADER* SDKMeshFileView::GetVertexBufferHeaders() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKMESH_VERTEX_BUFFER_HEADER*>(m_File.GetData() + pHeader->VertexStreamHeadersOffset) : nullptr;
+}
+
+const SDKMESH_INDEX_BUFFER_HEADER* SDKMeshFileView::GetIndexBufferHeaders() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKMESH_INDEX_BUFFER_HEADER*>(m_File.GetData() + pHeader->IndexStreamHeadersOffset) : nullptr;
+}
+
+const SDKMESH_MESH* SDKMeshFileView::GetMeshes() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKMESH_MESH*>(m_File.GetData() + pHeader->MeshDataOffset) : nullptr;
+}
+
+const SDKMESH_SUBSET* SDKMeshFileView::GetSubsets() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKMESH_SUBSET*>(m_File.GetData() + pHeader->SubsetDataOffset) : nullptr;
+}
+
+const SDKMESH_FRAME* SDKMeshFileView::GetFrames() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKMESH_FRAME*>(m_File.GetData() + pHeader->FrameDataOffset) : nullptr;
+}
+
+const SDKMESH_MATERIAL* SDKMeshFileView::GetMaterials() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKMESH_MATERIAL*>(m_File.GetData() + pHeader->MaterialDataOffset) : nullptr;
+}
+
+const uint32_t* SDKMeshFileView::GetMeshSubsetIndices(const SDKMESH_MESH& Mesh) const noexcept
+{
+    return reinterpret_cast<const uint32_t*>(m_File.GetData() + Mesh.SubsetOffset);
+}
+
+const uint32_t* SDKMeshFileView::GetMeshFrameInfluences(const SDKMESH_MESH& Mesh) const noexcept
+{
+    return reinterpret_cast<const uint32_t*>(m_File.GetData() + Mesh.FrameInfluenceOffset);
+}
+
+const void* SDKMeshFileView::GetVertexData(size_t dwVBIndex) const noexcept
+{
+    return m_File.GetData() + GetVertexBufferHeaders()[dwVBIndex].DataOffset;
+}
+
+const void* SDKMeshFileView::GetIndexData(size_t dwIBIndex) const noexcept
+{
+    return m_File.GetData() + GetIndexBufferHeaders()[dwIBIndex].DataOffset;
+}
+
+const SDKMESH_CHUNK_HEADER* SDKMeshFileView::FindChunk(uint32_t uType) const noexcept
+{
+    auto pHeader = GetHeader();
+    if (!pHeader || pHeader->Version != SDKMESH_FILE_VERSION_V2)
+        return nullptr;
+
+    UINT64 Offset = pHeader->HeaderSize + pHeader->NonBufferDataSize + pHeader->BufferDataSize;
+    while (m_File.ContainsRange(Offset, sizeof(SDKMESH_CHUNK_HEADER)))
+    {
+        auto pChunk = reinterpret_cast<const SDKMESH_CHUNK_HEADER*>(m_File.GetData() + Offset);
+        const UINT64 DataOffset = Offset + sizeof(SDKMESH_CHUNK_HEADER);
+        if (!m_File.ContainsRange(DataOffset, pChunk->SizeBytes))
+            return nullptr;
+        if (pChunk->Type == uType)
+            return pChunk;
+        Offset = DataOffset + RoundUp8B(pChunk->SizeBytes);
+    }
+    return nullptr;
+}
+
+namespace
+{
+    void ValidateMeshletChunk(const SDKMeshMappedFile& File, const SDKMESH_HEADER& Header, const SDKMESH_MESH* pMeshes,
+        const SDKMESH_VERTEX_BUFFER_HEADER* pVBs, const std::vector<bool>& VBValid, UINT64 DataOffset, UINT64 DataSize, ProblemReporter& Report)
+    {
+        if (DataSize < sizeof(SDKMESH_MESHLET_CHUNK))
+        {
+            Report("meshlet chunk is %llu bytes, which is too small for its header.", DataSize);
+            return;
+        }
+
+        const uint8_t* pFileData = File.GetData();
+        const auto& MeshletChunk = *reinterpret_cast<const SDKMESH_MESHLET_CHUNK*>(pFileData + DataOffset);
+        const UINT64 RecordOffset = DataOffset + sizeof(SDKMESH_MESHLET_CHUNK);
+        const UINT64 DataEnd = DataOffset + DataSize;
+        if (UINT64(MeshletChunk.NumMeshes) * sizeof(SDKMESH_MESHLET_MESH) > DataEnd - RecordOffset)
+        {
+            Report("meshlet chunk lists %u meshes, more than fit in the chunk.", MeshletChunk.NumMeshes);
+            return;
+        }
+
+        // Arrays must lie inside the chunk, after the mesh records.
+        const UINT64 ArrayStart = RecordOffset + UINT64(MeshletChunk.NumMeshes) * sizeof(SDKMESH_MESHLET_MESH);
+        auto InChunk = [&](UINT64 Offset, UINT64 Count, UINT64 ElementSize, UINT64 Alignment)
+        {
+            return Offset >= ArrayStart && Offset <= DataEnd && Count <= (DataEnd - Offset) / ElementSize && (Offset % Alignment) == 0;
+        };
+
+        const auto pRecords = reinterpret_cast<const SDKMESH_MESHLET_MESH*>(pFileData + RecordOffset);
+        for (uint32_t i = 0; i < MeshletChunk.NumMeshes; ++i)
+        {
+            const auto& Record = pRecords[i];
+            if (Record.Mesh >= Header.NumMeshes)
+            {
+                Report("meshlet record %u references mesh %u of %u.", i, Record.Mesh, Header.NumMeshes);
+                continue;
+            }
+            const auto& Mesh = pMeshes[Record.Mesh];
+            if (Record.NumSubsets != Mesh.NumSubsets)
+            {
+                Report("meshlet record %u has %u subsets, but mesh %u has %u.", i, Record.NumSubsets, Record.Mesh, Mesh.NumSubsets);
+                continue;
+            }
+            if (Record.IndexType != IT_16BIT && Record.IndexType != IT_32BIT)
+            {
+                Report("meshlet record %u has unknown index type %u.", i, Record.IndexType);
+                continue;
+            }
+            const UINT64 IndexSize = (Record.IndexType == IT_16BIT) ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (!InChunk(Record.SubsetOffset, Record.NumSubsets, sizeof(SDKMESH_MESHLET_SUBSET), sizeof(uint32_t))
+                || !InChunk(Record.MeshletOffset, Record.NumMeshlets, sizeof(SDKMESH_MESHLET), sizeof(uint32_t))
+                || !InChunk(Record.CullDataOffset, Record.NumMeshlets, sizeof(SDKMESH_MESHLET_CULL_DATA), sizeof(uint32_t))
+                || !InChunk(Record.UniqueVertexIndexOffset, Record.NumUniqueVertexIndices, IndexSize, IndexSize)
+                || !InChunk(Record.PrimitiveOffset, Record.NumPrimitives, sizeof(uint32_t), sizeof(uint32_t)))
+            {
+                Report("meshlet record %u has an array that is misaligned or outside the chunk.", i);
+                continue;
+            }
+
+            const auto pSubsets = reinterpret_cast<const SDKMESH_MESHLET_SUBSET*>(pFileData + Record.SubsetOffset);
+            for (uint32_t j = 0; j < Record.NumSubsets; ++j)
+            {
+                if (UINT64(pSubsets[j].MeshletStart) + pSubsets[j].MeshletCount > Record.NumMeshlets)
+                {
+                    Report("meshlet record %u subset %u range [%u, +%u) exceeds its %u meshlets.", i, j, pSubsets[j].MeshletStart, pSubsets[j].MeshletCount, Record.NumMeshlets);
+                    break;
+                }
+            }
+
+            const auto pMeshlets = reinterpret_cast<const SDKMESH_MESHLET*>(pFileData + Record.MeshletOffset);
+            const auto pPrimitives = reinterpret_cast<const uint32_t*>(pFileData + Record.PrimitiveOffset);
+            for (uint32_t j = 0; j < Record.NumMeshlets; ++j)
+            {
+                const auto& Meshlet = pMeshlets[j];
+                if (Meshlet.VertCount > MeshletChunk.MaxVertices || Meshlet.PrimCount > MeshletChunk.MaxPrimitives)
+                {
+                    Report("meshlet record %u meshlet %u has %u verts and %u prims, over the chunk limits of %u and %u.", i, j,
+                        Meshlet.VertCount, Meshlet.PrimCount, MeshletChunk.MaxVertices, MeshletChunk.MaxPrimitives);
+                    break;
+                }
+                if (UINT64(Meshlet.VertOffset) + Meshlet.VertCount > Record.NumUniqueVertexIndices
+                    || UINT64(Meshlet.PrimOffset) + Meshlet.PrimCount > Record.NumPrimitives)
+                {
+                    Report("meshlet record %u meshlet %u references vertices or primitives past the end of its arrays.", i, j);
+                    break;
+                }
+
+                bool bLocalIndicesValid = true;
+                for (uint32_t k = 0; k < Meshlet.PrimCount && bLocalIndicesValid; ++k)
+                {
+                    const uint32_t Primitive = pPrimitives[Meshlet.PrimOffset + k];
+                    bLocalIndicesValid = (Primitive & 0x3FF) < Meshlet.VertCount
+                        && ((Primitive >> 10) & 0x3FF) < Meshlet.VertCount
+                        && ((Primitive >> 20) & 0x3FF) < Meshlet.VertCount;
+                }
+                if (!bLocalIndicesValid)
+                {
+                    Report("meshlet record %u meshlet %u has a primitive index past its %u vertices.", i, j, Meshlet.VertCount);
+                    break;
+                }
+            }
+
+            const uint32_t uVB = Mesh.VertexBuffers[0];
+            if (Mesh.NumVertexBuffers > 0 && uVB < Header.NumVertexBuffers && VBValid[uVB])
+            {
+                const void* pIndexData = pFileData + Record.UniqueVertexIndexOffset;
+                const bool bInRange = (Record.IndexType == IT_16BIT)
+                    ? IndicesInRange(static_cast<const uint16_t*>(pIndexData), Record.NumUniqueVertexIndices, pVBs[uVB].NumVertices, false)
+                    : IndicesInRange(static_cast<const uint32_t*>(pIndexData), Record.NumUniqueVertexIndices, pVBs[uVB].NumVertices, false);
+                if (!bInRange)
+                {
+                    Report("meshlet record %u has unique vertex indices past the %llu vertices of mesh %u.", i, pVBs[uVB].NumVertices, Record.Mesh);
+                }
+            }
+        }
+    }
+}
+
+size_t SDKMeshFileView::Validate() const
+{
+    ProblemReporter Report(m_File.GetFileName());
+
+    auto pHeader = GetHeader();
+    if (!pHeader)
+    {
+        Report("file is smaller than the SDKMESH header (%llu bytes).", m_File.GetSize());
+        return Report.GetCount();
+    }
+    const auto& Header = *pHeader;
+
+    if (Header.Version != SDKMESH_FILE_VERSION && Header.Version != SDKMESH_FILE_VERSION_V2)
+    {
+        Report("unknown file version %u.", Header.Version);
+    }
+
+    const UINT64 ExpectedHeaderSize = sizeof(SDKMESH_HEADER)
+        + UINT64(Header.NumVertexBuffers) * sizeof(SDKMESH_VERTEX_BUFFER_HEADER)
+        + UINT64(Header.NumIndexBuffers) * sizeof(SDKMESH_INDEX_BUFFER_HEADER);
+    if (Header.HeaderSize != ExpectedHeaderSize)
+    {
+        Report("header size is %llu, expected %llu.", Header.HeaderSize, ExpectedHeaderSize);
+    }
+
+    // Version 2 files may have chunks after the buffer data.
+    const UINT64 ExpectedFileSize = Header.HeaderSize + Header.NonBufferDataSize + Header.BufferDataSize;
+    const bool bHasChunks = (Header.Version == SDKMESH_FILE_VERSION_V2) && (ExpectedFileSize < m_File.GetSize());
+    if (ExpectedFileSize != m_File.GetSize() && !bHasChunks)
+    {
+        Report("header describes %llu bytes, but the file is %llu bytes.", ExpectedFileSize, m_File.GetSize());
+    }
+
+    // Every table must be in the file and aligned for its 8-byte members before any
+    // of its entries can be inspected.
+    bool bTablesValid = true;
+    auto CheckTable = [&](const CHAR* strTable, UINT64 Offset, UINT64 Count, UINT64 ElementSize)
+    {
+        if (!m_File.ContainsRange(Offset, Count * ElementSize))
+        {
+            Report("%s table (offset %llu, %llu entries) extends past the end of the file.", strTable, Offset, Count);
+            bTablesValid = false;
+        }
+        else if ((Offset % SDKMESH_TABLE_ALIGNMENT) != 0)
+        {
+            Report("%s table offset %llu is not %llu-byte aligned.", strTable, Offset, SDKMESH_TABLE_ALIGNMENT);
+        }
+    };
+    CheckTable("vertex buffer header", Header.VertexStreamHeadersOffset, Header.NumVertexBuffers, sizeof(SDKMESH_VERTEX_BUFFER_HEADER));
+    CheckTable("index buffer header", Header.IndexStreamHeadersOffset, Header.NumIndexBuffers, sizeof(SDKMESH_INDEX_BUFFER_HEADER));
+    CheckTable("mesh", Header.MeshDataOffset, Header.NumMeshes, sizeof(SDKMESH_MESH));
+    CheckTable("subset", Header.SubsetDataOffset, Header.NumTotalSubsets, sizeof(SDKMESH_SUBSET));
+    CheckTable("frame", Header.FrameDataOffset, Header.NumFrames, sizeof(SDKMESH_FRAME));
+    CheckTable("material", Header.MaterialDataOffset, Header.NumMaterials, sizeof(SDKMESH_MATERIAL));
+    if (!bTablesValid)
+        return Report.GetCount();
+
+    const UINT64 BufferDataStart = Header.HeaderSize + Header.NonBufferDataSize;
+
+    const auto pVBs = GetVertexBufferHeaders();
+    std::vector<bool> VBValid(Header.NumVertexBuffers, false);
+    for (uint32_t i = 0; i < Header.NumVertexBuffers; ++i)
+    {
+        const auto& VB = pVBs[i];
+        if (VB.StrideBytes == 0 || VB.NumVertices * VB.StrideBytes != VB.SizeBytes)
+        {
+            Report("vertex buffer %u has %llu vertices of stride %llu, but a size of %llu bytes.", i, VB.NumVertices, VB.StrideBytes, VB.SizeBytes);
+            continue;
+        }
+        if (VB.DataOffset < BufferDataStart || !m_File.ContainsRange(VB.DataOffset, VB.SizeBytes))
+        {
+            Report("vertex buffer %u data (offset %llu, %llu bytes) is outside the buffer data region.", i, VB.DataOffset, VB.SizeBytes);
+            continue;
+        }
+        if (((VB.DataOffset - BufferDataStart) % SDKMESH_BUFFER_ALIGNMENT) != 0)
+        {
+            Report("vertex buffer %u data is not %llu-byte aligned within the buffer data region.", i, SDKMESH_BUFFER_ALIGNMENT);
+        }
+        VBValid[i] = true;
+    }
+
+    const auto pIBs = GetIndexBufferHeaders();
+    std::vector<bool> IBValid(Header.NumIndexBuffers, false);
+    for (uint32_t i = 0; i < Header.NumIndexBuffers; ++i)
+    {
+        const auto& IB = pIBs[i];
+        if (IB.IndexType != IT_16BIT && IB.IndexType != IT_32BIT)
+        {
+            Report("index buffer %u has unknown index type %u.", i, IB.IndexType);
+            continue;
+        }
+        const UINT64 IndexSize = (IB.IndexType == IT_16BIT) ? sizeof(uint16_t) : sizeof(uint32_t);
+        if (IB.NumIndices * IndexSize != IB.SizeBytes)
+        {
+            Report("index buffer %u has %llu indices, but a size of %llu bytes.", i, IB.NumIndices, IB.SizeBytes);
+            continue;
+        }
+        if (IB.DataOffset < BufferDataStart || !m_File.ContainsRange(IB.DataOffset, IB.SizeBytes))
+        {
+            Report("index buffer %u data (offset %llu, %llu bytes) is outside the buffer data region.", i, IB.DataOffset, IB.SizeBytes);
+            continue;
+        }
+        if (((IB.DataOffset - BufferDataStart) % SDKMESH_BUFFER_ALIGNMENT) != 0)
+        {
+            Report("index buffer %u data is not %llu-byte aligned within the buffer data region.", i, SDKMESH_BUFFER_ALIGNMENT);
+        }
+        IBValid[i] = true;
+    }
+
+    const auto pSubsets = GetSubsets();
+    for (uint32_t i = 0; i < Header.NumTotalSubsets; ++i)
+    {
+        const auto& Subset = pSubsets[i];
+        if (!IsTerminated(Subset.Name))
+        {
+            Report("subset %u name is not terminated.", i);
+        }
+        if (Subset.PrimitiveType > PT_TRIANGLE_PATCH_LIST)
+        {
+            Report("subset %u has unknown primitive type %u.", i, Subset.PrimitiveType);
+        }
+        if (Subset.MaterialID >= Header.NumMaterials)
+        {
+            Report("subset %u references material %u of %u.", i, Subset.MaterialID, Header.NumMaterials);
+        }
+    }
+
+    const auto pMeshes = GetMeshes();
+    for (uint32_t i = 0; i < Header.NumMeshes; ++i)
+    {
+        const auto& Mesh = pMeshes[i];
+        if (!IsTerminated(Mesh.Name))
+        {
+            Report("mesh %u name is not terminated.", i);
+        }
+
+        if (Mesh.NumVertexBuffers == 0 || Mesh.NumVertexBuffers > MAX_VERTEX_STREAMS)
+        {
+            Report("mesh %u has %u vertex streams.", i, Mesh.NumVertexBuffers);
+            continue;
+        }
+        bool bBuffersValid = true;
+        for (uint32_t j = 0; j < Mesh.NumVertexBuffers; ++j)
+        {
+            if (Mesh.VertexBuffers[j] >= Header.NumVertexBuffers)
+            {
+                Report("mesh %u stream %u references vertex buffer %u of %u.", i, j, Mesh.VertexBuffers[j], Header.NumVertexBuffers);
+                bBuffersValid = false;
+            }
+            else if (!VBValid[Mesh.VertexBuffers[j]])
+            {
+                bBuffersValid = false;
+            }
+        }
+        if (Mesh.IndexBuffer >= Header.NumIndexBuffers)
+        {
+            Report("mesh %u references index buffer %u of %u.", i, Mesh.IndexBuffer, Header.NumIndexBuffers);
+            bBuffersValid = false;
+        }
+        else if (!IBValid[Mesh.IndexBuffer])
+        {
+            bBuffersValid = false;
+        }
+
+        // The per-mesh lists live in the non-buffer data following the tables.
+        const UINT64 SubsetListSize = UINT64(Mesh.NumSubsets) * sizeof(uint32_t);
+        const UINT64 InfluenceListSize = UINT64(Mesh.NumFrameInfluences) * sizeof(uint32_t);
+        const bool bSubsetListValid = (Mesh.SubsetOffset >= Header.HeaderSize) && m_File.ContainsRange(Mesh.SubsetOffset, SubsetListSize)
+            && (Mesh.SubsetOffset + SubsetListSize <= BufferDataStart) && ((Mesh.SubsetOffset % sizeof(uint32_t)) == 0);
+        const bool bInfluenceListValid = (Mesh.FrameInfluenceOffset >= Header.HeaderSize) && m_File.ContainsRange(Mesh.FrameInfluenceOffset, InfluenceListSize)
+            && (Mesh.FrameInfluenceOffset + InfluenceListSize <= BufferDataStart) && ((Mesh.FrameInfluenceOffset % sizeof(uint32_t)) == 0);
+        if (!bSubsetListValid)
+        {
+            Report("mesh %u subset list (offset %llu, %u entries) is misplaced.", i, Mesh.SubsetOffset, Mesh.NumSubsets);
+        }
+        if (!bInfluenceListValid)
+        {
+            Report("mesh %u frame influence list (offset %llu, %u entries) is misplaced.", i, Mesh.FrameInfluenceOffset, Mesh.NumFrameInfluences);
+        }
+        else
+        {
+            const uint32_t* pInfluences = GetMeshFrameInfluences(Mesh);
+            for (uint32_t j = 0; j < Mesh.NumFrameInfluences; ++j)
+            {
+                if (pInfluences[j] >= Header.NumFrames)
+                {
+                    Report("mesh %u frame influence %u references frame %u of %u.", i, j, pInfluences[j], Header.NumFrames);
+                    break;
+                }
+            }
+        }
+        if (!bSubsetListValid)
+            continue;
+
+        const uint32_t* pSubsetIndices = GetMeshSubsetIndices(Mesh);
+        for (uint32_t j = 0; j < Mesh.NumSubsets; ++j)
+        {
+            const uint32_t uSubset = pSubsetIndices[j];
+            if (uSubset >= Header.NumTotalSubsets)
+            {
+                Report("mesh %u subset %u references subset %u of %u.", i, j, uSubset, Header.NumTotalSubsets);
+                continue;
+            }
+            if (!bBuffersValid)
+                continue;
+
+            const auto& VB = pVBs[Mesh.VertexBuffers[0]];
+            const auto& IB = pIBs[Mesh.IndexBuffer];
+            const auto& Subset = pSubsets[uSubset];
+            if (Subset.IndexStart > IB.NumIndices || Subset.IndexCount > IB.NumIndices - Subset.IndexStart)
+            {
+                Report("subset %u index range [%llu, +%llu) exceeds the %llu indices of mesh %u.", uSubset, Subset.IndexStart, Subset.IndexCount, IB.NumIndices, i);
+                continue;
+            }
+            if (Subset.VertexStart > VB.NumVertices || Subset.VertexCount > VB.NumVertices - Subset.VertexStart)
+            {
+                Report("subset %u vertex range [%llu, +%llu) exceeds the %llu vertices of mesh %u.", uSubset, Subset.VertexStart, Subset.VertexCount, VB.NumVertices, i);
+            }
+
+            // Reading every index also pages the index data in, which is part of what
+            // the load timing is meant to capture.
+            const bool bAllowRestart = IsStripType(Subset.PrimitiveType);
+            const void* pIndexData = m_File.GetData() + IB.DataOffset;
+            const bool bInRange = (IB.IndexType == IT_16BIT)
+                ? IndicesInRange(static_cast<const uint16_t*>(pIndexData) + Subset.IndexStart, Subset.IndexCount, VB.NumVertices, bAllowRestart)
+                : IndicesInRange(static_cast<const uint32_t*>(pIndexData) + Subset.IndexStart, Subset.IndexCount, VB.NumVertices, bAllowRestart);
+            if (!bInRange)
+            {
+                Report("subset %u of mesh %u has indices past the %llu vertices of its vertex buffer.", uSubset, i, VB.NumVertices);
+            }
+        }
+    }
+
+    const auto pFrames = GetFrames();
+    for (uint32_t i = 0; i < Header.NumFrames; ++i)
+    {
+        const auto& Frame = pFrames[i];
+        if (!IsTerminated(Frame.Name))
+        {
+            Report("frame %u name is not terminated.", i);
+        }
+        if (!IsValidReference(Frame.Mesh, Header.NumMeshes))
+        {
+            Report("frame %u references mesh %u of %u.", i, Frame.Mesh, Header.NumMeshes);
+        }
+        if (!IsValidReference(Frame.ParentFrame, Header.NumFrames)
+            || !IsValidReference(Frame.ChildFrame, Header.NumFrames)
+            || !IsValidReference(Frame.SiblingFrame, Header.NumFrames))
+        {
+            Report("frame %u has an out of range parent, child, or sibling link.", i);
+        }
+    }
+
+    const auto pMaterials = GetMaterials();
+    for (uint32_t i = 0; i < Header.NumMaterials; ++i)
+    {
+        if (!IsTerminated(pMaterials[i].Name))
+        {
+            Report("material %u name is not terminated.", i);
+        }
+    }
+
+    UINT64 ChunkOffset = bHasChunks ? ExpectedFileSize : m_File.GetSize();
+    while (ChunkOffset < m_File.GetSize())
+    {
+        if (!m_File.ContainsRange(ChunkOffset, sizeof(SDKMESH_CHUNK_HEADER)))
+        {
+            Report("chunk header at offset %llu extends past the end of the file.", ChunkOffset);
+            break;
+        }
+        const auto& Chunk = *reinterpret_cast<const SDKMESH_CHUNK_HEADER*>(m_File.GetData() + ChunkOffset);
+        const UINT64 DataOffset = ChunkOffset + sizeof(SDKMESH_CHUNK_HEADER);
+        if (!m_File.ContainsRange(DataOffset, Chunk.SizeBytes) || !m_File.ContainsRange(DataOffset, RoundUp8B(Chunk.SizeBytes)))
+        {
+            Report("chunk %08X at offset %llu (%llu bytes, padded to 8) extends past the end of the file.", Chunk.Type, ChunkOffset, Chunk.SizeBytes);
+            break;
+        }
+        if (Chunk.Type == SDKMESH_CHUNK_MESHLETS)
+        {
+            ValidateMeshletChunk(m_File, Header, pMeshes, pVBs, VBValid, DataOffset, Chunk.SizeBytes, Report);
+        }
+        ChunkOffset = DataOffset + RoundUp8B(Chunk.SizeBytes);
+    }
+
+    return Report.GetCount();
+}
+
+//-------------------------------------------------------------------------------------
+// SDKAnimationFileView
+//-------------------------------------------------------------------------------------
+
+bool SDKAnimationFileView::Open(const CHAR* strFileName)
+{
+    if (!m_File.Open(strFileName))
+    {
+        ExportLog::LogError("Could not open SDKMESH animation file \"%s\".", strFileName);
+        return false;
+    }
+    return true;
+}
+
+const SDKANIMATION_FILE_HEADER* SDKAnimationFileView::GetHeader() const noexcept
+{
+    if (m_File.GetSize() < sizeof(SDKANIMATION_FILE_HEADER))
+        return nullptr;
+    return reinterpret_cast<const SDKANIMATION_FILE_HEADER*>(m_File.GetData());
+}
+
+const SDKANIMATION_FRAME_DATA* SDKAnimationFileView::GetFrameData() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader ? reinterpret_cast<const SDKANIMATION_FRAME_DATA*>(m_File.GetData() + pHeader->AnimationDataOffset) : nullptr;
+}
+
+const SDKANIMATION_DATA* SDKAnimationFileView::GetFrameKeys(size_t dwFrameIndex) const noexcept
+{
+    auto pHeader = GetHeader();
+    if (!pHeader || pHeader->Version != SDKMESH_FILE_VERSION)
+        return nullptr;
+    // Frame data offsets are relative to the start of the animation data.
+    return reinterpret_cast<const SDKANIMATION_DATA*>(m_File.GetData() + pHeader->AnimationDataOffset + GetFrameData()[dwFrameIndex].DataOffset);
+}
+
+bool SDKAnimationFileView::IsQuantized() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader && pHeader->Version == SDKANIMATION_FILE_VERSION_QUANTIZED;
+}
+
+const SDKANIMATION_QUANTIZED_TRACK* SDKAnimationFileView::GetQuantizedTrack(size_t dwFrameIndex) const noexcept
+{
+    if (!IsQuantized())
+        return nullptr;
+    auto pHeader = GetHeader();
+    return reinterpret_cast<const SDKANIMATION_QUANTIZED_TRACK*>(m_File.GetData() + pHeader->AnimationDataOffset + GetFrameData()[dwFrameIndex].DataOffset);
+}
+
+bool SDKAnimationFileView::IsSparse() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader && pHeader->Version == SDKANIMATION_FILE_VERSION_SPARSE;
+}
+
+const SDKANIMATION_SPARSE_TRACK* SDKAnimationFileView::GetSparseTrack(size_t dwFrameIndex) const noexcept
+{
+    if (!IsSparse())
+        return nullptr;
+    auto pHeader = GetHeader();
+    return reinterpret_cast<const SDKANIMATION_SPARSE_TRACK*>(m_File.GetData() + pHeader->AnimationDataOffset + GetFrameData()[dwFrameIndex].DataOffset);
+}
+
+bool SDKAnimationFileView::IsMultiClip() const noexcept
+{
+    auto pHeader = GetHeader();
+    return pHeader && pHeader->Version == SDKANIMATION_FILE_VERSION_MULTICLIP;
+}
+
+size_t SDKAnimationFileView::GetClipCount() const noexcept
+{
+    if (!IsMultiClip())
+        return 0;
+    auto pHeader = GetHeader();
+    auto pClipTable = reinterpret_cast<const SDKANIMATION_CLIP_TABLE*>(GetFrameData() + pHeader->NumFrames);
+    return pClipTable->NumClips;
+}
+
+const SDKANIMATION_CLIP* SDKAnimationFileView::GetClip(size_t dwClipIndex) const noexcept
+{
+    if (dwClipIndex >= GetClipCount())
+        return nullptr;
+    auto pHeader = GetHeader();
+    auto pClipTable = reinterpret_cast<const SDKANIMATION_CLIP_TABLE*>(GetFrameData() + pHeader->NumFrames);
+    return reinterpret_cast<const SDKANIMATION_CLIP*>(pClipTable + 1) + dwClipIndex;
+}
+
+const SDKANIMATION_SPARSE_TRACK* SDKAnimationFileView::GetClipTrack(size_t dwClipIndex, size_t dwFrameIndex) const noexcept
+{
+    auto pClip = GetClip(dwClipIndex);
+    auto pHeader = GetHeader();
+    if (!pClip || dwFrameIndex >= pHeader->NumFrames)
+        return nullptr;
+
+    const uint8_t* pAnimationData = m_File.GetData() + pHeader->AnimationDataOffset;
+    const UINT64 TrackOffset = reinterpret_cast<const uint64_t*>(pAnimationData + pClip->TrackOffsetsOffset)[dwFrameIndex];
+    return TrackOffset ? reinterpret_cast<const SDKANIMATION_SPARSE_TRACK*>(pAnimationData + TrackOffset) : nullptr;
+}
+
+namespace
+{
+    struct SparseTrackKeys
+    {
+        const SDKANIMATION_TRANSLATION_KEY* pTranslationKeys;
+        const SDKANIMATION_ORIENTATION_KEY* pOrientationKeys;
+        const SDKANIMATION_SCALING_KEY*     pScalingKeys;
+    };
+
+    // The key lists follow the track header back to back.
+    SparseTrackKeys GetSparseTrackKeys(const SDKANIMATION_SPARSE_TRACK& Track) noexcept
+    {
+        SparseTrackKeys Keys;
+        Keys.pTranslationKeys = reinterpret_cast<const SDKANIMATION_TRANSLATION_KEY*>(&Track + 1);
+        Keys.pOrientationKeys = reinterpret_cast<const SDKANIMATION_ORIENTATION_KEY*>(Keys.pTranslationKeys + Track.TranslationKeyCount);
+        Keys.pScalingKeys = reinterpret_cast<const SDKANIMATION_SCALING_KEY*>(Keys.pOrientationKeys + Track.OrientationKeyCount);
+        return Keys;
+    }
+
+    inline XMVECTOR BlendOrientation(FXMVECTOR qA, FXMVECTOR qB, float fLerp)
+    {
+        // Short path, then renormalize.
+        const XMVECTOR qEnd = (XMVectorGetX(XMQuaternionDot(qA, qB)) < 0.0f) ? XMVectorNegate(qB) : qB;
+        return XMQuaternionNormalize(XMVectorLerp(qA, qEnd, fLerp));
+    }
+
+    template <typename KeyType, typename LoadFunc, typename BlendFunc>
+    XMVECTOR SampleSparseChannel(const KeyType* pKeys, size_t dwKeyCount, float fTime, LoadFunc Load, BlendFunc Blend, FXMVECTOR vDefault)
+    {
+        if (dwKeyCount == 0)
+            return vDefault;
+
+        // First key after fTime; values are held outside the channel's keys.
+        const KeyType* pEnd = pKeys + dwKeyCount;
+        const KeyType* pNext = std::upper_bound(pKeys, pEnd, fTime,
+            [](float fValue, const KeyType& Key) { return fValue < Key.Time; });
+        if (pNext == pKeys)
+            return Load(*pKeys);
+        if (pNext == pEnd)
+            return Load(*(pEnd - 1));
+
+        const KeyType& A = *(pNext - 1);
+        const KeyType& B = *pNext;
+        return Blend(Load(A), Load(B), (fTime - A.Time) / (B.Time - A.Time));
+    }
+
+    void SampleSparseTrack(const SDKANIMATION_SPARSE_TRACK& Track, float fTime, SDKANIMATION_DATA& Key)
+    {
+        auto Lerp = [](FXMVECTOR vA, FXMVECTOR vB, float fLerp) { return XMVectorLerp(vA, vB, fLerp); };
+        const SparseTrackKeys Keys = GetSparseTrackKeys(Track);
+
+        XMStoreFloat3(&Key.Translation, SampleSparseChannel(Keys.pTranslationKeys, Track.TranslationKeyCount, fTime,
+            [](const SDKANIMATION_TRANSLATION_KEY& K) { return XMLoadFloat3(&K.Translation); }, Lerp, XMVectorZero()));
+        XMStoreFloat4(&Key.Orientation, SampleSparseChannel(Keys.pOrientationKeys, Track.OrientationKeyCount, fTime,
+            [](const SDKANIMATION_ORIENTATION_KEY& K) { return XMLoadFloat4(&K.Orientation); }, BlendOrientation, XMQuaternionIdentity()));
+        XMStoreFloat3(&Key.Scaling, SampleSparseChannel(Keys.pScalingKeys, Track.ScalingKeyCount, fTime,
+            [](const SDKANIMATION_SCALING_KEY& K) { return XMLoadFloat3(&K.Scaling); }, Lerp, XMVectorSplatOne()));
+    }
+}
+
+bool SDKAnimationFileView::GetKey(size_t dwFrameIndex, size_t dwKeyIndex, SDKANIMATION_DATA& Key) const
+{
+    auto pHeader = GetHeader();
+    if (!pHeader || dwFrameIndex >= pHeader->NumFrames || dwKeyIndex >= pHeader->NumAnimationKeys)
+        return false;
+
+    if (IsSparse() || IsMultiClip())
+    {
+        const float fTime = pHeader->AnimationFPS ? static_cast<float>(dwKeyIndex) / static_cast<float>(pHeader->AnimationFPS) : 0.0f;
+        return SampleKey(dwFrameIndex, fTime, Key);
+    }
+
+    if (!IsQuantized())
+    {
+        Key = GetFrameKeys(dwFrameIndex)[dwKeyIndex];
+        return true;
+    }
+
+    const auto pTrack = GetQuantizedTrack(dwFrameIndex);
+    ExportQuantizedTrackHeader Header = {};
+    Header.Flags = pTrack->Flags;
+    Header.TranslationMin = pTrack->TranslationMin;
+    Header.TranslationExtent = pTrack->TranslationExtent;
+    Header.Orientation = pTrack->Orientation;
+    Header.ScaleMin = pTrack->ScalingMin;
+    Header.ScaleExtent = pTrack->ScalingExtent;
+
+    auto pSamples = reinterpret_cast<const uint16_t*>(pTrack + 1);
+    DecodeQuantizedKey(Header, pSamples, pHeader->NumAnimationKeys, dwKeyIndex, Key.Translation, Key.Orientation, Key.Scaling);
+    return true;
+}
+
+bool SDKAnimationFileView::SampleKey(size_t dwFrameIndex, float fTime, SDKANIMATION_DATA& Key) const
+{
+    auto pHeader = GetHeader();
+    if (!pHeader || dwFrameIndex >= pHeader->NumFrames)
+        return false;
+
+    if (IsMultiClip())
+        return SampleClipKey(0, dwFrameIndex, fTime, Key);
+
+    if (IsSparse())
+    {
+        SampleSparseTrack(*GetSparseTrack(dwFrameIndex), fTime, Key);
+        return true;
+    }
+
+    if (pHeader->NumAnimationKeys == 0)
+        return false;
+
+    // Fixed-rate formats blend the two keys either side of fTime.
+    const float fLastKey = static_cast<float>(pHeader->NumAnimationKeys - 1);
+    const float fKey = std::min(std::max(fTime * static_cast<float>(pHeader->AnimationFPS), 0.0f), fLastKey);
+    const size_t dwKey = static_cast<size_t>(fKey);
+    const size_t dwNextKey = std::min<size_t>(dwKey + 1, pHeader->NumAnimationKeys - 1);
+
+    SDKANIMATION_DATA A, B;
+    if (!GetKey(dwFrameIndex, dwKey, A) || !GetKey(dwFrameIndex, dwNextKey, B))
+        return false;
+
+    const float fLerp = fKey - static_cast<float>(dwKey);
+    auto Lerp = [](FXMVECTOR vA, FXMVECTOR vB, float fT) { return XMVectorLerp(vA, vB, fT); };
+    XMStoreFloat3(&Key.Translation, Lerp(XMLoadFloat3(&A.Translation), XMLoadFloat3(&B.Translation), fLerp));
+    XMStoreFloat4(&Key.Orientation, BlendOrientation(XMLoadFloat4(&A.Orientation), XMLoadFloat4(&B.Orientation), fLerp));
+    XMStoreFloat3(&Key.Scaling, Lerp(XMLoadFloat3(&A.Scaling), XMLoadFloat3(&B.Scaling), fLerp));
+    return true;
+}
+
+bool SDKAnimationFileView::SampleClipKey(size_t dwClipIndex, size_t dwFrameIndex, float fTime, SDKANIMATION_DATA& Key) const
+{
+    auto pTrack = GetClipTrack(dwClipIndex, dwFrameIndex);
+    if (!pTrack)
+        return false;
+    SampleSparseTrack(*pTrack, fTime, Key);
+    return true;
+}
+
+namespace
+{
+    void ValidateQuantizedTrack(const SDKAnimationFileView& View, ProblemReporter& Report, uint32_t uFrameIndex, UINT64 DataOffset)
+    {
+        const auto& Header = *View.GetHeader();
+        if (DataOffset > Header.AnimationDataSize || sizeof(SDKANIMATION_QUANTIZED_TRACK) > Header.AnimationDataSize - DataOffset)
+        {
+            Report("frame %u quantized track (offset %llu) extends past the animation data.", uFrameIndex, DataOffset);
+            return;
+        }
+        if ((DataOffset % SDKMESH_TABLE_ALIGNMENT) != 0)
+        {
+            Report("frame %u quantized track offset %llu is not %llu-byte aligned.", uFrameIndex, DataOffset, SDKMESH_TABLE_ALIGNMENT);
+        }
+
+        const auto& Track = *View.GetQuantizedTrack(uFrameIndex);
+        if (Track.Flags & ~static_cast<uint32_t>(QTF_ALL))
+        {
+            Report("frame %u quantized track has unknown flags 0x%08X.", uFrameIndex, Track.Flags);
+            return;
+        }
+
+        const UINT64 SamplesSize = UINT64(GetQuantizedSampleCount(Track.Flags, Header.NumAnimationKeys)) * sizeof(uint16_t);
+        if (SamplesSize > Header.AnimationDataSize - DataOffset - sizeof(SDKANIMATION_QUANTIZED_TRACK))
+        {
+            Report("frame %u quantized keys (%llu bytes) extend past the animation data.", uFrameIndex, SamplesSize);
+        }
+
+        if (!(Track.Flags & SQF_ORIENTATION_ANIMATED))
+        {
+            const auto& Q = Track.Orientation;
+            const float fLengthSq = Q.x * Q.x + Q.y * Q.y + Q.z * Q.z + Q.w * Q.w;
+            if (!std::isfinite(fLengthSq) || std::fabs(fLengthSq - 1.0f) > 1e-2f)
+            {
+                Report("frame %u has a non-unit constant orientation (length squared %f).", uFrameIndex, fLengthSq);
+            }
+        }
+    }
+}
+
+namespace
+{
+    template <typename KeyType>
+    bool AreKeyTimesOrdered(const KeyType* pKeys, size_t dwKeyCount)
+    {
+        for (size_t i = 0; i < dwKeyCount; ++i)
+        {
+            if (!std::isfinite(pKeys[i].Time) || (i > 0 && pKeys[i].Time < pKeys[i - 1].Time))
+                return false;
+        }
+        return true;
+    }
+
+    // strTrack names the track in messages, such as "frame 3" or "clip 1 frame 3".
+    void ValidateSparseTrack(const SDKANIMATION_FILE_HEADER& Header, const uint8_t* pAnimationData, ProblemReporter& Report, const CHAR* strTrack, UINT64 DataOffset)
+    {
+        if (DataOffset > Header.AnimationDataSize || sizeof(SDKANIMATION_SPARSE_TRACK) > Header.AnimationDataSize - DataOffset)
+        {
+            Report("%s sparse track (offset %llu) extends past the animation data.", strTrack, DataOffset);
+            return;
+        }
+        if ((DataOffset % SDKMESH_TABLE_ALIGNMENT) != 0)
+        {
+            Report("%s sparse track offset %llu is not %llu-byte aligned.", strTrack, DataOffset, SDKMESH_TABLE_ALIGNMENT);
+        }
+
+        const auto& Track = *reinterpret_cast<const SDKANIMATION_SPARSE_TRACK*>(pAnimationData + DataOffset);
+        const UINT64 KeysSize = UINT64(Track.TranslationKeyCount) * sizeof(SDKANIMATION_TRANSLATION_KEY)
+            + UINT64(Track.OrientationKeyCount) * sizeof(SDKANIMATION_ORIENTATION_KEY)
+            + UINT64(Track.ScalingKeyCount) * sizeof(SDKANIMATION_SCALING_KEY);
+        if (KeysSize > Header.AnimationDataSize - DataOffset - sizeof(SDKANIMATION_SPARSE_TRACK))
+        {
+            Report("%s sparse keys (%u/%u/%u keys) extend past the animation data.", strTrack,
+                Track.TranslationKeyCount, Track.OrientationKeyCount, Track.ScalingKeyCount);
+            return;
+        }
+
+        const SparseTrackKeys Keys = GetSparseTrackKeys(Track);
+        if (!AreKeyTimesOrdered(Keys.pTranslationKeys, Track.TranslationKeyCount)
+            || !AreKeyTimesOrdered(Keys.pOrientationKeys, Track.OrientationKeyCount)
+            || !AreKeyTimesOrdered(Keys.pScalingKeys, Track.ScalingKeyCount))
+        {
+            Report("%s sparse key times are not finite and in order.", strTrack);
+        }
+
+        for (uint32_t j = 0; j < Track.OrientationKeyCount; ++j)
+        {
+            const auto& Q = Keys.pOrientationKeys[j].Orientation;
+            const float fLengthSq = Q.x * Q.x + Q.y * Q.y + Q.z * Q.z + Q.w * Q.w;
+            if (!std::isfinite(fLengthSq) || std::fabs(fLengthSq - 1.0f) > 1e-2f)
+            {
+                Report("%s orientation key %u is not unit length (length squared %f).", strTrack, j, fLengthSq);
+                break;
+            }
+        }
+    }
+
+    void ValidateClips(const SDKANIMATION_FILE_HEADER& Header, const uint8_t* pAnimationData, ProblemReporter& Report)
+    {
+        const UINT64 ClipTableOffset = UINT64(Header.NumFrames) * sizeof(SDKANIMATION_FRAME_DATA);
+        if (sizeof(SDKANIMATION_CLIP_TABLE) > Header.AnimationDataSize - ClipTableOffset)
+        {
+            Report("clip table extends past the animation data.");
+            return;
+        }
+
+        const auto& ClipTable = *reinterpret_cast<const SDKANIMATION_CLIP_TABLE*>(pAnimationData + ClipTableOffset);
+        if (UINT64(ClipTable.NumClips) * sizeof(SDKANIMATION_CLIP) > Header.AnimationDataSize - ClipTableOffset - sizeof(SDKANIMATION_CLIP_TABLE))
+        {
+            Report("%u clip records do not fit in %llu bytes of animation data.", ClipTable.NumClips, Header.AnimationDataSize);
+            return;
+        }
+
+        const UINT64 TrackOffsetsSize = UINT64(Header.NumFrames) * sizeof(uint64_t);
+        const auto pClips = reinterpret_cast<const SDKANIMATION_CLIP*>(&ClipTable + 1);
+        for (uint32_t i = 0; i < ClipTable.NumClips; ++i)
+        {
+            const auto& Clip = pClips[i];
+            if (!IsTerminated(Clip.ClipName))
+            {
+                Report("clip %u name is not terminated.", i);
+            }
+            if (Clip.TrackOffsetsOffset > Header.AnimationDataSize || TrackOffsetsSize > Header.AnimationDataSize - Clip.TrackOffsetsOffset)
+            {
+                Report("clip %u track offsets (offset %llu) extend past the animation data.", i, Clip.TrackOffsetsOffset);
+                continue;
+            }
+            if ((Clip.TrackOffsetsOffset % SDKMESH_TABLE_ALIGNMENT) != 0)
+            {
+                Report("clip %u track offsets offset %llu is not %llu-byte aligned.", i, Clip.TrackOffsetsOffset, SDKMESH_TABLE_ALIGNMENT);
+                continue;
+            }
+
+            const auto pTrackOffsets = reinterpret_cast<const uint64_t*>(pAnimationData + Clip.TrackOffsetsOffset);
+            for (uint32_t j = 0; j < Header.NumFrames; ++j)
+            {
+                if (!pTrackOffsets[j])
+                    continue;
+                CHAR strTrack[64];
+                sprintf_s(strTrack, "clip %u frame %u", i, j);
+                ValidateSparseTrack(Header, pAnimationData, Report, strTrack, pTrackOffsets[j]);
+            }
+        }
+    }
+}
+
+size_t SDKAnimationFileView::Validate() const
+{
+    ProblemReporter Report(m_File.GetFileName());
+
+    auto pHeader = GetHeader();
+    if (!pHeader)
+    {
+        Report("file is smaller than the animation header (%llu bytes).", m_File.GetSize());
+        return Report.GetCount();
+    }
+    const auto& Header = *pHeader;
+
+    const bool bQuantized = (Header.Version == SDKANIMATION_FILE_VERSION_QUANTIZED);
+    const bool bSparse = (Header.Version == SDKANIMATION_FILE_VERSION_SPARSE);
+    const bool bMultiClip = (Header.Version == SDKANIMATION_FILE_VERSION_MULTICLIP);
+    if (Header.Version != SDKMESH_FILE_VERSION && !bQuantized && !bSparse && !bMultiClip)
+    {
+        Report("unknown file version %u.", Header.Version);
+    }
+    if (Header.FrameTransformType != FTT_RELATIVE && Header.FrameTransformType != FTT_ABSOLUTE)
+    {
+        Report("unknown frame transform type %u.", Header.FrameTransformType);
+    }
+    if (Header.AnimationDataOffset < sizeof(SDKANIMATION_FILE_HEADER) || !m_File.ContainsRange(Header.AnimationDataOffset, Header.AnimationDataSize))
+    {
+        Report("animation data (offset %llu, %llu bytes) extends past the end of the file.", Header.AnimationDataOffset, Header.AnimationDataSize);
+        return Report.GetCount();
+    }
+    if ((Header.AnimationDataOffset % SDKMESH_TABLE_ALIGNMENT) != 0)
+    {
+        Report("animation data offset %llu is not %llu-byte aligned.", Header.AnimationDataOffset, SDKMESH_TABLE_ALIGNMENT);
+    }
+    if (UINT64(Header.NumFrames) * sizeof(SDKANIMATION_FRAME_DATA) > Header.AnimationDataSize)
+    {
+        Report("%u frame records do not fit in %llu bytes of animation data.", Header.NumFrames, Header.AnimationDataSize);
+        return Report.GetCount();
+    }
+
+    const UINT64 TrackSize = UINT64(Header.NumAnimationKeys) * sizeof(SDKANIMATION_DATA);
+    const auto pAnimationData = m_File.GetData() + Header.AnimationDataOffset;
+    const auto pFrames = GetFrameData();
+    for (uint32_t i = 0; i < Header.NumFrames; ++i)
+    {
+        const auto& Frame = pFrames[i];
+        if (!IsTerminated(Frame.FrameName))
+        {
+            Report("frame %u name is not terminated.", i);
+        }
+        if (bQuantized)
+        {
+            ValidateQuantizedTrack(*this, Report, i, Frame.DataOffset);
+            continue;
+        }
+        if (bMultiClip)
+            continue;
+        if (bSparse)
+        {
+            CHAR strTrack[32];
+            sprintf_s(strTrack, "frame %u", i);
+            ValidateSparseTrack(Header, pAnimationData, Report, strTrack, Frame.DataOffset);
+            continue;
+        }
+        if (Frame.DataOffset > Header.AnimationDataSize || TrackSize > Header.AnimationDataSize - Frame.DataOffset)
+        {
+            Report("frame %u keys (offset %llu, %u keys) extend past the animation data.", i, Frame.DataOffset, Header.NumAnimationKeys);
+            continue;
+        }
+        if ((Frame.DataOffset % sizeof(float)) != 0)
+        {
+            Report("frame %u key offset %llu is not %zu-byte aligned.", i, Frame.DataOffset, sizeof(float));
+        }
+
+        const SDKANIMATION_DATA* pKeys = GetFrameKeys(i);
+        for (uint32_t j = 0; j < Header.NumAnimationKeys; ++j)
+        {
+            const auto& Q = pKeys[j].Orientation;
+            const float fLengthSq = Q.x * Q.x + Q.y * Q.y + Q.z * Q.z + Q.w * Q.w;
+            if (!std::isfinite(fLengthSq) || std::fabs(fLengthSq - 1.0f) > 1e-2f)
+            {
+                Report("frame %u key %u has a non-unit orientation (length squared %f).", i, j, fLengthSq);
+                break;
+            }
+        }
+    }
+
+    if (bMultiClip)
+    {
+        ValidateClips(Header, pAnimationData, Report);
+    }
+
+    return Report.GetCount();
+}
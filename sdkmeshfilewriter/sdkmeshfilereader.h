@@ -0,0 +1,140 @@
+//-------------------------------------------------------------------------------------
+// SDKMeshFileReader.h
+//
+// Zero-copy, memory-mapped views of SDKMESH and SDKMESH animation files, used to
+// load exported files back and validate their layout.
+//
+// Advanced Technology Group (ATG)
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=226208
+//-------------------------------------------------------------------------------------
+#pragma once
+
+namespace DXUT
+{
+    struct SDKMESH_HEADER;
+    struct SDKMESH_VERTEX_BUFFER_HEADER;
+    struct SDKMESH_INDEX_BUFFER_HEADER;
+    struct SDKMESH_MESH;
+    struct SDKMESH_SUBSET;
+    struct SDKMESH_FRAME;
+    struct SDKMESH_MATERIAL;
+    struct SDKMESH_CHUNK_HEADER;
+    struct SDKANIMATION_FILE_HEADER;
+    struct SDKANIMATION_FRAME_DATA;
+    struct SDKANIMATION_DATA;
+    struct SDKANIMATION_QUANTIZED_TRACK;
+    struct SDKANIMATION_SPARSE_TRACK;
+    struct SDKANIMATION_CLIP;
+}
+
+namespace ATG
+{
+    class SDKMeshMappedFile
+    {
+    public:
+        SDKMeshMappedFile() noexcept;
+        ~SDKMeshMappedFile() { Close(); }
+
+        SDKMeshMappedFile(const SDKMeshMappedFile&) = delete;
+        SDKMeshMappedFile& operator=(const SDKMeshMappedFile&) = delete;
+
+        bool Open(const CHAR* strFileName);
+        void Close() noexcept;
+
+        const uint8_t* GetData() const noexcept { return m_pData; }
+        UINT64 GetSize() const noexcept { return m_Size; }
+        const CHAR* GetFileName() const noexcept { return m_strFileName; }
+
+        // Returns true if [Offset, Offset + Size) lies inside the file.
+        bool ContainsRange(UINT64 Offset, UINT64 Size) const noexcept { return Offset <= m_Size && Size <= m_Size - Offset; }
+
+    protected:
+        HANDLE          m_hFile;
+        HANDLE          m_hMapping;
+        const uint8_t*  m_pData;
+        UINT64          m_Size;
+        CHAR            m_strFileName[MAX_PATH];
+    };
+
+    // Accessors return pointers into the mapped file; nothing is copied.  Call Validate
+    // before trusting any offset or count read from an untrusted file.
+    class SDKMeshFileView
+    {
+    public:
+        bool Open(const CHAR* strFileName);
+        void Close() noexcept { m_File.Close(); }
+
+        const DXUT::SDKMESH_HEADER* GetHeader() const noexcept;
+        const DXUT::SDKMESH_VERTEX_BUFFER_HEADER* GetVertexBufferHeaders() const noexcept;
+        const DXUT::SDKMESH_INDEX_BUFFER_HEADER* GetIndexBufferHeaders() const noexcept;
+        const DXUT::SDKMESH_MESH* GetMeshes() const noexcept;
+        const DXUT::SDKMESH_SUBSET* GetSubsets() const noexcept;
+        const DXUT::SDKMESH_FRAME* GetFrames() const noexcept;
+        const DXUT::SDKMESH_MATERIAL* GetMaterials() const noexcept;
+        const uint32_t* GetMeshSubsetIndices(const DXUT::SDKMESH_MESH& Mesh) const noexcept;
+        const uint32_t* GetMeshFrameInfluences(const DXUT::SDKMESH_MESH& Mesh) const noexcept;
+        const void* GetVertexData(size_t dwVBIndex) const noexcept;
+        const void* GetIndexData(size_t dwIBIndex) const noexcept;
+
+        // Returns the first chunk of uType after the buffer data, or nullptr.  Its data
+        // follows the header.
+        const DXUT::SDKMESH_CHUNK_HEADER* FindChunk(uint32_t uType) const noexcept;
+
+        UINT64 GetFileSize() const noexcept { return m_File.GetSize(); }
+
+        // Checks counts, offsets, sizes, alignment, cross references and index ranges.
+        // Each problem is logged as an error; returns the number of problems found.
+        size_t Validate() const;
+
+    protected:
+        SDKMeshMappedFile   m_File;
+    };
+
+    class SDKAnimationFileView
+    {
+    public:
+        bool Open(const CHAR* strFileName);
+        void Close() noexcept { m_File.Close(); }
+
+        const DXUT::SDKANIMATION_FILE_HEADER* GetHeader() const noexcept;
+        const DXUT::SDKANIMATION_FRAME_DATA* GetFrameData() const noexcept;
+        const DXUT::SDKANIMATION_DATA* GetFrameKeys(size_t dwFrameIndex) const noexcept;
+
+        // Quantized files store an SDKANIMATION_QUANTIZED_TRACK per frame instead of
+        // float keys; GetFrameKeys returns nullptr for them.
+        bool IsQuantized() const noexcept;
+        const DXUT::SDKANIMATION_QUANTIZED_TRACK* GetQuantizedTrack(size_t dwFrameIndex) const noexcept;
+
+        // Sparse files store an SDKANIMATION_SPARSE_TRACK per frame, with its own key
+        // times and counts; GetFrameKeys returns nullptr for them too.
+        bool IsSparse() const noexcept;
+        const DXUT::SDKANIMATION_SPARSE_TRACK* GetSparseTrack(size_t dwFrameIndex) const noexcept;
+
+        // Multi-clip files hold several clips over one frame table.  GetClipTrack returns
+        // nullptr where a clip does not animate the frame, and SampleClipKey then returns
+        // false so the frame keeps its bind pose.
+        bool IsMultiClip() const noexcept;
+        size_t GetClipCount() const noexcept;
+        const DXUT::SDKANIMATION_CLIP* GetClip(size_t dwClipIndex) const noexcept;
+        const DXUT::SDKANIMATION_SPARSE_TRACK* GetClipTrack(size_t dwClipIndex, size_t dwFrameIndex) const noexcept;
+        bool SampleClipKey(size_t dwClipIndex, size_t dwFrameIndex, float fTime, DXUT::SDKANIMATION_DATA& Key) const;
+
+        // Reads one key from any format, decoding quantized tracks.  Sparse tracks are
+        // sampled at dwKeyIndex / AnimationFPS, and multi-clip files read the first clip.
+        bool GetKey(size_t dwFrameIndex, size_t dwKeyIndex, DXUT::SDKANIMATION_DATA& Key) const;
+
+        // Evaluates a frame at fTime seconds from any format, interpolating linearly
+        // between keys and holding the first and last keys outside the clip.
+        bool SampleKey(size_t dwFrameIndex, float fTime, DXUT::SDKANIMATION_DATA& Key) const;
+
+        UINT64 GetFileSize() const noexcept { return m_File.GetSize(); }
+
+        size_t Validate() const;
+
+    protected:
+        SDKMeshMappedFile   m_File;
+    };
+}
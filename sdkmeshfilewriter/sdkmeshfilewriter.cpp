@@ -32,11 +32,150 @@ namespace ATG
     std::vector<uint32_t>                           g_SubsetIndexArray;
     std::vector<uint32_t>                           g_FrameInfluenceArray;
     std::vector<SDKMESH_MATERIAL>                   g_MaterialArray;
+    std::vector<SDKMESH_MESHLET_MESH>               g_MeshletMeshArray;
+    std::vector<const ExportMeshletData*>           g_MeshletDataArray;
+    std::vector<SDKMESH_MESHLET_SUBSET>             g_MeshletSubsetArray;
 
     using MaterialLookupMap = std::unordered_map<ExportMaterial*, DWORD>;
     MaterialLookupMap                               g_ExportMaterialToSDKMeshMaterialMap;
 
-    uint8_t g_Padding4K[4096] = {};
+    constexpr size_t STREAM_STAGING_BUFFER_SIZE = 1024 * 1024;
+    constexpr size_t STREAM_MAX_WRITE_SIZE = 1024 * 1024 * 1024;
+
+    // Buffered output for SDKMESH files.  Headers and other small records are gathered
+    // into a staging buffer so they reach the disk in a few large writes; payloads at
+    // least as large as the buffer bypass it and go straight from the caller's memory.
+    class SDKMeshFileStream
+    {
+    public:
+        SDKMeshFileStream() noexcept
+            : m_hFile(INVALID_HANDLE_VALUE),
+            m_dwBuffered(0),
+            m_BytesWritten(0),
+            m_bFailed(false)
+        {
+        }
+        ~SDKMeshFileStream() { Close(); }
+
+        SDKMeshFileStream(const SDKMeshFileStream&) = delete;
+        SDKMeshFileStream& operator=(const SDKMeshFileStream&) = delete;
+
+        bool Open(const CHAR* strFileName, UINT64 ExpectedSize)
+        {
+            m_hFile = CreateFileA(strFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_hFile == INVALID_HANDLE_VALUE)
+                return false;
+
+            // Size the file up front so it can be allocated in one piece; Close trims it
+            // to the bytes actually written.
+            if (ExpectedSize > 0)
+            {
+                LARGE_INTEGER Offset = {};
+                Offset.QuadPart = static_cast<LONGLONG>(ExpectedSize);
+                if (SetFilePointerEx(m_hFile, Offset, nullptr, FILE_BEGIN))
+                {
+                    SetEndOfFile(m_hFile);
+                }
+                Offset.QuadPart = 0;
+                SetFilePointerEx(m_hFile, Offset, nullptr, FILE_BEGIN);
+            }
+
+            m_Buffer.reset(new uint8_t[STREAM_STAGING_BUFFER_SIZE]);
+            return true;
+        }
+
+        void Write(const void* pData, size_t Size)
+        {
+            m_BytesWritten += Size;
+            if (Size >= STREAM_STAGING_BUFFER_SIZE)
+            {
+                Flush();
+                WriteDirect(pData, Size);
+                return;
+            }
+            if (m_dwBuffered + Size > STREAM_STAGING_BUFFER_SIZE)
+            {
+                Flush();
+            }
+            memcpy(m_Buffer.get() + m_dwBuffered, pData, Size);
+            m_dwBuffered += Size;
+        }
+
+        template<class T> void WriteArray(const std::vector<T>& Array)
+        {
+            if (!Array.empty())
+            {
+                Write(Array.data(), Array.size() * sizeof(T));
+            }
+        }
+
+        void WritePadding(size_t Size)
+        {
+            m_BytesWritten += Size;
+            while (Size > 0)
+            {
+                if (m_dwBuffered == STREAM_STAGING_BUFFER_SIZE)
+                {
+                    Flush();
+                }
+                const size_t Chunk = std::min(Size, STREAM_STAGING_BUFFER_SIZE - m_dwBuffered);
+                memset(m_Buffer.get() + m_dwBuffered, 0, Chunk);
+                m_dwBuffered += Chunk;
+                Size -= Chunk;
+            }
+        }
+
+        UINT64 GetBytesWritten() const noexcept { return m_BytesWritten; }
+
+        // Returns false if any write failed.
+        bool Close()
+        {
+            if (m_hFile == INVALID_HANDLE_VALUE)
+                return !m_bFailed;
+
+            Flush();
+            if (!SetEndOfFile(m_hFile))
+            {
+                m_bFailed = true;
+            }
+            CloseHandle(m_hFile);
+            m_hFile = INVALID_HANDLE_VALUE;
+            m_Buffer.reset();
+            return !m_bFailed;
+        }
+
+    protected:
+        void Flush()
+        {
+            if (m_dwBuffered > 0)
+            {
+                WriteDirect(m_Buffer.get(), m_dwBuffered);
+                m_dwBuffered = 0;
+            }
+        }
+
+        void WriteDirect(const void* pData, size_t Size)
+        {
+            auto pBytes = static_cast<const uint8_t*>(pData);
+            while (Size > 0 && !m_bFailed)
+            {
+                const DWORD dwChunk = static_cast<DWORD>(std::min(Size, STREAM_MAX_WRITE_SIZE));
+                DWORD dwBytesWritten = 0;
+                if (!WriteFile(m_hFile, pBytes, dwChunk, &dwBytesWritten, nullptr) || dwBytesWritten != dwChunk)
+                {
+                    m_bFailed = true;
+                }
+                pBytes += dwChunk;
+                Size -= dwChunk;
+            }
+        }
+
+        HANDLE                      m_hFile;
+        std::unique_ptr<uint8_t[]>  m_Buffer;
+        size_t                      m_dwBuffered;
+        UINT64                      m_BytesWritten;
+        bool                        m_bFailed;
+    };
 
     bool WriteSDKMeshAnimationFile(const CHAR* strFileName, ExportManifest* pManifest);
 
@@ -55,6 +194,9 @@ namespace ATG
         g_SubsetIndexArray.clear();
         g_FrameInfluenceArray.clear();
         g_MaterialArray.clear();
+        g_MeshletMeshArray.clear();
+        g_MeshletDataArray.clear();
+        g_MeshletSubsetArray.clear();
         g_ExportMaterialToSDKMeshMaterialMap.clear();
     }
 
@@ -307,6 +449,41 @@ namespace ATG
         g_SubsetArray.push_back(Subset);
     }
 
+    // Records the meshlet ranges of each subset in the order of the mesh's subset list.
+    void CaptureMeshlets(ExportMesh* pMesh, ExportModel* pModel, uint32_t uMeshIndex, uint32_t uSubsetCount)
+    {
+        const ExportMeshletData& Data = pMesh->GetMeshlets();
+        const DWORD dwIndexSize = pMesh->GetIB()->GetIndexSize();
+
+        SDKMESH_MESHLET_MESH MeshletMesh = {};
+        MeshletMesh.Mesh = uMeshIndex;
+        MeshletMesh.NumSubsets = uSubsetCount;
+        MeshletMesh.NumMeshlets = static_cast<uint32_t>(Data.Meshlets.size());
+        MeshletMesh.IndexType = dwIndexSize == 2 ? IT_16BIT : IT_32BIT;
+        MeshletMesh.NumUniqueVertexIndices = Data.UniqueVertexIndices.size() / dwIndexSize;
+        MeshletMesh.NumPrimitives = Data.Primitives.size();
+
+        if (pModel->GetBindingCount() == 0)
+        {
+            // The default subset covers the whole mesh.
+            SDKMESH_MESHLET_SUBSET Subset = { 0, MeshletMesh.NumMeshlets };
+            g_MeshletSubsetArray.push_back(Subset);
+        }
+        else
+        {
+            for (size_t i = 0; i < pModel->GetBindingCount(); ++i)
+            {
+                auto pIBSubset = pMesh->FindSubset(pModel->GetBinding(i)->SubsetName);
+                assert(pIBSubset != nullptr);
+                SDKMESH_MESHLET_SUBSET Subset = { pIBSubset->GetMeshletStart(), pIBSubset->GetMeshletCount() };
+                g_MeshletSubsetArray.push_back(Subset);
+            }
+        }
+
+        g_MeshletMeshArray.push_back(MeshletMesh);
+        g_MeshletDataArray.push_back(&Data);
+    }
+
     void CaptureModel(ExportModel* pModel, bool version2)
     {
         g_ModelArray.push_back(pModel);
@@ -393,6 +570,22 @@ namespace ATG
             g_SubsetArray.push_back(Subset);
         }
 
+        if (pMeshBase->GetMeshType() == ExportMeshBase::PolyMesh && !pSubDMesh)
+        {
+            auto pMesh = reinterpret_cast<ExportMesh*>(pMeshBase);
+            if (pMesh->HasMeshlets())
+            {
+                if (version2)
+                {
+                    CaptureMeshlets(pMesh, pModel, static_cast<uint32_t>(g_MeshHeaderArray.size()), MeshHeader.NumSubsets);
+                }
+                else
+                {
+                    ExportLog::LogWarning("Meshlets for mesh \"%s\" are only written to SDKMESH version 2 files.", pMeshBase->GetName().SafeString());
+                }
+            }
+        }
+
         g_MeshHeaderArray.push_back(MeshHeader);
     }
 
@@ -481,9 +674,9 @@ namespace ATG
         }
     }
 
-    constexpr inline DWORD RoundUp4K(DWORD dwValue)
+    constexpr inline UINT64 RoundUp4K(UINT64 Value)
     {
-        return ((dwValue + 4095) / 4096) * 4096;
+        return ((Value + 4095) / 4096) * 4096;
     }
 
     constexpr inline DWORD RoundUp32B(DWORD dwValue)
@@ -491,121 +684,178 @@ namespace ATG
         return ((dwValue + 31) / 32) * 32;
     }
 
+    constexpr inline UINT64 RoundUp8B(UINT64 Value)
+    {
+        return ((Value + 7) / 8) * 8;
+    }
+
     size_t ComputeMeshHeaderIndexDataSize()
     {
         return ((g_SubsetIndexArray.size() + g_FrameInfluenceArray.size()) * sizeof(uint32_t));
     }
 
-    DWORD ComputeBufferDataSize()
+    UINT64 ComputeBufferDataSize()
     {
-        DWORD dwDataSize = 0;
-        const size_t dwVBCount = g_VBHeaderArray.size();
-        for (size_t i = 0; i < dwVBCount; ++i)
+        UINT64 DataSize = 0;
+        for (const auto& VBHeader : g_VBHeaderArray)
         {
-            const auto& VBHeader = g_VBHeaderArray[i];
-            dwDataSize += RoundUp4K(static_cast<DWORD>(VBHeader.SizeBytes));
+            DataSize += RoundUp4K(VBHeader.SizeBytes);
         }
-        const size_t dwIBCount = g_IBHeaderArray.size();
-        for (size_t i = 0; i < dwIBCount; ++i)
+        for (const auto& IBHeader : g_IBHeaderArray)
         {
-            const auto& IBHeader = g_IBHeaderArray[i];
-            dwDataSize += RoundUp4K(static_cast<DWORD>(IBHeader.SizeBytes));
+            DataSize += RoundUp4K(IBHeader.SizeBytes);
         }
-        return dwDataSize;
+        return DataSize;
     }
 
-    void WriteVertexBufferHeaders(HANDLE hFile, UINT64& DataOffset)
+    void AssignBufferDataOffsets(UINT64 DataOffset)
     {
-        const size_t dwVBCount = g_VBHeaderArray.size();
-        for (size_t i = 0; i < dwVBCount; ++i)
+        for (auto& VBHeader : g_VBHeaderArray)
         {
-            auto& VBHeader = g_VBHeaderArray[i];
             VBHeader.DataOffset = DataOffset;
-            DataOffset += RoundUp4K(static_cast<DWORD>(VBHeader.SizeBytes));
-            DWORD dwBytesWritten = 0;
-            WriteFile(hFile, &VBHeader, sizeof(SDKMESH_VERTEX_BUFFER_HEADER), &dwBytesWritten, nullptr);
+            DataOffset += RoundUp4K(VBHeader.SizeBytes);
         }
-    }
-
-    void WriteIndexBufferHeaders(HANDLE hFile, UINT64& DataOffset)
-    {
-        const size_t dwIBCount = g_IBHeaderArray.size();
-        for (size_t i = 0; i < dwIBCount; ++i)
+        for (auto& IBHeader : g_IBHeaderArray)
         {
-            auto& IBHeader = g_IBHeaderArray[i];
             IBHeader.DataOffset = DataOffset;
-            DataOffset += RoundUp4K(static_cast<DWORD>(IBHeader.SizeBytes));
-            DWORD dwBytesWritten = 0;
-            WriteFile(hFile, &IBHeader, sizeof(SDKMESH_INDEX_BUFFER_HEADER), &dwBytesWritten, nullptr);
+            DataOffset += RoundUp4K(IBHeader.SizeBytes);
         }
     }
 
-    void WriteMeshes(HANDLE hFile, UINT64& DataOffset)
+    void AssignMeshDataOffsets(UINT64 DataOffset)
     {
-        const size_t dwMeshCount = g_MeshHeaderArray.size();
-        DWORD dwBytesWritten = 0;
-        for (size_t i = 0; i < dwMeshCount; ++i)
+        for (auto& Mesh : g_MeshHeaderArray)
         {
-            auto& Mesh = g_MeshHeaderArray[i];
             Mesh.SubsetOffset = DataOffset;
             DataOffset += Mesh.NumSubsets * sizeof(uint32_t);
             Mesh.FrameInfluenceOffset = DataOffset;
             DataOffset += Mesh.NumFrameInfluences * sizeof(uint32_t);
-            WriteFile(hFile, &Mesh, sizeof(SDKMESH_MESH), &dwBytesWritten, nullptr);
         }
     }
 
-    void WriteSubsetIndexAndFrameInfluenceData(HANDLE hFile)
+    // Every meshlet array starts on an 8-byte boundary, so the chunk needs no padding
+    // at the end.
+    UINT64 ComputeMeshletChunkSize()
     {
-        const size_t dwMeshCount = g_MeshHeaderArray.size();
-        DWORD dwSubsetIndexCount = 0;
-        DWORD dwFrameInfluenceCount = 0;
-        DWORD dwBytesWritten = 0;
-        for (size_t i = 0; i < dwMeshCount; ++i)
+        if (g_MeshletMeshArray.empty())
+            return 0;
+
+        UINT64 ChunkSize = sizeof(SDKMESH_CHUNK_HEADER) + sizeof(SDKMESH_MESHLET_CHUNK)
+            + g_MeshletMeshArray.size() * sizeof(SDKMESH_MESHLET_MESH);
+        for (size_t i = 0; i < g_MeshletMeshArray.size(); ++i)
+        {
+            const auto& MeshletMesh = g_MeshletMeshArray[i];
+            const ExportMeshletData* pData = g_MeshletDataArray[i];
+            ChunkSize += MeshletMesh.NumSubsets * sizeof(SDKMESH_MESHLET_SUBSET);
+            ChunkSize += MeshletMesh.NumMeshlets * (sizeof(SDKMESH_MESHLET) + sizeof(SDKMESH_MESHLET_CULL_DATA));
+            ChunkSize += RoundUp8B(pData->UniqueVertexIndices.size());
+            ChunkSize += RoundUp8B(pData->Primitives.size() * sizeof(uint32_t));
+        }
+        return ChunkSize;
+    }
+
+    void AssignMeshletDataOffsets(UINT64 DataOffset)
+    {
+        DataOffset += sizeof(SDKMESH_CHUNK_HEADER) + sizeof(SDKMESH_MESHLET_CHUNK)
+            + g_MeshletMeshArray.size() * sizeof(SDKMESH_MESHLET_MESH);
+        for (size_t i = 0; i < g_MeshletMeshArray.size(); ++i)
+        {
+            auto& MeshletMesh = g_MeshletMeshArray[i];
+            const ExportMeshletData* pData = g_MeshletDataArray[i];
+            MeshletMesh.SubsetOffset = DataOffset;
+            DataOffset += MeshletMesh.NumSubsets * sizeof(SDKMESH_MESHLET_SUBSET);
+            MeshletMesh.MeshletOffset = DataOffset;
+            DataOffset += MeshletMesh.NumMeshlets * sizeof(SDKMESH_MESHLET);
+            MeshletMesh.CullDataOffset = DataOffset;
+            DataOffset += MeshletMesh.NumMeshlets * sizeof(SDKMESH_MESHLET_CULL_DATA);
+            MeshletMesh.UniqueVertexIndexOffset = DataOffset;
+            DataOffset += RoundUp8B(pData->UniqueVertexIndices.size());
+            MeshletMesh.PrimitiveOffset = DataOffset;
+            DataOffset += RoundUp8B(pData->Primitives.size() * sizeof(uint32_t));
+        }
+    }
+
+    void WriteMeshletChunk(SDKMeshFileStream& Stream, UINT64 ChunkSize)
+    {
+        static_assert(sizeof(ExportMeshlet) == sizeof(SDKMESH_MESHLET), "Meshlet layout mismatch");
+        static_assert(sizeof(ExportMeshletCullData) == sizeof(SDKMESH_MESHLET_CULL_DATA), "Meshlet cull data layout mismatch");
+
+        SDKMESH_CHUNK_HEADER ChunkHeader = {};
+        ChunkHeader.Type = SDKMESH_CHUNK_MESHLETS;
+        ChunkHeader.SizeBytes = ChunkSize - sizeof(SDKMESH_CHUNK_HEADER);
+        Stream.Write(&ChunkHeader, sizeof(ChunkHeader));
+
+        SDKMESH_MESHLET_CHUNK MeshletChunk = {};
+        MeshletChunk.NumMeshes = static_cast<uint32_t>(g_MeshletMeshArray.size());
+        for (const ExportMeshletData* pData : g_MeshletDataArray)
+        {
+            MeshletChunk.MaxVertices = std::max<uint32_t>(MeshletChunk.MaxVertices, pData->uMaxVertices);
+            MeshletChunk.MaxPrimitives = std::max<uint32_t>(MeshletChunk.MaxPrimitives, pData->uMaxPrimitives);
+        }
+        Stream.Write(&MeshletChunk, sizeof(MeshletChunk));
+        Stream.WriteArray(g_MeshletMeshArray);
+
+        size_t dwSubsetCount = 0;
+        for (size_t i = 0; i < g_MeshletMeshArray.size(); ++i)
+        {
+            const auto& MeshletMesh = g_MeshletMeshArray[i];
+            const ExportMeshletData* pData = g_MeshletDataArray[i];
+            if (MeshletMesh.NumSubsets > 0)
+            {
+                Stream.Write(&g_MeshletSubsetArray[dwSubsetCount], MeshletMesh.NumSubsets * sizeof(SDKMESH_MESHLET_SUBSET));
+                dwSubsetCount += MeshletMesh.NumSubsets;
+            }
+            Stream.WriteArray(pData->Meshlets);
+            Stream.WriteArray(pData->CullData);
+
+            const size_t dwIndexDataSize = pData->UniqueVertexIndices.size();
+            Stream.WriteArray(pData->UniqueVertexIndices);
+            Stream.WritePadding(static_cast<size_t>(RoundUp8B(dwIndexDataSize) - dwIndexDataSize));
+
+            const size_t dwPrimitiveDataSize = pData->Primitives.size() * sizeof(uint32_t);
+            Stream.WriteArray(pData->Primitives);
+            Stream.WritePadding(static_cast<size_t>(RoundUp8B(dwPrimitiveDataSize) - dwPrimitiveDataSize));
+        }
+    }
+
+    void WriteSubsetIndexAndFrameInfluenceData(SDKMeshFileStream& Stream)
+    {
+        size_t dwSubsetIndexCount = 0;
+        size_t dwFrameInfluenceCount = 0;
+        for (const auto& Mesh : g_MeshHeaderArray)
         {
-            const auto& Mesh = g_MeshHeaderArray[i];
             if (Mesh.NumSubsets > 0)
             {
-                WriteFile(hFile, &g_SubsetIndexArray[dwSubsetIndexCount], Mesh.NumSubsets * sizeof(uint32_t), &dwBytesWritten, nullptr);
+                Stream.Write(&g_SubsetIndexArray[dwSubsetIndexCount], Mesh.NumSubsets * sizeof(uint32_t));
                 dwSubsetIndexCount += Mesh.NumSubsets;
             }
             if (Mesh.NumFrameInfluences > 0)
             {
-                WriteFile(hFile, &g_FrameInfluenceArray[dwFrameInfluenceCount], Mesh.NumFrameInfluences * sizeof(uint32_t), &dwBytesWritten, nullptr);
+                Stream.Write(&g_FrameInfluenceArray[dwFrameInfluenceCount], Mesh.NumFrameInfluences * sizeof(uint32_t));
                 dwFrameInfluenceCount += Mesh.NumFrameInfluences;
             }
         }
     }
 
-    void WriteVertexBufferData(HANDLE hFile)
+    void WriteVertexBufferData(SDKMeshFileStream& Stream)
     {
         assert(g_VBHeaderArray.size() == g_VBArray.size());
-        const size_t dwVBCount = g_VBHeaderArray.size();
-        DWORD dwBytesWritten = 0;
-        for (size_t i = 0; i < dwVBCount; ++i)
+        for (const auto pVB : g_VBArray)
         {
-            const auto pVB = g_VBArray[i];
-            const DWORD dwDataSize = static_cast<DWORD>(pVB->GetVertexDataSize());
-            WriteFile(hFile, pVB->GetVertexData(), dwDataSize, &dwBytesWritten, nullptr);
-            const DWORD dwPaddingSize = RoundUp4K(dwDataSize) - dwDataSize;
-            assert(dwPaddingSize < 4096);
-            WriteFile(hFile, g_Padding4K, dwPaddingSize, &dwBytesWritten, nullptr);
+            const size_t dwDataSize = pVB->GetVertexDataSize();
+            Stream.Write(pVB->GetVertexData(), dwDataSize);
+            Stream.WritePadding(static_cast<size_t>(RoundUp4K(dwDataSize) - dwDataSize));
         }
     }
 
-    void WriteIndexBufferData(HANDLE hFile)
+    void WriteIndexBufferData(SDKMeshFileStream& Stream)
     {
         assert(g_IBHeaderArray.size() == g_IBArray.size());
-        const size_t dwIBCount = g_IBHeaderArray.size();
-        DWORD dwBytesWritten = 0;
-        for (size_t i = 0; i < dwIBCount; ++i)
+        for (const auto pIB : g_IBArray)
         {
-            const auto pIB = g_IBArray[i];
-            const DWORD dwDataSize = static_cast<DWORD>(pIB->GetIndexDataSize());
-            WriteFile(hFile, pIB->GetIndexData(), dwDataSize, &dwBytesWritten, nullptr);
-            const DWORD dwPaddingSize = RoundUp4K(dwDataSize) - dwDataSize;
-            assert(dwPaddingSize < 4096);
-            WriteFile(hFile, g_Padding4K, dwPaddingSize, &dwBytesWritten, nullptr);
+            const size_t dwDataSize = pIB->GetIndexDataSize();
+            Stream.Write(pIB->GetIndexData(), dwDataSize);
+            Stream.WritePadding(static_cast<size_t>(RoundUp4K(dwDataSize) - dwDataSize));
         }
     }
 
@@ -655,15 +905,6 @@ namespace ATG
             g_FrameHeaderArray.push_back(defFrame);
         }
 
-        HANDLE hFile = CreateFileA(strFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-        if (hFile == INVALID_HANDLE_VALUE)
-        {
-            ExportLog::LogError("Could not write to file \"%s\".  Check that the file is not read-only and that the path exists.", strFileName);
-            return false;
-        }
-
-        ExportLog::LogMsg(1, "Writing to SDKMESH file \"%s\"", strFileName);
-
         SDKMESH_HEADER FileHeader = {};
 
         FileHeader.Version = (version2) ? SDKMESH_FILE_VERSION_V2 : SDKMESH_FILE_VERSION;
@@ -697,57 +938,57 @@ namespace ATG
         FileHeader.FrameDataOffset = FileHeader.SubsetDataOffset + FileHeader.NumTotalSubsets * sizeof(SDKMESH_SUBSET);
         FileHeader.MaterialDataOffset = FileHeader.FrameDataOffset + FileHeader.NumFrames * sizeof(SDKMESH_FRAME);
 
-        // Write header to file
-        DWORD dwBytesWritten = 0;
-        WriteFile(hFile, &FileHeader, sizeof(SDKMESH_HEADER), &dwBytesWritten, nullptr);
-
-        UINT64 BufferDataOffset = FileHeader.HeaderSize + FileHeader.NonBufferDataSize;
+        // Resolve every offset before writing, so the file is emitted in a single pass.
+        AssignBufferDataOffsets(FileHeader.HeaderSize + FileHeader.NonBufferDataSize);
+        AssignMeshDataOffsets(FileHeader.HeaderSize + StaticDataSize);
 
-        // Write VB headers
-        WriteVertexBufferHeaders(hFile, BufferDataOffset);
+        // Meshlets follow the buffer data as an optional chunk.
+        const UINT64 ChunkDataOffset = FileHeader.HeaderSize + FileHeader.NonBufferDataSize + FileHeader.BufferDataSize;
+        const UINT64 MeshletChunkSize = ComputeMeshletChunkSize();
+        AssignMeshletDataOffsets(ChunkDataOffset);
 
-        // Write IB headers
-        WriteIndexBufferHeaders(hFile, BufferDataOffset);
+        const UINT64 FileSize = ChunkDataOffset + MeshletChunkSize;
 
-        // Write meshes
-        UINT64 SubsetListOffset = FileHeader.HeaderSize + StaticDataSize;
-        WriteMeshes(hFile, SubsetListOffset);
-
-        // Write subsets
-        const size_t dwSubsetCount = g_SubsetArray.size();
-        for (size_t i = 0; i < dwSubsetCount; ++i)
+        SDKMeshFileStream Stream;
+        if (!Stream.Open(strFileName, FileSize))
         {
-            const auto& Subset = g_SubsetArray[i];
-            WriteFile(hFile, &Subset, sizeof(SDKMESH_SUBSET), &dwBytesWritten, nullptr);
+            ExportLog::LogError("Could not write to file \"%s\".  Check that the file is not read-only and that the path exists.", strFileName);
+            ClearSceneArrays();
+            return false;
         }
 
-        // Write frames
-        const size_t dwFrameCount = g_FrameHeaderArray.size();
-        for (size_t i = 0; i < dwFrameCount; ++i)
-        {
-            const auto& Frame = g_FrameHeaderArray[i];
-            WriteFile(hFile, &Frame, sizeof(SDKMESH_FRAME), &dwBytesWritten, nullptr);
-        }
+        ExportLog::LogMsg(1, "Writing to SDKMESH file \"%s\"", strFileName);
+
+        Stream.Write(&FileHeader, sizeof(SDKMESH_HEADER));
+        Stream.WriteArray(g_VBHeaderArray);
+        Stream.WriteArray(g_IBHeaderArray);
+        Stream.WriteArray(g_MeshHeaderArray);
+        Stream.WriteArray(g_SubsetArray);
+        Stream.WriteArray(g_FrameHeaderArray);
 
-        // Write materials
         // TODO - V2
-        const size_t dwMaterialCount = g_MaterialArray.size();
-        for (size_t i = 0; i < dwMaterialCount; ++i)
-        {
-            const auto& Material = g_MaterialArray[i];
-            WriteFile(hFile, &Material, sizeof(SDKMESH_MATERIAL), &dwBytesWritten, nullptr);
-        }
+        Stream.WriteArray(g_MaterialArray);
 
-        // Write subset index lists and frame influence lists
-        WriteSubsetIndexAndFrameInfluenceData(hFile);
+        // Subset index lists and frame influence lists
+        WriteSubsetIndexAndFrameInfluenceData(Stream);
 
-        // Write VB data
-        WriteVertexBufferData(hFile);
+        // VB and IB data, written from the buffers' own memory
+        WriteVertexBufferData(Stream);
+        WriteIndexBufferData(Stream);
+
+        if (MeshletChunkSize > 0)
+        {
+            WriteMeshletChunk(Stream, MeshletChunkSize);
+        }
 
-        // Write IB data
-        WriteIndexBufferData(hFile);
+        assert(Stream.GetBytesWritten() == FileSize);
 
-        CloseHandle(hFile);
+        if (!Stream.Close())
+        {
+            ExportLog::LogError("Failed writing to file \"%s\".  Check that there is enough free disk space.", strFileName);
+            ClearSceneArrays();
+            return false;
+        }
 
         ClearSceneArrays();
 
@@ -756,150 +997,226 @@ namespace ATG
         return true;
     }
 
-    bool SamplePositionData(const ExportAnimationPositionKey* pKeys, size_t dwKeyCount, SDKANIMATION_DATA* pDestKeys, size_t dwDestKeyCount, float fKeyInterval)
+    // Sparse keys are written straight from the track's key lists.
+    static_assert(sizeof(ExportAnimationPositionKey) == sizeof(SDKANIMATION_TRANSLATION_KEY)
+        && offsetof(ExportAnimationPositionKey, Position) == offsetof(SDKANIMATION_TRANSLATION_KEY, Translation), "Position key layout mismatch");
+    static_assert(sizeof(ExportAnimationOrientationKey) == sizeof(SDKANIMATION_ORIENTATION_KEY)
+        && offsetof(ExportAnimationOrientationKey, Orientation) == offsetof(SDKANIMATION_ORIENTATION_KEY, Orientation), "Orientation key layout mismatch");
+    static_assert(sizeof(ExportAnimationScaleKey) == sizeof(SDKANIMATION_SCALING_KEY)
+        && offsetof(ExportAnimationScaleKey, Scale) == offsetof(SDKANIMATION_SCALING_KEY, Scaling), "Scale key layout mismatch");
+
+    // A channel that holds one value throughout is written as a single key.
+    template <typename KeyType, typename ValueType>
+    size_t GetSparseKeyCount(const std::vector<KeyType>& Keys, ValueType KeyType::* pValue)
     {
-        if (dwKeyCount == 0)
-            return false;
-
-        DWORD dwCurrentSrcKey = 0;
-        bool bEndKey = false;
-        ExportAnimationPositionKey StartKey = pKeys[dwCurrentSrcKey];
-        ExportAnimationPositionKey EndKey = {};
-        if (dwKeyCount > 1)
+        for (size_t i = 1; i < Keys.size(); ++i)
         {
-            bEndKey = true;
-            EndKey = pKeys[dwCurrentSrcKey + 1];
+            if (memcmp(&(Keys[i].*pValue), &(Keys[0].*pValue), sizeof(ValueType)) != 0)
+                return Keys.size();
         }
+        return std::min<size_t>(Keys.size(), 1);
+    }
 
-        float fTime = 0;
-        for (size_t i = 0; i < dwDestKeyCount; ++i)
-        {
-            while (bEndKey && fTime >= EndKey.fTime)
-            {
-                StartKey = EndKey;
-                ++dwCurrentSrcKey;
-                if (dwCurrentSrcKey >= dwKeyCount)
-                    bEndKey = false;
-                else
-                    EndKey = pKeys[dwCurrentSrcKey + 1];
-            }
-            if (!bEndKey)
-            {
-                pDestKeys[i].Translation = StartKey.Position;
-            }
-            else
-            {
-                assert(fTime <= EndKey.fTime);
-                float fLerpFactor = (fTime - StartKey.fTime) / (EndKey.fTime - StartKey.fTime);
-                fLerpFactor = std::min(std::max(0.0f, fLerpFactor), 1.0f);
+    SDKANIMATION_SPARSE_TRACK GetSparseTrackHeader(const ExportAnimationTransformTrack& Track)
+    {
+        SDKANIMATION_SPARSE_TRACK TrackHeader = {};
+        TrackHeader.TranslationKeyCount = static_cast<uint32_t>(GetSparseKeyCount(Track.PositionKeys, &ExportAnimationPositionKey::Position));
+        TrackHeader.OrientationKeyCount = static_cast<uint32_t>(GetSparseKeyCount(Track.OrientationKeys, &ExportAnimationOrientationKey::Orientation));
+        TrackHeader.ScalingKeyCount = static_cast<uint32_t>(GetSparseKeyCount(Track.ScaleKeys, &ExportAnimationScaleKey::Scale));
+        return TrackHeader;
+    }
 
-                XMVECTOR v = XMLoadFloat3(&StartKey.Position);
-                const XMVECTOR vEnd = XMLoadFloat3(&EndKey.Position);
+    UINT64 ComputeSparseTrackSize(const SDKANIMATION_SPARSE_TRACK& TrackHeader)
+    {
+        return sizeof(SDKANIMATION_SPARSE_TRACK)
+            + UINT64(TrackHeader.TranslationKeyCount) * sizeof(SDKANIMATION_TRANSLATION_KEY)
+            + UINT64(TrackHeader.OrientationKeyCount) * sizeof(SDKANIMATION_ORIENTATION_KEY)
+            + UINT64(TrackHeader.ScalingKeyCount) * sizeof(SDKANIMATION_SCALING_KEY);
+    }
 
-                v = XMVectorLerp(v, vEnd, fLerpFactor);
+    void WriteSparseTrack(SDKMeshFileStream& Stream, const ExportAnimationTransformTrack& Track, const SDKANIMATION_SPARSE_TRACK& TrackHeader)
+    {
+        Stream.Write(&TrackHeader, sizeof(SDKANIMATION_SPARSE_TRACK));
+        Stream.Write(Track.PositionKeys.data(), TrackHeader.TranslationKeyCount * sizeof(SDKANIMATION_TRANSLATION_KEY));
+        Stream.Write(Track.OrientationKeys.data(), TrackHeader.OrientationKeyCount * sizeof(SDKANIMATION_ORIENTATION_KEY));
+        Stream.Write(Track.ScaleKeys.data(), TrackHeader.ScalingKeyCount * sizeof(SDKANIMATION_SCALING_KEY));
 
-                XMStoreFloat3(&pDestKeys[i].Translation, v);
-            }
-            fTime += fKeyInterval;
-        }
-        return true;
+        const UINT64 TrackSize = ComputeSparseTrackSize(TrackHeader);
+        Stream.WritePadding(static_cast<size_t>(RoundUp8B(TrackSize) - TrackSize));
     }
 
-    bool SampleOrientationData(const ExportAnimationOrientationKey* pKeys, size_t dwKeyCount, SDKANIMATION_DATA* pDestKeys, size_t dwDestKeyCount, float fKeyInterval)
+    inline ExportString GetTrackFrameName(ExportAnimationTrack* pTrack)
     {
-        if (dwKeyCount == 0)
-            return false;
+        auto pSourceFrame = pTrack->TransformTrack.pSourceFrame;
+        return pSourceFrame ? pSourceFrame->GetName() : pTrack->GetName();
+    }
 
-        DWORD dwCurrentSrcKey = 0;
-        bool bEndKey = false;
-        ExportAnimationOrientationKey StartKey = pKeys[dwCurrentSrcKey];
-        ExportAnimationOrientationKey EndKey = {};
-        if (dwKeyCount > 1)
+    // Writes every animation as a clip of one file.  The frame table is the union of
+    // every clip's tracks, and each clip stores sparse tracks for the frames it animates.
+    bool WriteSDKMeshMultiClipAnimationFile(const CHAR* strAnimFileName)
+    {
+        const size_t dwClipCount = g_pScene->GetAnimationCount();
+
+        if (g_pScene->Settings().bQuantizeAnimations)
         {
-            bEndKey = true;
-            EndKey = pKeys[dwCurrentSrcKey + 1];
+            ExportLog::LogWarning("Quantized tracks are not supported in multi-clip animation files; writing sparse tracks.");
         }
 
-        float fTime = 0;
-        for (size_t i = 0; i < dwDestKeyCount; ++i)
+        // The file header stores a single frame rate, so every clip must share it.
+        auto GetAnimationFPS = [](const ExportAnimation* pAnim) -> UINT
         {
-            while (bEndKey && fTime >= EndKey.fTime)
-            {
-                StartKey = EndKey;
-                ++dwCurrentSrcKey;
-                if (dwCurrentSrcKey >= dwKeyCount)
-                    bEndKey = false;
-                else
-                    EndKey = pKeys[dwCurrentSrcKey + 1];
-            }
-            if (!bEndKey)
+            return static_cast<UINT>(static_cast<int>(1.001f / pAnim->fSourceFrameInterval));
+        };
+        const UINT uAnimationFPS = GetAnimationFPS(g_pScene->GetAnimation(0));
+        for (size_t i = 1; i < dwClipCount; ++i)
+        {
+            const ExportAnimation* pAnim = g_pScene->GetAnimation(i);
+            if (GetAnimationFPS(pAnim) != uAnimationFPS)
             {
-                pDestKeys[i].Orientation = (XMFLOAT4)StartKey.Orientation;
+                ExportLog::LogError("Animation \"%s\" is %u FPS, but \"%s\" is %u FPS; all clips of a multi-clip animation file must have the same frame rate.",
+                    pAnim->GetName().SafeString(), GetAnimationFPS(pAnim), g_pScene->GetAnimation(0)->GetName().SafeString(), uAnimationFPS);
+                return false;
             }
-            else
+        }
+
+        // Frames are identified across clips by their source frame, so nodes that share
+        // a name still get separate slots.  Tracks without a source frame fall back to
+        // their pooled name.
+        std::vector<ExportString> FrameNames;
+        std::unordered_map<const void*, size_t> FrameLookup;
+
+        // Per clip: the frame each track maps to (or NO_FRAME if the track is skipped),
+        // and each track's sparse header.
+        constexpr size_t NO_FRAME = size_t(-1);
+        std::vector<std::vector<size_t>> TrackFrames(dwClipCount);
+        std::vector<std::vector<SDKANIMATION_SPARSE_TRACK>> SparseTracks(dwClipCount);
+        std::vector<uint8_t> FrameUsed;
+        for (size_t i = 0; i < dwClipCount; ++i)
+        {
+            ExportAnimation* pAnim = g_pScene->GetAnimation(i);
+            const size_t dwTrackCount = pAnim->GetTrackCount();
+            TrackFrames[i].resize(dwTrackCount, NO_FRAME);
+            SparseTracks[i].resize(dwTrackCount);
+            std::fill(FrameUsed.begin(), FrameUsed.end(), uint8_t(0));
+            for (size_t j = 0; j < dwTrackCount; ++j)
             {
-                assert(fTime <= EndKey.fTime);
-                float fLerpFactor = (fTime - StartKey.fTime) / (EndKey.fTime - StartKey.fTime);
-                fLerpFactor = std::min(std::max(0.0f, fLerpFactor), 1.0f);
+                ExportAnimationTrack* pTrack = pAnim->GetTrack(j);
+                if (!pTrack)
+                    return false;
 
-                XMVECTOR v = XMLoadFloat4(&StartKey.Orientation);
-                const XMVECTOR vEnd = XMLoadFloat4(&EndKey.Orientation);
+                const ExportString FrameName = GetTrackFrameName(pTrack);
+                const void* pFrameKey = pTrack->TransformTrack.pSourceFrame;
+                if (!pFrameKey)
+                    pFrameKey = FrameName.SafeString();
 
-                v = XMVectorLerp(v, vEnd, fLerpFactor);
+                auto it = FrameLookup.find(pFrameKey);
+                if (it == FrameLookup.end())
+                {
+                    it = FrameLookup.emplace(pFrameKey, FrameNames.size()).first;
+                    FrameNames.push_back(FrameName);
+                    FrameUsed.push_back(0);
+                }
 
-                XMStoreFloat4(&pDestKeys[i].Orientation, v);
+                if (FrameUsed[it->second])
+                {
+                    ExportLog::LogWarning("Animation \"%s\" has more than one track for frame \"%s\"; skipping the duplicate.", pAnim->GetName().SafeString(), FrameName.SafeString());
+                    continue;
+                }
+                FrameUsed[it->second] = 1;
+                TrackFrames[i][j] = it->second;
+                SparseTracks[i][j] = GetSparseTrackHeader(pTrack->TransformTrack);
             }
-            fTime += fKeyInterval;
         }
-        return true;
-    }
 
-    bool SampleScaleData(const ExportAnimationScaleKey* pKeys, size_t dwKeyCount, SDKANIMATION_DATA* pDestKeys, size_t dwDestKeyCount, float fKeyInterval)
-    {
-        if (dwKeyCount == 0)
+        const size_t dwFrameCount = FrameNames.size();
+        if (dwFrameCount == 0)
             return false;
 
-        DWORD dwCurrentSrcKey = 0;
-        bool bEndKey = false;
-        ExportAnimationScaleKey StartKey = pKeys[dwCurrentSrcKey];
-        ExportAnimationScaleKey EndKey = {};
-        if (dwKeyCount > 1)
+        // Lay out the frame table, clip table, per-clip track offsets, then the tracks.
+        UINT64 AnimationDataSize = dwFrameCount * sizeof(SDKANIMATION_FRAME_DATA) + sizeof(SDKANIMATION_CLIP_TABLE) + dwClipCount * sizeof(SDKANIMATION_CLIP);
+        std::vector<SDKANIMATION_CLIP> Clips(dwClipCount);
+        for (size_t i = 0; i < dwClipCount; ++i)
         {
-            bEndKey = true;
-            EndKey = pKeys[dwCurrentSrcKey + 1];
+            Clips[i].TrackOffsetsOffset = AnimationDataSize;
+            AnimationDataSize += dwFrameCount * sizeof(uint64_t);
         }
 
-        float fTime = 0;
-        for (size_t i = 0; i < dwDestKeyCount; ++i)
+        std::vector<std::vector<uint64_t>> TrackOffsets(dwClipCount, std::vector<uint64_t>(dwFrameCount, 0));
+        size_t dwMaxKeyCount = 0;
+        for (size_t i = 0; i < dwClipCount; ++i)
         {
-            while (bEndKey && fTime >= EndKey.fTime)
+            ExportAnimation* pAnim = g_pScene->GetAnimation(i);
+            auto& Clip = Clips[i];
+            strncpy_s(Clip.ClipName, pAnim->GetName().SafeString(), MAX_ANIMATION_NAME);
+            Clip.Duration = pAnim->GetDuration();
+            Clip.NumAnimationKeys = static_cast<uint32_t>(static_cast<int>(pAnim->GetDuration() / pAnim->fSourceFrameInterval));
+            dwMaxKeyCount = std::max<size_t>(dwMaxKeyCount, Clip.NumAnimationKeys);
+
+            for (size_t j = 0; j < SparseTracks[i].size(); ++j)
             {
-                StartKey = EndKey;
-                ++dwCurrentSrcKey;
-                if (dwCurrentSrcKey >= dwKeyCount)
-                    bEndKey = false;
-                else
-                    EndKey = pKeys[dwCurrentSrcKey + 1];
-            }
-            if (!bEndKey)
-            {
-                pDestKeys[i].Scaling = StartKey.Scale;
+                if (TrackFrames[i][j] == NO_FRAME)
+                    continue;
+                TrackOffsets[i][TrackFrames[i][j]] = AnimationDataSize;
+                AnimationDataSize += RoundUp8B(ComputeSparseTrackSize(SparseTracks[i][j]));
             }
-            else
-            {
-                assert(fTime <= EndKey.fTime);
-                float fLerpFactor = (fTime - StartKey.fTime) / (EndKey.fTime - StartKey.fTime);
-                fLerpFactor = std::min(std::max(0.0f, fLerpFactor), 1.0f);
+        }
+
+        SDKANIMATION_FILE_HEADER AnimHeader = {};
+        AnimHeader.Version = SDKANIMATION_FILE_VERSION_MULTICLIP;
+        AnimHeader.IsBigEndian = !g_pScene->Settings().bLittleEndian;
+        AnimHeader.FrameTransformType = FTT_RELATIVE;
+        AnimHeader.NumAnimationKeys = static_cast<UINT>(dwMaxKeyCount);
+        AnimHeader.AnimationFPS = uAnimationFPS;
+        AnimHeader.NumFrames = static_cast<UINT>(dwFrameCount);
+        AnimHeader.AnimationDataSize = AnimationDataSize;
+        AnimHeader.AnimationDataOffset = sizeof(SDKANIMATION_FILE_HEADER);
+
+        SDKMeshFileStream Stream;
+        if (!Stream.Open(strAnimFileName, AnimHeader.AnimationDataOffset + AnimHeader.AnimationDataSize))
+        {
+            ExportLog::LogError("Could not write to file \"%s\".  Check that the file is not read-only and that the path exists.", strAnimFileName);
+            return false;
+        }
+
+        ExportLog::LogMsg(1, "Writing %zu animations to SDKMESH animation file \"%s\"", dwClipCount, strAnimFileName);
 
-                XMVECTOR v = XMLoadFloat3(&StartKey.Scale);
-                const XMVECTOR vEnd = XMLoadFloat3(&EndKey.Scale);
+        Stream.Write(&AnimHeader, sizeof(SDKANIMATION_FILE_HEADER));
+
+        for (const auto& FrameName : FrameNames)
+        {
+            SDKANIMATION_FRAME_DATA FrameData = {};
+            strncpy_s(FrameData.FrameName, FrameName.SafeString(), MAX_FRAME_NAME);
+            Stream.Write(&FrameData, sizeof(SDKANIMATION_FRAME_DATA));
+        }
 
-                v = XMVectorLerp(v, vEnd, fLerpFactor);
+        SDKANIMATION_CLIP_TABLE ClipTable = {};
+        ClipTable.NumClips = static_cast<uint32_t>(dwClipCount);
+        Stream.Write(&ClipTable, sizeof(SDKANIMATION_CLIP_TABLE));
+        Stream.WriteArray(Clips);
 
-                XMStoreFloat3(&pDestKeys[i].Scaling, v);
+        for (const auto& ClipTrackOffsets : TrackOffsets)
+        {
+            Stream.WriteArray(ClipTrackOffsets);
+        }
+
+        for (size_t i = 0; i < dwClipCount; ++i)
+        {
+            ExportAnimation* pAnim = g_pScene->GetAnimation(i);
+            for (size_t j = 0; j < SparseTracks[i].size(); ++j)
+            {
+                if (TrackFrames[i][j] == NO_FRAME)
+                    continue;
+                WriteSparseTrack(Stream, pAnim->GetTrack(j)->TransformTrack, SparseTracks[i][j]);
             }
-            fTime += fKeyInterval;
         }
+
+        if (!Stream.Close())
+        {
+            ExportLog::LogError("Failed writing to file \"%s\".  Check that there is enough free disk space.", strAnimFileName);
+            return false;
+        }
+
+        ExportLog::LogMsg(2, "Multi-clip animation file: %zu clips over %zu frames, %llu bytes of animation data.", dwClipCount, dwFrameCount, AnimationDataSize);
         return true;
     }
 
@@ -911,41 +1228,112 @@ namespace ATG
         if (!g_pScene->Settings().bExportAnimations)
             return false;
 
+        CHAR strAnimFileName[MAX_PATH];
+        strcpy_s(strAnimFileName, strFileName);
+        strcat_s(strAnimFileName, "_anim");
+
+        if (g_pScene->Settings().bMultiClipAnimations)
+            return WriteSDKMeshMultiClipAnimationFile(strAnimFileName);
+
         ExportAnimation* pAnim = g_pScene->GetAnimation(0);
         const size_t dwTrackCount = pAnim->GetTrackCount();
         if (dwTrackCount == 0)
             return false;
 
-        CHAR strAnimFileName[MAX_PATH];
-        strcpy_s(strAnimFileName, strFileName);
-        strcat_s(strAnimFileName, "_anim");
-
-        HANDLE hFile = CreateFileA(strAnimFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-        if (hFile == INVALID_HANDLE_VALUE)
+        // Tracks are processed on the worker threads below, so check them all first.
+        for (size_t i = 0; i < dwTrackCount; ++i)
         {
-            ExportLog::LogError("Could not write to file \"%s\".  Check that the file is not read-only and that the path exists.", strAnimFileName);
-            return false;
+            if (!pAnim->GetTrack(i))
+                return false;
         }
 
-        ExportLog::LogMsg(1, "Writing to SDKMESH animation file \"%s\"", strAnimFileName);
-
-        SDKANIMATION_FILE_HEADER AnimHeader = {};
+        // Quantized tracks take precedence over sparse tracks when both are enabled.
+        const bool bQuantize = g_pScene->Settings().bQuantizeAnimations;
+        const bool bSparse = !bQuantize && g_pScene->Settings().bSparseAnimations;
 
-        const size_t dwKeyCount = size_t(static_cast<int>(pAnim->GetDuration() / pAnim->fSourceFrameInterval));
+        // Quantized tracks include the last frame, as they do in XATG files.  Resampled
+        // tracks keep the key count of the original SDKMESH animation format.
+        const size_t dwKeyCount = bQuantize ? GetQuantizedKeyCount(pAnim) : size_t(static_cast<int>(pAnim->GetDuration() / pAnim->fSourceFrameInterval));
         const size_t dwTrackHeadersDataSize = dwTrackCount * sizeof(SDKANIMATION_FRAME_DATA);
         const size_t dwSingleTrackDataSize = dwKeyCount * sizeof(SDKANIMATION_DATA);
 
-        AnimHeader.Version = SDKMESH_FILE_VERSION;
+        // Track data offsets are relative to the start of the animation data.
+        std::vector<ExportQuantizedTrack> QuantizedTracks;
+        std::vector<SDKANIMATION_SPARSE_TRACK> SparseTracks;
+        std::vector<UINT64> TrackDataOffsets(dwTrackCount);
+        UINT64 AnimationDataSize = dwTrackHeadersDataSize;
+        if (bQuantize)
+        {
+            static_assert(static_cast<uint32_t>(SQF_TRANSLATION_ANIMATED) == static_cast<uint32_t>(QTF_TRANSLATION_ANIMATED)
+                && static_cast<uint32_t>(SQF_ORIENTATION_ANIMATED) == static_cast<uint32_t>(QTF_ORIENTATION_ANIMATED)
+                && static_cast<uint32_t>(SQF_SCALING_ANIMATED) == static_cast<uint32_t>(QTF_SCALE_ANIMATED), "Quantized track flags mismatch");
+
+            const ULONGLONG ullStartTime = GetTickCount64();
+            ExportQuantizationStats TotalStats = {};
+            if (!QuantizeAnimationTracks(pAnim, dwKeyCount, QuantizedTracks, TotalStats))
+                return false;
+            ExportLog::LogMsg(3, "Quantizing %zu tracks took %llu ms.", dwTrackCount, GetTickCount64() - ullStartTime);
+
+            for (size_t i = 0; i < dwTrackCount; ++i)
+            {
+                TrackDataOffsets[i] = AnimationDataSize;
+                AnimationDataSize += RoundUp8B(sizeof(SDKANIMATION_QUANTIZED_TRACK) + QuantizedTracks[i].Samples.size() * sizeof(uint16_t));
+            }
+            LogQuantizationStats(pAnim->GetName().SafeString(), dwTrackCount, TotalStats);
+        }
+        else if (bSparse)
+        {
+            SparseTracks.resize(dwTrackCount);
+            size_t dwSourceKeyCount = 0;
+            size_t dwSparseKeyCount = 0;
+            for (size_t i = 0; i < dwTrackCount; ++i)
+            {
+                ExportAnimationTrack* pTrack = pAnim->GetTrack(i);
+                if (!pTrack)
+                    return false;
+
+                const auto& Track = pTrack->TransformTrack;
+                SparseTracks[i] = GetSparseTrackHeader(Track);
+                dwSourceKeyCount += Track.PositionKeys.size() + Track.OrientationKeys.size() + Track.ScaleKeys.size();
+                dwSparseKeyCount += size_t(SparseTracks[i].TranslationKeyCount) + SparseTracks[i].OrientationKeyCount + SparseTracks[i].ScalingKeyCount;
+
+                TrackDataOffsets[i] = AnimationDataSize;
+                AnimationDataSize += RoundUp8B(ComputeSparseTrackSize(SparseTracks[i]));
+            }
+
+            const UINT64 DenseSize = dwTrackHeadersDataSize + UINT64(dwTrackCount) * dwSingleTrackDataSize;
+            ExportLog::LogMsg(2, "Sparse animation \"%s\": %zu tracks, %zu keys (%zu before collapsing constant channels), %llu bytes versus %llu resampled.",
+                pAnim->GetName().SafeString(), dwTrackCount, dwSparseKeyCount, dwSourceKeyCount, AnimationDataSize, DenseSize);
+        }
+        else
+        {
+            for (size_t i = 0; i < dwTrackCount; ++i)
+            {
+                TrackDataOffsets[i] = AnimationDataSize;
+                AnimationDataSize += dwSingleTrackDataSize;
+            }
+        }
+
+        SDKANIMATION_FILE_HEADER AnimHeader = {};
+        AnimHeader.Version = bQuantize ? SDKANIMATION_FILE_VERSION_QUANTIZED : (bSparse ? SDKANIMATION_FILE_VERSION_SPARSE : SDKMESH_FILE_VERSION);
         AnimHeader.IsBigEndian = !g_pScene->Settings().bLittleEndian;
         AnimHeader.FrameTransformType = FTT_RELATIVE;
         AnimHeader.NumAnimationKeys = static_cast<UINT>(dwKeyCount);
         AnimHeader.AnimationFPS = static_cast<UINT>(static_cast<int>(1.001f / pAnim->fSourceFrameInterval));
         AnimHeader.NumFrames = static_cast<UINT>(dwTrackCount);
-        AnimHeader.AnimationDataSize = dwTrackHeadersDataSize + dwTrackCount * dwSingleTrackDataSize;
+        AnimHeader.AnimationDataSize = AnimationDataSize;
         AnimHeader.AnimationDataOffset = sizeof(SDKANIMATION_FILE_HEADER);
 
-        DWORD dwBytesWritten = 0;
-        WriteFile(hFile, &AnimHeader, sizeof(SDKANIMATION_FILE_HEADER), &dwBytesWritten, nullptr);
+        SDKMeshFileStream Stream;
+        if (!Stream.Open(strAnimFileName, AnimHeader.AnimationDataOffset + AnimHeader.AnimationDataSize))
+        {
+            ExportLog::LogError("Could not write to file \"%s\".  Check that the file is not read-only and that the path exists.", strAnimFileName);
+            return false;
+        }
+
+        ExportLog::LogMsg(1, "Writing to SDKMESH animation file \"%s\"", strAnimFileName);
+
+        Stream.Write(&AnimHeader, sizeof(SDKANIMATION_FILE_HEADER));
 
         for (size_t i = 0; i < dwTrackCount; ++i)
         {
@@ -953,41 +1341,68 @@ namespace ATG
             if (!pTrack)
                 return false;
 
-            auto pSourceFrame = pTrack->TransformTrack.pSourceFrame;
             SDKANIMATION_FRAME_DATA FrameData = {};
-            FrameData.DataOffset = dwTrackHeadersDataSize + i * dwSingleTrackDataSize;
-            if (!pSourceFrame)
+            FrameData.DataOffset = TrackDataOffsets[i];
+            strncpy_s(FrameData.FrameName, GetTrackFrameName(pTrack).SafeString(), MAX_FRAME_NAME);
+            Stream.Write(&FrameData, sizeof(SDKANIMATION_FRAME_DATA));
+        }
+
+        if (bQuantize)
+        {
+            for (const auto& Track : QuantizedTracks)
             {
-                strncpy_s(FrameData.FrameName, pTrack->GetName().SafeString(), MAX_FRAME_NAME);
+                SDKANIMATION_QUANTIZED_TRACK TrackHeader = {};
+                TrackHeader.Flags = Track.Header.Flags;
+                TrackHeader.TranslationMin = Track.Header.TranslationMin;
+                TrackHeader.TranslationExtent = Track.Header.TranslationExtent;
+                TrackHeader.Orientation = Track.Header.Orientation;
+                TrackHeader.ScalingMin = Track.Header.ScaleMin;
+                TrackHeader.ScalingExtent = Track.Header.ScaleExtent;
+                Stream.Write(&TrackHeader, sizeof(SDKANIMATION_QUANTIZED_TRACK));
+                Stream.WriteArray(Track.Samples);
+
+                const size_t dwTrackSize = sizeof(SDKANIMATION_QUANTIZED_TRACK) + Track.Samples.size() * sizeof(uint16_t);
+                Stream.WritePadding(static_cast<size_t>(RoundUp8B(dwTrackSize) - dwTrackSize));
             }
-            else
+        }
+        else if (bSparse)
+        {
+            for (size_t i = 0; i < dwTrackCount; ++i)
             {
-                strncpy_s(FrameData.FrameName, pSourceFrame->GetName().SafeString(), MAX_FRAME_NAME);
+                WriteSparseTrack(Stream, pAnim->GetTrack(i)->TransformTrack, SparseTracks[i]);
             }
-            WriteFile(hFile, &FrameData, sizeof(SDKANIMATION_FRAME_DATA), &dwBytesWritten, nullptr);
         }
-
-        std::unique_ptr<SDKANIMATION_DATA[]> pTrackData(new SDKANIMATION_DATA[dwKeyCount]);
-
-        for (size_t i = 0; i < dwTrackCount; ++i)
+        else
         {
-            ExportAnimationTrack* pTrack = pAnim->GetTrack(i);
-            if (!pTrack)
-                return false;
-
-            ExportAnimationTransformTrack* pTT = &pTrack->TransformTrack;
+            // Tracks are resampled in parallel into their own slices of one buffer, then
+            // written in order.
+            const ULONGLONG ullStartTime = GetTickCount64();
+            std::vector<SDKANIMATION_DATA> TrackData(dwTrackCount * dwKeyCount);
+            ExportParallelFor(dwTrackCount, [&](size_t i)
+                {
+                    std::vector<XMFLOAT3> Positions(dwKeyCount);
+                    std::vector<XMFLOAT4> Orientations(dwKeyCount);
+                    std::vector<XMFLOAT3> Scales(dwKeyCount);
+                    ResampleAnimationTrack(pAnim->GetTrack(i)->TransformTrack, dwKeyCount, pAnim->fSourceFrameInterval, Positions.data(), Orientations.data(), Scales.data());
 
-            ZeroMemory(pTrackData.get(), dwKeyCount * sizeof(SDKANIMATION_DATA));
-            SamplePositionData(pTT->GetPositionKeys(), pTT->GetPositionKeyCount(), pTrackData.get(), dwKeyCount, pAnim->fSourceFrameInterval);
-            SampleOrientationData(pTT->GetOrientationKeys(), pTT->GetOrientationKeyCount(), pTrackData.get(), dwKeyCount, pAnim->fSourceFrameInterval);
-            SampleScaleData(pTT->GetScaleKeys(), pTT->GetScaleKeyCount(), pTrackData.get(), dwKeyCount, pAnim->fSourceFrameInterval);
+                    SDKANIMATION_DATA* pKeys = TrackData.data() + i * dwKeyCount;
+                    for (size_t j = 0; j < dwKeyCount; ++j)
+                    {
+                        pKeys[j].Translation = Positions[j];
+                        pKeys[j].Orientation = Orientations[j];
+                        pKeys[j].Scaling = Scales[j];
+                    }
+                });
+            ExportLog::LogMsg(3, "Resampling %zu tracks to %zu keys took %llu ms.", dwTrackCount, dwKeyCount, GetTickCount64() - ullStartTime);
 
-            WriteFile(hFile, pTrackData.get(), static_cast<DWORD>(dwKeyCount * sizeof(SDKANIMATION_DATA)), &dwBytesWritten, nullptr);
+            Stream.WriteArray(TrackData);
         }
 
-        pTrackData.reset();
-
-        CloseHandle(hFile);
+        if (!Stream.Close())
+        {
+            ExportLog::LogError("Failed writing to file \"%s\".  Check that there is enough free disk space.", strAnimFileName);
+            return false;
+        }
 
         return true;
     }
@@ -13,6 +13,10 @@
 #include "XATGFileWriter.h"
 #include "xmlwriter.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 extern ATG::ExportScene* g_pScene;
 extern ExportPath g_CurrentInputFileName;
 
@@ -25,6 +29,173 @@ namespace ATG
     static const CHAR* g_strTextureOutputSubPath = "\\textures";
     static const CHAR* g_strSceneOutputSubPath = "\\scenes";
 
+    constexpr size_t BLOB_STAGING_BUFFER_SIZE = 4 * 1024 * 1024;
+    constexpr size_t BLOB_ALIGNMENT = 32;
+
+    // Writes the .pmem file on a background I/O thread.  Payloads are copied into one
+    // of two staging buffers; when that buffer fills it is handed to the I/O thread and
+    // copying continues into the other, so XML generation overlaps the disk writes.
+    // Offsets are tracked here, in 64 bits, rather than read back from the file.
+    class BinaryBlobStream
+    {
+    public:
+        BinaryBlobStream() noexcept
+            : m_hFile(INVALID_HANDLE_VALUE),
+            m_dwFillBuffer(0),
+            m_dwBuffered(0),
+            m_Offset(0),
+            m_dwPendingBuffer(0),
+            m_dwPendingSize(0),
+            m_bPending(false),
+            m_bExit(false),
+            m_bFailed(false)
+        {
+        }
+        ~BinaryBlobStream() { Close(); }
+
+        BinaryBlobStream(const BinaryBlobStream&) = delete;
+        BinaryBlobStream& operator=(const BinaryBlobStream&) = delete;
+
+        bool Open(const CHAR* strFileName)
+        {
+            m_hFile = CreateFile(strFileName, FILE_WRITE_DATA, 0, nullptr, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_hFile == INVALID_HANDLE_VALUE)
+                return false;
+
+            for (auto& Buffer : m_Buffers)
+            {
+                Buffer.reset(new uint8_t[BLOB_STAGING_BUFFER_SIZE]);
+            }
+            m_dwFillBuffer = 0;
+            m_dwBuffered = 0;
+            m_Offset = 0;
+            m_bPending = false;
+            m_bExit = false;
+            m_bFailed = false;
+            m_IOThread = std::thread(&BinaryBlobStream::IOThreadProc, this);
+            return true;
+        }
+
+        // Flushes the queued data and closes the file.  Returns false if any write failed.
+        bool Close()
+        {
+            if (m_hFile == INVALID_HANDLE_VALUE)
+                return true;
+
+            if (m_dwBuffered > 0)
+            {
+                Submit();
+            }
+            {
+                std::unique_lock<std::mutex> Lock(m_Mutex);
+                m_bExit = true;
+            }
+            m_Condition.notify_all();
+            m_IOThread.join();
+
+            CloseHandle(m_hFile);
+            m_hFile = INVALID_HANDLE_VALUE;
+            for (auto& Buffer : m_Buffers)
+            {
+                Buffer.reset();
+            }
+            return !m_bFailed;
+        }
+
+        bool IsOpen() const noexcept { return m_hFile != INVALID_HANDLE_VALUE; }
+        UINT64 GetOffset() const noexcept { return m_Offset; }
+
+        // Queues a copy of the data, zero padded to BLOB_ALIGNMENT bytes, and returns the
+        // offset it will be written at.  The caller's memory may be reused immediately.
+        UINT64 Write(const void* pData, size_t Size)
+        {
+            const UINT64 Offset = m_Offset;
+            Append(pData, Size);
+
+            const size_t PadSize = (BLOB_ALIGNMENT - (Size % BLOB_ALIGNMENT)) % BLOB_ALIGNMENT;
+            if (PadSize > 0)
+            {
+                const uint8_t Zeros[BLOB_ALIGNMENT] = {};
+                Append(Zeros, PadSize);
+            }
+            return Offset;
+        }
+
+    private:
+        void Append(const void* pData, size_t Size)
+        {
+            auto pSource = static_cast<const uint8_t*>(pData);
+            m_Offset += Size;
+            while (Size > 0)
+            {
+                const size_t CopySize = std::min(Size, BLOB_STAGING_BUFFER_SIZE - m_dwBuffered);
+                memcpy(m_Buffers[m_dwFillBuffer].get() + m_dwBuffered, pSource, CopySize);
+                m_dwBuffered += CopySize;
+                pSource += CopySize;
+                Size -= CopySize;
+                if (m_dwBuffered == BLOB_STAGING_BUFFER_SIZE)
+                {
+                    Submit();
+                }
+            }
+        }
+
+        // Hands the fill buffer to the I/O thread and switches to the other one, waiting
+        // first for the I/O thread to finish with it.
+        void Submit()
+        {
+            {
+                std::unique_lock<std::mutex> Lock(m_Mutex);
+                m_Condition.wait(Lock, [this]() { return !m_bPending; });
+                m_dwPendingBuffer = m_dwFillBuffer;
+                m_dwPendingSize = m_dwBuffered;
+                m_bPending = true;
+            }
+            m_Condition.notify_all();
+            m_dwFillBuffer ^= 1;
+            m_dwBuffered = 0;
+        }
+
+        void IOThreadProc()
+        {
+            std::unique_lock<std::mutex> Lock(m_Mutex);
+            for (;;)
+            {
+                m_Condition.wait(Lock, [this]() { return m_bPending || m_bExit; });
+                if (!m_bPending)
+                    break;
+
+                const uint8_t* pData = m_Buffers[m_dwPendingBuffer].get();
+                const size_t Size = m_dwPendingSize;
+                Lock.unlock();
+
+                DWORD dwBytesWritten = 0;
+                const bool bWritten = WriteFile(m_hFile, pData, static_cast<DWORD>(Size), &dwBytesWritten, nullptr) && (dwBytesWritten == Size);
+
+                Lock.lock();
+                if (!bWritten)
+                    m_bFailed = true;
+                m_bPending = false;
+                m_Condition.notify_all();
+            }
+        }
+
+        HANDLE                      m_hFile;
+        std::unique_ptr<uint8_t[]>  m_Buffers[2];
+        DWORD                       m_dwFillBuffer;
+        size_t                      m_dwBuffered;
+        UINT64                      m_Offset;
+
+        std::thread                 m_IOThread;
+        std::mutex                  m_Mutex;
+        std::condition_variable     m_Condition;
+        DWORD                       m_dwPendingBuffer;
+        size_t                      m_dwPendingSize;
+        bool                        m_bPending;
+        bool                        m_bExit;
+        bool                        m_bFailed;
+    };
+
     XATGExportSettings      g_XATGSettings;
 
     XMLWriter* g_pXMLWriter = nullptr;
@@ -36,7 +207,8 @@ namespace ATG
     INT                     g_iWorkSize = 0;
     INT                     g_iCompletedWork = 0;
 
-    HANDLE                  g_hBinaryBlobFile = INVALID_HANDLE_VALUE;
+    BinaryBlobStream        g_BinaryBlob;
+    CHAR                    g_strBinaryBlobFileName[MAX_PATH];
     ExportManifest          g_DefaultManifest;
     ExportFileRecord        g_TextureBundledFile;
 
@@ -48,8 +220,7 @@ namespace ATG
     void PrepareDestination();
     void PrepareBinaryBlob();
     void PrepareBundledFile();
-    DWORD GetBinaryBlobCurrentOffset();
-    void WriteBinaryBlobData(const uint8_t* pData, size_t dwDataSizeBytes);
+    UINT64 WriteBinaryBlobData(const uint8_t* pData, size_t dwDataSizeBytes);
 
     void XATGInitializeSettings()
     {
@@ -155,10 +326,9 @@ namespace ATG
         delete g_pXMLWriter;
         g_pXMLWriter = nullptr;
 
-        if (g_hBinaryBlobFile != INVALID_HANDLE_VALUE)
+        if (g_BinaryBlob.IsOpen() && !g_BinaryBlob.Close())
         {
-            CloseHandle(g_hBinaryBlobFile);
-            g_hBinaryBlobFile = INVALID_HANDLE_VALUE;
+            ExportLog::LogError("Could not write physical memory file \"%s\".  Verify that there is enough free space on the destination drive.", g_strBinaryBlobFileName);
         }
         g_strFileName[0] = '\0';
 
@@ -168,34 +338,152 @@ namespace ATG
     CHAR g_strBuffer[512];
     const CHAR* WriteMatrix(const XMFLOAT4X4& m)
     {
-        sprintf_s(g_strBuffer, "%f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f",
-            m._11, m._12, m._13, m._14,
-            m._21, m._22, m._23, m._24,
-            m._31, m._32, m._33, m._34,
-            m._41, m._42, m._43, m._44);
+        XMLWriter::FormatFloats(g_strBuffer, &m._11, 16);
         return g_strBuffer;
     }
 
     const CHAR* WriteVec3(const XMFLOAT3& vec3)
     {
-        sprintf_s(g_strBuffer, "%f, %f, %f", vec3.x, vec3.y, vec3.z);
+        XMLWriter::FormatFloats(g_strBuffer, &vec3.x, 3);
         return g_strBuffer;
     }
 
     const CHAR* WriteColor(const XMFLOAT4& color)
     {
-        sprintf_s(g_strBuffer, "%f, %f, %f, %f", color.w, color.x, color.y, color.z);
+        const float fValues[] = { color.w, color.x, color.y, color.z };
+        XMLWriter::FormatFloats(g_strBuffer, fValues, 4);
         return g_strBuffer;
     }
 
     const CHAR* WriteQuaternion(const XMFLOAT4& quat)
     {
-        sprintf_s(g_strBuffer, "%f, %f, %f, %f", quat.x, quat.y, quat.z, quat.w);
+        XMLWriter::FormatFloats(g_strBuffer, &quat.x, 4);
         return g_strBuffer;
     }
 
+    void AppendFloats(std::string& strText, const float* pValues, UINT uCount)
+    {
+        CHAR strTemp[16 * (XMLWRITER_MAX_NUMBER_CHARS + 2)];
+        assert(uCount <= 16);
+        strText.append(strTemp, XMLWriter::FormatFloats(strTemp, pValues, uCount));
+    }
+
+    // Formats uCount sibling elements with FormatFunc(i, strText) on worker threads and
+    // splices them into the output in order.  Chunks are formatted a batch at a time so
+    // memory use stays bounded for very large vertex buffers and animations.
+    template<typename FormatFuncType>
+    void WriteElementsParallel(size_t uCount, FormatFuncType FormatFunc)
+    {
+        constexpr size_t ELEMENTS_PER_CHUNK = 1024;
+        const size_t uChunkCount = (uCount + ELEMENTS_PER_CHUNK - 1) / ELEMENTS_PER_CHUNK;
+        const size_t uChunksPerBatch = std::max<size_t>(1, static_cast<size_t>(GetExportWorkerThreadCount()) * 4);
+
+        std::vector<std::string> Chunks(std::min(uChunkCount, uChunksPerBatch));
+        for (size_t uBatchStart = 0; uBatchStart < uChunkCount; uBatchStart += uChunksPerBatch)
+        {
+            const size_t uBatchSize = std::min(uChunksPerBatch, uChunkCount - uBatchStart);
+            ExportParallelFor(uBatchSize, [&](size_t uChunk)
+            {
+                std::string& strText = Chunks[uChunk];
+                strText.clear();
+                const size_t uFirst = (uBatchStart + uChunk) * ELEMENTS_PER_CHUNK;
+                const size_t uLast = std::min(uFirst + ELEMENTS_PER_CHUNK, uCount);
+                for (size_t i = uFirst; i < uLast; ++i)
+                {
+                    FormatFunc(i, strText);
+                }
+            });
+
+            for (size_t uChunk = 0; uChunk < uBatchSize; ++uChunk)
+            {
+                g_pXMLWriter->WriteFormattedElements(Chunks[uChunk].data(), Chunks[uChunk].size());
+            }
+        }
+    }
+
+    // Writes <strKeyName Time="..." strValueName="..." /> for every key of a track.
+    template<typename KeyType, typename ValueType>
+    void WriteAnimationKeys(const std::vector<KeyType>& Keys, const CHAR* strKeyName, const CHAR* strValueName, ValueType KeyType::* pValue)
+    {
+        constexpr UINT uValueCount = sizeof(ValueType) / sizeof(float);
+
+        std::string strPrefix;
+        g_pXMLWriter->GetChildIndent(strPrefix);
+        strPrefix += "<";
+        strPrefix += strKeyName;
+        strPrefix += " Time=\"";
+        std::string strValuePrefix = "\" ";
+        strValuePrefix += strValueName;
+        strValuePrefix += "=\"";
+        std::string strSuffix = "\" />";
+        strSuffix += g_pXMLWriter->GetNewline();
+
+        WriteElementsParallel(Keys.size(), [&](size_t i, std::string& strText)
+        {
+            const KeyType& Key = Keys[i];
+            strText += strPrefix;
+            AppendFloats(strText, &Key.fTime, 1);
+            strText += strValuePrefix;
+            AppendFloats(strText, &(Key.*pValue).x, uValueCount);
+            strText += strSuffix;
+        });
+    }
+
+    // Writes the quantized samples to the .pmem file when there is one, or as hex text.
+    void WriteQuantizedKeys(const ExportQuantizedTrack& Track)
+    {
+        const auto& Header = Track.Header;
+        g_pXMLWriter->StartElement("QuantizedKeys");
+        g_pXMLWriter->AddAttribute("Flags", static_cast<INT>(Header.Flags));
+        g_pXMLWriter->AddAttributeFloats("TranslationMin", &Header.TranslationMin.x, 3);
+        g_pXMLWriter->AddAttributeFloats("TranslationExtent", &Header.TranslationExtent.x, 3);
+        g_pXMLWriter->AddAttributeFloats("Orientation", &Header.Orientation.x, 4);
+        g_pXMLWriter->AddAttributeFloats("ScaleMin", &Header.ScaleMin.x, 3);
+        g_pXMLWriter->AddAttributeFloats("ScaleExtent", &Header.ScaleExtent.x, 3);
+        g_pXMLWriter->AddAttribute("SampleCount", static_cast<INT>(Track.Samples.size()));
+
+        if (!Track.Samples.empty())
+        {
+            if (g_XATGSettings.bBinaryBlobExport)
+            {
+                std::vector<uint16_t> Samples(Track.Samples);
+                if (!g_pScene->Settings().bLittleEndian)
+                {
+                    for (auto& Sample : Samples)
+                    {
+                        Sample = _byteswap_ushort(Sample);
+                    }
+                }
+
+                const size_t dwSize = Samples.size() * sizeof(uint16_t);
+                const UINT64 BlobLocation = WriteBinaryBlobData(reinterpret_cast<const uint8_t*>(Samples.data()), dwSize);
+                g_pXMLWriter->StartElement("PhysicalBinaryData");
+                g_pXMLWriter->AddAttribute("Offset", BlobLocation);
+                g_pXMLWriter->AddAttribute("Size", static_cast<UINT64>(dwSize));
+                g_pXMLWriter->EndElement();
+            }
+            else
+            {
+                static const CHAR s_strHexDigits[] = "0123456789ABCDEF";
+                std::string strSamples;
+                strSamples.reserve(Track.Samples.size() * 4);
+                for (const uint16_t Sample : Track.Samples)
+                {
+                    strSamples += s_strHexDigits[(Sample >> 12) & 0xF];
+                    strSamples += s_strHexDigits[(Sample >> 8) & 0xF];
+                    strSamples += s_strHexDigits[(Sample >> 4) & 0xF];
+                    strSamples += s_strHexDigits[Sample & 0xF];
+                }
+                g_pXMLWriter->WriteElement("Samples", strSamples.c_str());
+            }
+        }
+
+        g_pXMLWriter->EndElement();
+    }
+
     void WriteAnimations()
     {
+        const bool bQuantize = g_pScene->Settings().bQuantizeAnimations;
         for (size_t i = 0; i < g_pScene->GetAnimationCount(); i++)
         {
             ExportAnimation* pAnim = g_pScene->GetAnimation(i);
@@ -205,24 +493,48 @@ namespace ATG
             g_pXMLWriter->StartElement("Animation");
             g_pXMLWriter->AddAttribute("Name", pAnim->GetName());
             g_pXMLWriter->AddAttribute("Duration", pAnim->fEndTime - pAnim->fStartTime);
+
+            // Quantized keys are sampled once per source frame, including both ends.
+            ExportQuantizationStats TotalStats = {};
+            std::vector<ExportQuantizedTrack> QuantizedTracks;
+            if (bQuantize)
+            {
+                const size_t dwQuantizedKeyCount = GetQuantizedKeyCount(pAnim);
+                g_pXMLWriter->AddAttribute("KeyCount", static_cast<INT>(dwQuantizedKeyCount));
+                g_pXMLWriter->AddAttribute("KeyInterval", pAnim->fSourceFrameInterval);
+
+                const ULONGLONG ullStartTime = GetTickCount64();
+                if (!QuantizeAnimationTracks(pAnim, dwQuantizedKeyCount, QuantizedTracks, TotalStats))
+                {
+                    ExportLog::LogError("Animation \"%s\" has a missing track.", pAnim->GetName().SafeString());
+                    g_pXMLWriter->EndElement();
+                    continue;
+                }
+                ExportLog::LogMsg(3, "Quantizing %zu tracks took %llu ms.", dwTrackCount, GetTickCount64() - ullStartTime);
+            }
+
             for (size_t dwTrack = 0; dwTrack < dwTrackCount; dwTrack++)
             {
                 ExportAnimationTrack* pTrack = pAnim->GetTrack(dwTrack);
                 g_pXMLWriter->StartElement("AnimationTrack");
                 g_pXMLWriter->AddAttribute("Name", pTrack->GetName());
 
+                if (bQuantize)
+                {
+                    WriteQuantizedKeys(QuantizedTracks[dwTrack]);
+
+                    g_pXMLWriter->StartElement("AnnotationTrack");
+                    g_pXMLWriter->EndElement();
+
+                    g_pXMLWriter->EndElement();
+                    continue;
+                }
+
                 {
                     const size_t dwKeyCount = pTrack->TransformTrack.PositionKeys.size();
                     g_pXMLWriter->StartElement("PositionKeys");
                     g_pXMLWriter->AddAttribute("Count", static_cast<INT>(dwKeyCount));
-                    for (size_t dwKey = 0; dwKey < dwKeyCount; dwKey++)
-                    {
-                        const ExportAnimationPositionKey& Key = pTrack->TransformTrack.PositionKeys[dwKey];
-                        g_pXMLWriter->StartElement("PositionKey");
-                        g_pXMLWriter->AddAttribute("Time", Key.fTime);
-                        g_pXMLWriter->AddAttribute("Position", WriteVec3(Key.Position));
-                        g_pXMLWriter->EndElement();
-                    }
+                    WriteAnimationKeys(pTrack->TransformTrack.PositionKeys, "PositionKey", "Position", &ExportAnimationPositionKey::Position);
                     g_pXMLWriter->EndElement();
                 }
 
@@ -230,14 +542,7 @@ namespace ATG
                     const size_t dwKeyCount = pTrack->TransformTrack.OrientationKeys.size();
                     g_pXMLWriter->StartElement("OrientationKeys");
                     g_pXMLWriter->AddAttribute("Count", static_cast<INT>(dwKeyCount));
-                    for (size_t dwKey = 0; dwKey < dwKeyCount; dwKey++)
-                    {
-                        const ExportAnimationOrientationKey& Key = pTrack->TransformTrack.OrientationKeys[dwKey];
-                        g_pXMLWriter->StartElement("OrientationKey");
-                        g_pXMLWriter->AddAttribute("Time", Key.fTime);
-                        g_pXMLWriter->AddAttribute("Orientation", WriteQuaternion(Key.Orientation));
-                        g_pXMLWriter->EndElement();
-                    }
+                    WriteAnimationKeys(pTrack->TransformTrack.OrientationKeys, "OrientationKey", "Orientation", &ExportAnimationOrientationKey::Orientation);
                     g_pXMLWriter->EndElement();
                 }
 
@@ -245,14 +550,7 @@ namespace ATG
                     const size_t dwKeyCount = pTrack->TransformTrack.ScaleKeys.size();
                     g_pXMLWriter->StartElement("ScaleKeys");
                     g_pXMLWriter->AddAttribute("Count", static_cast<INT>(dwKeyCount));
-                    for (size_t dwKey = 0; dwKey < dwKeyCount; dwKey++)
-                    {
-                        const ExportAnimationScaleKey& Key = pTrack->TransformTrack.ScaleKeys[dwKey];
-                        g_pXMLWriter->StartElement("ScaleKey");
-                        g_pXMLWriter->AddAttribute("Time", Key.fTime);
-                        g_pXMLWriter->AddAttribute("Scale", WriteVec3(Key.Scale));
-                        g_pXMLWriter->EndElement();
-                    }
+                    WriteAnimationKeys(pTrack->TransformTrack.ScaleKeys, "ScaleKey", "Scale", &ExportAnimationScaleKey::Scale);
                     g_pXMLWriter->EndElement();
                 }
 
@@ -262,6 +560,11 @@ namespace ATG
                 g_pXMLWriter->EndElement();
             }
             g_pXMLWriter->EndElement();
+
+            if (bQuantize)
+            {
+                LogQuantizationStats(pAnim->GetName().SafeString(), dwTrackCount, TotalStats);
+            }
         }
     }
 
@@ -494,85 +797,84 @@ namespace ATG
     }
 
 
+    void AppendVertexElement(std::string& strText, const uint8_t* pVertexData, BYTE Type)
+    {
+        switch (Type)
+        {
+        case D3DDECLTYPE_FLOAT4:
+            AppendFloats(strText, reinterpret_cast<const float*>(pVertexData), 4);
+            break;
+        case D3DDECLTYPE_FLOAT3:
+            AppendFloats(strText, reinterpret_cast<const float*>(pVertexData), 3);
+            break;
+        case D3DDECLTYPE_FLOAT2:
+            AppendFloats(strText, reinterpret_cast<const float*>(pVertexData), 2);
+            break;
+        case D3DDECLTYPE_FLOAT1:
+            AppendFloats(strText, reinterpret_cast<const float*>(pVertexData), 1);
+            break;
+        case D3DDECLTYPE_D3DCOLOR:
+        case D3DDECLTYPE_UBYTE4:
+        case D3DDECLTYPE_UBYTE4N:
+        case D3DDECLTYPE_DXGI_R10G10B10A2_UNORM:
+        case D3DDECLTYPE_DXGI_R8G8B8A8_SNORM:
+        case D3DDECLTYPE_XBOX_R10G10B10_SNORM_A2_UNORM:
+        case D3DDECLTYPE_DXGI_R11G11B10_FLOAT:
+        {
+            CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+            strText.append(strTemp, XMLWriter::FormatHex32(strTemp, *reinterpret_cast<const DWORD*>(pVertexData)));
+            break;
+        }
+        case D3DDECLTYPE_FLOAT16_2:
+        {
+            float fData[2];
+            XMConvertHalfToFloatStream(fData, sizeof(float), reinterpret_cast<const HALF*>(pVertexData), sizeof(HALF), 2);
+            AppendFloats(strText, fData, 2);
+            break;
+        }
+        case D3DDECLTYPE_FLOAT16_4:
+        {
+            float fData[4];
+            XMConvertHalfToFloatStream(fData, sizeof(float), reinterpret_cast<const HALF*>(pVertexData), sizeof(HALF), 4);
+            AppendFloats(strText, fData, 4);
+            break;
+        }
+        case D3DDECLTYPE_SHORT4N:
+        {
+            auto pWords = reinterpret_cast<const short*>(pVertexData);
+            const float fData[4] = { (float)pWords[0] / 32767.0f, (float)pWords[1] / 32767.0f, (float)pWords[2] / 32767.0f, (float)pWords[3] / 32767.0f };
+            AppendFloats(strText, fData, 4);
+            break;
+        }
+        default:
+            strText += "UNSUPPORTED_TYPE";
+            break;
+        }
+    }
+
     void WriteVertexBufferVerbose(ExportVB* pVB, const D3DVERTEXELEMENT9* pVertexElements, size_t dwVertexElementCount)
     {
         const size_t uVertexCount = pVB->GetVertexCount();
 
-        for (size_t i = 0; i < uVertexCount; i++)
+        std::string strPrefix;
+        g_pXMLWriter->GetChildIndent(strPrefix);
+        strPrefix += "<E>";
+        std::string strSuffix = "</E>";
+        strSuffix += g_pXMLWriter->GetNewline();
+
+        WriteElementsParallel(uVertexCount, [&](size_t i, std::string& strText)
         {
             auto pVertex = pVB->GetVertex(i);
 
-            g_pXMLWriter->StartElement("E");
-            const CHAR* strComma = ", ";
-            for (UINT d = 0; d < dwVertexElementCount; d++)
+            strText += strPrefix;
+            for (size_t d = 0; d < dwVertexElementCount; d++)
             {
-                if (d == dwVertexElementCount - 1)
-                    strComma = "";
-                const uint8_t* pVertexData = pVertex + pVertexElements[d].Offset;
-                switch (pVertexElements[d].Type)
-                {
-                case D3DDECLTYPE_FLOAT4:
-                    g_pXMLWriter->WriteStringFormat("%f, %f, %f, %f%s",
-                        *reinterpret_cast<const float*>(pVertexData),
-                        *reinterpret_cast<const float*>(pVertexData + 4),
-                        *reinterpret_cast<const float*>(pVertexData + 8),
-                        *reinterpret_cast<const float*>(pVertexData + 12),
-                        strComma);
-                    break;
-                case D3DDECLTYPE_FLOAT3:
-                    g_pXMLWriter->WriteStringFormat("%f, %f, %f%s",
-                        *reinterpret_cast<const float*>(pVertexData),
-                        *reinterpret_cast<const float*>(pVertexData + 4),
-                        *reinterpret_cast<const float*>(pVertexData + 8),
-                        strComma);
-                    break;
-                case D3DDECLTYPE_FLOAT2:
-                    g_pXMLWriter->WriteStringFormat("%f, %f%s",
-                        *reinterpret_cast<const float*>(pVertexData),
-                        *reinterpret_cast<const float*>(pVertexData + 4),
-                        strComma);
-                    break;
-                case D3DDECLTYPE_FLOAT1:
-                    g_pXMLWriter->WriteStringFormat("%f%s", *reinterpret_cast<const float*>(pVertexData), strComma);
-                    break;
-                case D3DDECLTYPE_D3DCOLOR:
-                case D3DDECLTYPE_UBYTE4:
-                case D3DDECLTYPE_UBYTE4N:
-                case D3DDECLTYPE_DXGI_R10G10B10A2_UNORM:
-                case D3DDECLTYPE_DXGI_R8G8B8A8_SNORM:
-                case D3DDECLTYPE_XBOX_R10G10B10_SNORM_A2_UNORM:
-                case D3DDECLTYPE_DXGI_R11G11B10_FLOAT:
-                    g_pXMLWriter->WriteStringFormat("0x%08x%s", *reinterpret_cast<const DWORD*>(pVertexData), strComma);
-                    break;
-                case D3DDECLTYPE_FLOAT16_2:
-                {
-                    float fData[2];
-                    XMConvertHalfToFloatStream(fData, sizeof(float), reinterpret_cast<const HALF*>(pVertexData), sizeof(HALF), 2);
-                    g_pXMLWriter->WriteStringFormat("%f, %f%s", fData[0], fData[1], strComma);
-                    break;
-                }
-                case D3DDECLTYPE_FLOAT16_4:
-                {
-                    float fData[4];
-                    XMConvertHalfToFloatStream(fData, sizeof(float), reinterpret_cast<const HALF*>(pVertexData), sizeof(HALF), 4);
-                    g_pXMLWriter->WriteStringFormat("%f, %f, %f, %f%s",
-                        fData[0], fData[1], fData[2], fData[3], strComma);
-                    break;
-                }
-                case D3DDECLTYPE_SHORT4N:
-                {
-                    auto pWords = reinterpret_cast<const short*>(pVertexData);
-                    g_pXMLWriter->WriteStringFormat("%f, %f, %f, %f%s", (float)pWords[0] / 32767.0f, (float)pWords[1] / 32767.0f, (float)pWords[2] / 32767.0f, (float)pWords[3] / 32767.0f, strComma);
-                    break;
-                }
-                default:
-                    g_pXMLWriter->WriteStringFormat("UNSUPPORTED_TYPE%s", strComma);
-                    break;
-                }
+                if (d > 0)
+                    strText += ", ";
+                AppendVertexElement(strText, pVertex + pVertexElements[d].Offset, pVertexElements[d].Type);
             }
-            g_pXMLWriter->EndElement();
-        }
-
+            strText += strSuffix;
+        });
     }
 
     void WriteVertexData(ExportVB* pVB, const D3DVERTEXELEMENT9* pVertexElements, size_t dwVertexElementCount)
@@ -581,11 +883,10 @@ namespace ATG
 
         if (g_XATGSettings.bBinaryBlobExport)
         {
-            const DWORD dwBlobLocation = GetBinaryBlobCurrentOffset();
-            WriteBinaryBlobData(pVB->GetVertexData(), pVB->GetVertexDataSize());
+            const UINT64 BlobLocation = WriteBinaryBlobData(pVB->GetVertexData(), pVB->GetVertexDataSize());
             g_pXMLWriter->StartElement("PhysicalBinaryData");
-            g_pXMLWriter->AddAttribute("Offset", static_cast<INT>(dwBlobLocation));
-            g_pXMLWriter->AddAttribute("Size", static_cast<INT>(pVB->GetVertexDataSize()));
+            g_pXMLWriter->AddAttribute("Offset", BlobLocation);
+            g_pXMLWriter->AddAttribute("Size", static_cast<UINT64>(pVB->GetVertexDataSize()));
             g_pXMLWriter->AddAttribute("Count", static_cast<INT>(dwVertexCount));
             g_pXMLWriter->EndElement();
             return;
@@ -634,7 +935,7 @@ namespace ATG
     }
 
 
-    void WriteIBSubset(const  ExportIBSubset* pSubset)
+    void WriteIBSubset(const  ExportIBSubset* pSubset, bool bMeshlets)
     {
         const CHAR* const strPrimitiveTypes[] =
         {
@@ -648,10 +949,123 @@ namespace ATG
         g_pXMLWriter->AddAttribute("PrimitiveType", strPrimitiveTypes[pSubset->GetPrimitiveType()]);
         g_pXMLWriter->AddAttributeFormat("StartIndex", "%d", pSubset->GetStartIndex());
         g_pXMLWriter->AddAttributeFormat("IndexCount", "%d", pSubset->GetIndexCount());
+        if (bMeshlets)
+        {
+            g_pXMLWriter->AddAttributeFormat("MeshletStart", "%u", pSubset->GetMeshletStart());
+            g_pXMLWriter->AddAttributeFormat("MeshletCount", "%u", pSubset->GetMeshletCount());
+        }
         g_pXMLWriter->EndElement();
     }
 
 
+    void AppendUInts(std::string& strText, const uint32_t* pValues, UINT uCount)
+    {
+        CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+        for (UINT i = 0; i < uCount; ++i)
+        {
+            if (i > 0)
+                strText += ", ";
+            strText.append(strTemp, XMLWriter::FormatUInt64(strTemp, pValues[i]));
+        }
+    }
+
+    // Writes one meshlet array to the .pmem file, in the layout of the SDKMESH meshlet
+    // chunk, or as one child element per entry formatted by FormatFunc(i, strText).
+    template<typename FormatFuncType>
+    void WriteMeshletArray(const CHAR* strName, const void* pData, size_t dwCount, size_t dwElementSize, FormatFuncType FormatFunc)
+    {
+        g_pXMLWriter->StartElement(strName);
+        g_pXMLWriter->AddAttribute("Count", static_cast<INT>(dwCount));
+        if (g_XATGSettings.bBinaryBlobExport)
+        {
+            if (dwCount > 0)
+            {
+                const size_t dwSize = dwCount * dwElementSize;
+                const UINT64 BlobLocation = WriteBinaryBlobData(static_cast<const uint8_t*>(pData), dwSize);
+                g_pXMLWriter->StartElement("PhysicalBinaryData");
+                g_pXMLWriter->AddAttribute("Offset", BlobLocation);
+                g_pXMLWriter->AddAttribute("Size", static_cast<UINT64>(dwSize));
+                g_pXMLWriter->EndElement();
+            }
+        }
+        else
+        {
+            std::string strPrefix;
+            g_pXMLWriter->GetChildIndent(strPrefix);
+            const CHAR* strNewline = g_pXMLWriter->GetNewline();
+            WriteElementsParallel(dwCount, [&](size_t i, std::string& strText)
+            {
+                strText += strPrefix;
+                FormatFunc(i, strText);
+                strText += strNewline;
+            });
+        }
+        g_pXMLWriter->EndElement();
+    }
+
+    void WriteMeshlets(ExportMesh* pMesh)
+    {
+        const ExportMeshletData& Data = pMesh->GetMeshlets();
+        const DWORD dwIndexSize = pMesh->GetIB()->GetIndexSize();
+        const size_t dwUniqueIndexCount = Data.UniqueVertexIndices.size() / dwIndexSize;
+
+        g_pXMLWriter->StartElement("Meshlets");
+        g_pXMLWriter->AddAttribute("MaxVertices", static_cast<INT>(Data.uMaxVertices));
+        g_pXMLWriter->AddAttribute("MaxPrimitives", static_cast<INT>(Data.uMaxPrimitives));
+        g_pXMLWriter->AddAttribute("IndexSize", static_cast<INT>(dwIndexSize * 8));
+
+        WriteMeshletArray("MeshletList", Data.Meshlets.data(), Data.Meshlets.size(), sizeof(ExportMeshlet), [&](size_t i, std::string& strText)
+        {
+            const ExportMeshlet& Meshlet = Data.Meshlets[i];
+            strText += "<Meshlet VertexOffset=\"";
+            AppendUInts(strText, &Meshlet.VertOffset, 1);
+            strText += "\" VertexCount=\"";
+            AppendUInts(strText, &Meshlet.VertCount, 1);
+            strText += "\" PrimitiveOffset=\"";
+            AppendUInts(strText, &Meshlet.PrimOffset, 1);
+            strText += "\" PrimitiveCount=\"";
+            AppendUInts(strText, &Meshlet.PrimCount, 1);
+            strText += "\" />";
+        });
+
+        WriteMeshletArray("CullData", Data.CullData.data(), Data.CullData.size(), sizeof(ExportMeshletCullData), [&](size_t i, std::string& strText)
+        {
+            const ExportMeshletCullData& Cull = Data.CullData[i];
+            CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+            strText += "<Cull BoundingSphere=\"";
+            AppendFloats(strText, &Cull.BoundingSphere.Center.x, 3);
+            strText += ", ";
+            AppendFloats(strText, &Cull.BoundingSphere.Radius, 1);
+            strText += "\" NormalCone=\"";
+            strText.append(strTemp, XMLWriter::FormatHex32(strTemp, Cull.NormalCone.v));
+            strText += "\" ApexOffset=\"";
+            AppendFloats(strText, &Cull.ApexOffset, 1);
+            strText += "\" />";
+        });
+
+        WriteMeshletArray("UniqueVertexIndices", Data.UniqueVertexIndices.data(), dwUniqueIndexCount, dwIndexSize, [&](size_t i, std::string& strText)
+        {
+            const uint32_t uIndex = (dwIndexSize == 2)
+                ? reinterpret_cast<const uint16_t*>(Data.UniqueVertexIndices.data())[i]
+                : reinterpret_cast<const uint32_t*>(Data.UniqueVertexIndices.data())[i];
+            strText += "<E>";
+            AppendUInts(strText, &uIndex, 1);
+            strText += "</E>";
+        });
+
+        WriteMeshletArray("Primitives", Data.Primitives.data(), Data.Primitives.size(), sizeof(uint32_t), [&](size_t i, std::string& strText)
+        {
+            const uint32_t uPrimitive = Data.Primitives[i];
+            const uint32_t uIndices[3] = { uPrimitive & 0x3FF, (uPrimitive >> 10) & 0x3FF, (uPrimitive >> 20) & 0x3FF };
+            strText += "<E>";
+            AppendUInts(strText, uIndices, 3);
+            strText += "</E>";
+        });
+
+        g_pXMLWriter->EndElement(); // Meshlets
+    }
+
+
     void WritePatchSubset(const  ExportSubDPatchSubset* pSubset)
     {
         const CHAR* const strPrimitiveTypes[] =
@@ -695,11 +1109,10 @@ namespace ATG
         g_pXMLWriter->AddAttribute("IndexSize", static_cast<INT>(pIB->GetIndexSize() * 8));
         if (g_XATGSettings.bBinaryBlobExport)
         {
-            const DWORD dwBlobLocation = GetBinaryBlobCurrentOffset();
-            WriteBinaryBlobData(pIB->GetIndexData(), pIB->GetIndexDataSize());
+            const UINT64 BlobLocation = WriteBinaryBlobData(pIB->GetIndexData(), pIB->GetIndexDataSize());
             g_pXMLWriter->StartElement("PhysicalBinaryData");
-            g_pXMLWriter->AddAttribute("Offset", static_cast<INT>(dwBlobLocation));
-            g_pXMLWriter->AddAttribute("Size", static_cast<INT>(pIB->GetIndexDataSize()));
+            g_pXMLWriter->AddAttribute("Offset", BlobLocation);
+            g_pXMLWriter->AddAttribute("Size", static_cast<UINT64>(pIB->GetIndexDataSize()));
             g_pXMLWriter->AddAttribute("Count", static_cast<INT>(pIB->GetIndexCount()));
             g_pXMLWriter->EndElement();
         }
@@ -754,11 +1167,16 @@ namespace ATG
         {
             WriteVertexBuffer(pMesh->GetVB(), 0, &pMesh->GetVertexDeclElement(0), pMesh->GetVertexDeclElementCount());
             WriteIndexBuffer(pMesh->GetIB());
+            const bool bMeshlets = pMesh->HasMeshlets();
             const size_t uSubsetCount = pMesh->GetSubsetCount();
             for (size_t i = 0; i < uSubsetCount; i++)
             {
                 auto pSubset = pMesh->GetSubset(i);
-                WriteIBSubset(pSubset);
+                WriteIBSubset(pSubset, bMeshlets);
+            }
+            if (bMeshlets)
+            {
+                WriteMeshlets(pMesh);
             }
         }
         else
@@ -1068,7 +1486,7 @@ namespace ATG
     void PrepareBinaryBlob()
     {
         // Check if we're exporting the binary blob.
-        g_hBinaryBlobFile = INVALID_HANDLE_VALUE;
+        g_strBinaryBlobFileName[0] = '\0';
         if (!g_XATGSettings.bBinaryBlobExport)
             return;
 
@@ -1082,14 +1500,13 @@ namespace ATG
         strcat_s(strBlobFilename, ".pmem");
 
         // Create the file.
-        g_hBinaryBlobFile = CreateFile(strBlobFilename, FILE_WRITE_DATA, 0, nullptr, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
-        if (g_hBinaryBlobFile == INVALID_HANDLE_VALUE)
+        if (!g_BinaryBlob.Open(strBlobFilename))
         {
             ExportLog::LogError("Could not create physical memory file \"%s\".  Verify that the destination file is not read-only.", strBlobFilename);
             g_XATGSettings.bBinaryBlobExport = false;
             return;
         }
-        assert(g_hBinaryBlobFile != INVALID_HANDLE_VALUE);
+        strcpy_s(g_strBinaryBlobFileName, strBlobFilename);
 
         ExportLog::LogMsg(4, "Writing to physical memory file \"%s\".", strBlobFilename);
 
@@ -1154,24 +1571,9 @@ namespace ATG
         ExportLog::LogMsg(4, "Writing to bundler .XPR file \"%s\".", strTextureBundleFilename);
     }
 
-    DWORD GetBinaryBlobCurrentOffset()
+    UINT64 WriteBinaryBlobData(const uint8_t* pData, size_t dwDataSizeBytes)
     {
-        if (g_hBinaryBlobFile == INVALID_HANDLE_VALUE)
-            return 0;
-        return GetFileSize(g_hBinaryBlobFile, nullptr);
-    }
-
-    void WriteBinaryBlobData(const uint8_t* pData, size_t dwDataSizeBytes)
-    {
-        DWORD dwBytesWritten = 0;
-        WriteFile(g_hBinaryBlobFile, pData, static_cast<DWORD>(dwDataSizeBytes), &dwBytesWritten, nullptr);
-        constexpr DWORD dwPadSize = 32;
-        if ((dwDataSizeBytes % dwPadSize) != 0)
-        {
-            const DWORD dwZeroPadSize = dwPadSize - (dwDataSizeBytes % dwPadSize);
-            const uint8_t bZeros[dwPadSize] = {};
-            WriteFile(g_hBinaryBlobFile, bZeros, dwZeroPadSize, &dwBytesWritten, nullptr);
-        }
+        return g_BinaryBlob.Write(pData, dwDataSizeBytes);
     }
 
 
@@ -17,6 +17,381 @@
 
 using namespace ATG;
 
+namespace
+{
+    // Powers of ten that are exact in a double.
+    constexpr double s_Pow10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const CHAR s_strDigitPairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    UINT FormatUInt32(CHAR* strBuffer, uint32_t uValue)
+    {
+        CHAR strTemp[10];
+        CHAR* pEnd = strTemp + sizeof(strTemp);
+        CHAR* p = pEnd;
+        while (uValue >= 100)
+        {
+            const uint32_t uPair = uValue % 100;
+            uValue /= 100;
+            p -= 2;
+            memcpy(p, s_strDigitPairs + uPair * 2, 2);
+        }
+        if (uValue >= 10)
+        {
+            p -= 2;
+            memcpy(p, s_strDigitPairs + uValue * 2, 2);
+        }
+        else
+        {
+            *--p = static_cast<CHAR>('0' + uValue);
+        }
+        const UINT uLength = static_cast<UINT>(pEnd - p);
+        memcpy(strBuffer, p, uLength);
+        return uLength;
+    }
+
+    // Slow but exact check, used when the double fast path below cannot decide.
+    bool RoundTripsSlow(uint32_t uDigits, int iExponent, float fValue)
+    {
+        CHAR strTemp[32];
+        sprintf_s(strTemp, "%ue%d", uDigits, iExponent);
+        return strtof(strTemp, nullptr) == fValue;
+    }
+
+    // Returns true if uDigits * 10^iExponent reads back as fValue, for |iExponent| <= 22.
+    // With fewer than 2^53 digits and an exact power of ten, one double multiply or
+    // divide gives the correctly rounded double.  Rounding that double to float gives
+    // the correctly rounded float too, unless it lies exactly halfway between two
+    // floats, which is left to strtof.
+    bool RoundTrips(uint32_t uDigits, int iExponent, float fValue)
+    {
+        const double dDecimal = (iExponent >= 0) ? static_cast<double>(uDigits) * s_Pow10[iExponent] : static_cast<double>(uDigits) / s_Pow10[-iExponent];
+        uint64_t uBits;
+        memcpy(&uBits, &dDecimal, sizeof(uBits));
+        if ((uBits & 0x1FFFFFFF) == 0x10000000)
+            return RoundTripsSlow(uDigits, iExponent, fValue);
+        return static_cast<float>(dDecimal) == fValue;
+    }
+
+    // Finds the shortest uDigits * 10^iExponent that reads back as fValue (positive,
+    // normal).  Returns false outside the range the fast path handles.
+    bool ShortestDecimalFast(float fValue, uint32_t& uDigits, int& iExponent)
+    {
+        // Keeps every power of ten used below in the exact table.
+        if (fValue < 1e-13f || fValue >= 1e22f)
+            return false;
+
+        // floor(log10(2^e)) is the decimal exponent of the leading digit, or one less.
+        uint32_t uBits;
+        memcpy(&uBits, &fValue, sizeof(uBits));
+        const int iBinaryExponent = static_cast<int>((uBits >> 23) & 0xFF) - 127;
+        int iLeadingExponent = (iBinaryExponent * 78913) >> 18;
+
+        // The nine digit decimal nearest to the value; shorter candidates are taken
+        // from its leading digits.
+        const double dValue = fValue;
+        double dNine = 0.0;
+        for (;;)
+        {
+            const int iScale = iLeadingExponent - 8;
+            const double dScaled = (iScale >= 0) ? dValue / s_Pow10[iScale] : dValue * s_Pow10[-iScale];
+            dNine = floor(dScaled + 0.5);
+            if (dNine < 1e9)
+                break;
+            ++iLeadingExponent;
+        }
+        const uint32_t uNine = static_cast<uint32_t>(dNine);
+
+        // Finds the candidate with iPrecision significant digits that reads back as
+        // fValue, if there is one.
+        auto FindCandidate = [&](int iPrecision, uint32_t& uCandidate) -> bool
+        {
+            static const uint32_t s_Divisors[] = { 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1 };
+            const uint32_t uDivisor = s_Divisors[iPrecision - 1];
+            const uint32_t uQuotient = uNine / uDivisor;
+            const uint32_t uRemainder = uNine % uDivisor;
+            const int iScale = iLeadingExponent - iPrecision + 1;
+
+            // Only the candidates either side of the value can read back as it; try the
+            // nearer one first.  Next to a power of two the interval that reads back as
+            // fValue is narrower below the value than above it, so the farther one may
+            // still qualify.
+            const bool bRoundUp = (uRemainder * 2 > uDivisor);
+            uCandidate = bRoundUp ? uQuotient + 1 : uQuotient;
+            if (RoundTrips(uCandidate, iScale, fValue))
+                return true;
+            uCandidate = bRoundUp ? uQuotient : uQuotient + 1;
+            if (RoundTrips(uCandidate, iScale, fValue))
+                return true;
+
+            // The nine digit value may have been rounded up onto a multiple of the
+            // divisor, leaving the value itself just below uQuotient.
+            uCandidate = uQuotient - 1;
+            return (uRemainder == 0) && (uQuotient > 1) && RoundTrips(uCandidate, iScale, fValue);
+        };
+
+        // If a precision reads back, every higher one does too, so binary search for
+        // the shortest.
+        uint32_t uBest = 0;
+        if (!FindCandidate(9, uBest))
+            return false;
+        int iBestPrecision = 9;
+        int iLow = 1;
+        while (iLow < iBestPrecision)
+        {
+            const int iPrecision = (iLow + iBestPrecision) / 2;
+            uint32_t uCandidate = 0;
+            if (FindCandidate(iPrecision, uCandidate))
+            {
+                uBest = uCandidate;
+                iBestPrecision = iPrecision;
+            }
+            else
+            {
+                iLow = iPrecision + 1;
+            }
+        }
+
+        uDigits = uBest;
+        iExponent = iLeadingExponent - iBestPrecision + 1;
+        return true;
+    }
+
+    // Handles very small, very large and denormal values with the CRT.
+    void ShortestDecimalSlow(float fValue, uint32_t& uDigits, int& iExponent)
+    {
+        CHAR strTemp[32];
+        for (int iPrecision = 1; ; ++iPrecision)
+        {
+            sprintf_s(strTemp, "%.*e", iPrecision - 1, static_cast<double>(fValue));
+            // Nine significant digits always read back as the same float.
+            if (iPrecision < 9 && strtof(strTemp, nullptr) != fValue)
+                continue;
+
+            uDigits = 0;
+            const CHAR* p = strTemp;
+            for (; *p && *p != 'e'; ++p)
+            {
+                if (*p >= '0' && *p <= '9')
+                    uDigits = uDigits * 10 + static_cast<uint32_t>(*p - '0');
+            }
+            iExponent = (*p ? atoi(p + 1) : 0) - (iPrecision - 1);
+            return;
+        }
+    }
+
+    UINT FormatDecimal(CHAR* strBuffer, uint32_t uDigits, int iExponent)
+    {
+        while (uDigits % 10 == 0)
+        {
+            uDigits /= 10;
+            ++iExponent;
+        }
+
+        CHAR strDigits[10];
+        const UINT uDigitCount = FormatUInt32(strDigits, uDigits);
+        const int iLeadingExponent = iExponent + static_cast<int>(uDigitCount) - 1;
+
+        CHAR* p = strBuffer;
+        if (iLeadingExponent < -5 || iLeadingExponent > 8)
+        {
+            // d.ddde-7
+            *p++ = strDigits[0];
+            if (uDigitCount > 1)
+            {
+                *p++ = '.';
+                memcpy(p, strDigits + 1, uDigitCount - 1);
+                p += uDigitCount - 1;
+            }
+            *p++ = 'e';
+            if (iLeadingExponent < 0)
+                *p++ = '-';
+            p += FormatUInt32(p, static_cast<uint32_t>(abs(iLeadingExponent)));
+        }
+        else if (iExponent >= 0)
+        {
+            // ddd00
+            memcpy(p, strDigits, uDigitCount);
+            p += uDigitCount;
+            memset(p, '0', static_cast<size_t>(iExponent));
+            p += iExponent;
+        }
+        else if (iLeadingExponent >= 0)
+        {
+            // dd.ddd
+            const UINT uIntegerDigits = static_cast<UINT>(iLeadingExponent + 1);
+            memcpy(p, strDigits, uIntegerDigits);
+            p += uIntegerDigits;
+            *p++ = '.';
+            memcpy(p, strDigits + uIntegerDigits, uDigitCount - uIntegerDigits);
+            p += uDigitCount - uIntegerDigits;
+        }
+        else
+        {
+            // 0.000ddd
+            *p++ = '0';
+            *p++ = '.';
+            memset(p, '0', static_cast<size_t>(-iLeadingExponent - 1));
+            p += -iLeadingExponent - 1;
+            memcpy(p, strDigits, uDigitCount);
+            p += uDigitCount;
+        }
+        *p = '\0';
+        return static_cast<UINT>(p - strBuffer);
+    }
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: FormatFloat
+// Desc: Writes the shortest decimal string that reads back as exactly fValue.
+//----------------------------------------------------------------------------------
+UINT XMLWriter::FormatFloat(CHAR* strBuffer, float fValue)
+{
+    uint32_t uBits;
+    memcpy(&uBits, &fValue, sizeof(uBits));
+
+    CHAR* p = strBuffer;
+    if ((uBits & 0x7F800000) == 0x7F800000)
+    {
+        if (uBits & 0x007FFFFF)
+        {
+            strcpy_s(p, XMLWRITER_MAX_NUMBER_CHARS, "nan");
+            return 3;
+        }
+        if (uBits & 0x80000000)
+            *p++ = '-';
+        strcpy_s(p, 4, "inf");
+        return static_cast<UINT>(p - strBuffer) + 3;
+    }
+
+    if (uBits & 0x80000000)
+        *p++ = '-';
+
+    const float fAbsValue = fabsf(fValue);
+    if (fAbsValue == 0.0f)
+    {
+        *p++ = '0';
+        *p = '\0';
+        return static_cast<UINT>(p - strBuffer);
+    }
+
+    uint32_t uDigits = 0;
+    int iExponent = 0;
+    if (!ShortestDecimalFast(fAbsValue, uDigits, iExponent))
+        ShortestDecimalSlow(fAbsValue, uDigits, iExponent);
+
+    return static_cast<UINT>(p - strBuffer) + FormatDecimal(p, uDigits, iExponent);
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: FormatFloats
+// Desc: Writes a comma separated list of floats.
+//----------------------------------------------------------------------------------
+UINT XMLWriter::FormatFloats(CHAR* strBuffer, const float* pValues, UINT uCount)
+{
+    CHAR* p = strBuffer;
+    *p = '\0';
+    for (UINT i = 0; i < uCount; ++i)
+    {
+        if (i > 0)
+        {
+            *p++ = ',';
+            *p++ = ' ';
+        }
+        p += FormatFloat(p, pValues[i]);
+    }
+    return static_cast<UINT>(p - strBuffer);
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: FormatInt
+// Desc: Writes a signed decimal integer.
+//----------------------------------------------------------------------------------
+UINT XMLWriter::FormatInt(CHAR* strBuffer, INT iValue)
+{
+    CHAR* p = strBuffer;
+    uint32_t uValue = static_cast<uint32_t>(iValue);
+    if (iValue < 0)
+    {
+        *p++ = '-';
+        uValue = 0u - uValue;
+    }
+    p += FormatUInt32(p, uValue);
+    *p = '\0';
+    return static_cast<UINT>(p - strBuffer);
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: FormatUInt64
+// Desc: Writes an unsigned 64-bit decimal integer.
+//----------------------------------------------------------------------------------
+UINT XMLWriter::FormatUInt64(CHAR* strBuffer, UINT64 uValue)
+{
+    if (uValue <= UINT32_MAX)
+    {
+        const UINT uLength = FormatUInt32(strBuffer, static_cast<uint32_t>(uValue));
+        strBuffer[uLength] = '\0';
+        return uLength;
+    }
+
+    // Peel off the low nine digits until the rest fits in 32 bits.
+    CHAR strTemp[20];
+    CHAR* pEnd = strTemp + sizeof(strTemp);
+    CHAR* p = pEnd;
+    while (uValue > UINT32_MAX)
+    {
+        uint32_t uLow = static_cast<uint32_t>(uValue % 1000000000u);
+        uValue /= 1000000000u;
+        for (int i = 0; i < 9; ++i)
+        {
+            *--p = static_cast<CHAR>('0' + uLow % 10);
+            uLow /= 10;
+        }
+    }
+    UINT uLength = FormatUInt32(strBuffer, static_cast<uint32_t>(uValue));
+    memcpy(strBuffer + uLength, p, static_cast<size_t>(pEnd - p));
+    uLength += static_cast<UINT>(pEnd - p);
+    strBuffer[uLength] = '\0';
+    return uLength;
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: FormatHex32
+// Desc: Writes a 32-bit value as 0x followed by eight lowercase hex digits.
+//----------------------------------------------------------------------------------
+UINT XMLWriter::FormatHex32(CHAR* strBuffer, DWORD dwValue)
+{
+    static const CHAR s_strHexDigits[] = "0123456789abcdef";
+    strBuffer[0] = '0';
+    strBuffer[1] = 'x';
+    for (UINT i = 0; i < 8; ++i)
+    {
+        strBuffer[9 - i] = s_strHexDigits[dwValue & 0xF];
+        dwValue >>= 4;
+    }
+    strBuffer[10] = '\0';
+    return 10;
+}
+
 //----------------------------------------------------------------------------------
 // Name: XMLWriter
 // Desc: Constructor for the XML writer class.
@@ -242,8 +617,8 @@ bool XMLWriter::WriteElement(const CHAR* strName, INT iBody)
 {
     bool result = true;
     result &= StartElement(strName);
-    CHAR strTemp[32];
-    _itoa_s(iBody, strTemp, 10);
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+    FormatInt(strTemp, iBody);
     result &= WriteString(strTemp);
     result &= EndElement();
     return result;
@@ -258,8 +633,8 @@ bool XMLWriter::WriteElement(const CHAR* strName, float fBody)
 {
     bool result = true;
     result &= StartElement(strName);
-    CHAR strTemp[32];
-    sprintf_s(strTemp, "%f", fBody);
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+    FormatFloat(strTemp, fBody);
     result &= WriteString(strTemp);
     result &= EndElement();
     return result;
@@ -450,8 +825,22 @@ bool XMLWriter::AddAttribute(const CHAR* strName, const WCHAR* wstrValue)
 //----------------------------------------------------------------------------------
 bool XMLWriter::AddAttribute(const CHAR* strName, INT iValue)
 {
-    CHAR strTemp[20];
-    _itoa_s(iValue, strTemp, 10);
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+    FormatInt(strTemp, iValue);
+    return AddAttribute(strName, strTemp);
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: AddAttribute
+// Desc: Adds a key-value attribute pair to an XML open tag.  This must be called
+//       after calling StartElement(), but before calling WriteString() or
+//       EndElement().
+//----------------------------------------------------------------------------------
+bool XMLWriter::AddAttribute(const CHAR* strName, UINT64 uValue)
+{
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+    FormatUInt64(strTemp, uValue);
     return AddAttribute(strName, strTemp);
 }
 
@@ -464,12 +853,44 @@ bool XMLWriter::AddAttribute(const CHAR* strName, INT iValue)
 //----------------------------------------------------------------------------------
 bool XMLWriter::AddAttribute(const CHAR* strName, float fValue)
 {
-    CHAR strTemp[20];
-    sprintf_s(strTemp, "%f", fValue);
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS];
+    FormatFloat(strTemp, fValue);
     return AddAttribute(strName, strTemp);
 }
 
 
+//----------------------------------------------------------------------------------
+// Name: AddAttributeFloats
+// Desc: Adds an attribute whose value is a comma separated list of floats.  This
+//       must be called after calling StartElement(), but before calling
+//       WriteString() or EndElement().
+//----------------------------------------------------------------------------------
+bool XMLWriter::AddAttributeFloats(const CHAR* strName, const float* pValues, UINT uCount)
+{
+    if (m_bOpenTagFinished)
+        return false;
+    bool result = true;
+    result &= OutputStringFast(" ", 1);
+    result &= OutputString(strName);
+    result &= OutputStringFast("=\"", 2);
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS + 2];
+    for (UINT i = 0; i < uCount; ++i)
+    {
+        UINT uLength = 0;
+        if (i > 0)
+        {
+            strTemp[0] = ',';
+            strTemp[1] = ' ';
+            uLength = 2;
+        }
+        uLength += FormatFloat(strTemp + uLength, pValues[i]);
+        result &= OutputStringFast(strTemp, uLength);
+    }
+    result &= OutputStringFast("\"", 1);
+    return result;
+}
+
+
 //----------------------------------------------------------------------------------
 // Name: WriteString
 // Desc: Writes a string after an XML open tag.
@@ -506,6 +927,88 @@ bool XMLWriter::WriteStringFormat(const CHAR* strFormat, ...)
 }
 
 
+//----------------------------------------------------------------------------------
+// Name: WriteFloats
+// Desc: Writes a comma separated list of floats after an XML open tag.
+//----------------------------------------------------------------------------------
+bool XMLWriter::WriteFloats(const float* pValues, UINT uCount)
+{
+    if (!m_bOpenTagFinished)
+    {
+        if (!EndOpenTag())
+            return false;
+    }
+    bool result = true;
+    CHAR strTemp[XMLWRITER_MAX_NUMBER_CHARS + 2];
+    for (UINT i = 0; i < uCount; ++i)
+    {
+        UINT uLength = 0;
+        if (i > 0)
+        {
+            strTemp[0] = ',';
+            strTemp[1] = ' ';
+            uLength = 2;
+        }
+        uLength += FormatFloat(strTemp + uLength, pValues[i]);
+        result &= OutputStringFast(strTemp, uLength);
+    }
+    return result;
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: GetChildIndent
+// Desc: Returns the indentation written before a child of the current element.
+//----------------------------------------------------------------------------------
+void XMLWriter::GetChildIndent(std::string& strIndent) const
+{
+    strIndent.clear();
+    for (size_t i = 0; i < m_NameStackPositions.size(); i++)
+    {
+        strIndent.append(m_strIndent, m_uIndentCount);
+    }
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: GetNewline
+// Desc: Returns the line break written after each element.
+//----------------------------------------------------------------------------------
+const CHAR* XMLWriter::GetNewline() const noexcept
+{
+    if (!m_bWriteNewlines)
+        return "";
+    return (m_hFile != INVALID_HANDLE_VALUE) ? "\r\n" : "\n";
+}
+
+
+//----------------------------------------------------------------------------------
+// Name: WriteFormattedElements
+// Desc: Splices a run of complete child elements, formatted by the caller, into the
+//       output, leaving the writer in the state EndElement() would.
+//----------------------------------------------------------------------------------
+bool XMLWriter::WriteFormattedElements(const CHAR* strText, size_t uLength)
+{
+    if (!m_bOpenTagFinished)
+    {
+        if (!EndOpenTag())
+            return false;
+        if (!WriteNewline())
+            return false;
+    }
+    bool result = true;
+    while (uLength > 0)
+    {
+        const UINT uChunk = static_cast<UINT>(std::min<size_t>(uLength, UINT32_MAX / 2));
+        result &= OutputStringFast(strText, uChunk);
+        strText += uChunk;
+        uLength -= uChunk;
+    }
+    m_bWriteCloseTagIndent = true;
+    return result;
+}
+
+
 //----------------------------------------------------------------------------------
 // Name: EndOpenTag
 // Desc: Writes the closing angle bracket of an XML open tag, and sets the proper
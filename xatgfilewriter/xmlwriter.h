@@ -11,8 +11,14 @@
 //-------------------------------------------------------------------------------------
 #pragma once
 
+#include <string>
+
 #define XMLWRITER_NAME_STACK_SIZE 255
 
+// Enough for any value written by FormatFloat, FormatInt, FormatUInt64 or FormatHex32,
+// including the terminating null.
+#define XMLWRITER_MAX_NUMBER_CHARS 24
+
 namespace ATG
 {
     class XMLWriter
@@ -51,10 +57,31 @@ namespace ATG
         bool AddAttribute(const CHAR* strName, const CHAR* strValue);
         bool AddAttribute(const CHAR* strName, const WCHAR* wstrValue);
         bool AddAttribute(const CHAR* strName, INT iValue);
+        bool AddAttribute(const CHAR* strName, UINT64 uValue);
         bool AddAttribute(const CHAR* strName, float fValue);
+        bool AddAttributeFloats(const CHAR* strName, const float* pValues, UINT uCount);
 
         bool WriteString(const CHAR* strText);
         bool WriteStringFormat(const CHAR* strFormat, ...);
+        bool WriteFloats(const float* pValues, UINT uCount);
+
+        // Number formatting used by the writer.  Floats are written as the shortest
+        // decimal that reads back as the same value.  These are thread safe and return
+        // the length written, not counting the terminating null.  FormatFloats separates
+        // values with ", " and needs uCount * (XMLWRITER_MAX_NUMBER_CHARS + 2) characters.
+        static UINT FormatFloat(CHAR* strBuffer, float fValue);
+        static UINT FormatFloats(CHAR* strBuffer, const float* pValues, UINT uCount);
+        static UINT FormatInt(CHAR* strBuffer, INT iValue);
+        static UINT FormatUInt64(CHAR* strBuffer, UINT64 uValue);
+        static UINT FormatHex32(CHAR* strBuffer, DWORD dwValue);
+
+        // Support for formatting long runs of sibling elements on worker threads.  A
+        // child of the current element starts with GetChildIndent and ends with
+        // GetNewline; WriteFormattedElements splices the preformatted text into the
+        // output as if the elements had been written one at a time.
+        void GetChildIndent(std::string& strIndent) const;
+        const CHAR* GetNewline() const noexcept;
+        bool WriteFormattedElements(const CHAR* strText, size_t uLength);
 
     private:
 